@@ -2,7 +2,8 @@
 #include "BlockInternals.h"
 
 // --------------------------------------------------------------------------
-void Block::update_fields(float t, const OscillatorArray &oscillators)
+void Block::update_fields(float t, const OscillatorArray &oscillators,
+    const OscillatorBins &bins)
 {
     // update the scalar oscillator field
     const Vertex &shape = grid.shape();
@@ -27,21 +28,52 @@ void Block::update_fields(float t, const OscillatorArray &oscillators)
     int deviceId = -1;
 #endif
     BlockInternals::UpdateFields(deviceId, t, oscillators.Data(),
-        oscillators.Size(), ni,nj,nk, i0,j0,k0, x0,y0,z0, dx,dy,dz,
+        oscillators.Size(), &bins, ni,nj,nk, i0,j0,k0, x0,y0,z0, dx,dy,dz,
         pdata);
 }
 
 // --------------------------------------------------------------------------
-void Block::update_particles(float t, const OscillatorArray &oscillators)
+void Block::swap_grid(const std::function<bool(const float*)> &in_use)
+{
+    if (!in_use(grid.data()))
+        return;
+
+    for (auto &spare : spare_grids)
+    {
+        if (!in_use(spare.data()))
+        {
+            grid.swap(spare);
+            return;
+        }
+    }
+
+    spare_grids.emplace_back(grid.shape());
+    grid.swap(spare_grids.back());
+}
+
+// --------------------------------------------------------------------------
+void Block::update_particles(float t, const OscillatorArray &oscillators,
+    const OscillatorBins &bins)
 {
     // update the velocity field on the particle mesh
     const Oscillator *pOsc = oscillators.Data();
     for (auto& particle : particles)
     {
         particle.velocity = { 0, 0, 0 };
-        for (unsigned long q = 0; q < oscillators.Size(); ++q)
+        if (bins.Enabled())
+        {
+            const sdiy::Point<float,3> &x = particle.position;
+
+            int n = 0;
+            const int *ids = bins.Bin(x[0], x[1], x[2], n);
+
+            for (int q = 0; q < n; ++q)
+                particle.velocity += pOsc[ids[q]].evaluateGradient(x, t);
+        }
+        else
         {
-            particle.velocity += pOsc[q].evaluateGradient(particle.position, t);
+            for (unsigned long q = 0; q < oscillators.Size(); ++q)
+                particle.velocity += pOsc[q].evaluateGradient(particle.position, t);
         }
         // scale the gradient to get "units" right for velocity
         particle.velocity *= velocity_scale;
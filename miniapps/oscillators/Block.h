@@ -8,11 +8,14 @@
 #include <sdiy/point.hpp>
 
 #include "Oscillator.h"
+#include "OscillatorBins.h"
 #include "Particles.h"
 #include "Grid.h"
 
 #include <vector>
+#include <deque>
 #include <ostream>
+#include <functional>
 
 struct Block
 {
@@ -26,11 +29,21 @@ struct Block
                 grid(Vertex(&bounds.max[0]) - Vertex(&bounds.min[0]) + Vertex::one())
     {}
 
-    // update mesh based scalar and vector fields
-    void update_fields(float t, const OscillatorArray &oscillators);
+    // update mesh based scalar and vector fields. when the bins are enabled
+    // only nearby oscillators are evaluated
+    void update_fields(float t, const OscillatorArray &oscillators,
+        const OscillatorBins &bins);
 
-    // update particle based scalar and vector fields
-    void update_particles(float t, const OscillatorArray &oscillators);
+    // when in_use reports that the gridded data is still referenced, for
+    // instance by analyses executing asynchronously, swap in a buffer that is
+    // not, allocating one when all are in use. the fields are recomputed
+    // each step so the contents of the buffer do not matter
+    void swap_grid(const std::function<bool(const float*)> &in_use);
+
+    // update particle based scalar and vector fields. when the bins are
+    // enabled only nearby oscillators are evaluated
+    void update_particles(float t, const OscillatorArray &oscillators,
+        const OscillatorBins &bins);
 
     // update pareticle positions
     void move_particles(float dt, const sdiy::Master::ProxyWithLink& cp);
@@ -50,6 +63,7 @@ struct Block
     sdiy::Point<float,3>              spacing; // mesh spacing
     int                               nghost; // number of ghost zones
     oscillator::Grid<float,3>         grid;   // container for the gridded data arrays
+    std::deque<oscillator::Grid<float,3>> spare_grids; // buffers swapped with grid, their memory does not move
     std::vector<Particle>             particles;
 
  private:
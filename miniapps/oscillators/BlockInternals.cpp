@@ -1,5 +1,11 @@
 #include "BlockInternals.h"
 
+#include <svtkSMPTools.h>
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+
 namespace BlockInternals
 {
 #if defined(OSCILLATOR_CUDA)
@@ -50,43 +56,205 @@ void UpdateFields(
 
 namespace CPU
 {
-/// calculate oscillator contributions on the CPU
+/// oscillator parameters in structure of arrays layout. the time dependent
+/// amplitude, where the oscillator types differ, is evaluated once per update
+/// leaving only the Gaussian damping to be evaluated at each grid point.
+struct OscillatorSoA
+{
+    OscillatorSoA(const Oscillator *oscillators, int n, float t) :
+        cx(n), cy(n), cz(n), ninv2r2(n), amp(n)
+    {
+        for (int q = 0; q < n; ++q)
+        {
+            const Oscillator &o = oscillators[q];
+            cx[q] = o.center_x;
+            cy[q] = o.center_y;
+            cz[q] = o.center_z;
+            ninv2r2[q] = -1.f/(2.f*o.radius*o.radius);
+            amp[q] = o.amplitude(t);
+        }
+    }
+
+    std::vector<float> cx;
+    std::vector<float> cy;
+    std::vector<float> cz;
+    std::vector<float> ninv2r2;
+    std::vector<float> amp;
+};
+
+/// the smallest argument passed to vexp. points where the Gaussian is
+/// smaller than exp(minArg) are not evaluated.
+constexpr float minArg = -80.f;
+
+/// exp(x) for -87 <= x <= 0 using only arithmetic and conversions such that
+/// loops calling it are vectorized. the relative error is about 2e-7. the
+/// range is not checked, since a branch would prevent vectorization.
+inline float vexp(float x)
+{
+    // x = (n + f) ln 2, with n integer and |f| <= 1/2
+    float tn = x*1.44269504f;
+    int n = int(tn - 0.5f);
+    float y = (tn - float(n))*0.693147181f;
+
+    // exp(y) for |y| <= ln(2)/2
+    float p = 1.f + y*(1.f + y*(0.5f + y*(1.f/6.f + y*(1.f/24.f
+        + y*(1.f/120.f + y*(1.f/720.f))))));
+
+    // scale by 2^n
+    int bits = (n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(float));
+
+    return p*scale;
+}
+
+/// evaluates a range of k-slabs of the field
+struct UpdateFieldsFunctor
+{
+    /// accumulate the contribution of the listed oscillators to points
+    /// i0 through i1 of a row. with no list all oscillators are used.
+    void EvaluateRow(const int *ids, int n, float y, float z,
+        int i0, int i1, float *pd) const
+    {
+        const float *xs = this->X.data();
+        for (int qq = 0; qq < n; ++qq)
+        {
+            int q = ids ? ids[qq] : qq;
+
+            float dy = y - this->Osc->cy[q];
+            float dz = z - this->Osc->cz[q];
+            float nir = this->Osc->ninv2r2[q];
+            float dyz2 = dy*dy + dz*dz;
+
+            // the points of the row where the Gaussian is above exp(minArg)
+            float rx2 = minArg/nir - dyz2;
+            if (rx2 < 0.f)
+                continue;
+
+            float cx = this->Osc->cx[q];
+            float amp = this->Osc->amp[q];
+
+            float rx = std::sqrt(rx2);
+            float ilo = std::ceil((cx - rx - this->X0)/this->Dx);
+            float ihi = std::floor((cx + rx - this->X0)/this->Dx) + 1.f;
+            int ib = ilo > i0 ? (ilo < i1 ? int(ilo) : i1) : i0;
+            int ie = ihi < i1 ? (ihi > ib ? int(ihi) : ib) : i1;
+
+            for (int i = ib; i < ie; ++i)
+            {
+                float dx = xs[i] - cx;
+                pd[i] += amp*vexp((dx*dx + dyz2)*nir);
+            }
+        }
+    }
+
+    void operator()(int k0, int k1) const
+    {
+        int ni = this->Ni;
+        int nj = this->Nj;
+        long nij = long(ni)*nj;
+
+        for (int k = k0; k < k1; ++k)
+        {
+            float z = this->Z0 + this->Dz*(this->K0 + k);
+            float *pdk = this->Data + k*nij;
+            for (int j = 0; j < nj; ++j)
+            {
+                float y = this->Y0 + this->Dy*(this->J0 + j);
+                float *pd = pdk + j*ni;
+
+                for (int i = 0; i < ni; ++i)
+                    pd[i] = 0.f;
+
+                if (!this->Bins)
+                {
+                    this->EvaluateRow(nullptr, this->NumOscillators,
+                        y, z, 0, ni, pd);
+                    continue;
+                }
+
+                // evaluate runs of points that share a bin
+                int bj = this->Bins->Index(1, y);
+                int bk = this->Bins->Index(2, z);
+                const int *bi = this->BinI.data();
+                int i0 = 0;
+                while (i0 < ni)
+                {
+                    int i1 = i0 + 1;
+                    while ((i1 < ni) && (bi[i1] == bi[i0]))
+                        ++i1;
+
+                    int n = 0;
+                    const int *ids = this->Bins->Bin(bi[i0], bj, bk, n);
+                    this->EvaluateRow(ids, n, y, z, i0, i1, pd);
+
+                    i0 = i1;
+                }
+            }
+        }
+    }
+
+    const OscillatorSoA *Osc;
+    int NumOscillators;
+    const OscillatorBins *Bins;
+    std::vector<float> X;   // x coordinate of each point in a row
+    float X0, Dx;           // x = X0 + Dx*i
+    std::vector<int> BinI;  // bin index of each point in a row
+    int Ni, Nj;
+    int J0, K0;
+    float Y0, Z0;
+    float Dy, Dz;
+    float *Data;
+};
+
+/// calculate oscillator contributions on the CPU. when the bins are passed
+/// only the oscillators in the bin containing each point are evaluated. the
+/// work is split over k-slabs using SVTK's SMP backend.
 void UpdateFields(
   float t,
   const Oscillator *oscillators,
   int nOscillators,
+  const OscillatorBins *bins,
   int ni, int nj, int nk,
   int i0, int j0, int k0,
   float x0, float y0, float z0,
   float dx, float dy, float dz,
   float *pdata)
 {
-    int nij = ni*nj;
+    OscillatorSoA osc(oscillators, nOscillators, t);
 
-    for (int k = 0; k < nk; ++k)
+    UpdateFieldsFunctor func;
+    func.Osc = &osc;
+    func.NumOscillators = nOscillators;
+    func.Bins = bins;
+    func.X.resize(ni);
+    for (int i = 0; i < ni; ++i)
+        func.X[i] = x0 + dx*(i0 + i);
+    func.X0 = x0 + dx*i0;
+    func.Dx = dx;
+    if (bins)
     {
-        float z = z0 + dz*(k0 + k);
-        float *pdk = pdata + k*nij;
-        for (int j = 0; j < nj; ++j)
-        {
-            float y = y0 + dy*(j0 + j);
-            float *pd = pdk + j*ni;
-            for (int i = 0; i < ni; ++i)
-            {
-                float x = x0 + dx*(i0 + i);
-                pd[i] = 0.f;
-
-                for (int q = 0; q < nOscillators; ++q)
-                    pd[i] += oscillators[q].evaluate(x,y,z, t);
-            }
-        }
+        func.BinI.resize(ni);
+        for (int i = 0; i < ni; ++i)
+            func.BinI[i] = bins->Index(0, func.X[i]);
     }
+    func.Ni = ni;
+    func.Nj = nj;
+    func.J0 = j0;
+    func.K0 = k0;
+    func.Y0 = y0;
+    func.Z0 = z0;
+    func.Dy = dy;
+    func.Dz = dz;
+    func.Data = pdata;
+
+    svtkSMPTools::For(0, nk, 1, func);
 }
 }
 
 // **************************************************************************
 int UpdateFields(int deviceId, float t, const Oscillator *oscillators,
-  int nOscillators, int ni, int nj, int nk, int i0, int j0, int k0,
+  int nOscillators, const OscillatorBins *bins, int ni, int nj, int nk, int i0, int j0, int k0,
   float x0, float y0, float z0, float dx, float dy, float dz, float *pdata)
 {
   (void) deviceId;
@@ -100,7 +268,7 @@ int UpdateFields(int deviceId, float t, const Oscillator *oscillators,
 #endif
     // run on the CPU
     BlockInternals::CPU::UpdateFields(
-      t, oscillators, nOscillators,
+      t, oscillators, nOscillators, (bins && bins->Enabled() ? bins : nullptr),
       ni,nj,nk, i0,j0,k0, x0,y0,z0, dx,dy,dz, pdata);
 #if defined(OSCILLATOR_CUDA)
   }
@@ -4,15 +4,19 @@
 #include <senseiConfig.h>
 
 #include "Oscillator.h"
+#include "OscillatorBins.h"
 
 namespace BlockInternals
 {
-/// dispatch the calculations to the requested device
+/// dispatch the calculations to the requested device. when bins are passed
+/// and enabled only the oscillators in the bin containing each grid point
+/// are evaluated. bins are used on the CPU only.
 int UpdateFields(
   int deviceId,
   float t,
   const Oscillator *oscillators,
   int nOscillators,
+  const OscillatorBins *bins,
   int ni, int nj, int nk,
   int i0, int j0, int k0,
   float x0, float y0, float z0,
@@ -1,18 +1,20 @@
 #include "DataAdaptor.h"
 #include "MeshMetadata.h"
+#include "SVTKObjectPool.h"
 #include "Error.h"
 
 #include <svtkCellArray.h>
 #include <svtkCellData.h>
 #include <svtkPointData.h>
+#include <svtkDoubleArray.h>
 #include <svtkFloatArray.h>
-#include <svtkIdTypeArray.h>
 #include <svtkIntArray.h>
 #include <svtkImageData.h>
 #include <svtkMultiBlockDataSet.h>
 #include <svtkObjectFactory.h>
 #include <svtkPoints.h>
 #include <svtkSmartPointer.h>
+#include <svtkTypeInt64Array.h>
 #include <svtkUnsignedCharArray.h>
 #include <svtkUnstructuredGrid.h>
 #include <svtkPolyData.h>
@@ -60,11 +62,11 @@ void getBlockExtent(const sdiy::DiscreteBounds &db, int *ext)
 }
 
 static
-svtkImageData *newCartesianBlock(double *origin,
+svtkImageData *newCartesianBlock(sensei::SVTKObjectPool &pool, double *origin,
   double *spacing, const sdiy::DiscreteBounds &cellExts,
   bool structureOnly)
 {
-  svtkImageData *id = svtkImageData::New();
+  svtkImageData *id = pool.NewObject<svtkImageData>();
 
   if (!structureOnly)
     {
@@ -79,11 +81,11 @@ svtkImageData *newCartesianBlock(double *origin,
 }
 
 static
-svtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
-  const double *spacing, const sdiy::DiscreteBounds &cellExts,
-  bool structureOnly)
+svtkUnstructuredGrid *newUnstructuredBlock(sensei::SVTKObjectPool &pool,
+  const double *origin, const double *spacing,
+  const sdiy::DiscreteBounds &cellExts, bool structureOnly)
 {
-  svtkUnstructuredGrid *ug = svtkUnstructuredGrid::New();
+  svtkUnstructuredGrid *ug = pool.NewObject<svtkUnstructuredGrid>();
 
   if (!structureOnly)
     {
@@ -92,11 +94,8 @@ svtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
     int ny = cellExts.max[1] - cellExts.min[1] + 1 + 1;
     int nz = cellExts.max[2] - cellExts.min[2] + 1 + 1;
 
-    svtkPoints *pts = svtkPoints::New();
-    pts->SetDataTypeToDouble();
-    pts->SetNumberOfPoints(nx*ny*nz);
-
-    svtkIdType idx = 0;
+    svtkDoubleArray *coords = pool.NewArray<svtkDoubleArray>(3, nx*ny*nz);
+    double *pc = coords->GetPointer(0);
 
     for(int k = cellExts.min[2]; k <= cellExts.max[2]+1; ++k)
       {
@@ -107,11 +106,19 @@ svtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
         for(int i = cellExts.min[0]; i <= cellExts.max[0]+1; ++i)
           {
           double x = origin[0] + spacing[0]*i;
-          pts->SetPoint(idx++, x,y,z);
+          pc[0] = x;
+          pc[1] = y;
+          pc[2] = z;
+          pc += 3;
           }
         }
       }
 
+    svtkPoints *pts = svtkPoints::New();
+    pts->SetDataTypeToDouble();
+    pts->SetData(coords);
+    coords->Delete();
+
     ug->SetPoints(pts);
     pts->Delete();
 
@@ -121,18 +128,17 @@ svtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
     int ncz = nz - 1;
     svtkIdType ncells = ncx*ncy*ncz;
 
-    svtkIdTypeArray *nlist = svtkIdTypeArray::New();
-    nlist->SetNumberOfValues(ncells * 8);
+    svtkTypeInt64Array *nlist = pool.NewArray<svtkTypeInt64Array>(1, ncells*8);
 
-    svtkUnsignedCharArray *cellTypes = svtkUnsignedCharArray::New();
-    cellTypes->SetNumberOfValues(ncells);
+    svtkUnsignedCharArray *cellTypes =
+      pool.NewArray<svtkUnsignedCharArray>(1, ncells);
 
-    svtkIdTypeArray *cellLocations = svtkIdTypeArray::New();
-    cellLocations->SetNumberOfValues(ncells + 1);
+    svtkTypeInt64Array *cellLocations =
+      pool.NewArray<svtkTypeInt64Array>(1, ncells + 1);
 
-    svtkIdType *nl = nlist->GetPointer(0);
+    svtkTypeInt64 *nl = nlist->GetPointer(0);
     unsigned char *ct = cellTypes->GetPointer(0);
-    svtkIdType *cl = cellLocations->GetPointer(0);
+    svtkTypeInt64 *cl = cellLocations->GetPointer(0);
     int nxny = nx*ny;
     int offset = 0;
     for(int k = 0; k < ncz; ++k)
@@ -174,26 +180,45 @@ svtkUnstructuredGrid *newUnstructuredBlock(const double *origin,
 }
 
 static
-svtkPolyData *newParticleBlock(const std::vector<Particle> *particles,
-  bool structureOnly)
+svtkPolyData *newParticleBlock(sensei::SVTKObjectPool &pool,
+  const std::vector<Particle> *particles, bool structureOnly)
 {
-  svtkPolyData *block = svtkPolyData::New();
+  svtkPolyData *block = pool.NewObject<svtkPolyData>();
 
   if (structureOnly)
     return block;
 
-  svtkNew<svtkPoints> points;
-  svtkNew<svtkCellArray> cells;
-  points->Allocate(particles->size());
-  cells->Allocate(particles->size());
+  svtkIdType np = particles->size();
+
+  svtkFloatArray *coords = pool.NewArray<svtkFloatArray>(3, np);
+  svtkTypeInt64Array *offsets = pool.NewArray<svtkTypeInt64Array>(1, np + 1);
+  svtkTypeInt64Array *conn = pool.NewArray<svtkTypeInt64Array>(1, np);
+
+  float *pc = coords->GetPointer(0);
+  svtkTypeInt64 *po = offsets->GetPointer(0);
+  svtkTypeInt64 *pcn = conn->GetPointer(0);
 
-  svtkIdType pointId = 0;
-  for (const auto &p : *particles)
+  // one vertex per particle
+  for (svtkIdType i = 0; i < np; ++i)
     {
-    points->InsertNextPoint(p.position[0], p.position[1], p.position[2]);
-    cells->InsertNextCell(1, &pointId);
-    ++pointId;
+    const Particle &p = (*particles)[i];
+    pc[3*i] = p.position[0];
+    pc[3*i+1] = p.position[1];
+    pc[3*i+2] = p.position[2];
+    po[i] = i;
+    pcn[i] = i;
     }
+  po[np] = np;
+
+  svtkNew<svtkPoints> points;
+  points->SetData(coords);
+  coords->Delete();
+
+  svtkNew<svtkCellArray> cells;
+  cells->SetData(offsets, conn);
+  offsets->Delete();
+  conn->Delete();
+
   block->SetPoints(points.Get());
   block->SetVerts(cells.Get());
 
@@ -201,14 +226,16 @@ svtkPolyData *newParticleBlock(const std::vector<Particle> *particles,
 }
 
 static
-int newParticleArray(const std::vector<Particle> &particles,
-  const std::string &arrayName, svtkFloatArray *&fa)
+int newParticleArray(sensei::SVTKObjectPool &pool,
+  const std::vector<Particle> &particles, const std::string &arrayName,
+  svtkFloatArray *&fa)
 {
   enum {PID, VEL, VELMAG};
 
-  fa = svtkFloatArray::New();
+  fa = nullptr;
 
   int aid = PID;
+  int nComps = 1;
   if (arrayName == "pid")
     {
     aid = PID;
@@ -216,7 +243,7 @@ int newParticleArray(const std::vector<Particle> &particles,
   else if (arrayName == "velocity")
     {
     aid = VEL;
-    fa->SetNumberOfComponents(3);
+    nComps = 3;
     }
   else if (arrayName == "velocityMagnitude")
     {
@@ -230,8 +257,8 @@ int newParticleArray(const std::vector<Particle> &particles,
 
   unsigned int np = particles.size();
 
+  fa = pool.NewArray<svtkFloatArray>(nComps, np);
   fa->SetName(arrayName.c_str());
-  fa->SetNumberOfTuples(np);
 
   float *pfa = fa->GetPointer(0);
 
@@ -262,8 +289,8 @@ int newParticleArray(const std::vector<Particle> &particles,
 }
 
 static
-svtkUnsignedCharArray *newGhostCellsArray(int *shape,
-  sdiy::DiscreteBounds &cellExt, int ng)
+svtkUnsignedCharArray *newGhostCellsArray(sensei::SVTKObjectPool &pool,
+  int *shape, sdiy::DiscreteBounds &cellExt, int ng)
 {
     // This sim is a:lways 3D.
     int imin = cellExt.min[0];
@@ -278,8 +305,7 @@ svtkUnsignedCharArray *newGhostCellsArray(int *shape,
     int nxny = nx*ny;
     int ncells = nx*ny*nz;
 
-    svtkUnsignedCharArray *g = svtkUnsignedCharArray::New();
-    g->SetNumberOfTuples(ncells);
+    svtkUnsignedCharArray *g = pool.NewArray<svtkUnsignedCharArray>(1, ncells);
     memset(g->GetVoidPointer(0), 0, sizeof(unsigned char) * ncells);
     g->SetName("svtkGhostType");
     unsigned char *gptr = (unsigned char *)g->GetVoidPointer(0);
@@ -348,11 +374,13 @@ struct DataAdaptor::InternalsType
 
   using BlockExtentMap = std::map<long, sdiy::DiscreteBounds>;
   using BlockDataMap = std::map<long, float*>;
+  using BlockArrayMap = std::map<long, std::map<const float*, svtkSmartPointer<svtkFloatArray>>>;
 
   long NumBlocks;                                    // total number of blocks on all ranks
   sdiy::DiscreteBounds DomainExtent;                 // global index space
   BlockExtentMap BlockExtents;                       // local block extents, indexed by global block id
   BlockDataMap BlockData;                            // local data array, indexed by block id
+  BlockArrayMap BlockArrays;                         // zero copy arrays passed to the analyses, indexed by block id and memory
   std::map<long, const std::vector<Particle>*> ParticleData;
   OscillatorArray Oscillators;                       // global list of oscillators
 
@@ -361,6 +389,8 @@ struct DataAdaptor::InternalsType
 
   int Shape[3];
   int NumGhostCells;                                 // number of ghost cells
+
+  sensei::SVTKObjectPool Pool;                       // recycles meshes across steps
 };
 
 //-----------------------------------------------------------------------------
@@ -408,6 +438,18 @@ void DataAdaptor::Initialize(size_t nblocks, size_t n_local_blocks,
     }
 }
 
+//-----------------------------------------------------------------------------
+void DataAdaptor::SetUseObjectPool(bool useObjectPool)
+{
+  this->Internals->Pool.SetEnabled(useObjectPool);
+}
+
+//-----------------------------------------------------------------------------
+bool DataAdaptor::GetUseObjectPool() const
+{
+  return this->Internals->Pool.GetEnabled();
+}
+
 //-----------------------------------------------------------------------------
 void DataAdaptor::SetBlockExtent(int gid, int xmin, int xmax, int ymin,
    int ymax, int zmin, int zmax)
@@ -438,6 +480,39 @@ void DataAdaptor::SetDomainExtent(int xmin, int xmax, int ymin,
 void DataAdaptor::SetBlockData(int gid, float* data)
 {
   this->Internals->BlockData[gid] = data;
+
+  // the same array is passed to the analyses each time the memory is, so
+  // that its reference count tells if the analyses are done with it
+  svtkSmartPointer<svtkFloatArray> &fa = this->Internals->BlockArrays[gid][data];
+  if (!fa)
+    {
+    svtkIdType nCells = getBlockNumCells(this->Internals->BlockExtents[gid]);
+
+    fa = svtkSmartPointer<svtkFloatArray>::New();
+    fa->SetName("data");
+    fa->SetArray(data, nCells, 1);
+    }
+
+  // the contents were updated in place
+  fa->Modified();
+}
+
+//-----------------------------------------------------------------------------
+bool DataAdaptor::GetBlockDataInUse(int gid, const float *data)
+{
+  InternalsType::BlockArrayMap::iterator bit = this->Internals->BlockArrays.find(gid);
+  if (bit == this->Internals->BlockArrays.end())
+    return false;
+
+  auto ait = bit->second.find(data);
+  if (ait == bit->second.end())
+    return false;
+
+  // pooled meshes released by the analyses still hold their arrays until
+  // they are recycled
+  this->Internals->Pool.Recycle();
+
+  return ait->second->GetReferenceCount() > 1;
 }
 
 //-----------------------------------------------------------------------------
@@ -466,7 +541,9 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
     return -1;
     }
 
-  svtkMultiBlockDataSet *mb = svtkMultiBlockDataSet::New();
+  sensei::SVTKObjectPool &pool = this->Internals->Pool;
+
+  svtkMultiBlockDataSet *mb = pool.NewObject<svtkMultiBlockDataSet>();
   mesh = mb;
 
   if (meshName == "oscillators")
@@ -480,16 +557,22 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
       {
       size_t numPts = this->Internals->Oscillators.Size();
 
-      svtkPolyData *pd = svtkPolyData::New();
+      svtkPolyData *pd = pool.NewObject<svtkPolyData>();
 
-      svtkPoints *pts = svtkPoints::New();
-      pts->SetDataTypeToFloat();
-      pts->SetNumberOfPoints(numPts);
+      svtkFloatArray *coords = pool.NewArray<svtkFloatArray>(3, numPts);
+      float *pc = coords->GetPointer(0);
       for (size_t cc=0; cc < numPts; ++cc)
       {
         const Oscillator &o = this->Internals->Oscillators[cc];
-        pts->SetPoint(cc, o.center_x, o.center_y, o.center_z);
+        pc[3*cc] = o.center_x;
+        pc[3*cc+1] = o.center_y;
+        pc[3*cc+2] = o.center_z;
       }
+
+      svtkPoints *pts = svtkPoints::New();
+      pts->SetData(coords);
+      coords->Delete();
+
       pd->SetPoints(pts);
       pts->Delete();
 
@@ -512,7 +595,7 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
       if (particleBlocks)
         {
         svtkPolyData *pd =
-          newParticleBlock(this->Internals->ParticleData[it->first],
+          newParticleBlock(pool, this->Internals->ParticleData[it->first],
           structureOnly);
 
         mb->SetBlock(it->first, pd);
@@ -520,15 +603,16 @@ int DataAdaptor::GetMesh(const std::string &meshName, bool structureOnly,
         }
       else if (unstructuredBlocks)
         {
-        svtkUnstructuredGrid *ug = newUnstructuredBlock(this->Internals->Origin,
-          this->Internals->Spacing, it->second, structureOnly);
+        svtkUnstructuredGrid *ug = newUnstructuredBlock(pool,
+          this->Internals->Origin, this->Internals->Spacing, it->second,
+          structureOnly);
 
         mb->SetBlock(it->first, ug);
         ug->Delete();
         }
       else
         {
-        svtkImageData *id = newCartesianBlock(this->Internals->Origin,
+        svtkImageData *id = newCartesianBlock(pool, this->Internals->Origin,
           this->Internals->Spacing, it->second, structureOnly);
 
         mb->SetBlock(it->first, id);
@@ -563,8 +647,7 @@ int DataAdaptor::AddArray(svtkDataObject* mesh, const std::string &meshName,
 
       if (arrayName == "radius")
         {
-        svtkFloatArray *radius = svtkFloatArray::New();
-        radius->SetNumberOfTuples(numPts);
+        svtkFloatArray *radius = this->Internals->Pool.NewArray<svtkFloatArray>(1, numPts);
         radius->SetName("radius");
         pd->GetPointData()->AddArray(radius);
         radius->Delete();
@@ -577,8 +660,7 @@ int DataAdaptor::AddArray(svtkDataObject* mesh, const std::string &meshName,
 
       if (arrayName == "omega0")
         {
-        svtkFloatArray *omega0 = svtkFloatArray::New();
-        omega0->SetNumberOfTuples(numPts);
+        svtkFloatArray *omega0 = this->Internals->Pool.NewArray<svtkFloatArray>(1, numPts);
         omega0->SetName("omega0");
         pd->GetPointData()->AddArray(omega0);
         omega0->Delete();
@@ -591,8 +673,7 @@ int DataAdaptor::AddArray(svtkDataObject* mesh, const std::string &meshName,
 
       if (arrayName == "zeta")
         {
-        svtkFloatArray *zeta = svtkFloatArray::New();
-        zeta->SetNumberOfTuples(numPts);
+        svtkFloatArray *zeta = this->Internals->Pool.NewArray<svtkFloatArray>(1, numPts);
         zeta->SetName("zeta");
         pd->GetPointData()->AddArray(zeta);
         zeta->Delete();
@@ -605,8 +686,7 @@ int DataAdaptor::AddArray(svtkDataObject* mesh, const std::string &meshName,
 
       if (arrayName == "type")
         {
-        svtkIntArray *type = svtkIntArray::New();
-        type->SetNumberOfTuples(numPts);
+        svtkIntArray *type = this->Internals->Pool.NewArray<svtkIntArray>(1, numPts);
         type->SetName("type");
         pd->GetPointData()->AddArray(type);
         type->Delete();
@@ -673,17 +753,17 @@ int DataAdaptor::AddArray(svtkDataObject* mesh, const std::string &meshName,
       if (meshId == BLOCK)
         {
         dsa = blk->GetAttributes(svtkDataObject::CELL);
-        svtkIdType nCells = getBlockNumCells(this->Internals->BlockExtents[it->first]);
 
-        // zero coopy the array
-        fa = svtkFloatArray::New();
-        fa->SetName("data");
-        fa->SetArray(it->second, nCells, 1);
+        // zero copy the array
+        fa = this->Internals->BlockArrays[it->first][it->second];
+        fa->Register(nullptr);
         }
       else
         {
         dsa = blk->GetAttributes(svtkDataObject::POINT);
-        newParticleArray(*this->Internals->ParticleData[it->first], arrayName, fa);
+        if (newParticleArray(this->Internals->Pool,
+          *this->Internals->ParticleData[it->first], arrayName, fa))
+          return -1;
         }
 
       dsa->AddArray(fa);
@@ -715,8 +795,8 @@ int DataAdaptor::AddGhostCellsArray(svtkDataObject *mesh, const std::string &mes
 
   if (meshName == "oscillators")
     {
-    svtkUnsignedCharArray *gh = svtkUnsignedCharArray::New();
-    gh->SetNumberOfTuples(Internals->Oscillators.Size());
+    svtkUnsignedCharArray *gh = this->Internals->Pool.NewArray<
+      svtkUnsignedCharArray>(1, this->Internals->Oscillators.Size());
     gh->Fill(0);
     gh->SetName("svtkGhostType");
 
@@ -743,8 +823,8 @@ int DataAdaptor::AddGhostCellsArray(svtkDataObject *mesh, const std::string &mes
 
       svtkDataSetAttributes *dsa = blk->GetAttributes(svtkDataObject::CELL);
 
-      svtkUnsignedCharArray *ga = newGhostCellsArray(this->Internals->Shape,
-        it->second, this->Internals->NumGhostCells);
+      svtkUnsignedCharArray *ga = newGhostCellsArray(this->Internals->Pool,
+        this->Internals->Shape, it->second, this->Internals->NumGhostCells);
 
       dsa->AddArray(ga);
       ga->Delete();
@@ -975,6 +1055,8 @@ int DataAdaptor::GetMeshMetadata(unsigned int id, sensei::MeshMetadataPtr &metad
 //-----------------------------------------------------------------------------
 int DataAdaptor::ReleaseData()
 {
+  // meshes no longer in use by the analyses are reused in the next step
+  this->Internals->Pool.Recycle();
   return 0;
 }
 
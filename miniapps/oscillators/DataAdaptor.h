@@ -35,15 +35,28 @@ public:
   void SetDomainExtent(int xmin, int xmax, int ymin, int ymax,
     int zmin, int zmax);
 
-  /// Set data for a specific block.
+  /// Set data for a specific block. The array passed to the analyses
+  /// references this memory.
   void SetBlockData(int gid, float* data);
 
+  /// Returns true while the analyses reference the block data passed
+  /// earlier in the given memory, for instance when they execute
+  /// asynchronously on zero-copy snapshots. The simulation must not modify
+  /// the memory until this returns false.
+  bool GetBlockDataInUse(int gid, const float *data);
+
   /// Set particles for a specific block
   void SetParticleData(int gid, const std::vector<Particle> &particles);
 
   /// Set the list of oscillators
   void SetOscillators(const OscillatorArray &oscillators);
 
+  /// Recycle the SVTK objects and arrays of the meshes across time steps.
+  /// Meshes that are released by the analyses are reused in the next step
+  /// rather than allocated again. Disabled by default.
+  void SetUseObjectPool(bool useObjectPool);
+  bool GetUseObjectPool() const;
+
   // SENSEI API
   int GetNumberOfMeshes(unsigned int &numMeshes) override;
 
@@ -21,31 +21,40 @@ struct Oscillator
 #endif
     float evaluate(float vx, float vy, float vz, float t) const
     {
-        t *= 2.f*pi;
-
         float dist_x = center_x - vx;
         float dist_y = center_y - vy;
         float dist_z = center_z - vz;
         float dist2 = dist_x*dist_x + dist_y*dist_y + dist_z*dist_z;
         float dist_damp = exp(-dist2/(2.f*radius*radius));
+        return amplitude(t) * dist_damp;
+    }
+
+    /// the time dependent part of the oscillator, which is independent of
+    /// position. evaluate is this damped by the distance from the center.
+#if defined(OSCILLATOR_CUDA)
+    __host__ __device__
+#endif
+    float amplitude(float t) const
+    {
+        t *= 2.f*pi;
 
         if (type == damped)
         {
             float phi   = acos(zeta);
             float val   = 1.f - exp(-zeta*omega0*t) * (sin(sqrt(1.f-zeta*zeta)*omega0*t + phi) / sin(phi));
-            return val * dist_damp;
+            return val;
         }
         else if (type == decaying)
         {
             t += 1.f / omega0;
             float val = sin(t / omega0) / (omega0 * t);
-            return val * dist_damp;
+            return val;
         }
         else if (type == periodic)
         {
             t += 1.f / omega0;
             float val = sin(t / omega0);
-            return val * dist_damp;
+            return val;
         }
         else
         {
@@ -0,0 +1,111 @@
+#include "OscillatorBins.h"
+
+#include <algorithm>
+
+namespace
+{
+// the largest number of bins along an axis
+constexpr int maxBinsPerAxis = 128;
+}
+
+// --------------------------------------------------------------------------
+void OscillatorBins::Clear()
+{
+    mTolerance = 0.f;
+    for (int i = 0; i < 3; ++i)
+    {
+        mDims[i] = 0;
+        mOrigin[i] = 0.f;
+        mInvWidth[i] = 0.f;
+    }
+    mOffsets.clear();
+    mIds.clear();
+}
+
+// --------------------------------------------------------------------------
+void OscillatorBins::Initialize(const OscillatorArray &oscillators,
+    const sdiy::Bounds<float> &bounds, float tol)
+{
+    Clear();
+
+    unsigned long nOsc = oscillators.Size();
+    if ((tol <= 0.f) || (tol >= 1.f) || (nOsc == 0))
+        return;
+
+    mTolerance = tol;
+
+    // the distance beyond which the gaussian falls below the tolerance
+    float cutoff = std::sqrt(-2.f*std::log(tol));
+
+    // size the bins by the mean cutoff radius. any size gives the same
+    // result, this balances the number of bins an oscillator is placed in
+    // against the number of oscillators evaluated per point
+    float meanRc = 0.f;
+    for (unsigned long q = 0; q < nOsc; ++q)
+        meanRc += cutoff*oscillators[q].radius;
+    meanRc /= nOsc;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        float ext = bounds.max[i] - bounds.min[i];
+
+        mOrigin[i] = bounds.min[i];
+        mDims[i] = (ext > 0.f) && (meanRc > 0.f) ?
+            std::min(maxBinsPerAxis, std::max(1, int(std::ceil(ext/meanRc)))) : 1;
+        mInvWidth[i] = ext > 0.f ? mDims[i]/ext : 0.f;
+    }
+
+    long nBins = long(mDims[0])*mDims[1]*mDims[2];
+
+    // the range of bins overlapped by the bounding box of each
+    // oscillator's cutoff sphere
+    std::vector<int> ranges(6*nOsc);
+    for (unsigned long q = 0; q < nOsc; ++q)
+    {
+        const Oscillator &o = oscillators[q];
+        float rc = cutoff*o.radius;
+        float c[3] = {o.center_x, o.center_y, o.center_z};
+        int *r = ranges.data() + 6*q;
+        for (int i = 0; i < 3; ++i)
+        {
+            r[2*i] = Index(i, c[i] - rc);
+            r[2*i+1] = Index(i, c[i] + rc);
+        }
+    }
+
+    // count the oscillators in each bin
+    mOffsets.assign(nBins + 1, 0);
+    for (unsigned long q = 0; q < nOsc; ++q)
+    {
+        const int *r = ranges.data() + 6*q;
+        for (int k = r[4]; k <= r[5]; ++k)
+            for (int j = r[2]; j <= r[3]; ++j)
+                for (int i = r[0]; i <= r[1]; ++i)
+                    mOffsets[(k*mDims[1] + j)*mDims[0] + i + 1] += 1;
+    }
+
+    for (long b = 0; b < nBins; ++b)
+        mOffsets[b+1] += mOffsets[b];
+
+    // fill in the ids. oscillators are visited in order so that within a
+    // bin they are summed in the same order as when all are evaluated
+    mIds.resize(mOffsets[nBins]);
+    std::vector<int> pos(mOffsets.begin(), mOffsets.end() - 1);
+    for (unsigned long q = 0; q < nOsc; ++q)
+    {
+        const int *r = ranges.data() + 6*q;
+        for (int k = r[4]; k <= r[5]; ++k)
+            for (int j = r[2]; j <= r[3]; ++j)
+                for (int i = r[0]; i <= r[1]; ++i)
+                    mIds[pos[(k*mDims[1] + j)*mDims[0] + i]++] = q;
+    }
+}
+
+// --------------------------------------------------------------------------
+float OscillatorBins::MeanOccupancy() const
+{
+    if (mOffsets.size() < 2)
+        return 0.f;
+
+    return float(mOffsets.back())/(mOffsets.size() - 1);
+}
@@ -0,0 +1,82 @@
+#ifndef OscillatorBins_h
+#define OscillatorBins_h
+
+#include "Oscillator.h"
+
+#include <sdiy/types.hpp>
+
+#include <vector>
+#include <cmath>
+
+/// bins oscillators into a uniform grid so that only the nearby ones are
+/// evaluated at a point
+/** An oscillator's contribution is damped by exp(-d^2/(2 r^2)) and falls
+ * below tol times its amplitude beyond the cutoff radius r sqrt(-2 ln tol).
+ * Each oscillator is placed in every bin overlapped by the bounding box of
+ * its cutoff sphere, hence the list of oscillators in a bin includes all of
+ * those that contribute more than the tolerance anywhere in the bin. Points
+ * outside of the binned bounds are served by the nearest bin, which is exact
+ * since bin indices are clamped the same way when binning.
+ *
+ * The bins are stored in compressed row format, the oscillator ids of bin b
+ * are mIds[mOffsets[b]] through mIds[mOffsets[b+1]-1], in ascending order.
+ */
+class OscillatorBins
+{
+public:
+    OscillatorBins() : mTolerance(0.f), mDims{0,0,0},
+        mOrigin{0.f,0.f,0.f}, mInvWidth{0.f,0.f,0.f} {}
+
+    /// bin the oscillators over the given world space bounds. a tolerance
+    /// of 0 disables binning, in which case all oscillators are evaluated
+    /// everywhere.
+    void Initialize(const OscillatorArray &oscillators,
+        const sdiy::Bounds<float> &bounds, float tol);
+
+    /// release the bins
+    void Clear();
+
+    /// true when the oscillators have been binned
+    bool Enabled() const { return !mOffsets.empty(); }
+
+    /// the tolerance used to compute cutoff radii
+    float Tolerance() const { return mTolerance; }
+
+    /// the number of bins along each axis
+    const int *Dims() const { return mDims; }
+
+    /// the average number of oscillators per bin
+    float MeanOccupancy() const;
+
+    /// the index along the given axis of the bin containing x
+    int Index(int axis, float x) const
+    {
+        int i = int(std::floor((x - mOrigin[axis])*mInvWidth[axis]));
+        return i < 0 ? 0 : (i >= mDims[axis] ? mDims[axis] - 1 : i);
+    }
+
+    /// get the ids of the oscillators in bin i,j,k
+    const int *Bin(int i, int j, int k, int &n) const
+    {
+        int b = (k*mDims[1] + j)*mDims[0] + i;
+        int o = mOffsets[b];
+        n = mOffsets[b+1] - o;
+        return mIds.data() + o;
+    }
+
+    /// get the ids of the oscillators in the bin containing x,y,z
+    const int *Bin(float x, float y, float z, int &n) const
+    {
+        return Bin(Index(0, x), Index(1, y), Index(2, z), n);
+    }
+
+private:
+    float               mTolerance;
+    int                 mDims[3];
+    float               mOrigin[3];
+    float               mInvWidth[3];
+    std::vector<int>    mOffsets;
+    std::vector<int>    mIds;
+};
+
+#endif
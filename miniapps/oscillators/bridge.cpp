@@ -21,7 +21,7 @@ int initialize(size_t nblocks, size_t n_local_blocks,
   float *origin, float *spacing, int domain_shape_x, int domain_shape_y,
   int domain_shape_z, int *gid, int *from_x, int *from_y, int *from_z,
   int *to_x, int *to_y, int *to_z, int *shape, int ghostLevels,
-  const std::string &config_file)
+  const std::string &config_file, bool pool_meshes)
 {
   TimeEvent<128> event("bridge::initialize");
 
@@ -31,6 +31,8 @@ int initialize(size_t nblocks, size_t n_local_blocks,
     domain_shape_x, domain_shape_y, domain_shape_z, gid, from_x, from_y,
     from_z, to_x, to_y, to_z, shape, ghostLevels);
 
+  DataAdaptor->SetUseObjectPool(pool_meshes);
+
   AnalysisAdaptor = svtkSmartPointer<sensei::ConfigurableAnalysis>::New();
   if (AnalysisAdaptor->Initialize(config_file))
     {
@@ -59,6 +61,12 @@ void set_oscillators(const OscillatorArray &oscillators)
   DataAdaptor->SetOscillators(oscillators);
 }
 
+//-----------------------------------------------------------------------------
+bool data_in_use(int gid, const float *data)
+{
+  return DataAdaptor->GetBlockDataInUse(gid, data);
+}
+
 //-----------------------------------------------------------------------------
 void execute(long step, float time, sensei::DataAdaptor **dataOut)
 {
@@ -13,11 +13,14 @@ namespace sensei { class DataAdaptor; }
 
 namespace bridge
 {
-  /// initialize for in situ processing using SENSEI
+  /// initialize for in situ processing using SENSEI. when pool_meshes is
+  /// set the SVTK objects and arrays passed to the analyses are recycled
+  /// across time steps
   int initialize(size_t nblocks, size_t n_local_blocks, float *origin,
     float *spacing, int domain_shape_x, int domain_shape_y, int domain_shape_z,
     int *gid, int *from_x, int *from_y, int *from_z, int *to_x, int *to_y,
-    int *to_z, int *shape, int ghostLevels, const std::string &config_file);
+    int *to_z, int *shape, int ghostLevels, const std::string &config_file,
+    bool pool_meshes);
 
   /// pass the grid based array for the block identified by gid
   void set_data(int gid, float* data);
@@ -28,6 +31,12 @@ namespace bridge
   /// pass the list of oscillators
   void set_oscillators(const OscillatorArray &oscilators);
 
+  /// returns true while the analyses reference the grid based array passed
+  /// by set_data in the given memory, for instance when they execute
+  /// asynchronously on zero-copy snapshots. the simulation must not modify
+  /// the memory until this returns false
+  bool data_in_use(int gid, const float *data);
+
   /// invoke in situ processing
   void execute(long step, float time, sensei::DataAdaptor **dataOut);
 
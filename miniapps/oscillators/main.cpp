@@ -1,7 +1,12 @@
 #include <vector>
+#include <set>
 #include <chrono>
 #include <ctime>
 #include <memory>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <algorithm>
 
 #include <opts/opts.h>
 
@@ -13,6 +18,7 @@
 #include <sdiy/point.hpp>
 
 #include "Oscillator.h"
+#include "OscillatorBins.h"
 #include "Particles.h"
 #include "Block.h"
 
@@ -27,6 +33,9 @@
 
 #include <Profiler.h>
 #include <DataAdaptor.h>
+#include <MemoryProfiler.h>
+
+#include <svtkSMPTools.h>
 
 using sensei::Profiler;
 using sensei::TimeEvent;
@@ -69,11 +78,14 @@ int main(int argc, char** argv)
     size_t                      k_max     = 3;
 #endif
     int                         threads   = 1;
+    int                         kernelThreads = 0;
     int                         ghostCells = 1;
     int                         numberOfParticles = 0;
     int                         seed = 0x240dc6a9;
+    float                       cutoffTol = 0.0f;
     std::string                 config_file;
     std::string                 out_prefix = "";
+    std::string                 particles_out = "";
     Bounds                      bounds{0.,-1.,0.,-1.,0.,-1.};
 
     Options ops(argc, argv);
@@ -90,13 +102,20 @@ int main(int argc, char** argv)
 #endif
         >> Option(     "t-end",  t_end,     "end time")
         >> Option('j', "jobs",   threads,   "number of threads to use")
+        >> Option(     "kernel-threads", kernelThreads, "number of threads used by the field update within a block. 0 uses the SMP backend's default")
         >> Option('o', "output", out_prefix, "prefix to save output")
         >> Option('g', "ghost-cells", ghostCells, "number of ghost cells")
         >> Option('p', "particles", numberOfParticles, "number of random particles to generate")
+        >> Option(     "particles-out", particles_out, "file to write the final particle positions to, sorted by id")
         >> Option('v', "v-scale", velocity_scale, "scale factor to convert function gradient to velocity")
         >> Option(     "seed", seed, "specify a random seed")
+        >> Option(     "cutoff-tol", cutoffTol, "evaluate only oscillators whose contribution exceeds this fraction of their amplitude. 0 evaluates all")
     ;
     bool sync = ops >> Present("sync", "synchronize after each time step");
+    bool asyncParticles = ops >> Present("async-particles", "migrate particles with a non-blocking exchange overlapped with the field update");
+#ifdef ENABLE_SENSEI
+    bool poolMeshes = ops >> Present("pool-meshes", "recycle the SVTK objects and arrays passed to in situ analysis across time steps");
+#endif
     bool verbose = ops >> Present("verbose", "print debugging messages");
 
     std::string infn;
@@ -150,6 +169,9 @@ int main(int argc, char** argv)
         rng(); // different seed for each rank
 
 
+    // threads used within a block by the field update
+    svtkSMPTools::Initialize(kernelThreads);
+
     // read the oscillators from disk
     OscillatorArray oscillators;
     oscillators.Initialize(comm, infn);
@@ -238,6 +260,19 @@ int main(int argc, char** argv)
                    },
                    share_face, wrap, ghosts);
 
+    // bin the oscillators so that only nearby ones are evaluated
+    sdiy::Bounds<float> world_bounds = world_space_bounds(domain, origin, spacing);
+
+    OscillatorBins bins;
+    bins.Initialize(oscillators, world_bounds, cutoffTol);
+
+    if (verbose && (comm.rank() == 0) && bins.Enabled())
+    {
+      std::cerr << "oscillators binned on a " << bins.Dims()[0] << " x "
+        << bins.Dims()[1] << " x " << bins.Dims()[2] << " grid with "
+        << bins.MeanOccupancy() << " oscillators per bin" << std::endl;
+    }
+
     Profiler::EndEvent("oscillators::initialize");
 
 #ifdef ENABLE_SENSEI
@@ -249,10 +284,17 @@ int main(int argc, char** argv)
                        &from_x[0], &from_y[0], &from_z[0],
                        &to_x[0],   &to_y[0],   &to_z[0],
                        &shape[0], ghostCells,
-                       config_file);
+                       config_file, poolMeshes);
     }
 #endif
 
+    // time spent updating fields, updating and moving particles, and
+    // migrating particles. with async particles only the part of the
+    // migration not overlapped with the updates is counted
+    double fieldsTime = 0.0;
+    double particlesTime = 0.0;
+    double migrateTime = 0.0;
+
     int t_count = 0;
     float t = 0.;
     while (t < t_end)
@@ -260,30 +302,93 @@ int main(int argc, char** argv)
         if (verbose && (comm.rank() == 0))
             std::cerr << "started step = " << t_count << " t = " << t << std::endl;
 
-        {
-        TimeEvent<128>("oscillators::solve");
-
+#ifdef ENABLE_SENSEI
+        // analyses executing asynchronously on zero-copy snapshots may still
+        // reference the fields of earlier steps. rather than waiting for
+        // them the fields are computed in a buffer they do not reference
         master.foreach([&](Block* b, const Proxy&)
                               {
-                                b->update_fields(t, oscillators);
+                              b->swap_grid([b](const float *data)
+                                  { return bridge::data_in_use(b->gid, data); });
                               });
+#endif
+        {
+        TimeEvent<128> event("oscillators::solve");
 
-        master.foreach([&](Block* b, const Proxy&)
+        if (asyncParticles)
+        {
+            // each block's particles are moved and sent first, then the
+            // block's fields are updated while they are in flight. later
+            // visits receive the particles sent by the neighbors until no
+            // messages remain anywhere
+            TimeEvent<128> migrate("oscillators::migrate_particles");
+            auto t0 = Time::now();
+            double computeTime = 0.0;
+
+            std::set<int> moved;
+            master.iexchange([&](Block* b, const Master::IProxyWithLink& p) -> bool
                               {
-                                b->update_particles(t, oscillators);
-                              });
+                                if (moved.insert(b->gid).second)
+                                {
+                                    auto t1 = Time::now();
+                                    b->update_particles(t, oscillators, bins);
+                                    b->move_particles(dt, p);
+                                    auto t2 = Time::now();
+                                    b->update_fields(t, oscillators, bins);
+                                    auto t3 = Time::now();
+
+                                    particlesTime += std::chrono::duration<double>(t2 - t1).count();
+                                    fieldsTime += std::chrono::duration<double>(t3 - t2).count();
+                                    computeTime += std::chrono::duration<double>(t3 - t1).count();
+                                }
 
-        master.foreach([&](Block* b, const Proxy& p)
-                              {
-                                b->move_particles(dt, p);
+                                b->handle_incoming_particles(p);
+                                return true;
                               });
 
-        master.exchange();
+            migrateTime += std::chrono::duration<double>(Time::now() - t0).count()
+                - computeTime;
+        }
+        else
+        {
+            auto t0 = Time::now();
+
+            master.foreach([&](Block* b, const Proxy&)
+                                  {
+                                    b->update_fields(t, oscillators, bins);
+                                  });
 
-        master.foreach([=](Block* b, const Proxy& p)
-                              {
-                                b->handle_incoming_particles(p);
-                              });
+            auto t1 = Time::now();
+
+            master.foreach([&](Block* b, const Proxy&)
+                                  {
+                                    b->update_particles(t, oscillators, bins);
+                                  });
+
+            master.foreach([&](Block* b, const Proxy& p)
+                                  {
+                                    b->move_particles(dt, p);
+                                  });
+
+            auto t2 = Time::now();
+
+            {
+            TimeEvent<128> migrate("oscillators::migrate_particles");
+
+            master.exchange();
+
+            master.foreach([=](Block* b, const Proxy& p)
+                                  {
+                                    b->handle_incoming_particles(p);
+                                  });
+            }
+
+            auto t3 = Time::now();
+
+            fieldsTime += std::chrono::duration<double>(t1 - t0).count();
+            particlesTime += std::chrono::duration<double>(t2 - t1).count();
+            migrateTime += std::chrono::duration<double>(t3 - t2).count();
+        }
         }
 #ifdef ENABLE_SENSEI
         {
@@ -305,6 +410,7 @@ int main(int argc, char** argv)
         if (daOut)
         {
           oscillators.Initialize(comm, daOut);
+          bins.Initialize(oscillators, world_bounds, cutoffTol);
           daOut->ReleaseData();
           daOut->Delete();
 
@@ -340,6 +446,51 @@ int main(int argc, char** argv)
         ++t_count;
     }
 
+    if (!particles_out.empty())
+    {
+        TimeEvent<128> event("oscillators::write_particles");
+
+        // gather the id and position of the particles of all blocks on rank 0
+        std::vector<double> local;
+        master.foreach([&local](Block* b, const Proxy&)
+                              {
+                                for (const Particle &p : b->particles)
+                                    local.insert(local.end(), {double(p.id),
+                                        p.position[0], p.position[1], p.position[2]});
+                              });
+
+        int nLocal = local.size();
+        std::vector<int> counts(comm.size(), 0);
+        MPI_Gather(&nLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+
+        std::vector<int> offsets(comm.size(), 0);
+        for (int i = 1; i < comm.size(); ++i)
+            offsets[i] = offsets[i-1] + counts[i-1];
+
+        std::vector<double> global(comm.rank() == 0 ?
+            offsets.back() + counts.back() : 0);
+
+        MPI_Gatherv(local.data(), nLocal, MPI_DOUBLE, global.data(),
+            counts.data(), offsets.data(), MPI_DOUBLE, 0, comm);
+
+        if (comm.rank() == 0)
+        {
+            // sorted by id the output does not depend on the order in which
+            // particles arrived at the blocks
+            size_t n = global.size()/4;
+            std::vector<size_t> order(n);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(),
+                [&global](size_t a, size_t b) { return global[4*a] < global[4*b]; });
+
+            std::ofstream ofs(particles_out);
+            ofs << std::setprecision(9);
+            for (size_t i : order)
+                ofs << int(global[4*i]) << " " << global[4*i+1] << " "
+                    << global[4*i+2] << " " << global[4*i+3] << "\n";
+        }
+    }
+
 #ifdef ENABLE_SENSEI
     {
     TimeEvent<128> event("oscillators::in_situ_finalize");
@@ -349,13 +500,44 @@ int main(int argc, char** argv)
 
     Profiler::Finalize();
 
+    // the slowest rank's time in each phase of the solve
+    double solveTimes[3] = {fieldsTime, particlesTime, migrateTime};
+    MPI_Reduce(comm.rank() == 0 ? MPI_IN_PLACE : solveTimes, solveTimes, 3,
+        MPI_DOUBLE, MPI_MAX, 0, comm);
+
     comm.barrier();
     if (comm.rank() == 0)
     {
         auto duration = std::chrono::duration_cast<ms>(Time::now() - start);
         std::cerr << "Total run time: " << duration.count() / 1000
             << "." << duration.count() % 1000 << " s" << std::endl;
+
+        // field update throughput, counting the cores used by all ranks
+        double nCells = double(shape[0])*shape[1]*shape[2]*t_count;
+        int nCores = comm.size()*svtkSMPTools::GetEstimatedNumberOfThreads();
+        double runTime = std::max(1, int(duration.count())) / 1000.0;
+        std::cerr << "Cells per second per core: " << nCells / runTime / nCores
+            << " (" << nCores << " cores)" << std::endl;
+
+        std::cerr << "Solve time: fields " << solveTimes[0] << " s particles "
+            << solveTimes[1] << " s migration " << solveTimes[2] << " s"
+            << (asyncParticles ? " (not overlapped)" : "") << std::endl;
     }
 
+#ifdef ENABLE_SENSEI
+    // SVTK objects and arrays allocated and recycled for in situ analysis,
+    // summed over all ranks
+    long long allocs[4] = {0};
+    sensei::MemoryProfiler::GetAllocations(allocs[0], allocs[1],
+        allocs[2], allocs[3]);
+    MPI_Reduce(comm.rank() == 0 ? MPI_IN_PLACE : allocs, allocs, 4,
+        MPI_LONG_LONG, MPI_SUM, 0, comm);
+
+    if (comm.rank() == 0)
+        std::cerr << "SVTK allocations: " << allocs[0] << " new ("
+            << allocs[2] << " bytes) " << allocs[1] << " recycled ("
+            << allocs[3] << " bytes)" << std::endl;
+#endif
+
     return 0;
 }
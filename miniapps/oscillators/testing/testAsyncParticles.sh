@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+
+# runs the oscillator with particles migrated by the blocking exchange and by
+# the non-blocking exchange overlapped with the field update, and checks that
+# no particle is lost or duplicated by the migration and that the final
+# particle positions are identical.
+
+if [[ $# -lt 6 ]]
+then
+  echo "testAsyncParticles.sh [mpiexec] [npflag] [nproc] [oscillator] [src dir] [num particles]"
+  exit 1
+fi
+
+mpiexec=$1
+npflag=$2
+nproc=$3
+oscillator=$4
+srcdir=$5
+nparticles=$6
+shift 6
+if [ "$1" == "--" ]; then
+  shift
+fi
+mpiflags="$@"
+
+blocking=`mktemp`
+async=`mktemp`
+trap 'rm -f ${blocking} ${async}' EXIT
+
+runOscillator()
+{
+  out=$1
+  shift
+  ${mpiexec} ${npflag} ${nproc} ${mpiflags} ${oscillator} -t 1 -b ${nproc} \
+    -g 1 -p ${nparticles} --particles-out ${out} $@ \
+    -f ${srcdir}/oscillator_histogram.xml ${srcdir}/simple.osc
+}
+
+runOscillator ${blocking} || exit 1
+runOscillator ${async} --async-particles || exit 1
+
+# the particles are divided evenly amongst the blocks
+let nexpected=${nproc}*\(${nparticles}/${nproc}\)
+
+nblocking=`wc -l < ${blocking}`
+nasync=`wc -l < ${async}`
+nunique=`cut -d' ' -f1 ${async} | uniq | wc -l`
+
+echo "particles: ${nexpected} generated, ${nblocking} blocking, ${nasync} async, ${nunique} unique async"
+
+if [[ ${nblocking} -ne ${nexpected} || ${nasync} -ne ${nexpected} || \
+  ${nunique} -ne ${nexpected} ]]
+then
+  echo "ERROR: particles were lost or duplicated during migration"
+  exit 1
+fi
+
+if ! cmp -s ${blocking} ${async}
+then
+  echo "ERROR: the particle positions differ from the blocking run"
+  diff ${blocking} ${async} | head -n 10
+  exit 1
+fi
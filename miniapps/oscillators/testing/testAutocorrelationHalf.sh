@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+
+# runs the oscillator with the autocorrelation buffer in single and in half
+# precision and checks that the summed autocorrelations agree to within the
+# precision of half floats, 2^-10 of the largest autocorrelation.
+
+if [[ $# -lt 3 ]]
+then
+  echo "testAutocorrelationHalf.sh [oscillator] [src dir] [num blocks]"
+  exit 1
+fi
+
+oscillator=$1
+srcdir=$2
+nblocks=$3
+
+getAutocorrelations()
+{
+  ${oscillator} -t 1 -b ${nblocks} -g 1 -f ${srcdir}/$1 \
+    ${srcdir}/simple.osc 2>&1 | grep "^Autocorrelations:" | cut -d: -f2
+}
+
+single=`getAutocorrelations oscillator_autocorrelation.xml`
+half=`getAutocorrelations oscillator_autocorrelation_half.xml`
+
+echo "single:${single}"
+echo "half:${half}"
+
+if [[ -z "${single}" || -z "${half}" ]]
+then
+  echo "ERROR: the autocorrelations were not reported"
+  exit 1
+fi
+
+echo "${single}" "${half}" | awk '{
+  n = NF/2
+  if (n != int(n)) { print "ERROR: different number of lags"; exit 1 }
+  amax = 0
+  for (i = 1; i <= n; ++i) { a = $i < 0 ? -$i : $i; if (a > amax) amax = a }
+  tol = amax/1024
+  for (i = 1; i <= n; ++i)
+    {
+    d = $i - $(i+n); d = d < 0 ? -d : d
+    if (d > tol)
+      {
+      print "ERROR: lag " i-1 " differs by " d " tolerance " tol
+      exit 1
+      }
+    }
+  }'
@@ -0,0 +1,149 @@
+#include "Oscillator.h"
+#include "OscillatorBins.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Bins three oscillators whose cutoff spheres have a radius of 1 over a
+// domain of 7.6 cubed, which gives 8 bins of width 0.95 along each axis, and
+// checks the number of oscillators in the bins against counts worked out by
+// hand. The centers are chosen so that no cutoff sphere ends near a bin
+// boundary.
+//
+//   oscillator  center           bins overlapped         number of bins
+//   0           0.5, 0.5, 0.5    0-1, 0-1, 0-1           8
+//   1           4,   4,   4      3-5, 3-5, 3-5           27
+//   2           4,   2.5, 6      3-5, 1-3, 5-7           27
+//
+// oscillators 1 and 2 share the 3 bins 3-5, 3, 5.
+//
+// usage: testOscillatorBins
+
+namespace
+{
+// --------------------------------------------------------------------------
+int checkBin(const OscillatorBins &bins, int i, int j, int k,
+    const std::vector<int> &expected)
+{
+    int n = 0;
+    const int *ids = bins.Bin(i, j, k, n);
+
+    if (std::vector<int>(ids, ids + n) != expected)
+    {
+        std::cerr << "Bin " << i << ", " << j << ", " << k << " has "
+            << n << " oscillators, expected " << expected.size() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+}
+
+int main(int, char **)
+{
+    int status = 0;
+
+    // the tolerance at which the cutoff radius is the oscillator's radius
+    float tol = std::exp(-0.5f);
+
+    float centers[3][3] = {{0.5f, 0.5f, 0.5f}, {4.f, 4.f, 4.f},
+        {4.f, 2.5f, 6.f}};
+
+    OscillatorArray oscillators;
+    oscillators.Allocate(3);
+    for (int q = 0; q < 3; ++q)
+    {
+        Oscillator &o = oscillators[q];
+        o.center_x = centers[q][0];
+        o.center_y = centers[q][1];
+        o.center_z = centers[q][2];
+        o.radius = 1.f;
+        o.omega0 = 1.f;
+        o.zeta = 0.f;
+        o.type = Oscillator::periodic;
+    }
+
+    sdiy::Bounds<float> bounds;
+    for (int i = 0; i < 3; ++i)
+    {
+        bounds.min[i] = 0.f;
+        bounds.max[i] = 7.6f;
+    }
+
+    OscillatorBins bins;
+    bins.Initialize(oscillators, bounds, tol);
+
+    const int *dims = bins.Dims();
+    if (!bins.Enabled() || (dims[0] != 8) || (dims[1] != 8) || (dims[2] != 8))
+    {
+        std::cerr << "Wrong number of bins " << dims[0] << ", " << dims[1]
+            << ", " << dims[2] << std::endl;
+        return -1;
+    }
+
+    // count the oscillators in each bin and the bins that are occupied
+    int nIds = 0;
+    int nOccupied = 0;
+    int nShared = 0;
+    for (int k = 0; k < 8; ++k)
+        for (int j = 0; j < 8; ++j)
+            for (int i = 0; i < 8; ++i)
+            {
+                int n = 0;
+                bins.Bin(i, j, k, n);
+                nIds += n;
+                nOccupied += n > 0;
+                nShared += n > 1;
+            }
+
+    if ((nIds != 62) || (nOccupied != 59) || (nShared != 3))
+    {
+        std::cerr << "The bins hold " << nIds << " oscillators in "
+            << nOccupied << " bins, " << nShared << " shared. expected 62 "
+            "in 59 bins, 3 shared" << std::endl;
+        status = -1;
+    }
+
+    if (std::fabs(bins.MeanOccupancy() - 62.f/512.f) > 1e-6f)
+    {
+        std::cerr << "Wrong mean occupancy " << bins.MeanOccupancy()
+            << std::endl;
+        status = -1;
+    }
+
+    // the contents of individual bins, ids are in ascending order
+    status |= checkBin(bins, 0, 0, 0, {0});
+    status |= checkBin(bins, 1, 1, 1, {0});
+    status |= checkBin(bins, 2, 2, 2, {});
+    status |= checkBin(bins, 3, 3, 3, {1});
+    status |= checkBin(bins, 5, 5, 4, {1});
+    status |= checkBin(bins, 4, 1, 6, {2});
+    status |= checkBin(bins, 3, 3, 5, {1, 2});
+    status |= checkBin(bins, 5, 3, 5, {1, 2});
+    status |= checkBin(bins, 4, 4, 5, {1});
+    status |= checkBin(bins, 7, 7, 7, {});
+
+    // points outside of the bounds are served by the nearest bin
+    int n = 0;
+    const int *ids = bins.Bin(-1.f, -1.f, -1.f, n);
+    if ((n != 1) || (ids[0] != 0))
+    {
+        std::cerr << "A point outside of the bounds was not served by the "
+            "nearest bin" << std::endl;
+        status = -1;
+    }
+
+    // a tolerance of 0 disables binning
+    bins.Initialize(oscillators, bounds, 0.f);
+    if (bins.Enabled())
+    {
+        std::cerr << "Binning was not disabled" << std::endl;
+        status = -1;
+    }
+
+    if (status == 0)
+        std::cerr << "Binned oscillators correctly" << std::endl;
+
+    return status ? -1 : 0;
+}
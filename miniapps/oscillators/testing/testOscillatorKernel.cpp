@@ -0,0 +1,144 @@
+#include "Oscillator.h"
+#include "OscillatorBins.h"
+#include "BlockInternals.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Updates the field of a block that does not start at the origin of the
+// domain with the vectorized structure of arrays kernel, with and without
+// binning, and compares the result with the field computed point by point
+// with Oscillator::evaluate, the scalar path, on the same grid. The kernel
+// differs from the scalar path by the rounding of its exponential and by
+// the contributions below exp(-80) that it skips, hence the fields are
+// compared to within a tolerance relative to the sum of the amplitudes.
+// With binning the contributions below the cutoff tolerance are also
+// dropped, which is added to the tolerance.
+//
+// usage: testOscillatorKernel
+
+namespace
+{
+// --------------------------------------------------------------------------
+int compare(const char *name, const std::vector<float> &field,
+    const std::vector<float> &ref, float tol)
+{
+    float maxDiff = 0.f;
+    for (size_t q = 0; q < ref.size(); ++q)
+        maxDiff = std::max(maxDiff, std::fabs(field[q] - ref[q]));
+
+    std::cerr << name << " max difference " << maxDiff << " tolerance "
+        << tol << std::endl;
+
+    if (!(maxDiff <= tol))
+    {
+        std::cerr << "The " << name << " field differs from the scalar path"
+            << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+}
+
+int main(int, char **)
+{
+    int status = 0;
+
+    // a block of 24 x 20 x 16 points offset by 8, 4, 2 points from the
+    // origin of the domain
+    int ni = 24, nj = 20, nk = 16;
+    int i0 = 8, j0 = 4, k0 = 2;
+    float x0 = 0.5f, y0 = 0.5f, z0 = 0.5f;
+    float dx = 0.5f, dy = 0.5f, dz = 0.5f;
+    long nPts = long(ni)*nj*nk;
+
+    // oscillators of each type, some centered outside of the block
+    struct { float c[3]; float r; float omega0; float zeta; Oscillator::Type type; }
+    params[] = {
+        {{ 8.f,  6.f,  5.f}, 2.0f, 3.1f, 0.3f, Oscillator::damped},
+        {{ 4.5f, 2.f,  2.f}, 1.0f, 1.7f, 0.0f, Oscillator::decaying},
+        {{14.f,  9.f,  8.f}, 3.0f, 4.5f, 0.0f, Oscillator::periodic},
+        {{10.f,  4.f,  1.f}, 0.5f, 2.2f, 0.6f, Oscillator::damped},
+        {{20.f, 12.f, 10.f}, 1.5f, 5.0f, 0.0f, Oscillator::periodic},
+        {{11.f,  7.5f, 4.f}, 0.8f, 0.9f, 0.0f, Oscillator::decaying}};
+
+    int nOsc = sizeof(params)/sizeof(params[0]);
+
+    OscillatorArray oscillators;
+    oscillators.Allocate(nOsc);
+    for (int q = 0; q < nOsc; ++q)
+    {
+        Oscillator &o = oscillators[q];
+        o.center_x = params[q].c[0];
+        o.center_y = params[q].c[1];
+        o.center_z = params[q].c[2];
+        o.radius = params[q].r;
+        o.omega0 = params[q].omega0;
+        o.zeta = params[q].zeta;
+        o.type = params[q].type;
+    }
+
+    sdiy::Bounds<float> bounds;
+    for (int i = 0; i < 3; ++i)
+    {
+        bounds.min[i] = 0.f;
+        bounds.max[i] = 20.f;
+    }
+
+    float cutoffTol = 1e-6f;
+    OscillatorBins bins;
+    bins.Initialize(oscillators, bounds, cutoffTol);
+
+    float times[] = {0.f, 0.37f, 2.1f};
+    for (float t : times)
+    {
+        // the scalar path
+        std::vector<float> ref(nPts);
+        for (int k = 0; k < nk; ++k)
+            for (int j = 0; j < nj; ++j)
+                for (int i = 0; i < ni; ++i)
+                {
+                    float x = x0 + dx*(i0 + i);
+                    float y = y0 + dy*(j0 + j);
+                    float z = z0 + dz*(k0 + k);
+
+                    float val = 0.f;
+                    for (int q = 0; q < nOsc; ++q)
+                        val += oscillators[q].evaluate(x, y, z, t);
+
+                    ref[(long(k)*nj + j)*ni + i] = val;
+                }
+
+        float ampSum = 0.f;
+        for (int q = 0; q < nOsc; ++q)
+            ampSum += std::fabs(oscillators[q].amplitude(t));
+
+        float tol = 1e-6f*ampSum;
+
+        // the vectorized kernel
+        std::vector<float> field(nPts, -1.f);
+        BlockInternals::UpdateFields(-1, t, oscillators.Data(), nOsc,
+            nullptr, ni, nj, nk, i0, j0, k0, x0, y0, z0, dx, dy, dz,
+            field.data());
+
+        std::cerr << "t = " << t << " ";
+        status |= compare("vectorized", field, ref, tol);
+
+        // and with binning
+        std::fill(field.begin(), field.end(), -1.f);
+        BlockInternals::UpdateFields(-1, t, oscillators.Data(), nOsc,
+            &bins, ni, nj, nk, i0, j0, k0, x0, y0, z0, dx, dy, dz,
+            field.data());
+
+        std::cerr << "t = " << t << " ";
+        status |= compare("binned", field, ref, tol + cutoffTol*ampSum);
+    }
+
+    if (status == 0)
+        std::cerr << "The vectorized kernel matches the scalar path" << std::endl;
+
+    return status ? -1 : 0;
+}
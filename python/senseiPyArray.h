@@ -5,6 +5,8 @@
 #include <numpy/arrayobject.h>
 #include <Python.h>
 #include <cstdlib>
+#include <cstring>
+#include <type_traits>
 
 namespace senseiPyArray
 {
@@ -111,6 +113,13 @@ bool Copy(cpp_t *va, unsigned long n, PyObject *obj)
 
   // copy
   SENSEI_PY_ARRAY_DISPATCH(arr,
+    // same type and contiguous, copy the block
+    if (std::is_same<AT, cpp_t>::value && PyArray_IS_C_CONTIGUOUS(arr))
+      {
+      memcpy(va, PyArray_DATA(arr), n*sizeof(cpp_t));
+      return true;
+      }
+    // element by element with conversion
     unsigned long i = 0;
     NpyIter *it = NpyIter_New(arr, NPY_ITER_READONLY,
         NPY_KEEPORDER, NPY_NO_CASTING, nullptr);
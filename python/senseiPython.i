@@ -300,10 +300,9 @@ SENSEI_WRAP_ANALYSIS_ADAPTOR(VTKPosthocIO)
 SENSEI_WRAP_ANALYSIS_ADAPTOR(VTKAmrWriter)
 #endif
 
+#endif
+
 /****************************************************************************
  * SliceExtract
  ***************************************************************************/
-#ifdef ENABLE_VTK_FILTERS
 SENSEI_WRAP_ANALYSIS_ADAPTOR(SliceExtract)
-#endif
-#endif
@@ -47,7 +47,7 @@ senseiNewMacro(ADIOS2AnalysisAdaptor);
 //----------------------------------------------------------------------------
 ADIOS2AnalysisAdaptor::ADIOS2AnalysisAdaptor() :
     Schema(nullptr), FileName("sensei.bp"), DebugMode(0),
-    StepsPerFile(0), StepIndex(0), FileIndex(0)
+    DeferredPuts(0), StepsPerFile(0), StepIndex(0), FileIndex(0)
 {
   this->Handles.io = nullptr;
   this->Handles.engine = nullptr;
@@ -276,6 +276,9 @@ int ADIOS2AnalysisAdaptor::Initialize(pugi::xml_node &node)
   // enable file series for file based engines
   this->SetStepsPerFile(node.attribute("steps_per_file").as_int(0));
 
+  // stage all blocks of a step and flush them once
+  this->SetDeferredPuts(node.attribute("deferred_puts").as_int(0));
+
   // pass a group of engine parameters
   pugi::xml_node params = node.child("engine_parameters");
   if (params)
@@ -299,6 +302,7 @@ int ADIOS2AnalysisAdaptor::Initialize(pugi::xml_node &node)
 
   SENSEI_STATUS("Configured ADIOSAnalysisAdaptor filename=\""
     << filename << "\" engine=" << engine
+    << (this->DeferredPuts ? " deferred_puts=1 " : " ")
     << (!bufferMode.empty() ? "buffer_mode=" : "")
     << (!bufferMode.empty() ? bufferMode.c_str() : "")
     << (!bufferSize.empty() ? "buffer_size=" : "")
@@ -349,6 +353,9 @@ int ADIOS2AnalysisAdaptor::InitializeADIOS2()
   // create space for ADIOS2 variables
   this->Schema = new senseiADIOS2::DataObjectCollectionSchema;
 
+  this->Schema->SetPutMode(this->DeferredPuts ?
+    adios2_mode_deferred : adios2_mode_sync);
+
   // Open the engine
   if (adios2_set_engine(this->Handles.io, this->EngineName.c_str()))
     {
@@ -484,19 +491,26 @@ int ADIOS2AnalysisAdaptor::WriteTimestep(unsigned long timeStep,
   double time, const std::vector<MeshMetadataPtr> &metadata,
   const std::vector<svtkCompositeDataSetPtr> &objects)
 {
-  TimeEvent<128> mark("ADIOS2AnalysisAdaptor::WriteTimestep");
+  // the event records the number of bytes written, giving the rate per step
+  // which can be used to compare sync and deferred puts
+  Profiler::StartEvent("ADIOS2AnalysisAdaptor::WriteTimestep");
+  double t0 = MPI_Wtime();
 
   int ierr = 0;
   adios2_error aerr = adios2_error_none;
 
   if (this->UpdateStream())
+    {
+    Profiler::EndEvent("ADIOS2AnalysisAdaptor::WriteTimestep");
     return -1;
+    }
 
   adios2_step_status status;
   if ((aerr = adios2_begin_step(this->Handles.engine,
     adios2_step_mode_append, -1, &status)))
     {
     SENSEI_ERROR("adios2_begin_step failed. " << adios2_strerror(aerr))
+    Profiler::EndEvent("ADIOS2AnalysisAdaptor::WriteTimestep");
     return -1;
     }
 
@@ -508,20 +522,37 @@ int ADIOS2AnalysisAdaptor::WriteTimestep(unsigned long timeStep,
     ierr = -1;
     }
 
+  // in deferred mode this is where the staged blocks are copied
+  long long numBytes = this->Schema->GetNumberOfBytesPut();
+  Profiler::StartEvent("ADIOS2AnalysisAdaptor::PerformPuts");
+
   if ((aerr = adios2_perform_puts(this->Handles.engine)))
     {
     SENSEI_ERROR("adios2_perform_puts failed. " << adios2_strerror(aerr))
-    return -1;
+    ierr = -1;
     }
-
-  if ((aerr = adios2_end_step(this->Handles.engine)))
+  else if ((aerr = adios2_end_step(this->Handles.engine)))
     {
     SENSEI_ERROR("adios2_end_step failed. " << adios2_strerror(aerr))
-    return -1;
+    ierr = -1;
     }
 
+  Profiler::EndEvent("ADIOS2AnalysisAdaptor::PerformPuts", numBytes);
+
+  this->Schema->ReleaseDeferredData();
+
   ++this->StepIndex;
 
+  double dt = MPI_Wtime() - t0;
+  Profiler::EndEvent("ADIOS2AnalysisAdaptor::WriteTimestep", numBytes);
+
+  if (this->DebugMode)
+    {
+    SENSEI_STATUS("ADIOS2AnalysisAdaptor wrote " << numBytes << " bytes in "
+      << dt << " s (" << numBytes/dt << " bytes/s) for step " << timeStep
+      << " using " << (this->DeferredPuts ? "deferred" : "sync") << " puts")
+    }
+
   return ierr;
 }
 
@@ -79,6 +79,19 @@ public:
   void SetDebugMode(int mode)
   { this->DebugMode = mode; }
 
+  /** Enable/disable deferred puts. When enabled the blocks of all meshes and
+   * arrays in a time step are put with adios2_mode_deferred and are copied by
+   * ADIOS2 in a single flush at the end of the step, rather than being copied
+   * or flushed one block at a time. The simulation's data is referenced until
+   * the end of the step. The default value is 0.
+   */
+  void SetDeferredPuts(int val)
+  { this->DeferredPuts = val; }
+
+  /// Returns 1 if deferred puts are enabled.
+  int GetDeferredPuts() const
+  { return this->DeferredPuts; }
+
   /** Adds a set of sensei::DataRequirements, typically this will come from an XML
    * configuratiopn file. Data requirements tell the adaptor what to fetch from
    * the simulation and write to disk. If none are given then all available
@@ -147,6 +160,7 @@ protected:
   adios2_adios *Adios;
   std::vector<std::pair<std::string,std::string>> Parameters;
   int DebugMode;
+  int DeferredPuts;
   long StepsPerFile;
   long StepIndex;
   long FileIndex;
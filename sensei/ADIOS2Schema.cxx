@@ -54,6 +54,7 @@
 #include <functional>
 #include <sstream>
 #include <regex>
+#include <deque>
 
 namespace senseiADIOS2
 {
@@ -659,6 +660,38 @@ int InputStream::Finalize()
 
 
 
+// state shared by the schemas while writing a step. Puts are issued in
+// either adios2_mode_sync or adios2_mode_deferred. In deferred mode nothing
+// is copied until adios2_perform_puts is called once at the end of the step,
+// hence temporaries passed to adios2_put are held here until the step ends.
+// Single values are always put in sync mode, ADIOS2 copies them immediately.
+struct PutContext
+{
+  PutContext() : Mode(adios2_mode_sync), NumBytes(0) {}
+
+  // releases the data held for deferred puts and resets the byte count
+  void Clear();
+
+  adios2_mode Mode;
+  long long NumBytes;
+  std::vector<svtkCompositeDataSetPtr> Objects;
+  std::vector<svtkSmartPointer<svtkDataArray>> Arrays;
+  std::deque<sensei::BinaryStream> Streams;
+  std::deque<std::vector<int64_t>> Buffers;
+};
+
+// --------------------------------------------------------------------------
+void PutContext::Clear()
+{
+  this->NumBytes = 0;
+  this->Objects.clear();
+  this->Arrays.clear();
+  this->Streams.clear();
+  this->Buffers.clear();
+}
+
+
+
 // helper for writing binary streams of data. binary stream is a sequence
 // of bytes that has externally defined meaning.
 class BinaryStreamSchema
@@ -666,8 +699,8 @@ class BinaryStreamSchema
 public:
   static int DefineVariables(AdiosHandle handles, const std::string &path);
 
-  static int Write(AdiosHandle handles, const std::string &path,
-    const sensei::BinaryStream &md);
+  static int Write(AdiosHandle handles, PutContext &ctx,
+    const std::string &path, const sensei::BinaryStream &md);
 
   static int Read(MPI_Comm comm, InputStream &iStream,
     const std::string &path, sensei::BinaryStream &md);
@@ -748,8 +781,8 @@ int BinaryStreamSchema::Read(MPI_Comm comm, InputStream &iStream,
 }
 
 // --------------------------------------------------------------------------
-int BinaryStreamSchema::Write(AdiosHandle handles, const std::string &path,
-  const sensei::BinaryStream &str)
+int BinaryStreamSchema::Write(AdiosHandle handles, PutContext &ctx,
+  const std::string &path, const sensei::BinaryStream &str)
 {
   sensei::Profiler::StartEvent("senseiADIOS2::BinaryStreamSchema::Write");
 
@@ -760,12 +793,14 @@ int BinaryStreamSchema::Write(AdiosHandle handles, const std::string &path,
 
   if (adios2_set_shape(internalBinVar, 1, &n) ||
       adios2_set_selection(internalBinVar, 1, &selectionStart, &n) ||
-      adios2_put_by_name(handles.engine, path.c_str(), str.GetData(), adios2_mode_sync))
+      adios2_put_by_name(handles.engine, path.c_str(), str.GetData(), ctx.Mode))
     {
     SENSEI_ERROR("Failed to write BinaryStream at \"" << path << "\"")
     return -1;
     }
 
+  ctx.NumBytes += n;
+
   sensei::Profiler::EndEvent("senseiADIOS2::BinaryStreamSchema::Write", n);
   return 0;
 }
@@ -863,9 +898,11 @@ struct ArraySchema
     std::vector<size_t> &putVarsCount, adios2_variable *&putVar);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
-  int Write(MPI_Comm comm, AdiosHandle handles, unsigned int i,
+  int Write(MPI_Comm comm, AdiosHandle handles, PutContext &ctx,
+    unsigned int i,
     const std::string &array_name, int array_cen, svtkCompositeDataSet *dobj,
     unsigned int num_blocks, const std::vector<int> &block_owner,
     const std::vector<size_t> &putVarsStart, const std::vector<size_t> &putVarsCount,
@@ -1030,7 +1067,8 @@ int ArraySchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 }
 
 // --------------------------------------------------------------------------
-int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int i,
+int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles, PutContext &ctx,
+  unsigned int i,
   const std::string &array_name, int array_cen, svtkCompositeDataSet *dobj,
   unsigned int num_blocks, const std::vector<int> &block_owner,
   const std::vector<size_t> &putVarsStart,
@@ -1084,7 +1122,7 @@ int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int i,
 
       // do the write
       if (adios2_put(handles.engine, putVar,
-        da->GetVoidPointer(0), adios2_mode_sync))
+        da->GetVoidPointer(0), ctx.Mode))
         {
         SENSEI_ERROR("adios2_put block " << j << " array "
           << i << " failed")
@@ -1099,13 +1137,16 @@ int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int i,
 
   it->Delete();
 
+  ctx.NumBytes += numBytes;
+
   sensei::Profiler::EndEvent("senseiADIOS2::ArraySchema::Write", numBytes);
   return 0;
 }
 
 // --------------------------------------------------------------------------
 int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   sensei::TimeEvent<128> mark("senseiADIOS2::ArraySchema::Write");
 
@@ -1122,18 +1163,18 @@ int ArraySchema::Write(MPI_Comm comm, AdiosHandle handles,
 
   for (unsigned int i = 0; i < num_arrays; ++i)
     {
-    if (this->Write(comm, handles, i, md->ArrayName[i], md->ArrayCentering[i],
+    if (this->Write(comm, handles, ctx, i, md->ArrayName[i], md->ArrayCentering[i],
       dobj, md->NumBlocks, md->BlockOwner, putVarsStart, putVarsCount, putVars[i]))
       return -1;
     }
 
   // write ghost arrays
-  if (have_ghost_cells && this->Write(comm, handles, num_arrays, "svtkGhostType",
+  if (have_ghost_cells && this->Write(comm, handles, ctx, num_arrays, "svtkGhostType",
     svtkDataObject::CELL, dobj, md->NumBlocks, md->BlockOwner, putVarsStart,
     putVarsCount, putVars[num_arrays]))
       return -1;
 
-  if (md->NumGhostNodes && this->Write(comm, handles, num_arrays,
+  if (md->NumGhostNodes && this->Write(comm, handles, ctx, num_arrays,
     "svtkGhostType", svtkDataObject::POINT, dobj, md->NumBlocks,
     md->BlockOwner, putVarsStart, putVarsCount,
     putVars[num_arrays + (have_ghost_cells ? 1 : 0)]))
@@ -1287,7 +1328,8 @@ struct PointSchema
     const std::string &ons, const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
@@ -1365,7 +1407,8 @@ int PointSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 
 // --------------------------------------------------------------------------
 int PointSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::Unstructured(md) || sensei::SVTKUtils::Structured(md)
     || sensei::SVTKUtils::Polydata(md))
@@ -1409,7 +1452,7 @@ int PointSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
         svtkDataArray *da = ds->GetPoints()->GetData();
         if (adios2_put(handles.engine, putVar,
-          da->GetVoidPointer(0), adios2_mode_sync))
+          da->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put \"" << md->MeshName
             << "\" block " << j << " points failed")
@@ -1423,6 +1466,8 @@ int PointSchema::Write(MPI_Comm comm, AdiosHandle handles,
       }
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::PointSchema::Write", numBytes);
     }
 
@@ -1530,7 +1575,8 @@ struct UnstructuredCellSchema
     const std::string &ons, const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
@@ -1682,7 +1728,8 @@ int UnstructuredCellSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 
 // --------------------------------------------------------------------------
 int UnstructuredCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::Unstructured(md))
     {
@@ -1735,7 +1782,7 @@ int UnstructuredCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
         svtkDataArray *cta = ds->GetCellTypesArray();
         if (adios2_put(handles.engine, cellTypeVar,
-          cta->GetVoidPointer(0), adios2_mode_sync))
+          cta->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell types for mesh \""
             << md->MeshName << "\" block " << j << " failed")
@@ -1758,7 +1805,7 @@ int UnstructuredCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
         svtkDataArray *co = ds->GetCells()->GetOffsetsArray();
 
         if (adios2_put(handles.engine, cellOffsVar,
-          co->GetVoidPointer(0), adios2_mode_sync))
+          co->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell offsets for mesh \""
             << md->MeshName << "\" block " << j << " failed")
@@ -1779,7 +1826,7 @@ int UnstructuredCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
         svtkDataArray *cc = ds->GetCells()->GetConnectivityArray();
 
         if (adios2_put(handles.engine, cellConnVar,
-          cc->GetVoidPointer(0), adios2_mode_sync))
+          cc->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell offsets for mesh \""
             << md->MeshName << "\" block " << j << " failed")
@@ -1795,6 +1842,8 @@ int UnstructuredCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::UnstructuredCellSchema::Write",
       numBytes);
     }
@@ -2013,7 +2062,8 @@ struct PolydataCellSchema
     const std::string &ons, const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
@@ -2166,7 +2216,8 @@ int PolydataCellSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 
 // --------------------------------------------------------------------------
 int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::Polydata(md))
     {
@@ -2211,8 +2262,12 @@ int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
         size_t ctStart = 4*j;
         size_t ctCount = 4;
 
-        int64_t ct[4] = {ds->GetNumberOfVerts(), ds->GetNumberOfLines(),
-            ds->GetNumberOfPolys(),  ds->GetNumberOfStrips()};
+        // held by the context until the step ends
+        ctx.Buffers.emplace_back(std::vector<int64_t>({ds->GetNumberOfVerts(),
+            ds->GetNumberOfLines(), ds->GetNumberOfPolys(),
+            ds->GetNumberOfStrips()}));
+
+        int64_t *ct = ctx.Buffers.back().data();
 
         // write the cell types
         if (adios2_set_selection(cellTypeVar, 1, &ctStart, &ctCount))
@@ -2222,7 +2277,7 @@ int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
           return -1;
           }
 
-        if (adios2_put(handles.engine, cellTypeVar, ct, adios2_mode_sync))
+        if (adios2_put(handles.engine, cellTypeVar, ct, ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell types for mesh \""
             << md->MeshName << "\" block " << j << " failed")
@@ -2294,7 +2349,7 @@ int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
           }
 
         if (adios2_put(handles.engine, cellOffsVar,
-          co->GetVoidPointer(0), adios2_mode_sync))
+          co->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell offsets for mesh \""
             << md->MeshName << "\" block " << j << " failed")
@@ -2310,15 +2365,16 @@ int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
           }
 
         if (adios2_put(handles.engine, cellConnVar,
-          cc->GetVoidPointer(0), adios2_mode_sync))
+          cc->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put cell offsets for mesh \""
             << md->MeshName << "\" block " << j << " failed")
           return -1;
           }
 
-        co->Delete();
-        cc->Delete();
+        // in deferred mode the packed arrays must outlive the put
+        ctx.Arrays.emplace_back(svtkSmartPointer<svtkDataArray>::Take(co));
+        ctx.Arrays.emplace_back(svtkSmartPointer<svtkDataArray>::Take(cc));
 
         // track number of bytes for profiling
         numBytes += 4 *sizeof(uint64_t) + (coCount + ccCount) * elemSize;
@@ -2329,6 +2385,8 @@ int PolydataCellSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::PolydataCellSchema::Write",
       numBytes);
     }
@@ -2550,7 +2608,8 @@ struct LogicallyCartesianSchema
     const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles,
     const std::string &ons, const sensei::MeshMetadataPtr &md,
@@ -2599,7 +2658,8 @@ int LogicallyCartesianSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles
 
 // --------------------------------------------------------------------------
 int LogicallyCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::LogicallyCartesian(md))
     {
@@ -2647,18 +2707,18 @@ int LogicallyCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
           case SVTK_RECTILINEAR_GRID:
             ierr = adios2_put(handles.engine, writeVar,
               dynamic_cast<svtkRectilinearGrid*>(dobj)->GetExtent(),
-              adios2_mode_sync);
+              ctx.Mode);
             break;
 
           case SVTK_IMAGE_DATA:
           case SVTK_UNIFORM_GRID:
             ierr = adios2_put(handles.engine, writeVar,
-              dynamic_cast<svtkImageData*>(dobj)->GetExtent(), adios2_mode_sync);
+              dynamic_cast<svtkImageData*>(dobj)->GetExtent(), ctx.Mode);
             break;
 
           case SVTK_STRUCTURED_GRID:
             ierr = adios2_put(handles.engine, writeVar,
-              dynamic_cast<svtkStructuredGrid*>(dobj)->GetExtent(), adios2_mode_sync);
+              dynamic_cast<svtkStructuredGrid*>(dobj)->GetExtent(), ctx.Mode);
             break;
           }
 
@@ -2676,6 +2736,8 @@ int LogicallyCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::LogicallyCartesianSchema::Write",
       numBytes);
     }
@@ -2776,7 +2838,8 @@ struct UniformCartesianSchema
     const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
@@ -2843,7 +2906,8 @@ int UniformCartesianSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 
 // --------------------------------------------------------------------------
 int UniformCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::UniformCartesian(md))
     {
@@ -2884,7 +2948,7 @@ int UniformCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
           }
 
         if (adios2_put(handles.engine, originWriteVar,
-          ds->GetOrigin(), adios2_mode_sync))
+          ds->GetOrigin(), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put origin block " << j << " failed")
           return -1;
@@ -2898,7 +2962,7 @@ int UniformCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
           }
 
         if (adios2_put(handles.engine, spacingWriteVar,
-          ds->GetSpacing(), adios2_mode_sync))
+          ds->GetSpacing(), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put spacing block " << j << " failed")
           return -1;
@@ -2911,6 +2975,8 @@ int UniformCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
       }
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::UniformCartesianSchema::Write", numBytes);
     }
 
@@ -3029,7 +3095,8 @@ struct StretchedCartesianSchema
     const sensei::MeshMetadataPtr &md);
 
   int Write(MPI_Comm comm, AdiosHandle handles,
-    const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
+    PutContext &ctx, const sensei::MeshMetadataPtr &md,
+    svtkCompositeDataSet *dobj);
 
   int Read(MPI_Comm comm, AdiosHandle handles, const std::string &ons,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
@@ -3180,7 +3247,8 @@ int StretchedCartesianSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles
 
 // --------------------------------------------------------------------------
 int StretchedCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
-  const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
+  PutContext &ctx, const sensei::MeshMetadataPtr &md,
+  svtkCompositeDataSet *dobj)
 {
   if (sensei::SVTKUtils::StretchedCartesian(md))
     {
@@ -3232,7 +3300,7 @@ int StretchedCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
         svtkDataArray *xda = ds->GetXCoordinates();
         if (adios2_put(handles.engine, xcVar,
-          xda->GetVoidPointer(0), adios2_mode_sync))
+          xda->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put x-coordinates block " << j << " failed")
           return -1;
@@ -3250,7 +3318,7 @@ int StretchedCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
         svtkDataArray *yda = ds->GetYCoordinates();
         if (adios2_put(handles.engine, ycVar,
-          yda->GetVoidPointer(0), adios2_mode_sync))
+          yda->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put y-coordinates block " << j << " failed")
           return -1;
@@ -3267,7 +3335,7 @@ int StretchedCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
           }
 
         if (adios2_put(handles.engine, zcVar,
-          zda->GetVoidPointer(0), adios2_mode_sync))
+          zda->GetVoidPointer(0), ctx.Mode))
           {
           SENSEI_ERROR("adios2_put y-coordinates block " << j << " failed")
           return -1;
@@ -3281,6 +3349,8 @@ int StretchedCartesianSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
     it->Delete();
 
+    ctx.NumBytes += numBytes;
+
     sensei::Profiler::EndEvent("senseiADIOS2::StretchedCartesianSchema::Write",
       numBytes);
     }
@@ -3464,7 +3534,8 @@ struct DataObjectSchema
   int DefineVariables(MPI_Comm comm, AdiosHandle handles,
     unsigned int doid,  const sensei::MeshMetadataPtr &md);
 
-  int Write(MPI_Comm comm, AdiosHandle handles, unsigned int doid,
+  int Write(MPI_Comm comm, AdiosHandle handles, PutContext &ctx,
+    unsigned int doid,
     const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj);
 
   int ReadMesh(MPI_Comm comm, AdiosHandle handles,
@@ -3515,18 +3586,19 @@ int DataObjectSchema::DefineVariables(MPI_Comm comm, AdiosHandle handles,
 }
 
 // --------------------------------------------------------------------------
-int DataObjectSchema::Write(MPI_Comm comm, AdiosHandle handles, unsigned int doid,
+int DataObjectSchema::Write(MPI_Comm comm, AdiosHandle handles,
+  PutContext &ctx, unsigned int doid,
   const sensei::MeshMetadataPtr &md, svtkCompositeDataSet *dobj)
 {
   sensei::TimeEvent<128> mark("senseiADIOS2::DataObjectSchema::Write");
 
-  if (this->DataArrays.Write(comm, handles, md, dobj) ||
-    this->Points.Write(comm, handles, md, dobj) ||
-    this->UnstructuredCells.Write(comm, handles, md, dobj) ||
-    this->PolydataCells.Write(comm, handles, md, dobj) ||
-    this->UniformCartesian.Write(comm, handles, md, dobj) ||
-    this->StretchedCartesian.Write(comm, handles, md, dobj) ||
-    this->LogicallyCartesian.Write(comm, handles, md, dobj))
+  if (this->DataArrays.Write(comm, handles, ctx, md, dobj) ||
+    this->Points.Write(comm, handles, ctx, md, dobj) ||
+    this->UnstructuredCells.Write(comm, handles, ctx, md, dobj) ||
+    this->PolydataCells.Write(comm, handles, ctx, md, dobj) ||
+    this->UniformCartesian.Write(comm, handles, ctx, md, dobj) ||
+    this->StretchedCartesian.Write(comm, handles, ctx, md, dobj) ||
+    this->LogicallyCartesian.Write(comm, handles, ctx, md, dobj))
     {
     SENSEI_ERROR("Failed to write for object "
       << doid << " \"" << md->MeshName << "\"")
@@ -3628,6 +3700,7 @@ struct DataObjectCollectionSchema::InternalsType
   InternalsType() : BlockOwnerArrayMetadata(0) {}
   VersionSchema Version;
   DataObjectSchema DataObject;
+  PutContext Put;
   sensei::MeshMetadataMap SenderMdMap;
   sensei::MeshMetadataMap ReceiverMdMap;
   int BlockOwnerArrayMetadata;
@@ -3843,6 +3916,15 @@ int DataObjectCollectionSchema::Write(MPI_Comm comm, AdiosHandle handles,
 {
   sensei::Profiler::StartEvent("senseiADIOS2::DataObjectCollectionSchema::Write");
 
+  // release anything held from the previous step
+  PutContext &ctx = this->Internals->Put;
+  ctx.Clear();
+
+  // in deferred mode the objects must remain valid until the puts are
+  // performed at the end of the step
+  if (ctx.Mode == adios2_mode_deferred)
+    ctx.Objects = objects;
+
   unsigned int n_objects = objects.size();
   if (n_objects != metadata.size())
     {
@@ -3883,7 +3965,8 @@ int DataObjectCollectionSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
   for (unsigned int i = 0; i < n_objects; ++i)
     {
-    sensei::BinaryStream bs;
+    ctx.Streams.emplace_back();
+    sensei::BinaryStream &bs = ctx.Streams.back();
     metadata[i]->ToStream(bs);
 
     std::ostringstream oss;
@@ -3892,14 +3975,14 @@ int DataObjectCollectionSchema::Write(MPI_Comm comm, AdiosHandle handles,
 
     // /data_object_<id>/metadata
     path = object_id + "metadata";
-    if (BinaryStreamSchema::Write(handles, path, bs))
+    if (BinaryStreamSchema::Write(handles, ctx, path, bs))
       {
       SENSEI_ERROR("Failed to write metadata for object " << i)
       return -1;
       }
 
     // write the object
-    if (this->Internals->DataObject.Write(comm, handles, i,
+    if (this->Internals->DataObject.Write(comm, handles, ctx, i,
       metadata[i], objects[i].Get()))
       {
       SENSEI_ERROR("Failed to write object " << i << " \""
@@ -3908,11 +3991,37 @@ int DataObjectCollectionSchema::Write(MPI_Comm comm, AdiosHandle handles,
       }
     }
 
+  ctx.NumBytes += sizeof(time_step) + sizeof(time) + sizeof(n_objects);
+
   sensei::Profiler::EndEvent("senseiADIOS2::DataObjectCollectionSchema::Write",
-    sizeof(time_step)+sizeof(time));
+    ctx.NumBytes);
   return 0;
 }
 
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::SetPutMode(adios2_mode mode)
+{
+  this->Internals->Put.Mode = mode;
+}
+
+// --------------------------------------------------------------------------
+adios2_mode DataObjectCollectionSchema::GetPutMode() const
+{
+  return this->Internals->Put.Mode;
+}
+
+// --------------------------------------------------------------------------
+long long DataObjectCollectionSchema::GetNumberOfBytesPut() const
+{
+  return this->Internals->Put.NumBytes;
+}
+
+// --------------------------------------------------------------------------
+void DataObjectCollectionSchema::ReleaseDeferredData()
+{
+  this->Internals->Put.Clear();
+}
+
 // --------------------------------------------------------------------------
 bool DataObjectCollectionSchema::CanRead(InputStream &iStream)
 {
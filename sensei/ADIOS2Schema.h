@@ -65,6 +65,21 @@ public:
   // get the number of meshes available. Available after ReadMeshMetadata
   int GetNumberOfObjects(unsigned int &num);
 
+  // Set the mode used to put the meshes and arrays. In adios2_mode_sync
+  // (the default) each block is copied or flushed as it is put. In
+  // adios2_mode_deferred the blocks of all objects are staged and ADIOS2
+  // copies them when adios2_perform_puts is called, once per step. In that
+  // case the objects passed to Write, and temporaries made while writing,
+  // are held until ReleaseDeferredData is called or the next step is written.
+  void SetPutMode(adios2_mode mode);
+  adios2_mode GetPutMode() const;
+
+  // release the data held for deferred puts. call after adios2_end_step
+  void ReleaseDeferredData();
+
+  // get the number of bytes put by the most recent call to Write
+  long long GetNumberOfBytesPut() const;
+
   // write the object collection
   int Write(MPI_Comm comm, AdiosHandle handles, unsigned long time_step, double time,
     const std::vector<sensei::MeshMetadataPtr> &metadata,
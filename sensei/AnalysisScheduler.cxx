@@ -0,0 +1,323 @@
+#include "AnalysisScheduler.h"
+#include "DataAdaptor.h"
+#include "SVTKUtils.h"
+#include "XMLUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <pugixml.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace sensei
+{
+
+// --------------------------------------------------------------------------
+int AnalysisScheduler::AddAnalyses(unsigned int nAnalyses,
+  pugi::xml_node node)
+{
+  PolicyType policy;
+
+  policy.TimeBudget = node.attribute("time_budget").as_double(0.0);
+  policy.MinInterval = node.attribute("min_interval").as_int(0);
+  policy.MaxInterval = node.attribute("max_interval").as_int(0);
+
+  for (pugi::xml_node tnode = node.child("trigger"); tnode;
+    tnode = tnode.next_sibling("trigger"))
+    {
+    if (XMLUtils::RequireAttribute(tnode, "mesh") ||
+      XMLUtils::RequireAttribute(tnode, "array"))
+      {
+      SENSEI_ERROR("Failed to initialize the trigger")
+      return -1;
+      }
+
+    TriggerType trigger;
+    trigger.Mesh = tnode.attribute("mesh").value();
+    trigger.Array = tnode.attribute("array").value();
+
+    std::string assocStr = tnode.attribute("association").as_string("point");
+    if (SVTKUtils::GetAssociation(assocStr, trigger.Association))
+      {
+      SENSEI_ERROR("Invalid association \"" << assocStr << "\"")
+      return -1;
+      }
+
+    std::string metric = tnode.attribute("metric").as_string("max");
+    if ((metric != "max") && (metric != "min"))
+      {
+      SENSEI_ERROR("Invalid metric \"" << metric << "\". Use min or max")
+      return -1;
+      }
+    trigger.Max = metric == "max";
+
+    trigger.Change = tnode.attribute("change").as_double(0.1);
+    trigger.Reference = 0.0;
+
+    policy.Triggers.push_back(trigger);
+    }
+
+  if ((policy.TimeBudget < 0.0) || (policy.MinInterval < 0) ||
+    (policy.MaxInterval < 0))
+    {
+    SENSEI_ERROR("Invalid time_budget " << policy.TimeBudget
+      << ", min_interval " << policy.MinInterval << ", or max_interval "
+      << policy.MaxInterval)
+    return -1;
+    }
+
+  policy.Active = (policy.TimeBudget > 0.0) || (policy.MinInterval > 0) ||
+    (policy.MaxInterval > 0) || policy.Triggers.size();
+
+  if (policy.Active)
+    {
+    SENSEI_STATUS("Scheduling \"" << node.attribute("type").value()
+      << "\" with time_budget " << policy.TimeBudget << ", min_interval "
+      << policy.MinInterval << ", max_interval " << policy.MaxInterval
+      << ", and " << policy.Triggers.size() << " triggers")
+    }
+
+  this->Policies.resize(nAnalyses, policy);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+bool AnalysisScheduler::GetActive() const
+{
+  unsigned int nAnalyses = this->Policies.size();
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    {
+    if (this->Policies[i].Active)
+      return true;
+    }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+bool AnalysisScheduler::GetActive(unsigned int ai) const
+{
+  return this->Policies[ai].Active;
+}
+
+// --------------------------------------------------------------------------
+long AnalysisScheduler::GetNumberOfExecutions(unsigned int ai) const
+{
+  return this->Policies[ai].NumExecutions;
+}
+
+// --------------------------------------------------------------------------
+long AnalysisScheduler::GetNumberOfSteps(unsigned int ai) const
+{
+  return this->Policies[ai].NumSteps;
+}
+
+// --------------------------------------------------------------------------
+void AnalysisScheduler::SetExecutionTime(unsigned int ai, double seconds)
+{
+  this->Policies[ai].LastTime = seconds;
+}
+
+// --------------------------------------------------------------------------
+int AnalysisScheduler::GetRange(DataAdaptor *data,
+  const TriggerType &trigger, std::map<std::string, MeshMetadataPtr> &metadata,
+  double range[2])
+{
+  // fetch the metadata of each mesh once per step
+  MeshMetadataPtr md;
+  auto it = metadata.find(trigger.Mesh);
+  if (it != metadata.end())
+    {
+    md = it->second;
+    }
+  else
+    {
+    unsigned int nMeshes = 0;
+    if (data->GetNumberOfMeshes(nMeshes))
+      {
+      SENSEI_ERROR("Failed to get the number of meshes")
+      return -1;
+      }
+
+    for (unsigned int i = 0; i < nMeshes; ++i)
+      {
+      MeshMetadataFlags flags;
+      flags.SetBlockArrayRange();
+
+      MeshMetadataPtr tmp = MeshMetadata::New(flags);
+      if (data->GetMeshMetadata(i, tmp))
+        {
+        SENSEI_ERROR("Failed to get metadata for mesh " << i)
+        return -1;
+        }
+
+      if (tmp->MeshName == trigger.Mesh)
+        {
+        md = tmp;
+        break;
+        }
+      }
+
+    if (!md)
+      {
+      SENSEI_ERROR("No mesh named \"" << trigger.Mesh << "\"")
+      return -1;
+      }
+
+    metadata[trigger.Mesh] = md;
+    }
+
+  int ai = 0;
+  while ((ai < md->NumArrays) && !((md->ArrayName[ai] == trigger.Array) &&
+    (md->ArrayCentering[ai] == trigger.Association)))
+    ++ai;
+
+  if (ai == md->NumArrays)
+    {
+    SENSEI_ERROR("No " << SVTKUtils::GetAttributesName(trigger.Association)
+      << " data array named \"" << trigger.Array << "\" on mesh \""
+      << trigger.Mesh << "\"")
+    return -1;
+    }
+
+  // the range over the local blocks
+  range[0] = std::numeric_limits<double>::max();
+  range[1] = std::numeric_limits<double>::lowest();
+
+  unsigned long nBlocks = md->BlockArrayRange.size();
+  for (unsigned long i = 0; i < nBlocks; ++i)
+    {
+    range[0] = std::min(range[0], md->BlockArrayRange[i][ai][0]);
+    range[1] = std::max(range[1], md->BlockArrayRange[i][ai][1]);
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int AnalysisScheduler::Schedule(MPI_Comm comm, DataAdaptor *data,
+  double solverTime, std::vector<int> &execute)
+{
+  TimeEvent<128> mark("AnalysisScheduler::Schedule");
+
+  unsigned int nAnalyses = this->Policies.size();
+  execute.assign(nAnalyses, 1);
+
+  if (!this->GetActive())
+    return 0;
+
+  // gather this rank's times and the array ranges of the triggers, reduced
+  // in a single exchange
+  bool reduce = false;
+  std::vector<double> vals(1, solverTime);
+  std::map<std::string, MeshMetadataPtr> metadata;
+
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    {
+    PolicyType &policy = this->Policies[i];
+
+    reduce |= (policy.TimeBudget > 0.0) || policy.Triggers.size();
+    vals.push_back(policy.LastTime);
+    policy.LastTime = 0.0;
+
+    unsigned int nTriggers = policy.Triggers.size();
+    for (unsigned int j = 0; j < nTriggers; ++j)
+      {
+      double range[2] = {0.0};
+      if (this->GetRange(data, policy.Triggers[j], metadata, range))
+        {
+        SENSEI_ERROR("Failed to evaluate the trigger on array \""
+          << policy.Triggers[j].Array << "\"")
+        return -1;
+        }
+
+      // negate the min, so that a max reduction computes it
+      vals.push_back(-range[0]);
+      vals.push_back(range[1]);
+      }
+    }
+
+  if (reduce)
+    {
+    MPI_Allreduce(MPI_IN_PLACE, vals.data(), vals.size(), MPI_DOUBLE,
+      MPI_MAX, comm);
+    }
+
+  this->SolverTime += vals[0];
+
+  long step = data->GetDataTimeStep();
+
+  unsigned long vi = 1;
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    {
+    PolicyType &policy = this->Policies[i];
+
+    if (vals[vi] > 0.0)
+      {
+      policy.AnalysisTime += vals[vi];
+      policy.Cost = vals[vi];
+      }
+    ++vi;
+
+    // the current value of each trigger's metric, and whether it fired
+    unsigned int nTriggers = policy.Triggers.size();
+    std::vector<double> values(nTriggers);
+    bool fired = nTriggers == 0;
+    for (unsigned int j = 0; j < nTriggers; ++j, vi += 2)
+      {
+      TriggerType &trigger = policy.Triggers[j];
+
+      values[j] = trigger.Max ? vals[vi + 1] : -vals[vi];
+
+      fired |= std::fabs(values[j] - trigger.Reference) >
+        trigger.Change*std::fabs(trigger.Reference);
+      }
+
+    if (!policy.Active)
+      continue;
+
+    ++policy.NumSteps;
+
+    bool run = true;
+    if (policy.LastStep >= 0)
+      {
+      long interval = step - policy.LastStep;
+
+      bool inBudget = (policy.TimeBudget <= 0.0) ||
+        (policy.AnalysisTime + policy.Cost <= policy.TimeBudget*this->SolverTime);
+
+      if (interval < policy.MinInterval)
+        run = false;
+      else if ((policy.MaxInterval > 0) && (interval >= policy.MaxInterval))
+        run = true;
+      else
+        run = fired && inBudget;
+      }
+
+    if (Profiler::Enabled() && (this->SolverTime > 0.0))
+      {
+      std::ostringstream oss;
+      oss << "AnalysisScheduler::" << i << "::TimeFraction";
+      Profiler::RecordValue(oss.str().c_str(),
+        policy.AnalysisTime/this->SolverTime);
+      }
+
+    execute[i] = run ? 1 : 0;
+
+    if (run)
+      {
+      policy.LastStep = step;
+      ++policy.NumExecutions;
+
+      for (unsigned int j = 0; j < nTriggers; ++j)
+        policy.Triggers[j].Reference = values[j];
+      }
+    }
+
+  return 0;
+}
+
+}
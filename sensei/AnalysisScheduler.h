@@ -0,0 +1,138 @@
+#ifndef sensei_AnalysisScheduler_h
+#define sensei_AnalysisScheduler_h
+
+#include "senseiConfig.h"
+#include "MeshMetadata.h"
+
+#include <mpi.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pugi { class xml_node; }
+
+namespace sensei
+{
+
+class DataAdaptor;
+
+/** Decides, each time step, which of a list of analyses execute. This is
+ * used by ConfigurableAnalysis to throttle any analysis by wall-clock cost
+ * and by how much the simulation data has changed. Each analysis is given a
+ * policy from the following attributes and child elements of its XML
+ * element, analyses without them execute every time step.
+ *
+ *   time_budget  -- the fraction of the solver's wall-clock time the
+ *                   analysis may use. The analysis is skipped while its
+ *                   accumulated execution time plus the time of its last
+ *                   execution would exceed this fraction of the accumulated
+ *                   time spent in the solver between calls to Execute.
+ *   min_interval -- the minimum number of simulation time steps between
+ *                   executions. Takes precedence over everything else.
+ *   max_interval -- the maximum number of simulation time steps between
+ *                   executions. The analysis executes when this many steps
+ *                   have passed, regardless of budget and triggers.
+ *   trigger      -- a child element with mesh, array, association, metric
+ *                   and change attributes. The trigger fires when the global
+ *                   min or max (metric) of the array has changed by more
+ *                   than the change fraction since the analysis last
+ *                   executed. When triggers are given the analysis executes
+ *                   only when at least one fires.
+ *
+ * Analyses execute at the first time step they are offered. Triggers are
+ * evaluated from the array ranges reported in the mesh metadata, no array is
+ * fetched. Execution times and ranges are reduced across ranks in a single
+ * all reduce so that all ranks reach the same decision.
+ *
+ * e.g. a histogram that uses at most 5% of the solver's time, executes at
+ * least every 100 steps, and is otherwise triggered by a 10% change of the
+ * maximum of the pressure:
+ *
+ *   <analysis type="histogram" mesh="mesh" array="pressure" association="cell"
+ *       time_budget="0.05" max_interval="100" enabled="1">
+ *     <trigger mesh="mesh" array="pressure" association="cell"
+ *        metric="max" change="0.1"/>
+ *   </analysis>
+ */
+class SENSEI_EXPORT AnalysisScheduler
+{
+public:
+  AnalysisScheduler() : SolverTime(0.0) {}
+
+  /** Set the policy of the analyses added since the last call, up to
+   * nAnalyses in total, from the XML element. Returns 0 if successful.
+   */
+  int AddAnalyses(unsigned int nAnalyses, pugi::xml_node node);
+
+  /// Returns true if any analysis has a policy.
+  bool GetActive() const;
+
+  /** Decide which analyses execute at the current time step, given the
+   * wall-clock time the solver used since the last call. execute is set to
+   * 1 for each analysis that executes and 0 for each that is skipped.
+   * Collective over comm when a policy uses a budget or triggers. Returns 0
+   * if successful.
+   */
+  int Schedule(MPI_Comm comm, DataAdaptor *data, double solverTime,
+    std::vector<int> &execute);
+
+  /** Record the wall-clock time the ai'th analysis took to execute. This
+   * may be called concurrently for different analyses.
+   */
+  void SetExecutionTime(unsigned int ai, double seconds);
+
+  /** Get the number of times the ai'th analysis was scheduled to execute.
+   * Only counted for analyses with a policy.
+   */
+  long GetNumberOfExecutions(unsigned int ai) const;
+
+  /** Get the number of time steps offered to the ai'th analysis. Only
+   * counted for analyses with a policy.
+   */
+  long GetNumberOfSteps(unsigned int ai) const;
+
+  /// Returns true if the ai'th analysis has a policy.
+  bool GetActive(unsigned int ai) const;
+
+private:
+  struct TriggerType
+  {
+    std::string Mesh;
+    std::string Array;
+    int Association;
+    bool Max;
+    double Change;
+    double Reference;   // the value when the analysis last executed
+  };
+
+  struct PolicyType
+  {
+    PolicyType() : Active(false), TimeBudget(0.0), MinInterval(0),
+      MaxInterval(0), LastStep(-1), AnalysisTime(0.0), Cost(0.0),
+      LastTime(0.0), NumExecutions(0), NumSteps(0) {}
+
+    bool Active;
+    double TimeBudget;
+    long MinInterval;
+    long MaxInterval;
+    std::vector<TriggerType> Triggers;
+
+    long LastStep;        // the step the analysis last executed
+    double AnalysisTime;  // accumulated execution time, max over ranks
+    double Cost;          // time of the last execution, max over ranks
+    double LastTime;      // time of the last execution on this rank
+    long NumExecutions;
+    long NumSteps;
+  };
+
+  int GetRange(DataAdaptor *data, const TriggerType &trigger,
+    std::map<std::string, MeshMetadataPtr> &metadata, double range[2]);
+
+  std::vector<PolicyType> Policies;
+  double SolverTime;  // accumulated solver time, max over ranks
+};
+
+}
+
+#endif
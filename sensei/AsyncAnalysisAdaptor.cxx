@@ -0,0 +1,659 @@
+#include "AsyncAnalysisAdaptor.h"
+#include "SVTKDataAdaptor.h"
+#include "SVTKUtils.h"
+#include "MeshMetadata.h"
+#include "MeshMetadataMap.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <svtkDataObject.h>
+#include <svtkDataSet.h>
+#include <svtkFieldData.h>
+#include <svtkDataArray.h>
+#include <svtkObjectFactory.h>
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <limits>
+
+namespace sensei
+{
+
+namespace
+{
+/* A data adaptor serving the data captured in a snapshot. In addition to
+ * what SVTKDataAdaptor provides, the ghost arrays captured from the
+ * simulation are served.
+ */
+class SnapshotDataAdaptor : public SVTKDataAdaptor
+{
+public:
+  static SnapshotDataAdaptor *New();
+  senseiTypeMacro(SnapshotDataAdaptor, SVTKDataAdaptor);
+
+  int AddGhostNodesArray(svtkDataObject *mesh,
+    const std::string &meshName) override
+  {
+    return this->AddGhostArray(mesh, meshName, svtkDataObject::POINT);
+  }
+
+  int AddGhostCellsArray(svtkDataObject *mesh,
+    const std::string &meshName) override
+  {
+    return this->AddGhostArray(mesh, meshName, svtkDataObject::CELL);
+  }
+
+protected:
+  SnapshotDataAdaptor() {}
+  ~SnapshotDataAdaptor() {}
+
+  // shares the ghost array with the mesh when it was captured
+  int AddGhostArray(svtkDataObject *mesh, const std::string &meshName,
+    int association)
+  {
+    svtkDataObject *dobj = nullptr;
+    if (this->GetDataObject(meshName, dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    SVTKUtils::BinaryDatasetFunction addGhosts =
+      [&](svtkDataSet *ds, svtkDataSet *dsOut) -> int
+      {
+      svtkDataArray *da =
+        SVTKUtils::GetAttributes(ds, association)->GetArray("svtkGhostType");
+
+      if (da)
+        SVTKUtils::GetAttributes(dsOut, association)->AddArray(da);
+
+      return 0;
+      };
+
+    return SVTKUtils::Apply(dobj, mesh, addGhosts);
+  }
+};
+
+senseiNewMacro(SnapshotDataAdaptor);
+
+using SnapshotDataAdaptorPtr = svtkSmartPointer<SnapshotDataAdaptor>;
+
+// the data captured for one time step
+struct Snapshot
+{
+  Snapshot() : Index(0), Running(false), Copied(false), Dropped(false) {}
+
+  SnapshotDataAdaptorPtr Data;
+  std::vector<std::string> MeshNames;
+  long Index;     // the number of time steps offered before this one
+  bool Running;
+  bool Copied;
+  bool Dropped;   // discarded by the queue policy before it was started
+};
+
+using SnapshotPtr = std::shared_ptr<Snapshot>;
+
+// --------------------------------------------------------------------------
+svtkDataObject *DeepCopy(svtkDataObject *dobj)
+{
+  svtkDataObject *copy = dobj->NewInstance();
+  copy->DeepCopy(dobj);
+  return copy;
+}
+}
+
+struct AsyncAnalysisAdaptor::InternalsType
+{
+  InternalsType() : SnapshotMode(AsyncAnalysisAdaptor::ZERO_COPY),
+    MaxQueueLength(1), QueuePolicy(AsyncAnalysisAdaptor::BLOCK),
+    NumSteps(0), NumDropped(0), Asynchronous(false), Error(false) {}
+
+  // capture the required data from the simulation
+  int MakeSnapshot(DataAdaptor *data, const SnapshotPtr &snap);
+
+  // deep copy the meshes held by the snapshot
+  int CopySnapshot(const SnapshotPtr &snap);
+
+  // executes the analysis on the snapshot. called from the background thread
+  void Process(const SnapshotPtr &snap);
+
+  // applies a drop policy when a time step arrives. returns true if the
+  // arriving step is to be skipped. called with the queue locked
+  bool ApplyQueuePolicy(MPI_Comm comm);
+
+  svtkSmartPointer<AnalysisAdaptor> Analysis;
+  DataRequirements Requirements;
+  int SnapshotMode;
+  int MaxQueueLength;
+  int QueuePolicy;
+  long NumSteps;
+  long NumDropped;
+  bool Asynchronous;
+  bool Error;
+
+  // the background thread
+  ThreadPool Pool;
+
+  // snapshots in flight, oldest first, and the data adaptors available for
+  // new snapshots. data adaptors are allocated up front since doing so
+  // involves a collective communicator duplication.
+  std::deque<SnapshotPtr> Queue;
+  std::vector<SnapshotDataAdaptorPtr> Free;
+  std::mutex QueueMutex;
+  std::condition_variable QueueCondition;
+};
+
+// --------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::InternalsType::MakeSnapshot(DataAdaptor *data,
+  const SnapshotPtr &snap)
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::MakeSnapshot");
+
+  snap->Data->SetDataTime(data->GetDataTime());
+  snap->Data->SetDataTimeStep(data->GetDataTimeStep());
+
+  // when no subset is specified capture everything
+  DataRequirements allReqs;
+  if (this->Requirements.Empty() && allReqs.Initialize(data, false))
+    {
+    SENSEI_ERROR("Failed to initialize data requirements")
+    return -1;
+    }
+
+  const DataRequirements &reqs =
+    this->Requirements.Empty() ? allReqs : this->Requirements;
+
+  // the simulation's metadata tells us which ghost arrays are available
+  MeshMetadataMap mdm;
+  if (mdm.Initialize(data))
+    {
+    SENSEI_ERROR("Failed to get metadata")
+    return -1;
+    }
+
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    const std::string &meshName = mit.MeshName();
+
+    MeshMetadataPtr md;
+    if (mdm.GetMeshMetadata(meshName, md))
+      {
+      SENSEI_ERROR("Failed to get mesh metadata for mesh \""
+        << meshName << "\"")
+      return -1;
+      }
+
+    svtkDataObject *dobj = nullptr;
+    if (data->GetMesh(meshName, mit.StructureOnly(), dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    if ((md->NumGhostCells || SVTKUtils::AMR(md)) &&
+      data->AddGhostCellsArray(dobj, meshName))
+      {
+      SENSEI_ERROR("Failed to get ghost cells for mesh \"" << meshName << "\"")
+      dobj->Delete();
+      return -1;
+      }
+
+    if (md->NumGhostNodes && data->AddGhostNodesArray(dobj, meshName))
+      {
+      SENSEI_ERROR("Failed to get ghost nodes for mesh \"" << meshName << "\"")
+      dobj->Delete();
+      return -1;
+      }
+
+    ArrayRequirementsIterator ait = reqs.GetArrayRequirementsIterator(meshName);
+    for (; ait; ++ait)
+      {
+      if (data->AddArray(dobj, meshName, ait.Association(), ait.Array()))
+        {
+        SENSEI_ERROR("Failed to add "
+          << SVTKUtils::GetAttributesName(ait.Association())
+          << " data array \"" << ait.Array() << "\" to mesh \""
+          << meshName << "\"")
+        dobj->Delete();
+        return -1;
+        }
+      }
+
+    if (this->SnapshotMode == AsyncAnalysisAdaptor::DEEP_COPY)
+      {
+      svtkDataObject *copy = DeepCopy(dobj);
+      dobj->Delete();
+      dobj = copy;
+      }
+
+    snap->Data->SetDataObject(meshName, dobj);
+    snap->MeshNames.push_back(meshName);
+
+    dobj->Delete();
+    }
+
+  snap->Copied = this->SnapshotMode == AsyncAnalysisAdaptor::DEEP_COPY;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::InternalsType::CopySnapshot(const SnapshotPtr &snap)
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::CopySnapshot");
+
+  unsigned int nMeshes = snap->MeshNames.size();
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    const std::string &meshName = snap->MeshNames[i];
+
+    svtkDataObject *dobj = nullptr;
+    if (snap->Data->GetDataObject(meshName, dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    svtkDataObject *copy = DeepCopy(dobj);
+    snap->Data->SetDataObject(meshName, copy);
+    copy->Delete();
+    }
+
+  snap->Copied = true;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::InternalsType::Process(const SnapshotPtr &snap)
+{
+  {
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+
+  // its data adaptor was recycled when it was dropped
+  if (snap->Dropped)
+    return;
+
+  snap->Running = true;
+  }
+
+  bool ok = this->Analysis->Execute(snap->Data.GetPointer(), nullptr);
+  if (!ok)
+    {
+    SENSEI_ERROR("Failed to execute " << this->Analysis->GetClassName()
+      << " at step " << snap->Data->GetDataTimeStep())
+    }
+
+  snap->Data->ReleaseData();
+
+  {
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+  this->Error = this->Error || !ok;
+  this->Free.push_back(snap->Data);
+  this->Queue.erase(std::find(this->Queue.begin(), this->Queue.end(), snap));
+  }
+
+  this->QueueCondition.notify_all();
+}
+
+// --------------------------------------------------------------------------
+bool AsyncAnalysisAdaptor::InternalsType::ApplyQueuePolicy(MPI_Comm comm)
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::ApplyQueuePolicy");
+
+  // snapshots are processed in order. those after the one running have not
+  // been started
+  long oldest = std::numeric_limits<long>::max();
+  std::deque<SnapshotPtr>::iterator it = this->Queue.begin();
+  std::deque<SnapshotPtr>::iterator end = this->Queue.end();
+  for (; it != end; ++it)
+    {
+    if (!(*it)->Running)
+      {
+      oldest = (*it)->Index;
+      break;
+      }
+    }
+
+  // ranks progress through the queue at different rates. they agree on
+  // whether any rank's queue is full, and on the oldest step that has not
+  // been started on any rank, the largest of the ranks' oldest. the
+  // background thread can not start a snapshot while we hold the lock.
+  long vals[2] = {int(this->Queue.size()) >= this->MaxQueueLength, oldest};
+  MPI_Allreduce(MPI_IN_PLACE, vals, 2, MPI_LONG, MPI_MAX, comm);
+
+  if (!vals[0])
+    return false;
+
+  ++this->NumDropped;
+
+  if ((this->QueuePolicy == AsyncAnalysisAdaptor::DROP_OLDEST) &&
+    (vals[1] < std::numeric_limits<long>::max()))
+    {
+    it = std::find_if(this->Queue.begin(), this->Queue.end(),
+      [vals](const SnapshotPtr &snap) { return snap->Index == vals[1]; });
+
+    SnapshotPtr snap = *it;
+    snap->Dropped = true;
+    snap->Data->ReleaseData();
+
+    this->Free.push_back(snap->Data);
+    this->Queue.erase(it);
+
+    return false;
+    }
+
+  // DROP_NEWEST, or all queued snapshots have been started on some rank
+  return true;
+}
+
+
+//----------------------------------------------------------------------------
+senseiNewMacro(AsyncAnalysisAdaptor);
+
+//----------------------------------------------------------------------------
+AsyncAnalysisAdaptor::AsyncAnalysisAdaptor()
+{
+  this->Internals = new InternalsType;
+}
+
+//----------------------------------------------------------------------------
+AsyncAnalysisAdaptor::~AsyncAnalysisAdaptor()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::SetAnalysisAdaptor(AnalysisAdaptor *analysis)
+{
+  this->Internals->Analysis = analysis;
+}
+
+//----------------------------------------------------------------------------
+AnalysisAdaptor *AsyncAnalysisAdaptor::GetAnalysisAdaptor()
+{
+  return this->Internals->Analysis.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::SetDataRequirements(const DataRequirements &reqs)
+{
+  this->Internals->Requirements = reqs;
+}
+
+//----------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::SetSnapshotMode(int mode)
+{
+  this->Internals->SnapshotMode = mode;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::GetSnapshotMode() const
+{
+  return this->Internals->SnapshotMode;
+}
+
+//----------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::SetMaxQueueLength(int n)
+{
+  this->Internals->MaxQueueLength = std::max(1, n);
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::GetMaxQueueLength() const
+{
+  return this->Internals->MaxQueueLength;
+}
+
+//----------------------------------------------------------------------------
+void AsyncAnalysisAdaptor::SetQueuePolicy(int policy)
+{
+  this->Internals->QueuePolicy = policy;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::GetQueuePolicy() const
+{
+  return this->Internals->QueuePolicy;
+}
+
+//----------------------------------------------------------------------------
+long AsyncAnalysisAdaptor::GetNumberOfDroppedSteps() const
+{
+  return this->Internals->NumDropped;
+}
+
+//----------------------------------------------------------------------------
+bool AsyncAnalysisAdaptor::GetAsynchronous() const
+{
+  return this->Internals->Asynchronous;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::Initialize()
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::Initialize");
+
+  if (!this->Internals->Analysis)
+    {
+    SENSEI_ERROR("An analysis adaptor was not set")
+    return -1;
+    }
+
+  // the analysis communicates on the background thread while the
+  // simulation communicates on this one
+  int threadLevel = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&threadLevel);
+  if (threadLevel < MPI_THREAD_MULTIPLE)
+    {
+    SENSEI_WARNING("Asynchronous execution of "
+      << this->Internals->Analysis->GetClassName() << " was requested but"
+      " MPI was not initialized with MPI_THREAD_MULTIPLE. The analysis will"
+      " be executed synchronously.")
+    this->Internals->Asynchronous = false;
+    return 0;
+    }
+
+  // allocate the snapshots up front. the data adaptors serving the snapshots
+  // communicate on the background thread using a duplicate of the analysis'
+  // communicator
+  int nSnapshots = this->Internals->MaxQueueLength;
+  for (int i = 0; i < nSnapshots; ++i)
+    {
+    SnapshotDataAdaptorPtr snapData = SnapshotDataAdaptorPtr::New();
+    snapData->SetCommunicator(this->Internals->Analysis->GetCommunicator());
+    this->Internals->Free.push_back(snapData);
+    }
+
+  if (this->Internals->Pool.Initialize(1))
+    {
+    SENSEI_ERROR("Failed to start the background thread")
+    return -1;
+    }
+
+  this->Internals->Asynchronous = true;
+
+  if (this->GetVerbose())
+    {
+    const char *policies[] = {"block", "drop_newest", "drop_oldest"};
+    SENSEI_STATUS("Executing " << this->Internals->Analysis->GetClassName()
+      << " asynchronously with " << nSnapshots << " time steps in flight ("
+      << policies[this->Internals->QueuePolicy] << ")"
+      << " using " << (this->Internals->SnapshotMode == ZERO_COPY ?
+      "zero-copy" : "deep-copy") << " snapshots")
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+bool AsyncAnalysisAdaptor::Execute(DataAdaptor *dataIn, DataAdaptor **dataOut)
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::Execute");
+
+  if (!this->Internals->Analysis)
+    {
+    SENSEI_ERROR("An analysis adaptor was not set")
+    return false;
+    }
+
+  // fall back to synchronous execution
+  if (!this->Internals->Asynchronous)
+    return this->Internals->Analysis->Execute(dataIn, dataOut);
+
+  // apply back-pressure. when the queue is full wait for the oldest
+  // snapshot to be processed, or drop a time step
+  SnapshotPtr snap = std::make_shared<Snapshot>();
+  {
+  TimeEvent<128> waitMark("AsyncAnalysisAdaptor::Wait");
+
+  std::unique_lock<std::mutex> lock(this->Internals->QueueMutex);
+
+  bool skip = false;
+  if (this->Internals->QueuePolicy == BLOCK)
+    {
+    this->Internals->QueueCondition.wait(lock, [this]()
+      {
+      return int(this->Internals->Queue.size()) < this->Internals->MaxQueueLength;
+      });
+    }
+  else
+    {
+    skip = this->Internals->ApplyQueuePolicy(this->GetCommunicator());
+    }
+
+  snap->Index = this->Internals->NumSteps++;
+
+  if (this->Internals->Error)
+    {
+    SENSEI_ERROR("Asynchronous execution of "
+      << this->Internals->Analysis->GetClassName() << " failed")
+    return false;
+    }
+
+  if (skip)
+    return true;
+
+  snap->Data = this->Internals->Free.back();
+  this->Internals->Free.pop_back();
+  }
+
+  // capture the data
+  if (this->Internals->MakeSnapshot(dataIn, snap))
+    {
+    SENSEI_ERROR("Failed to capture the data for step "
+      << dataIn->GetDataTimeStep())
+    snap->Data->ReleaseData();
+    std::lock_guard<std::mutex> lock(this->Internals->QueueMutex);
+    this->Internals->Free.push_back(snap->Data);
+    return false;
+    }
+
+  // hand it to the background thread
+  {
+  std::lock_guard<std::mutex> lock(this->Internals->QueueMutex);
+  this->Internals->Queue.push_back(snap);
+  }
+
+  this->Internals->Pool.Push([this, snap]() { this->Internals->Process(snap); });
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::PrepareToModify()
+{
+  if (!this->Internals->Asynchronous ||
+    (this->Internals->SnapshotMode == DEEP_COPY))
+    return 0;
+
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::PrepareToModify");
+
+  std::unique_lock<std::mutex> lock(this->Internals->QueueMutex);
+
+  // copy the snapshots that have not been started. the background thread
+  // can not start them while we hold the lock
+  std::deque<SnapshotPtr>::iterator it = this->Internals->Queue.begin();
+  std::deque<SnapshotPtr>::iterator end = this->Internals->Queue.end();
+  for (; it != end; ++it)
+    {
+    SnapshotPtr &snap = *it;
+    if (!snap->Running && !snap->Copied && this->Internals->CopySnapshot(snap))
+      {
+      SENSEI_ERROR("Failed to copy the snapshot of step "
+        << snap->Data->GetDataTimeStep())
+      return -1;
+      }
+    }
+
+  // wait for the one in progress
+  this->Internals->QueueCondition.wait(lock, [this]()
+    {
+    return this->Internals->Queue.empty() ||
+      this->Internals->Queue.front()->Copied;
+    });
+
+  return this->Internals->Error ? -1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::Synchronize()
+{
+  if (!this->Internals->Asynchronous)
+    return 0;
+
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::Synchronize");
+
+  std::unique_lock<std::mutex> lock(this->Internals->QueueMutex);
+
+  this->Internals->QueueCondition.wait(lock,
+    [this]() { return this->Internals->Queue.empty(); });
+
+  return this->Internals->Error ? -1 : 0;
+}
+
+//----------------------------------------------------------------------------
+int AsyncAnalysisAdaptor::Finalize()
+{
+  TimeEvent<128> mark("AsyncAnalysisAdaptor::Finalize");
+
+  int ierr = 0;
+
+  if (this->Internals->Asynchronous)
+    {
+    if (this->Synchronize())
+      {
+      SENSEI_ERROR("Asynchronous execution of "
+        << this->Internals->Analysis->GetClassName() << " failed")
+      ierr = -1;
+      }
+
+    this->Internals->Pool.Finalize();
+    this->Internals->Free.clear();
+    this->Internals->Asynchronous = false;
+
+    if (this->Internals->NumDropped)
+      {
+      SENSEI_STATUS("Dropped " << this->Internals->NumDropped << " of "
+        << this->Internals->NumSteps << " time steps offered to "
+        << this->Internals->Analysis->GetClassName())
+      }
+    }
+
+  if (this->Internals->Analysis && this->Internals->Analysis->Finalize())
+    {
+    SENSEI_ERROR("Failed to finalize "
+      << this->Internals->Analysis->GetClassName())
+    ierr = -1;
+    }
+
+  return ierr;
+}
+
+}
@@ -0,0 +1,141 @@
+#ifndef sensei_AsyncAnalysisAdaptor_h
+#define sensei_AsyncAnalysisAdaptor_h
+
+#include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
+
+#include <svtkSmartPointer.h>
+
+#include <memory>
+
+namespace sensei
+{
+
+/** An analysis adaptor that executes another analysis adaptor asynchronously
+ * so that the simulation does not block while the analysis runs. In Execute
+ * the meshes and arrays named in the data requirements are captured in a
+ * snapshot which is handed to a background thread, and control returns to
+ * the simulation immediately. The wrapped analysis processes the snapshot on
+ * the background thread using its own communicator.
+ *
+ * Back-pressure is provided by a bounded queue. At most MaxQueueLength
+ * snapshots may be in flight (queued or being processed). What happens when
+ * the queue is full is set by the queue policy. With BLOCK, the default,
+ * Execute blocks until the oldest snapshot has been processed. With
+ * DROP_NEWEST the arriving time step is skipped. With DROP_OLDEST the oldest
+ * snapshot that has not been started is discarded to make room, or the
+ * arriving time step is skipped when all have been started. The drop
+ * policies decide collectively so that all ranks process the same time
+ * steps, which costs a small all reduce per time step.
+ *
+ * Two snapshot modes are supported. In ZERO_COPY mode (the default) the
+ * snapshot references the simulation's arrays. The simulation promises not to
+ * modify them until they have been processed, or must call PrepareToModify
+ * before it does so. PrepareToModify deep copies the data held by queued
+ * snapshots (copy-on-write) and waits for the snapshot being processed to
+ * complete, serializing the simulation with that analysis. A simulation that
+ * must not wait writes its next step to a buffer that no snapshot references
+ * instead, as the oscillator miniapp does. A snapshot holds a reference to
+ * each of its arrays until it has been processed. In DEEP_COPY mode the snapshot is a deep copy made in Execute and
+ * the simulation is free to modify its data as soon as Execute returns.
+ *
+ * Running MPI collectives on the background thread while the simulation
+ * communicates on the calling thread requires MPI_THREAD_MULTIPLE. If MPI
+ * was not initialized with this level of support a warning is issued and the
+ * wrapped analysis is executed synchronously.
+ *
+ * Output from the wrapped analysis is not available when executing
+ * asynchronously.
+ */
+class SENSEI_EXPORT AsyncAnalysisAdaptor : public AnalysisAdaptor
+{
+public:
+  static AsyncAnalysisAdaptor *New();
+  senseiTypeMacro(AsyncAnalysisAdaptor, AnalysisAdaptor);
+
+  /// Snapshot modes
+  enum {ZERO_COPY = 0, DEEP_COPY = 1};
+
+  /// Queue policies
+  enum {BLOCK = 0, DROP_NEWEST = 1, DROP_OLDEST = 2};
+
+  /** Set the analysis to execute asynchronously. This must be called before
+   * Initialize.
+   */
+  void SetAnalysisAdaptor(AnalysisAdaptor *analysis);
+
+  /// Get the analysis executed asynchronously.
+  AnalysisAdaptor *GetAnalysisAdaptor();
+
+  /** Set the meshes and arrays that are captured in the snapshot. When
+   * empty, the default, all meshes and arrays are captured.
+   */
+  void SetDataRequirements(const DataRequirements &reqs);
+
+  /// Set the snapshot mode, either ZERO_COPY or DEEP_COPY.
+  void SetSnapshotMode(int mode);
+  int GetSnapshotMode() const;
+
+  /** Set the maximum number of time steps that may be in flight. The
+   * default is 1. This must be called before Initialize.
+   */
+  void SetMaxQueueLength(int n);
+  int GetMaxQueueLength() const;
+
+  /** Set the policy applied when a time step arrives while the queue is
+   * full, one of BLOCK, DROP_NEWEST, or DROP_OLDEST. The default is BLOCK.
+   */
+  void SetQueuePolicy(int policy);
+  int GetQueuePolicy() const;
+
+  /// Get the number of time steps dropped by the queue policy.
+  long GetNumberOfDroppedSteps() const;
+
+  /** Start the background thread. When MPI does not support concurrent
+   * calls from multiple threads no thread is started and Execute is
+   * synchronous. Returns 0 if successful.
+   */
+  int Initialize();
+
+  /** Returns true when the analysis is executed asynchronously, that is
+   * after Initialize has been called and MPI_THREAD_MULTIPLE is available.
+   */
+  bool GetAsynchronous() const;
+
+  /** Capture a snapshot of the simulation data and queue it for processing
+   * on the background thread. Blocks only when the queue is full and the
+   * queue policy is BLOCK. Collective when the queue policy is a drop policy.
+   */
+  bool Execute(DataAdaptor *dataIn, DataAdaptor **dataOut) override;
+
+  /** Called by the simulation before it modifies data that may be held by a
+   * ZERO_COPY snapshot. Snapshots that have not yet been processed are deep
+   * copied and the snapshot currently being processed, if any, is waited
+   * on, so the simulation does not overlap that analysis. Returns 0 if
+   * successful.
+   */
+  int PrepareToModify();
+
+  /// Wait for all queued snapshots to be processed. Returns 0 if successful.
+  int Synchronize();
+
+  /** Waits for queued snapshots to be processed, stops the background
+   * thread, and finalizes the wrapped analysis.
+   */
+  int Finalize() override;
+
+protected:
+  AsyncAnalysisAdaptor();
+  ~AsyncAnalysisAdaptor();
+
+  AsyncAnalysisAdaptor(const AsyncAnalysisAdaptor&) = delete;
+  void operator=(const AsyncAnalysisAdaptor&) = delete;
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
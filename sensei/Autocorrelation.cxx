@@ -18,16 +18,19 @@
 #include <svtkSmartPointer.h>
 #include <svtkStructuredData.h>
 #include <svtkUnsignedCharArray.h>
+#include <svtkSMPTools.h>
 
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 #include <sdiy/master.hpp>
 #include <sdiy/reduce.hpp>
 #include <sdiy/partners/merge.hpp>
 #include <sdiy/io/numpy.hpp>
-#include <sdiy/grid.hpp>
-#include <sdiy/vertices.hpp>
+#include <sdiy/point.hpp>
 
 
 // http://stackoverflow.com/a/12580468
@@ -61,72 +64,205 @@ template<class U> struct mpi_op<add_vectors<U>>
 namespace sensei
 {
 
-using GridRef = sdiy::GridRef<float,3>;
-using Vertex  = GridRef::Vertex;
-using Vertex4D = Vertex::UPoint;
+using Vertex  = sdiy::Point<int,3>;
 
+namespace
+{
+// converts a float to half precision, rounding to nearest even. values too
+// large are converted to infinity and values too small to zero
+uint16_t FloatToHalf(float f)
+{
+  uint32_t x;
+  memcpy(&x, &f, sizeof(float));
+
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t ax = x & 0x7fffffff;
+
+  // nan and inf
+  if (ax >= 0x7f800000)
+    return sign | (ax > 0x7f800000 ? 0x7e00 : 0x7c00);
+
+  // overflow
+  if (ax >= 0x477ff000)
+    return sign | 0x7c00;
+
+  // underflow, and subnormals
+  if (ax < 0x38800000)
+    {
+    if (ax < 0x33000000)
+      return sign;
+
+    // shift the mantissa, with its implicit bit, into place and round
+    uint32_t e = ax >> 23;
+    uint32_t m = (ax & 0x7fffff) | 0x800000;
+    uint32_t shift = 126 - e;
+    uint32_t h = m >> shift;
+    uint32_t rem = m & ((1u << shift) - 1);
+    uint32_t half = 1u << (shift - 1);
+    if ((rem > half) || ((rem == half) && (h & 1)))
+      ++h;
+    return sign | h;
+    }
+
+  // normals. rebias the exponent and round the mantissa, a carry into the
+  // exponent is the correct result
+  uint32_t h = (ax - 0x38000000) >> 13;
+  uint32_t rem = ax & 0x1fff;
+  if ((rem > 0x1000) || ((rem == 0x1000) && (h & 1)))
+    ++h;
+
+  return sign | h;
+}
+
+// converts a half to float. written without branches such that loops
+// calling it are vectorized
+inline float HalfToFloat(uint16_t h)
+{
+  // shift exponent and mantissa into place and scale by 2^112 to rebias the
+  // exponent. this handles normals and subnormals alike
+  uint32_t em = uint32_t(h & 0x7fff) << 13;
+  float f;
+  memcpy(&f, &em, sizeof(float));
+  f *= 5.192296858534828e+33f;
+
+  // the maximum exponent encodes infinity and nan, for which the scaled
+  // exponent is set to the maximum, keeping the mantissa
+  uint32_t x;
+  memcpy(&x, &f, sizeof(float));
+  x |= ((h & 0x7c00) == 0x7c00) ? 0x7f800000u : 0u;
+  x |= uint32_t(h & 0x8000) << 16;
+  memcpy(&f, &x, sizeof(float));
+
+  return f;
+}
+
+// access to the circular buffer in the supported precisions
+inline float Load(float v) { return v; }
+inline float Load(uint16_t v) { return HalfToFloat(v); }
+inline void Store(float &v, float f) { v = f; }
+inline void Store(uint16_t &v, float f) { v = FloatToHalf(f); }
+}
+
+// Accumulates the autocorrelations of a block. The circular buffer of past
+// values and the autocorrelations are stored lag-contiguous per vertex, the
+// window values of each vertex being adjacent in memory. The buffer is kept
+// in reverse time order, such that the values at lags 1 through window are
+// found at increasing addresses from the most recently stored value, wrapping
+// around at most once. Thus the lag loop is two contiguous, vectorizable
+// loops. Vertices are independent and optionally processed in parallel.
 struct AutocorrelationImpl
 {
-  using Grid = sdiy::Grid<float,4>;
-  AutocorrelationImpl(size_t window_, int gid_, Vertex from_, Vertex to_):
+  AutocorrelationImpl(size_t window_, int gid_, Vertex from_, Vertex to_,
+    int precision_, int useSMP_):
     window(window_),
     gid(gid_),
     from(from_), to(to_),
     shape(to - from + Vertex::one()),
-    // init grid with (to - from + 1) in 3D, and window in the 4-th dimension
-    values(shape.lift(3, window)),
-    corr(shape.lift(3, window))
-  { corr = 0; }
+    precision(precision_),
+    useSMP(useSMP_)
+    {
+    size_t n = window*this->size();
+
+    // init the autocorrelations and circular buffer with window values for
+    // each vertex
+    corr.assign(n, 0.0f);
+
+    if (precision == Autocorrelation::PRECISION_HALF)
+      halfValues.assign(n, 0);
+    else
+      values.assign(n, 0.0f);
+    }
 
   static void* create()            { return new AutocorrelationImpl; }
   static void destroy(void* b)    { delete static_cast<AutocorrelationImpl*>(b); }
-  void process(float* data, unsigned char *ghostArray)
+
+  // number of vertices
+  size_t size() const
+    { return size_t(shape[0])*shape[1]*shape[2]; }
+
+  // get the index space location of the vertex, SVTK ordering
+  Vertex vertex(size_t idx) const
     {
-    GridRef g(data, shape);
+    size_t nx = shape[0];
+    size_t nxy = nx*shape[1];
+    Vertex v;
+    v[0] = from[0] + idx % nx;
+    v[1] = from[1] + (idx % nxy) / nx;
+    v[2] = from[2] + idx / nxy;
+    return v;
+    }
 
-    if (ghostArray)
+  // process a range of vertices
+  template <typename buffer_t>
+  struct Functor
+  {
+    void operator()(svtkIdType v0, svtkIdType v1) const
       {
-      sdiy::GridRef<unsigned char, 3> ghost(ghostArray, shape);
-      // record the values
-      sdiy::for_each(g.shape(), [&](const Vertex& v)
-        {
-        auto gv = (ghost(v) == 0) ? g(v) : 0;
+      size_t w = this->Window;
+      size_t nLags = this->NumLags;
+      size_t head = this->Head;
+      size_t newHead = (head + w - 1) % w;
 
-        for (size_t i = 1; i <= window; ++i)
+      // the lags found before and after the wrap
+      size_t n1 = std::min(nLags, w - head);
+      size_t n2 = nLags - n1;
+
+      for (svtkIdType v = v0; v < v1; ++v)
         {
-        if (i > count) continue;    // during the initial fill, we don't get contributions to some shifts
+        float gv = (this->Ghosts && this->Ghosts[v]) ? 0.0f : this->Data[v];
 
-        auto uc = v.lift(3, i-1);
-        auto uv = v.lift(3, (offset + window - i) % window);
-        corr(uc) += values(uv)*gv;
-        }
+        buffer_t *buf = this->Values + v*w;
+        float *corr = this->Corr + v*w;
 
-        auto u = v.lift(3, offset);
-        values(u) = gv;
-        });
-      }
-    else
-      {
-      // record the values
-      sdiy::for_each(g.shape(), [&](const Vertex& v)
-        {
-        auto gv = g(v);
+        const buffer_t *buf1 = buf + head;
+        for (size_t i = 0; i < n1; ++i)
+          corr[i] += Load(buf1[i])*gv;
 
-        for (size_t i = 1; i <= window; ++i)
-        {
-        if (i > count) continue;    // during the initial fill, we don't get contributions to some shifts
+        float *corr2 = corr + n1;
+        for (size_t i = 0; i < n2; ++i)
+          corr2[i] += Load(buf[i])*gv;
 
-        auto uc = v.lift(3, i-1);
-        auto uv = v.lift(3, (offset + window - i) % window);
-        corr(uc) += values(uv)*gv;
+        Store(buf[newHead], gv);
         }
-
-        auto u = v.lift(3, offset);
-        values(u) = gv;
-        });
       }
-    offset += 1;
-    offset %= window;
+
+    const float *Data;
+    const unsigned char *Ghosts;
+    buffer_t *Values;
+    float *Corr;
+    size_t Window;
+    size_t NumLags;
+    size_t Head;
+  };
+
+  template <typename buffer_t>
+  void process(const float* data, const unsigned char *ghostArray,
+    buffer_t *vals)
+    {
+    Functor<buffer_t> func;
+    func.Data = data;
+    func.Ghosts = ghostArray;
+    func.Values = vals;
+    func.Corr = corr.data();
+    func.Window = window;
+    // during the initial fill, we don't get contributions to some shifts
+    func.NumLags = std::min(count, window);
+    func.Head = head;
+
+    if (useSMP)
+      svtkSMPTools::For(0, this->size(), func);
+    else
+      func(0, this->size());
+    }
+
+  void process(const float* data, const unsigned char *ghostArray)
+    {
+    if (precision == Autocorrelation::PRECISION_HALF)
+      this->process(data, ghostArray, halfValues.data());
+    else
+      this->process(data, ghostArray, values.data());
+
+    head = (head + window - 1) % window;
 
     ++count;
     }
@@ -134,10 +270,13 @@ struct AutocorrelationImpl
   size_t          window;
   int             gid;
   Vertex          from, to, shape;
-  Grid            values;     // circular buffer of last `window` values
-  Grid            corr;       // autocorrelations for different time shifts
+  int             precision;
+  int             useSMP;
+  std::vector<float> values;        // circular buffer of last `window` values
+  std::vector<uint16_t> halfValues; // same, in half precision
+  std::vector<float> corr;          // autocorrelations for different time shifts
 
-  size_t          offset = 0;
+  size_t          head = 0;         // where the most recent value is stored
   size_t          count  = 0;
 
 private:
@@ -154,11 +293,14 @@ public:
   int Association;
   std::string ArrayName;
   size_t Window;
+  int Precision;
+  int UseSMP;
   bool BlocksInitialized;
   size_t NumberOfBlocks;
 
   AInternals() : KMax(3), Association(svtkDataObject::POINT),
-    Window(10), BlocksInitialized(false), NumberOfBlocks(0) {}
+    Window(10), Precision(Autocorrelation::PRECISION_FLOAT), UseSMP(1),
+    BlocksInitialized(false), NumberOfBlocks(0) {}
 
   void InitializeBlocks(svtkDataObject* dobj)
     {
@@ -181,7 +323,8 @@ public:
       Vertex from { ext[0], ext[2], ext[4] };
       Vertex to   { ext[1], ext[3], ext[5] };
       int bid = this->Master->communicator().rank();
-      AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to);
+      AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to,
+        this->Precision, this->UseSMP);
       this->Master->add(bid, b, new sdiy::Link);
       this->NumberOfBlocks = this->Master->communicator().size();
       }
@@ -210,7 +353,8 @@ public:
           Vertex from { ext[0], ext[2], ext[4] };
           Vertex to   { ext[1], ext[3], ext[5] };
 
-          AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to);
+          AutocorrelationImpl* b = new AutocorrelationImpl(this->Window, bid, from, to,
+        this->Precision, this->UseSMP);
           this->Master->add(bid, b, new sdiy::Link);
           }
         }
@@ -253,6 +397,25 @@ void Autocorrelation::Initialize(size_t window, const std::string &meshName,
   internals.KMax = kmax;
 }
 
+//-----------------------------------------------------------------------------
+int Autocorrelation::SetBufferPrecision(int precision)
+{
+  if ((precision != PRECISION_FLOAT) && (precision != PRECISION_HALF))
+    {
+    SENSEI_ERROR("Invalid buffer precision " << precision)
+    return -1;
+    }
+
+  this->Internals->Precision = precision;
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+void Autocorrelation::SetUseSMP(int useSMP)
+{
+  this->Internals->UseSMP = useSMP;
+}
+
 //-----------------------------------------------------------------------------
 bool Autocorrelation::Execute(DataAdaptor* dataIn, DataAdaptor** dataOut)
 {
@@ -333,7 +496,7 @@ bool Autocorrelation::Execute(DataAdaptor* dataIn, DataAdaptor** dataOut)
         svtkFloatArray* fa = svtkFloatArray::SafeDownCast(
           dataObj->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
         svtkUnsignedCharArray *gc = svtkUnsignedCharArray::SafeDownCast(
-          dataObj->GetCellData()->GetArray("svtkGhostType"));
+          dataObj->GetAttributesAsFieldData(association)->GetArray("svtkGhostType"));
         if (fa)
           {
           corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
@@ -354,7 +517,7 @@ bool Autocorrelation::Execute(DataAdaptor* dataIn, DataAdaptor** dataOut)
     svtkFloatArray* fa = svtkFloatArray::SafeDownCast(
       ds->GetAttributesAsFieldData(association)->GetArray(internals.ArrayName.c_str()));
     svtkUnsignedCharArray *gc = svtkUnsignedCharArray::SafeDownCast(
-      ds->GetCellData()->GetArray("svtkGhostType"));
+      ds->GetAttributesAsFieldData(association)->GetArray("svtkGhostType"));
     if (fa)
       {
       corr->process(fa->GetPointer(0), gc ? gc->GetPointer(0) : nullptr);
@@ -383,11 +546,13 @@ void Autocorrelation::PrintResults(size_t k_max)
   internals.Master->foreach([](AutocorrelationImpl* b, const sdiy::Master::ProxyWithLink& cp)
                                      {
                                         std::vector<float> sums(b->window, 0);
-                                        sdiy::for_each(b->corr.shape(), [&](const Vertex4D& v)
+                                        size_t n = b->size();
+                                        for (size_t i = 0; i < n; ++i)
                                         {
-                                            size_t w = v[3];
-                                            sums[w] += b->corr(v);
-                                        });
+                                            const float *corr = b->corr.data() + i*b->window;
+                                            for (size_t w = 0; w < b->window; ++w)
+                                                sums[w] += corr[w];
+                                        }
 
                                         cp.all_reduce(sums, add_vectors<float>());
                                      });
@@ -425,22 +590,25 @@ void Autocorrelation::PrintResults(size_t k_max)
                   MaxHeapVector maxs(b->window);
                   if (rp.in_link().size() == 0)
                   {
-                      sdiy::for_each(b->corr.shape(), [&](const Vertex4D& v)
+                      size_t n = b->size();
+                      for (size_t i = 0; i < n; ++i)
                       {
-                          size_t offset = v[3];
-                          float val = b->corr(v);
-                          auto& max = maxs[offset];
-                          if (max.size() < k_max)
+                          for (size_t offset = 0; offset < b->window; ++offset)
                           {
-                              max.emplace_back(val, v.drop(3) + b->from);
-                              std::push_heap(max.begin(), max.end(), Compare());
-                          } else if (val > std::get<0>(max[0]))
-                          {
-                              std::pop_heap(max.begin(), max.end(), Compare());
-                              maxs[offset].back() = std::make_tuple(val, v.drop(3) + b->from);
-                              std::push_heap(max.begin(), max.end(), Compare());
+                              float val = b->corr[i*b->window + offset];
+                              auto& max = maxs[offset];
+                              if (max.size() < k_max)
+                              {
+                                  max.emplace_back(val, b->vertex(i));
+                                  std::push_heap(max.begin(), max.end(), Compare());
+                              } else if (val > std::get<0>(max[0]))
+                              {
+                                  std::pop_heap(max.begin(), max.end(), Compare());
+                                  maxs[offset].back() = std::make_tuple(val, b->vertex(i));
+                                  std::push_heap(max.begin(), max.end(), Compare());
+                              }
                           }
-                      });
+                      }
                   } else
                   {
                       for (long i = 0; i < rp.in_link().size(); ++i)
@@ -7,10 +7,25 @@
 
 namespace sensei
 {
-/// Performs a temporal autocorrelation on the simulation data
+/** Performs a temporal autocorrelation on the simulation data. For each
+ * vertex the products of the current value with the values at lags 1 through
+ * window are accumulated. The past values are held in a circular buffer.
+ *
+ * The buffer and the autocorrelations are stored lag-contiguous per vertex
+ * and the lag loop is vectorized. Vertices are processed in parallel using
+ * SVTK's SMP backend unless disabled with SetUseSMP. The buffer may be stored
+ * in half precision to halve its footprint (see SetBufferPrecision). Half
+ * precision has about 3 significant digits. Values below 6e-5 in magnitude
+ * are stored as subnormals with reduced precision, those below 6e-8 are
+ * stored as 0, and those above 65504 overflow to infinity, which makes the
+ * correlations of the vertex infinite or nan.
+ */
 class SENSEI_EXPORT Autocorrelation : public AnalysisAdaptor
 {
 public:
+  /// precisions the circular buffer of past values may be stored in
+  enum {PRECISION_FLOAT = 0, PRECISION_HALF = 1};
+
   /// Allocate a new Autocorrelation instance
   static Autocorrelation* New();
 
@@ -32,6 +47,17 @@ public:
     int association, const std::string &arrayName, size_t kMax,
     int numThreads = 1);
 
+  /** Set the precision of the circular buffer of past values. Either
+   * PRECISION_FLOAT, the default, or PRECISION_HALF. Autocorrelations are
+   * accumulated in single precision in either case. Must be called before
+   * the first call to Execute. Returns zero if successful.
+   */
+  int SetBufferPrecision(int precision);
+
+  /// Enable or disable processing vertices in parallel, enabled by default.
+  /// Must be called before the first call to Execute.
+  void SetUseSMP(int useSMP);
+
   /// Incrementally computes autocorrelation on the current simulation state
   bool Execute(DataAdaptor* data, DataAdaptor**) override;
 
@@ -1,4 +1,6 @@
 #include "BinaryStream.h"
+
+#include <algorithm>
 #include <mpi.h>
 
 namespace sensei
@@ -6,7 +8,14 @@ namespace sensei
 
 //-----------------------------------------------------------------------------
 BinaryStream::BinaryStream()
-   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr)
+   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr),
+   mOwner(true)
+{}
+
+//-----------------------------------------------------------------------------
+BinaryStream::BinaryStream(unsigned char *data, unsigned long nBytes)
+   : mSize(nBytes), mData(data), mReadPtr(data), mWritePtr(data + nBytes),
+   mOwner(false)
 {}
 
 //-----------------------------------------------------------------------------
@@ -17,12 +26,14 @@ BinaryStream::~BinaryStream() noexcept
 
 //-----------------------------------------------------------------------------
 BinaryStream::BinaryStream(const BinaryStream &other)
-   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr)
+   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr),
+   mOwner(true)
 { *this = other; }
 
 //-----------------------------------------------------------------------------
 BinaryStream::BinaryStream(BinaryStream &&other) noexcept
-   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr)
+   : mSize(0), mData(nullptr), mReadPtr(nullptr), mWritePtr(nullptr),
+   mOwner(true)
 { this->Swap(other); }
 
 //-----------------------------------------------------------------------------
@@ -32,6 +43,10 @@ const BinaryStream &BinaryStream::operator=(
   if (&other == this)
     return *this;
 
+  // copies always own their data
+  if (!mOwner)
+    this->Clear();
+
   this->Resize(other.mSize);
   unsigned long inUse = other.mWritePtr - other.mData;
   memcpy(mData, other.mData, inUse);
@@ -53,20 +68,19 @@ const BinaryStream &BinaryStream::operator=(
 //-----------------------------------------------------------------------------
 void BinaryStream::Clear() noexcept
 {
-  free(mData);
+  if (mOwner)
+    free(mData);
+
   mData = nullptr;
   mReadPtr = nullptr;
   mWritePtr = nullptr;
   mSize = 0;
+  mOwner = true;
 }
 
 //-----------------------------------------------------------------------------
 void BinaryStream::Resize(unsigned long nBytes)
 {
-  // no change
-  if (nBytes == mSize)
-    return;
-
   // free
   if (nBytes == 0)
     {
@@ -74,6 +88,29 @@ void BinaryStream::Resize(unsigned long nBytes)
     return;
     }
 
+  // a view is copied into memory owned by the stream, including when the
+  // size does not change, so that the external data is never written to
+  if (!mOwner)
+    {
+    unsigned long nCopy = std::min(nBytes, mSize);
+    unsigned long writePos = std::min((unsigned long)(mWritePtr - mData), nBytes);
+    unsigned long readPos = std::min((unsigned long)(mReadPtr - mData), nBytes);
+
+    unsigned char *data = (unsigned char *)malloc(nBytes);
+    memcpy(data, mData, nCopy);
+
+    mWritePtr = data + writePos;
+    mReadPtr = data + readPos;
+    mData = data;
+    mSize = nBytes;
+    mOwner = true;
+    return;
+    }
+
+  // no change
+  if (nBytes == mSize)
+    return;
+
   // shrink
   if (nBytes < mSize)
     {
@@ -84,15 +121,14 @@ void BinaryStream::Resize(unsigned long nBytes)
     }
 
   // grow
-  unsigned char *origMData = mData;
+  unsigned long writePos = mWritePtr - mData;
+  unsigned long readPos = mReadPtr - mData;
+
   mData = (unsigned char *)realloc(mData, nBytes);
 
   // update the stream pointer
-  if (mData != origMData)
-    {
-    mWritePtr = mData + (mWritePtr - origMData);
-    mReadPtr = mData + (mReadPtr - origMData);
-    }
+  mWritePtr = mData + writePos;
+  mReadPtr = mData + readPos;
 
   mSize = nBytes;
 }
@@ -101,15 +137,28 @@ void BinaryStream::Resize(unsigned long nBytes)
 void BinaryStream::Grow(unsigned long nBytes)
 {
   unsigned long nBytesNeeded = this->Size() + nBytes;
-  if (nBytesNeeded > mSize)
+
+  // packing into a view, also after SetWritePos has moved the write
+  // position back, copies it first
+  if (!mOwner)
+    this->Resize(std::max(mSize, nBytesNeeded));
+  else if (nBytesNeeded > mSize)
     {
-    unsigned long newSize = mSize + this->GetBlockSize();
-    while (newSize < nBytesNeeded)
-      newSize += this->GetBlockSize();
+    // doubling the size keeps the cost of copying during reallocation
+    // proportional to the size of the stream
+    unsigned long newSize = std::max(2*mSize,
+      std::max(nBytesNeeded, (unsigned long)this->GetBlockSize()));
     this->Resize(newSize);
     }
 }
 
+//-----------------------------------------------------------------------------
+void BinaryStream::Reserve(unsigned long nBytes)
+{
+  if (nBytes > mSize)
+    this->Resize(nBytes);
+}
+
 //-----------------------------------------------------------------------------
 void BinaryStream::Swap(BinaryStream &other) noexcept
 {
@@ -117,33 +166,47 @@ void BinaryStream::Swap(BinaryStream &other) noexcept
   std::swap(mWritePtr, other.mWritePtr);
   std::swap(mReadPtr, other.mReadPtr);
   std::swap(mSize, other.mSize);
+  std::swap(mOwner, other.mOwner);
 }
 
 //-----------------------------------------------------------------------------
 int BinaryStream::Broadcast(int rootRank)
+{
+  return this->Broadcast(MPI_COMM_WORLD, rootRank);
+}
+
+//-----------------------------------------------------------------------------
+int BinaryStream::Broadcast(MPI_Comm comm, int rootRank)
 {
   int init = 0;
-  int rank = 0;
   MPI_Initialized(&init);
-  if (init)
+  if (!init)
+    return 0;
+
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  unsigned long nBytes = 0;
+  if (rank == rootRank)
+    nBytes = this->Size();
+
+  MPI_Bcast(&nBytes, 1, MPI_UNSIGNED_LONG, rootRank, comm);
+
+  if (rank != rootRank)
     {
-    unsigned long nbytes = 0;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    if (rank == rootRank)
-      {
-      nbytes = this->Size();
-      MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, rootRank, MPI_COMM_WORLD);
-      MPI_Bcast(this->GetData(), nbytes, MPI_BYTE, rootRank, MPI_COMM_WORLD);
-      }
-    else
-      {
-      MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, rootRank, MPI_COMM_WORLD);
-      this->Resize(nbytes);
-      MPI_Bcast(this->GetData(), nbytes, MPI_BYTE, rootRank, MPI_COMM_WORLD);
-      this->SetReadPos(0);
-      this->SetWritePos(nbytes);
-      }
+    this->Clear();
+    this->Resize(nBytes);
+    this->SetReadPos(0);
+    this->SetWritePos(nBytes);
     }
+
+  // send the data in pieces no larger than the largest message
+  for (unsigned long i = 0; i < nBytes; i += this->GetMaxMessageSize())
+    {
+    int n = std::min(nBytes - i, this->GetMaxMessageSize());
+    MPI_Bcast(mData + i, n, MPI_BYTE, rootRank, comm);
+    }
+
   return 0;
 }
 
@@ -4,6 +4,8 @@
 #include "senseiConfig.h"
 #include "Error.h"
 
+#include <mpi.h>
+
 #include <cstdlib>
 #include <cstring>
 #include <string>
@@ -16,6 +18,12 @@ namespace sensei
 {
 
 // Serialize objects into a binary stream.
+//
+// The stream grows geometrically so that packing n bytes costs O(n). A
+// stream may also be a non-owning view of data allocated elsewhere, such as
+// a buffer received from MPI or read from disk, which is then unpacked
+// without being copied. Arrays may be unpacked as pointers into the stream
+// with UnpackView.
 class SENSEI_EXPORT BinaryStream
 {
 public:
@@ -23,6 +31,12 @@ public:
   BinaryStream();
   ~BinaryStream() noexcept;
 
+  // construct a non-owning view of nBytes of data. the data is not copied
+  // and must outlive the stream. a view is read-only: packing into it, also
+  // after SetWritePos, or resizing it first copies the data into memory
+  // owned by the stream, the external data is never modified.
+  BinaryStream(unsigned char *data, unsigned long nBytes);
+
   // copy
   BinaryStream(const BinaryStream &s);
   const BinaryStream &operator=(const BinaryStream &other);
@@ -45,6 +59,14 @@ public:
   // ensures space for nBytes more to the stream.
   void Grow(unsigned long nBytes);
 
+  // ensures space for a total of nBytes in the stream. use this before
+  // packing when the size is known to allocate once.
+  void Reserve(unsigned long nBytes);
+
+  // returns true if the stream is a non-owning view of external data
+  bool IsView() const noexcept
+  { return !mOwner; }
+
   // Get a pointer to the stream internal representation.
   unsigned char *GetData() noexcept
   { return mData; }
@@ -82,6 +104,14 @@ public:
   template <typename T> void Pack(const T *val, unsigned long n);
   template <typename T> void Unpack(T *val, unsigned long n);
 
+  // Extract arrays without copying. val is set to point into the stream and
+  // is valid until the stream is modified or destroyed. The first form
+  // extracts n elements packed with Pack(const T *, n), the second a
+  // std::vector packed with Pack, and returns its length. The pointer may
+  // not be aligned for T, which the platforms supported by SENSEI allow.
+  template <typename T> void UnpackView(const T *&val, unsigned long n);
+  template <typename T> unsigned long UnpackView(const T *&val);
+
   // specializations
   void Pack(const std::string &str);
   void Unpack(std::string &str);
@@ -89,6 +119,10 @@ public:
   template <typename T, unsigned long N> void Pack(const std::array<T,N> &arr);
   template <typename T, unsigned long N> void Unpack(std::array<T,N> &arr);
 
+  // vectors of arrays of fixed size are packed with a single copy
+  template <typename T, unsigned long N> void Pack(const std::vector<std::array<T,N>> &v);
+  template <typename T, unsigned long N> void Unpack(std::vector<std::array<T,N>> &v);
+
   template <typename K, typename V> void Pack(const std::map<K,V> &amap);
   template <typename K, typename V> void Unpack(std::map<K,V> &amap);
 
@@ -106,20 +140,32 @@ public:
     typename std::enable_if<!std::is_class<T>::value>::type* = 0);
 #endif
 
-  // broadcast the stream from the root process to all other processes
+  // broadcast the stream from the root process to all other processes in
+  // MPI_COMM_WORLD
   int Broadcast(int rootRank=0);
 
+  // broadcast the stream from the root process to all other processes in
+  // the communicator. streams larger than the largest MPI message are sent
+  // in pieces.
+  int Broadcast(MPI_Comm comm, int rootRank);
+
 private:
-  // re-allocation size
+  // the smallest allocation size
   static
   constexpr unsigned int GetBlockSize()
   { return 512; }
 
+  // the largest message sent by Broadcast. MPI counts are int.
+  static
+  constexpr unsigned long GetMaxMessageSize()
+  { return 1ul << 30; }
+
 private:
   unsigned long mSize;
   unsigned char *mData;
   unsigned char *mReadPtr;
   unsigned char *mWritePtr;
+  bool mOwner;
 };
 
 //-----------------------------------------------------------------------------
@@ -168,6 +214,24 @@ void BinaryStream::Unpack(T *val, unsigned long n)
   mReadPtr += nn;
 }
 
+//-----------------------------------------------------------------------------
+template <typename T>
+void BinaryStream::UnpackView(const T *&val, unsigned long n)
+{
+  val = reinterpret_cast<const T*>(mReadPtr);
+  mReadPtr += n*sizeof(T);
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+unsigned long BinaryStream::UnpackView(const T *&val)
+{
+  unsigned long vlen = 0;
+  this->Unpack(vlen);
+  this->UnpackView(val, vlen);
+  return vlen;
+}
+
 //-----------------------------------------------------------------------------
 inline
 void BinaryStream::Pack(const std::string &str)
@@ -204,6 +268,31 @@ void BinaryStream::Unpack(std::array<T,N> &arr)
   this->Unpack(arr.data(), N);
 }
 
+//-----------------------------------------------------------------------------
+template <typename T, unsigned long N>
+void BinaryStream::Pack(const std::vector<std::array<T,N>> &v)
+{
+  static_assert(std::is_trivially_copyable<T>::value &&
+    (sizeof(std::array<T,N>) == N*sizeof(T)), "std::array is not contiguous");
+
+  unsigned long vlen = v.size();
+  this->Pack(vlen);
+  if (vlen)
+    this->Pack(v.data()->data(), vlen*N);
+}
+
+//-----------------------------------------------------------------------------
+template <typename T, unsigned long N>
+void BinaryStream::Unpack(std::vector<std::array<T,N>> &v)
+{
+  unsigned long vlen = 0;
+  this->Unpack(vlen);
+
+  v.resize(vlen);
+  if (vlen)
+    this->Unpack(v.data()->data(), vlen*N);
+}
+
 //-----------------------------------------------------------------------------
 template <typename K, typename V>
 void BinaryStream::Pack(const std::map<K,V> &amap)
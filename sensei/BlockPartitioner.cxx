@@ -32,6 +32,8 @@ int BlockPartitioner::GetPartition(MPI_Comm comm, const MeshMetadataPtr &mdIn,
       mdOut->BlockOwner[i] = rank;
     }
 
+  this->RecordMetrics(comm, mdOut);
+
   return 0;
 }
 
@@ -0,0 +1,506 @@
+#include "CachingDataAdaptor.h"
+#include "MeshMetadata.h"
+#include "SVTKUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <svtkCompositeDataIterator.h>
+#include <svtkCompositeDataSet.h>
+#include <svtkDataObject.h>
+#include <svtkDataSet.h>
+#include <svtkFieldData.h>
+#include <svtkAbstractArray.h>
+#include <svtkObjectFactory.h>
+#include <svtkSmartPointer.h>
+#include <svtkWeakPointer.h>
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <functional>
+
+using svtkDataObjectPtr = svtkSmartPointer<svtkDataObject>;
+
+using svtkCompositeDataIteratorPtr =
+  svtkSmartPointer<svtkCompositeDataIterator>;
+
+namespace
+{
+// --------------------------------------------------------------------------
+long long GetFlagsKey(const sensei::MeshMetadataFlags &flags)
+{
+  return (flags.BlockDecompSet() ? 0x1 : 0) |
+    (flags.BlockSizeSet() ? 0x2 : 0) | (flags.BlockExtentsSet() ? 0x4 : 0) |
+    (flags.BlockBoundsSet() ? 0x8 : 0) | (flags.BlockArrayRangeSet() ? 0x10 : 0);
+}
+
+// --------------------------------------------------------------------------
+// make a copy of the data object where the tree of data objects is new but
+// the arrays are shared with the source.
+svtkDataObject *NewShallowCopy(svtkDataObject *dobj)
+{
+  svtkDataObject *copy = dobj->NewInstance();
+  copy->ShallowCopy(dobj);
+
+  // composite data shallow copies share the leaf datasets. replace them with
+  // shallow copies so that arrays can be added without side effects.
+  if (svtkCompositeDataSet *cd = dynamic_cast<svtkCompositeDataSet*>(copy))
+    {
+    svtkCompositeDataIteratorPtr it;
+    it.TakeReference(cd->NewIterator());
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      svtkDataObject *leaf = it->GetCurrentDataObject();
+      svtkDataObject *leafCopy = leaf->NewInstance();
+      leafCopy->ShallowCopy(leaf);
+      cd->SetDataSet(it, leafCopy);
+      leafCopy->Delete();
+      }
+    }
+
+  return copy;
+}
+
+// --------------------------------------------------------------------------
+long long GetMeshBytes(svtkDataObject *dobj)
+{
+  return dobj ? 1024ll*dobj->GetActualMemorySize() : 0ll;
+}
+}
+
+namespace sensei
+{
+
+struct CachingDataAdaptor::CacheType
+{
+  CacheType() : HaveNumMeshes(false), NumMeshes(0), Stats{} {}
+
+  // identifies a cached mesh by name and structure only flag
+  using MeshKeyType = std::pair<std::string, bool>;
+
+  // identifies an array by association and name
+  using ArrayKeyType = std::pair<int, std::string>;
+
+  using FetchFunction = std::function<int(svtkDataObject*)>;
+
+  struct MeshEntry
+  {
+    MeshEntry() : Bytes(0) {}
+
+    svtkDataObjectPtr Mesh;
+    long long Bytes; // size of the mesh as fetched, without added arrays
+    std::set<ArrayKeyType> Arrays;
+  };
+
+  struct CopyEntry
+  {
+    svtkWeakPointer<svtkDataObject> Copy;
+    MeshKeyType Key;
+  };
+
+  // drop all cached data
+  void Clear();
+
+  // add the array to the caller's copy of a cached mesh, fetching it
+  // through the passed function the first time it is requested.
+  // the caller must hold the lock.
+  int AddArray(svtkDataObject *mesh, int association,
+    const std::string &arrayName, const FetchFunction &fetch);
+
+  // find the cached mesh that can serve the request, or null
+  MeshEntry *FindMesh(const std::string &meshName, bool structureOnly,
+    MeshKeyType &key);
+
+  std::mutex Mutex;
+  svtkSmartPointer<DataAdaptor> Source;
+  bool HaveNumMeshes;
+  unsigned int NumMeshes;
+  std::map<std::pair<unsigned int, long long>, MeshMetadataPtr> Metadata;
+  std::map<MeshKeyType, MeshEntry> Meshes;
+  std::map<svtkDataObject*, CopyEntry> Copies;
+  StatisticsType Stats;
+};
+
+// --------------------------------------------------------------------------
+void CachingDataAdaptor::CacheType::Clear()
+{
+  this->HaveNumMeshes = false;
+  this->NumMeshes = 0;
+  this->Metadata.clear();
+  this->Meshes.clear();
+  this->Copies.clear();
+}
+
+// --------------------------------------------------------------------------
+int CachingDataAdaptor::CacheType::AddArray(svtkDataObject *mesh,
+  int association, const std::string &arrayName, const FetchFunction &fetch)
+{
+  // look for the cached mesh this is a copy of. a null weak pointer means
+  // that the copy was deleted and the address has been reused.
+  auto cit = this->Copies.find(mesh);
+  if ((cit == this->Copies.end()) || !cit->second.Copy)
+    {
+    // not one of ours, pass through
+    return fetch(mesh);
+    }
+
+  MeshEntry &entry = this->Meshes[cit->second.Key];
+
+  // fetch the array into the cached mesh the first time it is requested
+  ArrayKeyType arrayKey(association, arrayName);
+  bool hit = entry.Arrays.count(arrayKey);
+  const char *eventName = hit ?
+    "CachingDataAdaptor::Hit" : "CachingDataAdaptor::Miss";
+
+  Profiler::StartEvent(eventName);
+
+  if (!hit)
+    {
+    if (fetch(entry.Mesh))
+      {
+      Profiler::EndEvent(eventName);
+      return -1;
+      }
+
+    entry.Arrays.insert(arrayKey);
+    }
+
+  // share the array with the caller's copy
+  long long nBytes = 0;
+  SVTKUtils::BinaryDatasetFunction func =
+    [&](svtkDataSet *src, svtkDataSet *dst) -> int
+    {
+    svtkFieldData *srcAtts = SVTKUtils::GetAttributes(src, association);
+    svtkFieldData *dstAtts = SVTKUtils::GetAttributes(dst, association);
+    if (!srcAtts || !dstAtts)
+      return -1;
+
+    if (svtkAbstractArray *array = srcAtts->GetAbstractArray(arrayName.c_str()))
+      {
+      dstAtts->AddArray(array);
+      nBytes += array->GetNumberOfValues()*array->GetDataTypeSize();
+      }
+
+    return 0;
+    };
+
+  int ierr = SVTKUtils::Apply(entry.Mesh, mesh, func);
+
+  Profiler::EndEvent(eventName, nBytes);
+
+  if (ierr)
+    {
+    SENSEI_ERROR("Failed to share " << SVTKUtils::GetAttributesName(association)
+      << " data array \"" << arrayName << "\" from the cache")
+    return -1;
+    }
+
+  if (hit)
+    {
+    this->Stats.ArrayHits += 1;
+    this->Stats.BytesServed += nBytes;
+    }
+  else
+    {
+    this->Stats.ArrayMisses += 1;
+    this->Stats.BytesFetched += nBytes;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+CachingDataAdaptor::CacheType::MeshEntry *
+CachingDataAdaptor::CacheType::FindMesh(const std::string &meshName,
+  bool structureOnly, MeshKeyType &key)
+{
+  // the full mesh can serve a request for the structure only mesh
+  auto it = this->Meshes.find(MeshKeyType(meshName, false));
+  if ((it == this->Meshes.end()) && structureOnly)
+    it = this->Meshes.find(MeshKeyType(meshName, true));
+
+  if (it == this->Meshes.end())
+    return nullptr;
+
+  key = it->first;
+  return &it->second;
+}
+
+
+
+//----------------------------------------------------------------------------
+senseiNewMacro(CachingDataAdaptor);
+
+//----------------------------------------------------------------------------
+CachingDataAdaptor::CachingDataAdaptor() : Cache(new CacheType)
+{
+}
+
+//----------------------------------------------------------------------------
+CachingDataAdaptor::~CachingDataAdaptor()
+{
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::SetDataAdaptor(DataAdaptor *source)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  this->Cache->Clear();
+  this->Cache->Source = source;
+}
+
+//----------------------------------------------------------------------------
+DataAdaptor *CachingDataAdaptor::GetDataAdaptor()
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  return this->Cache->Source.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::ShareCache(CachingDataAdaptor *other)
+{
+  this->Cache = other->Cache;
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::ClearCache()
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  this->Cache->Clear();
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::GetStatistics(StatisticsType &stats)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  stats = this->Cache->Stats;
+}
+
+//----------------------------------------------------------------------------
+void CachingDataAdaptor::ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  this->Cache->Stats = StatisticsType{};
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::PrefetchMetadata()
+{
+  TimeEvent<128> mark("CachingDataAdaptor::PrefetchMetadata");
+
+  unsigned int nMeshes = 0;
+  if (this->GetNumberOfMeshes(nMeshes))
+    return -1;
+
+  for (unsigned int i = 0; i < nMeshes; ++i)
+    {
+    MeshMetadataPtr md = MeshMetadata::New();
+    if (this->GetMeshMetadata(i, md))
+      return -1;
+    }
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetNumberOfMeshes(unsigned int &numMeshes)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  if (!this->Cache->HaveNumMeshes)
+    {
+    if (this->Cache->Source->GetNumberOfMeshes(this->Cache->NumMeshes))
+      return -1;
+
+    this->Cache->HaveNumMeshes = true;
+    }
+
+  numMeshes = this->Cache->NumMeshes;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetMeshMetadata(unsigned int id,
+  MeshMetadataPtr &metadata)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  MeshMetadataFlags flags = metadata ? metadata->Flags : MeshMetadataFlags();
+  auto key = std::make_pair(id, GetFlagsKey(flags));
+
+  auto it = this->Cache->Metadata.find(key);
+  if (it == this->Cache->Metadata.end())
+    {
+    MeshMetadataPtr md = MeshMetadata::New(flags);
+    if (this->Cache->Source->GetMeshMetadata(id, md))
+      return -1;
+
+    it = this->Cache->Metadata.insert(std::make_pair(key, md)).first;
+    }
+
+  // callers are free to modify the metadata, hand out a copy
+  metadata = it->second->NewCopy();
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::GetMesh(const std::string &meshName,
+  bool structureOnly, svtkDataObject *&mesh)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  mesh = nullptr;
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  CacheType::MeshKeyType key;
+  CacheType::MeshEntry *entry =
+    this->Cache->FindMesh(meshName, structureOnly, key);
+
+  if (entry)
+    {
+    long long nBytes = entry->Bytes;
+
+    Profiler::StartEvent("CachingDataAdaptor::Hit");
+    Profiler::EndEvent("CachingDataAdaptor::Hit", nBytes);
+
+    this->Cache->Stats.MeshHits += 1;
+    this->Cache->Stats.BytesServed += nBytes;
+    }
+  else
+    {
+    Profiler::StartEvent("CachingDataAdaptor::Miss");
+
+    svtkDataObject *dobj = nullptr;
+    if (this->Cache->Source->GetMesh(meshName, structureOnly, dobj))
+      {
+      Profiler::EndEvent("CachingDataAdaptor::Miss");
+      return -1;
+      }
+
+    long long nBytes = GetMeshBytes(dobj);
+
+    Profiler::EndEvent("CachingDataAdaptor::Miss", nBytes);
+
+    this->Cache->Stats.MeshMisses += 1;
+    this->Cache->Stats.BytesFetched += nBytes;
+
+    key = CacheType::MeshKeyType(meshName, structureOnly);
+    entry = &this->Cache->Meshes[key];
+    entry->Mesh.TakeReference(dobj);
+    entry->Bytes = nBytes;
+    }
+
+  // it is not an error for a rank to have no data
+  if (!entry->Mesh)
+    return 0;
+
+  // give the caller a copy that shares array memory with the cache
+  mesh = NewShallowCopy(entry->Mesh);
+
+  CacheType::CopyEntry &copy = this->Cache->Copies[mesh];
+  copy.Copy = mesh;
+  copy.Key = key;
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddGhostNodesArray(svtkDataObject *mesh,
+  const std::string &meshName)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  DataAdaptor *source = this->Cache->Source;
+
+  return this->Cache->AddArray(mesh, svtkDataObject::POINT, "svtkGhostType",
+    [&](svtkDataObject *dobj) -> int
+    { return source->AddGhostNodesArray(dobj, meshName); });
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddGhostCellsArray(svtkDataObject *mesh,
+  const std::string &meshName)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  DataAdaptor *source = this->Cache->Source;
+
+  return this->Cache->AddArray(mesh, svtkDataObject::CELL, "svtkGhostType",
+    [&](svtkDataObject *dobj) -> int
+    { return source->AddGhostCellsArray(dobj, meshName); });
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::AddArray(svtkDataObject *mesh,
+  const std::string &meshName, int association, const std::string &arrayName)
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+
+  if (!this->Cache->Source)
+    {
+    SENSEI_ERROR("No data adaptor was set")
+    return -1;
+    }
+
+  DataAdaptor *source = this->Cache->Source;
+
+  return this->Cache->AddArray(mesh, association, arrayName,
+    [&](svtkDataObject *dobj) -> int
+    { return source->AddArray(dobj, meshName, association, arrayName); });
+}
+
+//----------------------------------------------------------------------------
+int CachingDataAdaptor::ReleaseData()
+{
+  this->ClearCache();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+double CachingDataAdaptor::GetDataTime()
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  return this->Cache->Source ? this->Cache->Source->GetDataTime() : 0.0;
+}
+
+//----------------------------------------------------------------------------
+long CachingDataAdaptor::GetDataTimeStep()
+{
+  std::lock_guard<std::mutex> lock(this->Cache->Mutex);
+  return this->Cache->Source ? this->Cache->Source->GetDataTimeStep() : 0;
+}
+
+}
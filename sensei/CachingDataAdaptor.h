@@ -0,0 +1,125 @@
+#ifndef sensei_CachingDataAdaptor_h
+#define sensei_CachingDataAdaptor_h
+
+#include "DataAdaptor.h"
+
+#include <memory>
+
+namespace sensei
+{
+
+/** A thread safe sensei::DataAdaptor that decorates another data adaptor and
+ * memoizes the meshes, arrays, and metadata it provides during the current
+ * time step. The first request for a mesh or array is forwarded to the
+ * decorated adaptor, subsequent requests are served from the cache.
+ *
+ * Callers of GetMesh receive their own shallow copy of the cached mesh. The
+ * tree of data objects is unique to each caller while array memory is shared
+ * by all callers. Thus callers may add and remove arrays on their copy but
+ * must not modify array contents in place.
+ *
+ * Instances may share a cache (see ShareCache). This allows analyses running
+ * concurrently in different threads to use the same cache, each through an
+ * adaptor instance with its own communicator. Access to the decorated adaptor
+ * is serialized.
+ *
+ * Meshes are cached by name and structure only flag, and arrays by mesh,
+ * association, and name. Ghost arrays are cached like any other array, hence
+ * the ghost zones are generated only once per time step. A request for a
+ * structure only mesh is served from the full mesh when that is cached.
+ *
+ * The cache is cleared when a new adaptor is set, when ClearCache is called,
+ * and by ReleaseData. This should be done at the end of each time step.
+ *
+ * Hits and misses are counted along with the bytes fetched from the decorated
+ * adaptor and the bytes served from the cache (see GetStatistics). When the
+ * Profiler is enabled each miss is recorded as a CachingDataAdaptor::Miss
+ * event timing the fetch, and each hit as a CachingDataAdaptor::Hit event.
+ * Both report the bytes of the mesh or array.
+ */
+class SENSEI_EXPORT CachingDataAdaptor : public DataAdaptor
+{
+public:
+  static CachingDataAdaptor *New();
+  senseiTypeMacro(CachingDataAdaptor, DataAdaptor);
+
+  /// Set the data adaptor to decorate. This clears the cache.
+  void SetDataAdaptor(DataAdaptor *source);
+
+  /// Get the decorated data adaptor.
+  DataAdaptor *GetDataAdaptor();
+
+  /** Share the cache of another instance. After this call both instances
+   * access the same cached data and decorated adaptor.
+   */
+  void ShareCache(CachingDataAdaptor *other);
+
+  /// Release all cached meshes, arrays, and metadata.
+  void ClearCache();
+
+  /// Counts of cache accesses, accumulated over time steps.
+  struct StatisticsType
+  {
+    long MeshHits;        ///< meshes served from the cache
+    long MeshMisses;      ///< meshes fetched from the decorated adaptor
+    long ArrayHits;       ///< arrays served from the cache
+    long ArrayMisses;     ///< arrays fetched from the decorated adaptor
+    long long BytesFetched; ///< bytes fetched from the decorated adaptor
+    long long BytesServed;  ///< bytes served from the cache without a fetch
+  };
+
+  /// Get the counts of cache accesses. These are shared with other instances
+  /// through ShareCache.
+  void GetStatistics(StatisticsType &stats);
+
+  /// Zero the counts of cache accesses.
+  void ResetStatistics();
+
+  /** Fetch the number of meshes and metadata with the default flags for each
+   * mesh. Data adaptors are free to use MPI collectives when generating
+   * metadata. When the cache is used from multiple threads, calling this
+   * from a single thread prior to launching the others ensures that these
+   * collectives are issued in the same order on all ranks.
+   */
+  int PrefetchMetadata();
+
+  int GetNumberOfMeshes(unsigned int &numMeshes) override;
+
+  int GetMeshMetadata(unsigned int id, MeshMetadataPtr &metadata) override;
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    svtkDataObject *&mesh) override;
+
+  int AddGhostNodesArray(svtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddGhostCellsArray(svtkDataObject* mesh,
+    const std::string &meshName) override;
+
+  int AddArray(svtkDataObject* mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override;
+
+  /// Releases the cached data. The decorated adaptor is not modified.
+  int ReleaseData() override;
+
+  /// Forwarded to the decorated adaptor.
+  double GetDataTime() override;
+
+  /// Forwarded to the decorated adaptor.
+  long GetDataTimeStep() override;
+
+protected:
+  CachingDataAdaptor();
+  ~CachingDataAdaptor();
+
+  CachingDataAdaptor(const CachingDataAdaptor&) = delete;
+  void operator=(const CachingDataAdaptor&) = delete;
+
+private:
+  struct CacheType;
+  std::shared_ptr<CacheType> Cache;
+};
+
+}
+
+#endif
@@ -2,10 +2,13 @@
 #include <svtkSmartPointer.h>
 #include <svtkNew.h>
 #include <svtkDataObject.h>
+#include <svtkSMPTools.h>
 
 #include <vector>
+#include <future>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 #include <cstdio>
 #include <errno.h>
 
@@ -17,9 +20,15 @@
 #include "XMLUtils.h"
 #include "STLUtils.h"
 #include "DataRequirements.h"
+#include "CachingDataAdaptor.h"
+#include "AsyncAnalysisAdaptor.h"
+#include "AnalysisScheduler.h"
+#include "ThreadPool.h"
 
 #include "Autocorrelation.h"
 #include "Histogram.h"
+#include "QuantileSketch.h"
+#include "SliceExtract.h"
 #ifdef ENABLE_VTK_IO
 #include "VTKPosthocIO.h"
 #ifdef ENABLE_VTK_MPI
@@ -58,10 +67,6 @@
 #ifdef ENABLE_PYTHON
 #include "PythonAnalysis.h"
 #endif
-#if defined(ENABLE_VTK_IO) && defined(ENABLE_VTK_FILTERS)
-#define ENABLE_SLICE_EXTRACT
-#include "SliceExtract.h"
-#endif
 #if defined(ENABLE_VTK_FILTERS)
 #include "Calculator.h"
 #endif
@@ -77,10 +82,25 @@ using namespace STLUtils; // for operator<< overloads
 struct ConfigurableAnalysis::InternalsType
 {
   InternalsType()
-    : Comm(MPI_COMM_NULL)
+    : Comm(MPI_COMM_NULL), NumConcurrentThreads(0), NumSMPThreads(0),
+    LastExecuteEnd(0.0), GlobalViewCaching(false)
   {
   }
 
+  // set up the thread pool and caches used to execute analyses
+  // concurrently. when MPI does not support concurrent calls from
+  // multiple threads the analyses are executed in order.
+  int InitializeConcurrency(MPI_Comm comm);
+
+  // executes the ai'th analysis, timing it for the scheduler and when
+  // profiling is enabled. this is called concurrently from multiple threads.
+  bool ExecuteAnalysis(unsigned int ai, DataAdaptor *data,
+    DataAdaptor **dataOut);
+
+  // replaces the most recently added analysis with an adaptor that executes
+  // it asynchronously. the snapshot is configured from the xml.
+  int MakeAsynchronous(pugi::xml_node node);
+
   // Initializes the adaptor by calling the initializer functor,
   // optionally timing how long initialization takes.
   // If no \a initializer is passed, then no initialization is
@@ -89,11 +109,18 @@ struct ConfigurableAnalysis::InternalsType
     AnalysisAdaptorPtr adaptor,
     std::function<int()> initializer = []() { return 0; });
 
+  // gets the arrays an analysis processes, given either by the mesh,
+  // association, and array attributes or by nested mesh elements. a
+  // description of the arrays is returned for status messages
+  int GetArrayRequirements(pugi::xml_node node, DataRequirements &req,
+    std::string &desc);
+
   // creates, initializes from xml, and adds the analysis
   // if it has been compiled into the build and is enabled.
   // a status message indicating success/failure is printed
   // by rank 0
   int AddHistogram(pugi::xml_node node);
+  int AddQuantileSketch(pugi::xml_node node);
   int AddVTKmContour(pugi::xml_node node);
   int AddVTKmVolumeReduction(pugi::xml_node node);
   int AddVTKmCDF(pugi::xml_node node);
@@ -133,8 +160,195 @@ public:
   MPI_Comm Comm;
 
   std::vector<std::string> LogEventNames;
+
+  // flags indicating which analyses may run concurrently with the others.
+  // this is parallel to the list of analyses.
+  std::vector<int> Concurrent;
+
+  // the number of threads to use for concurrent execution. 0 means one
+  // thread per concurrent analysis.
+  int NumConcurrentThreads;
+
+  // the number of threads svtkSMPTools uses while the analyses execute. 0
+  // leaves the number the simulation uses unchanged.
+  int NumSMPThreads;
+
+  // threads used to execute analyses concurrently
+  ThreadPool Pool;
+
+  // decides which analyses execute each time step, and the time the last
+  // call to Execute returned, from which the solver's time is measured
+  AnalysisScheduler Scheduler;
+  double LastExecuteEnd;
+
+  // when executing concurrently or when caching is enabled, simulation data
+  // is fetched once and shared through these. there is one adaptor per
+  // concurrent analysis, each using a communicator of its own, and one for
+  // the analyses that execute on the calling thread. all share the same cache.
+  std::vector<svtkSmartPointer<CachingDataAdaptor>> Caches;
+  svtkSmartPointer<CachingDataAdaptor> SerialCache;
+
+  // set when the global view of static meshes is cached, the cache holds
+  // MPI groups that are released in Finalize
+  bool GlobalViewCaching;
 };
 
+// --------------------------------------------------------------------------
+bool ConfigurableAnalysis::InternalsType::ExecuteAnalysis(unsigned int ai,
+  DataAdaptor *data, DataAdaptor **dataOut)
+{
+  const char* analysisName = nullptr;
+  bool logEnabled = Profiler::Enabled();
+  if (logEnabled)
+    {
+    analysisName = this->LogEventNames[3 * ai + 1].c_str();
+    Profiler::StartEvent(analysisName);
+    }
+
+  double t0 = MPI_Wtime();
+
+  bool status = this->Analyses[ai]->Execute(data, dataOut);
+
+  this->Scheduler.SetExecutionTime(ai, MPI_Wtime() - t0);
+
+  if (logEnabled)
+    Profiler::EndEvent(analysisName);
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::InitializeConcurrency(MPI_Comm comm)
+{
+  unsigned int nAnalyses = this->Analyses.size();
+
+  int nConcurrent = 0;
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    nConcurrent += this->Concurrent[i] ? 1 : 0;
+
+  if (nConcurrent == 0)
+    return 0;
+
+  // analyses communicate from different threads
+  int threadLevel = MPI_THREAD_SINGLE;
+  MPI_Query_thread(&threadLevel);
+  if (threadLevel < MPI_THREAD_MULTIPLE)
+    {
+    SENSEI_WARNING("Concurrent execution of " << nConcurrent << " analyses"
+      " was requested but MPI was not initialized with MPI_THREAD_MULTIPLE."
+      " The analyses will be executed in order.")
+    this->Concurrent.assign(nAnalyses, 0);
+    return 0;
+    }
+
+  int nThreads = this->NumConcurrentThreads > 0 ?
+    this->NumConcurrentThreads : nConcurrent;
+
+  if (this->Pool.Initialize(nThreads))
+    {
+    SENSEI_ERROR("Failed to initialize the thread pool")
+    return -1;
+    }
+
+  this->SerialCache = svtkSmartPointer<CachingDataAdaptor>::New();
+  this->SerialCache->SetCommunicator(comm);
+
+  this->Caches.resize(nAnalyses);
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    {
+    if (this->Concurrent[i])
+      {
+      svtkSmartPointer<CachingDataAdaptor> cache =
+        svtkSmartPointer<CachingDataAdaptor>::New();
+
+      cache->ShareCache(this->SerialCache);
+      cache->SetCommunicator(this->Analyses[i]->GetCommunicator());
+
+      this->Caches[i] = cache;
+      }
+    }
+
+  SENSEI_STATUS("Configured concurrent execution of " << nConcurrent
+    << " analyses using " << nThreads << " threads")
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::MakeAsynchronous(pugi::xml_node node)
+{
+  AnalysisAdaptorPtr analysis = this->Analyses.back();
+
+  auto async = svtkSmartPointer<AsyncAnalysisAdaptor>::New();
+
+  if (this->Comm != MPI_COMM_NULL)
+    async->SetCommunicator(this->Comm);
+
+  async->SetAnalysisAdaptor(analysis);
+  async->SetMaxQueueLength(node.attribute("async_queue_length").as_int(1));
+
+  std::string mode = node.attribute("async_copy").as_string("zero");
+  if (mode == "zero")
+    {
+    async->SetSnapshotMode(AsyncAnalysisAdaptor::ZERO_COPY);
+    }
+  else if (mode == "deep")
+    {
+    async->SetSnapshotMode(AsyncAnalysisAdaptor::DEEP_COPY);
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid async_copy \"" << mode << "\". Use zero or deep")
+    return -1;
+    }
+
+  std::string policy = node.attribute("async_policy").as_string("block");
+  if (policy == "block")
+    {
+    async->SetQueuePolicy(AsyncAnalysisAdaptor::BLOCK);
+    }
+  else if (policy == "drop_newest")
+    {
+    async->SetQueuePolicy(AsyncAnalysisAdaptor::DROP_NEWEST);
+    }
+  else if (policy == "drop_oldest")
+    {
+    async->SetQueuePolicy(AsyncAnalysisAdaptor::DROP_OLDEST);
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid async_policy \"" << policy << "\". Use block,"
+      " drop_newest, or drop_oldest")
+    return -1;
+    }
+
+  // the meshes and arrays to capture. everything when none are given
+  DataRequirements req;
+  if (req.Initialize(node))
+    {
+    SENSEI_ERROR("Failed to initialize data requirements")
+    return -1;
+    }
+  async->SetDataRequirements(req);
+
+  if (async->Initialize())
+    {
+    SENSEI_ERROR("Failed to initialize asynchronous execution of "
+      << analysis->GetClassName())
+    return -1;
+    }
+
+  this->Analyses.back() = async.GetPointer();
+
+  SENSEI_STATUS("Configured " << analysis->GetClassName() << " for "
+    << (async->GetAsynchronous() ? "asynchronous" : "synchronous")
+    << " execution with " << async->GetMaxQueueLength()
+    << " time steps in flight (" << policy << ") and " << mode
+    << "-copy snapshots")
+
+  return 0;
+}
+
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::TimeInitialization(
   AnalysisAdaptorPtr adaptor, std::function<int()> initializer)
@@ -166,24 +380,60 @@ int ConfigurableAnalysis::InternalsType::TimeInitialization(
 }
 
 // --------------------------------------------------------------------------
-int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
+int ConfigurableAnalysis::InternalsType::GetArrayRequirements(
+  pugi::xml_node node, DataRequirements &req, std::string &desc)
 {
-  if (XMLUtils::RequireAttribute(node, "mesh") || XMLUtils::RequireAttribute(node, "array"))
+  // the arrays are given either by the mesh, association, and array
+  // attributes or by nested mesh elements, which allows for any number of
+  // arrays on any number of meshes
+  if (node.attribute("mesh") || node.attribute("array") || !node.child("mesh"))
     {
-    SENSEI_ERROR("Failed to initialize Histogram");
+    if (XMLUtils::RequireAttribute(node, "mesh") || XMLUtils::RequireAttribute(node, "array"))
+      return -1;
+
+    int association = 0;
+    std::string assocStr = node.attribute("association").as_string("point");
+    if (SVTKUtils::GetAssociation(assocStr, association))
+      return -1;
+
+    std::string mesh = node.attribute("mesh").value();
+    std::string array = node.attribute("array").value();
+    req.AddRequirement(mesh, association, array);
+    }
+  else if (req.Initialize(node) || req.Empty())
+    {
+    SENSEI_ERROR("Failed to parse the mesh elements")
     return -1;
     }
 
-  int association = 0;
-  std::string assocStr = node.attribute("association").as_string("point");
-  if (SVTKUtils::GetAssociation(assocStr, association))
+  std::ostringstream oss;
+  MeshRequirementsIterator mit = req.GetMeshRequirementsIterator();
+  for (int i = 0; mit; ++mit)
+    {
+    ArrayRequirementsIterator ait = req.GetArrayRequirementsIterator(mit.MeshName());
+    for (; ait; ++ait, ++i)
+      {
+      oss << (i ? ", " : "") << SVTKUtils::GetAttributesName(ait.Association())
+        << " data array \"" << ait.Array() << "\" on mesh \""
+        << mit.MeshName() << "\"";
+      }
+    }
+  desc = oss.str();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
+{
+  DataRequirements req;
+  std::string arrays;
+  if (this->GetArrayRequirements(node, req, arrays))
     {
     SENSEI_ERROR("Failed to initialize Histogram");
     return -1;
     }
 
-  std::string mesh = node.attribute("mesh").value();
-  std::string array = node.attribute("array").value();
   int bins = node.attribute("bins").as_int(10);
   std::string fileName = node.attribute("file").value();
 
@@ -192,15 +442,62 @@ int ConfigurableAnalysis::InternalsType::AddHistogram(pugi::xml_node node)
   if (this->Comm != MPI_COMM_NULL)
     histogram->SetCommunicator(this->Comm);
 
-  this->TimeInitialization(histogram, [&]() {
-      histogram->Initialize(bins, mesh, association, array, fileName);
-      return 0;
-    });
+  if (this->TimeInitialization(histogram, [&]() {
+      return histogram->Initialize(bins, req, fileName);
+    }))
+    {
+    SENSEI_ERROR("Failed to initialize Histogram");
+    return -1;
+    }
+
   this->Analyses.push_back(histogram.GetPointer());
 
   SENSEI_STATUS("Configured histogram with " << bins
-    << " bins on " << assocStr << " data array \"" << array
-    << "\" on mesh \"" << mesh << "\" writing output to "
+    << " bins on " << arrays << " writing output to "
+    << (fileName.empty() ? "cout" : "file"))
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ConfigurableAnalysis::InternalsType::AddQuantileSketch(pugi::xml_node node)
+{
+  DataRequirements req;
+  std::string arrays;
+  if (this->GetArrayRequirements(node, req, arrays))
+    {
+    SENSEI_ERROR("Failed to initialize QuantileSketch");
+    return -1;
+    }
+
+  std::vector<double> quantiles;
+  if (node.child("quantiles"))
+    XMLUtils::ParseNumeric(node.child("quantiles"), quantiles);
+  else
+    quantiles = {0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99};
+
+  int window = node.attribute("window").as_int(1);
+  double compression = node.attribute("compression").as_double(100.0);
+  std::string fileName = node.attribute("file").value();
+
+  auto sketch = svtkSmartPointer<QuantileSketch>::New();
+
+  if (this->Comm != MPI_COMM_NULL)
+    sketch->SetCommunicator(this->Comm);
+
+  if (this->TimeInitialization(sketch, [&]() {
+      return sketch->Initialize(req, quantiles, window, compression, fileName);
+    }))
+    {
+    SENSEI_ERROR("Failed to initialize QuantileSketch");
+    return -1;
+    }
+
+  this->Analyses.push_back(sketch.GetPointer());
+
+  SENSEI_STATUS("Configured quantile sketch with compression " << compression
+    << " over " << (window ? std::to_string(window) : std::string("all"))
+    << " steps on " << arrays << " writing output to "
     << (fileName.empty() ? "cout" : "file"))
 
   return 0;
@@ -844,14 +1141,31 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
   int window = node.attribute("window").as_int(10);
   int kMax = node.attribute("k-max").as_int(3);
   int numThreads = node.attribute("n-threads").as_int(1);
+  int useSMP = node.attribute("smp").as_int(1);
+
+  std::string precStr = node.attribute("buffer-precision").as_string("float");
+  int precision = Autocorrelation::PRECISION_FLOAT;
+  if (precStr == "half")
+    {
+    precision = Autocorrelation::PRECISION_HALF;
+    }
+  else if (precStr != "float")
+    {
+    SENSEI_ERROR("Invalid buffer-precision \"" << precStr
+      << "\". Use float or half")
+    return -1;
+    }
 
   auto adaptor = svtkSmartPointer<Autocorrelation>::New();
 
   if (this->Comm != MPI_COMM_NULL)
     adaptor->SetCommunicator(this->Comm);
 
+  adaptor->SetBufferPrecision(precision);
+  adaptor->SetUseSMP(useSMP);
+
   this->TimeInitialization(adaptor, [&]() {
-    adaptor->Initialize(window, meshName, assoc, arrayName, kMax);
+    adaptor->Initialize(window, meshName, assoc, arrayName, kMax, numThreads);
     return 0;
   });
 
@@ -860,7 +1174,8 @@ int ConfigurableAnalysis::InternalsType::AddAutoCorrelation(pugi::xml_node node)
   SENSEI_STATUS("Configured Autocorrelation " << assocStr
     << " data array \"" << arrayName << "\" on mesh \"" << meshName
     << "\" window " << window << " k-max " << kMax
-    << " n-threads " << numThreads)
+    << " n-threads " << numThreads << " smp " << useSMP
+    << " buffer-precision " << precStr)
 
   return 0;
 }
@@ -987,6 +1302,25 @@ int ConfigurableAnalysis::InternalsType::AddPythonAnalysis(pugi::xml_node node)
   pyAnalysis->SetScriptModule(scriptModule);
   pyAnalysis->SetInitializeSource(initSource);
 
+  // import on rank 0 and broadcast to the others
+  pyAnalysis->SetBroadcastImports(
+    node.attribute("broadcast_imports").as_int(0));
+
+  pyAnalysis->SetExtensionDirectory(
+    node.attribute("extension_dir").as_string(""));
+
+  pugi::xml_node mnode = node.child("imports");
+  if (mnode)
+    {
+    std::string text = mnode.text().as_string();
+    std::replace(text.begin(), text.end(), ',', ' ');
+
+    std::istringstream iss(text);
+    std::string moduleName;
+    while (iss >> moduleName)
+      pyAnalysis->AddImport(moduleName);
+    }
+
   if (this->TimeInitialization(pyAnalysis, [&]() {
       return pyAnalysis->Initialize(); }))
     {
@@ -1010,12 +1344,6 @@ int ConfigurableAnalysis::InternalsType::AddPythonAnalysis(pugi::xml_node node)
 // --------------------------------------------------------------------------
 int ConfigurableAnalysis::InternalsType::AddSliceExtract(pugi::xml_node node)
 {
-#ifndef ENABLE_SLICE_EXTRACT
-  (void)node;
-  SENSEI_ERROR("SliceExtract requested but is disabled in this build")
-  return -1;
-#else
-
   std::ostringstream oss;
   oss << "Configured SliceExtract ";
 
@@ -1123,6 +1451,11 @@ int ConfigurableAnalysis::InternalsType::AddSliceExtract(pugi::xml_node node)
   adaptor->EnablePartitioner(enablePart);
   oss << " enable_partitioner=" <<  enablePart;
 
+  int useVTK = node.attribute("use_vtk").as_int(0);
+  if (adaptor->SetUseVTK(useVTK))
+    return -1;
+  oss << " use_vtk=" << useVTK;
+
   int verbose = node.attribute("verbose").as_int(0);
   adaptor->SetVerbose(verbose);
   oss << " verbose=" << verbose;
@@ -1134,7 +1467,6 @@ int ConfigurableAnalysis::InternalsType::AddSliceExtract(pugi::xml_node node)
   SENSEI_STATUS(<< oss.str())
 
   return 0;
-#endif
 }
 
 // --------------------------------------------------------------------------
@@ -1248,8 +1580,11 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
     if (!node.attribute("enabled").as_int(0))
       continue;
 
+    unsigned int nAnalyses = this->Internals->Analyses.size();
+
     std::string type = node.attribute("type").value();
     if (!(((type == "histogram") && !this->Internals->AddHistogram(node))
+      || ((type == "quantiles") && !this->Internals->AddQuantileSketch(node))
       || ((type == "autocorrelation") && !this->Internals->AddAutoCorrelation(node))
       || ((type == "adios1") && !this->Internals->AddAdios1(node))
       || ((type == "adios2") && !this->Internals->AddAdios2(node))
@@ -1269,6 +1604,30 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
       SENSEI_ERROR("Failed to add \"" << type << "\" analysis")
       MPI_Abort(this->GetCommunicator(), -1);
       }
+
+    // execute asynchronously. some adaptors are shared by multiple analysis
+    // elements, only newly created ones are wrapped
+    if (node.attribute("async").as_int(0) &&
+      (this->Internals->Analyses.size() > nAnalyses) &&
+      this->Internals->MakeAsynchronous(node))
+      {
+      SENSEI_ERROR("Failed to configure \"" << type << "\" analysis for"
+        " asynchronous execution")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    // some adaptors are shared by multiple analysis elements, only newly
+    // created ones are flagged
+    this->Internals->Concurrent.resize(this->Internals->Analyses.size(),
+      node.attribute("concurrent").as_int(0));
+
+    if (this->Internals->Scheduler.AddAnalyses(
+      this->Internals->Analyses.size(), node))
+      {
+      SENSEI_ERROR("Failed to configure scheduling of \"" << type
+        << "\" analysis")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
     }
 
   // create and configure transport analysis adaptors
@@ -1286,8 +1645,80 @@ int ConfigurableAnalysis::Initialize(const pugi::xml_node &root)
       SENSEI_ERROR("Failed to add \"" << type << "\" transport")
       MPI_Abort(this->GetCommunicator(), -1);
       }
+
+    if (node.attribute("async").as_int(0) &&
+      this->Internals->MakeAsynchronous(node))
+      {
+      SENSEI_ERROR("Failed to configure \"" << type << "\" transport for"
+        " asynchronous execution")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    this->Internals->Concurrent.resize(this->Internals->Analyses.size(),
+      node.attribute("concurrent").as_int(0));
+
+    if (this->Internals->Scheduler.AddAnalyses(
+      this->Internals->Analyses.size(), node))
+      {
+      SENSEI_ERROR("Failed to configure scheduling of \"" << type
+        << "\" transport")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+    }
+
+  // set up concurrent execution
+  this->Internals->NumConcurrentThreads =
+    root.attribute("concurrent_threads").as_int(0);
+
+  this->Internals->NumSMPThreads = root.attribute("smp_threads").as_int(0);
+
+  if (this->Internals->InitializeConcurrency(this->GetCommunicator()))
+    {
+    SENSEI_ERROR("Failed to initialize concurrent execution")
+    MPI_Abort(this->GetCommunicator(), -1);
+    }
+
+  // the number of SMP threads is global to the process. changing it around
+  // the analyses is only safe when none of them execute on another thread
+  if (this->Internals->NumSMPThreads > 0)
+    {
+    bool threaded = this->Internals->Pool.GetNumberOfThreads() > 0;
+
+    AnalysisAdaptorVector::iterator it = this->Internals->Analyses.begin();
+    AnalysisAdaptorVector::iterator end = this->Internals->Analyses.end();
+    for (; !threaded && (it != end); ++it)
+      {
+      AsyncAnalysisAdaptor *async =
+        dynamic_cast<AsyncAnalysisAdaptor*>(it->GetPointer());
+
+      threaded = async && async->GetAsynchronous();
+      }
+
+    if (threaded)
+      {
+      SENSEI_ERROR("smp_threads can not be used with concurrent or"
+        " asynchronous execution of analyses")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+    }
+
+  // share simulation data amongst the analyses executing on this thread
+  if (root.attribute("cache").as_int(0) && !this->Internals->SerialCache)
+    {
+    this->Internals->SerialCache = svtkSmartPointer<CachingDataAdaptor>::New();
+    this->Internals->SerialCache->SetCommunicator(this->GetCommunicator());
+    }
+
+  // reuse the global view of the decomposition of static meshes
+  if (root.attribute("cache_global_view").as_int(0))
+    {
+    MeshMetadata::SetGlobalViewCaching(true);
+    this->Internals->GlobalViewCaching = true;
     }
 
+  // the solver's time is measured from here
+  this->Internals->LastExecuteEnd = MPI_Wtime();
+
   return 0;
 }
 
@@ -1302,42 +1733,160 @@ bool ConfigurableAnalysis::Execute(DataAdaptor* data, DataAdaptor** dataOut)
 
   TimeEvent<128> event("ConfigurableAnalysis::Execute");
 
-  int ai = 0;
-  AnalysisAdaptorVector::iterator iter = this->Internals->Analyses.begin();
-  AnalysisAdaptorVector::iterator end = this->Internals->Analyses.end();
-  for (; iter != end; ++iter, ++ai)
+  // the time the solver used since the last call
+  double solverTime = MPI_Wtime() - this->Internals->LastExecuteEnd;
+
+  // use the configured number of SMP threads in the analyses, and restore
+  // the simulation's number when they are done
+  int numSMPThreads = this->Internals->NumSMPThreads;
+  int simSMPThreads = 0;
+  if (numSMPThreads > 0)
     {
-    const char* analysisName = nullptr;
-    bool logEnabled = Profiler::Enabled();
-    if (logEnabled)
+    simSMPThreads = svtkSMPTools::GetEstimatedNumberOfThreads();
+    svtkSMPTools::Initialize(numSMPThreads);
+    }
+
+  // when analyses execute concurrently or caching is enabled the simulation
+  // data is fetched once and shared by all analyses through the cache.
+  // metadata is fetched up front to keep any collectives the simulation makes
+  // in a consistent order
+  bool concurrent = this->Internals->Pool.GetNumberOfThreads() > 0;
+  bool cached = this->Internals->SerialCache;
+  if (cached)
+    {
+    this->Internals->SerialCache->SetDataAdaptor(data);
+    if (this->Internals->SerialCache->PrefetchMetadata())
       {
-      analysisName = this->Internals->LogEventNames[3 * ai + 1].c_str();
-      Profiler::StartEvent(analysisName);
+      SENSEI_ERROR("Failed to fetch metadata")
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+    }
+
+  // the data the analyses executing on this thread use
+  DataAdaptor *serialData = cached ?
+    this->Internals->SerialCache.GetPointer() : data;
+
+  // decide which analyses execute this time step
+  std::vector<int> execute;
+  if (this->Internals->Scheduler.Schedule(this->GetCommunicator(),
+    serialData, solverTime, execute))
+    {
+    SENSEI_ERROR("Failed to schedule the analyses")
+    MPI_Abort(this->GetCommunicator(), -1);
+    }
+
+  // launch the concurrent analyses
+  unsigned int nAnalyses = this->Internals->Analyses.size();
+  std::vector<std::future<bool>> status(nAnalyses);
+  std::vector<DataAdaptor*> outputs(nAnalyses, nullptr);
+  for (unsigned int ai = 0; concurrent && (ai < nAnalyses); ++ai)
+    {
+    if (this->Internals->Concurrent[ai] && execute[ai])
+      {
+      status[ai] = this->Internals->Pool.Push([this, ai, dataOut, &outputs]() {
+          return this->Internals->ExecuteAnalysis(ai,
+            this->Internals->Caches[ai], dataOut ? &outputs[ai] : nullptr);
+        });
       }
+    }
 
-    if (!(*iter)->Execute(data, dataOut))
+  // execute the rest, in order, on this thread
+  for (unsigned int ai = 0; ai < nAnalyses; ++ai)
+    {
+    if (this->Internals->Concurrent[ai] || !execute[ai])
+      continue;
+
+    if (!this->Internals->ExecuteAnalysis(ai, serialData, dataOut))
       {
-      SENSEI_ERROR("Failed to execute " << (*iter)->GetClassName())
+      SENSEI_ERROR("Failed to execute "
+        << this->Internals->Analyses[ai]->GetClassName())
       MPI_Abort(this->GetCommunicator(), -1);
       }
+    }
 
-    if (logEnabled)
-      Profiler::EndEvent(analysisName);
+  // wait for the concurrent analyses to complete
+  for (unsigned int ai = 0; concurrent && (ai < nAnalyses); ++ai)
+    {
+    if (!this->Internals->Concurrent[ai] || !execute[ai])
+      continue;
+
+    if (!status[ai].get())
+      {
+      SENSEI_ERROR("Failed to execute "
+        << this->Internals->Analyses[ai]->GetClassName())
+      MPI_Abort(this->GetCommunicator(), -1);
+      }
+
+    if (outputs[ai])
+      *dataOut = outputs[ai];
     }
 
+  // release the shared simulation data
+  if (cached)
+    this->Internals->SerialCache->SetDataAdaptor(nullptr);
+
+  if (numSMPThreads > 0)
+    svtkSMPTools::Initialize(simSMPThreads);
+
+  this->Internals->LastExecuteEnd = MPI_Wtime();
+
   return true;
 }
 
+//----------------------------------------------------------------------------
+int ConfigurableAnalysis::PrepareToModify()
+{
+  AnalysisAdaptorVector::iterator iter = this->Internals->Analyses.begin();
+  AnalysisAdaptorVector::iterator end = this->Internals->Analyses.end();
+  for (; iter != end; ++iter)
+    {
+    AsyncAnalysisAdaptor *async =
+      dynamic_cast<AsyncAnalysisAdaptor*>(iter->GetPointer());
+
+    if (async && async->PrepareToModify())
+      {
+      SENSEI_ERROR("Failed to prepare "
+        << async->GetAnalysisAdaptor()->GetClassName() << " for modification")
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 int ConfigurableAnalysis::Finalize()
 {
   TimeEvent<128> event("ConfigurableAnalysis::Finalize");
 
+  // shut down the threads used for concurrent execution
+  this->Internals->Pool.Finalize();
+
+  // report the effectiveness of the cache
+  if (this->Internals->SerialCache)
+    {
+    CachingDataAdaptor::StatisticsType stats;
+    this->Internals->SerialCache->GetStatistics(stats);
+
+    SENSEI_STATUS("The shared data cache served " << stats.MeshHits
+      << " meshes and " << stats.ArrayHits << " arrays (" << stats.BytesServed
+      << " bytes) and fetched " << stats.MeshMisses << " meshes and "
+      << stats.ArrayMisses << " arrays (" << stats.BytesFetched << " bytes)")
+    }
+
   int ai = 0;
   AnalysisAdaptorVector::iterator iter = this->Internals->Analyses.begin();
   AnalysisAdaptorVector::iterator end = this->Internals->Analyses.end();
   for (; iter != end; ++iter, ++ai)
     {
+    // report how often scheduled analyses executed
+    if (this->Internals->Scheduler.GetActive(ai))
+      {
+      SENSEI_STATUS("Scheduled " << (*iter)->GetClassName() << " to execute "
+        << this->Internals->Scheduler.GetNumberOfExecutions(ai) << " of "
+        << this->Internals->Scheduler.GetNumberOfSteps(ai) << " time steps")
+      }
+
     bool logEnabled = Profiler::Enabled();
     const char* analysisName = nullptr;
     if (logEnabled)
@@ -1356,6 +1905,14 @@ int ConfigurableAnalysis::Finalize()
       Profiler::EndEvent(analysisName);
     }
 
+  // release the cached global views and their MPI groups while MPI is
+  // still initialized
+  if (this->Internals->GlobalViewCaching)
+    {
+    MeshMetadata::SetGlobalViewCaching(false);
+    this->Internals->GlobalViewCaching = false;
+    }
+
   return 0;
 }
 
@@ -19,6 +19,7 @@ namespace sensei
  * | Class | Description |
  * | ----- | ----------- |
  * | sensei::Histogram | Computes histograms |
+ * | sensei::QuantileSketch | Computes approximate quantiles using mergeable sketches |
  * | sensei::ADIOS2AnalysisAdaptor | The write side of the ADIOS2 transport |
  * | sensei::HDF5AnalysisAdaptor | The write side of the HDF5 transport |
  * | sensei::AscentAnalysisAdaptor | Processes simulation data using Ascent |
@@ -30,6 +31,26 @@ namespace sensei
  * | sensei::PythonAnalysis | Invokes user provided Pythons scripts that process simulation data |
  * | sensei::SliceExtract | Computes planar slices and iso-surfaces on simulation data |
  *
+ * Analyses are executed in the order they are configured unless the
+ * "concurrent" attribute is set, in which case they are executed on a pool of
+ * threads while the others run. The number of threads is set by the
+ * "concurrent_threads" attribute of the root element. Concurrent analyses
+ * share simulation data through a sensei::CachingDataAdaptor so that each
+ * mesh and array is fetched only once, and communicate using their own
+ * communicators. Concurrent execution requires MPI_THREAD_MULTIPLE.
+ *
+ * When the "cache" attribute of the root element is set the analyses that
+ * execute in order share simulation data through the cache as well. This
+ * saves repeated generation of meshes, arrays and ghost zones when more than
+ * one analysis processes the same data. Cache hits and misses are reported
+ * through the sensei::Profiler.
+ *
+ * When the "async" attribute is set the analysis is executed on a background
+ * thread by a sensei::AsyncAnalysisAdaptor, overlapping it with the
+ * simulation. The "async_queue_length" attribute bounds the number of time
+ * steps in flight and the "async_copy" attribute selects zero or deep copy
+ * snapshots. Simulations modifying their data in place while using zero copy
+ * snapshots must call PrepareToModify before doing so.
  */
 class SENSEI_EXPORT ConfigurableAnalysis : public AnalysisAdaptor
 {
@@ -59,6 +80,12 @@ public:
   /// Invokes the Execute method on the currently configured adaptors.
   bool Execute(DataAdaptor *data, DataAdaptor **result) override;
 
+  /** Must be called by the simulation before it modifies data that may be
+   * held by zero copy snapshots of analyses executing asynchronously.
+   * Returns 0 if successful.
+   */
+  int PrepareToModify();
+
   /// Invokes the Finalize method on the currently configured adaptors.
   int Finalize() override;
 
@@ -4,6 +4,7 @@
 #include "MappedPartitioner.h"
 #include "PlanarPartitioner.h"
 #include "PlanarSlicePartitioner.h"
+#include "WeightedPartitioner.h"
 #include "XMLUtils.h"
 #include "Profiler.h"
 
@@ -80,6 +81,14 @@ int ConfigurablePartitioner::Initialize(pugi::xml_node &partNode)
     {
     tmp = PlanarSlicePartitioner::New();
     }
+  else if (partType == "weighted")
+    {
+    tmp = WeightedPartitioner::New();
+    }
+  else if (partType == "space_filling_curve")
+    {
+    tmp = SpaceFillingCurvePartitioner::New();
+    }
   else
     {
     SENSEI_ERROR("Failed to construct a partitioner. \""
@@ -88,6 +97,8 @@ int ConfigurablePartitioner::Initialize(pugi::xml_node &partNode)
     }
 
   // let the instance initialize itself
+  tmp->SetVerbose(partNode.attribute("verbose").as_int(0));
+
   if (tmp->Initialize(partNode))
     {
     SENSEI_ERROR("Failed to initialize the \"" << partType << "\" partitioner")
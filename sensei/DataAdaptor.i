@@ -10,6 +10,7 @@
 #include "MappedPartitioner.h"
 #include "PlanarSlicePartitioner.h"
 #include "IsoSurfacePartitioner.h"
+#include "WeightedPartitioner.h"
 #include "ConfigurablePartitioner.h"
 #include "SVTKUtils.h"
 #include "Error.h"
@@ -301,6 +302,8 @@ SENSEI_WRAP_DATA_ADAPTOR(DataAdaptor)
 %shared_ptr(sensei::MappedPartitioner)
 %shared_ptr(sensei::PlanarSlicePartitioner)
 %shared_ptr(sensei::IsoSurfacePartitioner)
+%shared_ptr(sensei::WeightedPartitioner)
+%shared_ptr(sensei::SpaceFillingCurvePartitioner)
 %shared_ptr(sensei::ConfigurablePartitioner)
 
 %define PARTITIONER_API(cname)
@@ -326,6 +329,8 @@ PARTITIONER_API(PlanarPartitioner)
 PARTITIONER_API(MappedPartitioner)
 PARTITIONER_API(PlanarSlicePartitioner)
 PARTITIONER_API(IsoSurfacePartitioner)
+PARTITIONER_API(WeightedPartitioner)
+PARTITIONER_API(SpaceFillingCurvePartitioner)
 PARTITIONER_API(ConfigurablePartitioner)
 
 %include "Partitioner.h"
@@ -334,6 +339,7 @@ PARTITIONER_API(ConfigurablePartitioner)
 %include "MappedPartitioner.h"
 %include "PlanarSlicePartitioner.h"
 %include "IsoSurfacePartitioner.h"
+%include "WeightedPartitioner.h"
 %include "ConfigurablePartitioner.h"
 
 /****************************************************************************
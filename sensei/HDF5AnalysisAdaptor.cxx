@@ -232,6 +232,11 @@ bool HDF5AnalysisAdaptor::Execute(DataAdaptor* dataAdaptor, DataAdaptor** daOut)
       ++mit;
     }
 
+  // make the step available to the reader now, rather than when the next
+  // step begins
+  if (!this->m_HDF5Writer->EndTimeStep())
+    return false;
+
   return true;
 }
 
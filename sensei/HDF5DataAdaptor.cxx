@@ -73,6 +73,11 @@ int HDF5DataAdaptor::Initialize(pugi::xml_node& node)
         }
     }
 
+  // streaming timeouts in seconds
+  SetOpenTimeout(node.attribute("open_timeout").as_double(m_OpenTimeout));
+  SetStepTimeout(node.attribute("step_timeout").as_double(m_StepTimeout));
+  SetPollInterval(node.attribute("poll_interval").as_double(m_PollInterval));
+
   return 0;
 }
 
@@ -93,6 +98,10 @@ int HDF5DataAdaptor::OpenStream()
         new senseiHDF5::ReadStream(this->GetCommunicator(), m_Streaming);
     }
 
+  this->m_HDF5Reader->m_OpenTimeout = m_OpenTimeout;
+  this->m_HDF5Reader->m_StepTimeout = m_StepTimeout;
+  this->m_HDF5Reader->m_PollInterval = m_PollInterval;
+
   if (!this->m_HDF5Reader->Init(m_StreamName))
     {
       SENSEI_ERROR("Failed to open \"" << m_StreamName << "\"");
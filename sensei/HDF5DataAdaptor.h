@@ -29,6 +29,23 @@ public:
   void SetStreaming(bool s) { m_Streaming = s; }
   void SetCollective(bool s) { m_Collective = s; }
 
+  /** When streaming, sets the time in seconds to wait for the writer to
+   * produce the first step. The default is 300 seconds.
+   */
+  void SetOpenTimeout(double s) { m_OpenTimeout = s; }
+
+  /** When streaming, sets the time in seconds to wait for the writer to
+   * produce each subsequent step. The default is 900 seconds.
+   */
+  void SetStepTimeout(double s) { m_StepTimeout = s; }
+
+  /** When streaming, sets the longest interval in seconds between checks for
+   * a new step. New steps are detected immediately when the file system
+   * reports changes, otherwise they are polled for with a back off that
+   * starts at 1 ms and is bounded by this interval. The default is 1 second.
+   */
+  void SetPollInterval(double s) { m_PollInterval = s; }
+
   // int Advance(); now is AdvanceStream()
 
   // int Close(); now is CloseStream()
@@ -77,6 +94,10 @@ private:
   bool m_Streaming = false;
   bool m_Collective = false;
 
+  double m_OpenTimeout = 300.0;
+  double m_StepTimeout = 900.0;
+  double m_PollInterval = 1.0;
+
   std::string m_StreamName;
 
   HDF5DataAdaptor(const HDF5DataAdaptor &) = delete;
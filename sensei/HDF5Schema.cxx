@@ -43,10 +43,20 @@
 #include <map>
 #include <set>
 #include <sstream>
+#include <fstream>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 #include <unistd.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
 
 #include "BlockPartitioner.h"
 
@@ -398,6 +408,93 @@ bool DefaultStreamHandler::Summary()
 // if using char, do 11111 and use 0 to indicate end... so only need to check
 // whether the last char is 0?
 
+//
+// Waits for changes to the host file of a per-step stream. Where inotify is
+// available the directory containing the host file is watched and the wait
+// returns as soon as the host file is replaced. Otherwise the wait simply
+// times out and the caller polls the host file.
+//
+class StepNotifier
+{
+public:
+  StepNotifier(const std::string &hostFile);
+  ~StepNotifier();
+
+  // wait for the host file to change or for the timeout in seconds to expire
+  void Wait(double timeout);
+
+private:
+  int m_Fd = -1;
+  std::string m_HostName;
+};
+
+StepNotifier::StepNotifier(const std::string &hostFile)
+{
+  size_t pos = hostFile.rfind('/');
+  std::string dirName = pos == std::string::npos ? "." : hostFile.substr(0, pos);
+  m_HostName = pos == std::string::npos ? hostFile : hostFile.substr(pos + 1);
+
+#if defined(__linux__)
+  m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  // the writer renames a temporary over the host file
+  if((m_Fd >= 0) && (inotify_add_watch(m_Fd, dirName.c_str(),
+      IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE) < 0))
+    {
+      close(m_Fd);
+      m_Fd = -1;
+    }
+#endif
+}
+
+StepNotifier::~StepNotifier()
+{
+  if(m_Fd >= 0)
+    close(m_Fd);
+}
+
+void StepNotifier::Wait(double timeout)
+{
+  using clock = std::chrono::steady_clock;
+  clock::time_point t1 = clock::now() +
+    std::chrono::microseconds(static_cast<long>(1.0e6 * timeout));
+
+#if defined(__linux__)
+  if(m_Fd >= 0)
+    {
+      alignas(struct inotify_event) char buf[4096];
+      while(true)
+        {
+          long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            t1 - clock::now()).count();
+
+          struct pollfd pfd = {m_Fd, POLLIN, 0};
+          if(poll(&pfd, 1, std::max(ms, 0l)) <= 0)
+            return;
+
+          // look for an event on the host file, others are ignored
+          ssize_t len = 0;
+          bool changed = false;
+          while((len = read(m_Fd, buf, sizeof(buf))) > 0)
+            {
+              for(char *ptr = buf; ptr < buf + len;)
+                {
+                  struct inotify_event *evt = (struct inotify_event*)ptr;
+                  if(evt->len && (m_HostName == evt->name))
+                    changed = true;
+                  ptr += sizeof(struct inotify_event) + evt->len;
+                }
+            }
+
+          if(changed || (ms <= 0))
+            return;
+        }
+    }
+#endif
+
+  std::this_thread::sleep_until(t1);
+}
+
 //
 //
 //
@@ -405,18 +502,15 @@ PerStepStreamHandler::PerStepStreamHandler(const std::string &hostFile,
     ReadStream *client)
   : StreamHandler(true, hostFile, client)
 {
-  unsigned int AllowedTimeOutSec = 300;
+  if(m_Client->m_Rank == 0)
+    m_Notifier = new StepNotifier(m_FileName);
 
-  // loop until timestep showed
-  unsigned int counter = 0;
-  while(counter < AllowedTimeOutSec)
-    {
-      GetCurrAvailStep();
-      if(m_NumStepsWritten > 0)
-        break;
-      sleep(2);
-      counter += 5;
-    }
+  // wait for the first step
+  WaitForStep(1, m_Client->m_OpenTimeout);
+
+  if((m_NumStepsWritten < 1) && (m_Client->m_Rank == 0))
+    SENSEI_ERROR("No steps were found in \"" << m_FileName << "\" after "
+      << m_Client->m_OpenTimeout << " seconds")
 }
 
 PerStepStreamHandler::PerStepStreamHandler(const std::string &hostFile,
@@ -428,7 +522,10 @@ PerStepStreamHandler::PerStepStreamHandler(const std::string &hostFile,
   MPI_Barrier(m_Client->m_Comm);
 }
 
-PerStepStreamHandler::~PerStepStreamHandler() {}
+PerStepStreamHandler::~PerStepStreamHandler()
+{
+  delete m_Notifier;
+}
 
 bool PerStepStreamHandler::IsValid()
 {
@@ -469,50 +566,68 @@ bool PerStepStreamHandler::Summary()
       return true;
     }
 
-  if(m_Client->m_Rank > 0)
-    return true;
-
-  std::ofstream outfile;
-  outfile.open(m_FileName, std::ios::out | std::ios::app);
-
-  if(outfile.fail())
-    throw std::ios_base::failure(std::strerror(errno));
-
-  outfile << 0;
-
-  outfile.close();
+  UpdateAvailStep(true);
 
   return true;
 }
 
-void PerStepStreamHandler::GetCurrAvailStep()
+void PerStepStreamHandler::ReadAvailStep()
 {
   if(m_AllStepsWritten)
     return;
 
+  // the host file holds a 1 for each step written, followed by a 0 once
+  // the writer is done. it is replaced atomically, hence never partial.
   int counter = -1;
-  if(m_Client->m_Rank == 0)
+  std::ifstream curr(m_FileName);
+  if(curr.is_open())
     {
-      std::ifstream curr(m_FileName);
       std::string line;
-      if(curr.is_open())
+      getline(curr, line);
+      curr.close();
+
+      counter = line.size();
+      if(!line.empty() && ('0' == line.back()))
         {
-          // while ( getline (curr,line) )
-          getline(curr, line);
-          curr.close();
+          counter--;
+          m_AllStepsWritten = true;
+        }
+    }
 
-          counter = line.size();
-          if('0' == line.back())
-            {
-              counter--;
-              m_AllStepsWritten = true;
-            }
-        } // else {
-      // counter = -1; // no such file
-      //}
-      m_NumStepsWritten = counter;
+  m_NumStepsWritten = counter;
+}
+
+void PerStepStreamHandler::WaitForStep(int nSteps, double timeout)
+{
+  int counter = -1;
+  if(m_Client->m_Rank == 0)
+    {
+      using clock = std::chrono::steady_clock;
+      clock::time_point t0 = clock::now();
+
+      // the interval between checks grows from 1 ms to the poll interval.
+      // a change notification ends the wait early.
+      double delay = std::min(1.0e-3, m_Client->m_PollInterval);
+
+      while(true)
+        {
+          ReadAvailStep();
+
+          if(m_AllStepsWritten || (m_NumStepsWritten >= nSteps) ||
+            ((m_NumStepsWritten < 0) && (m_TimeStepCounter > 0)))
+            break;
+
+          double remaining = timeout -
+            std::chrono::duration<double>(clock::now() - t0).count();
 
-      counter *= 10;
+          if(remaining <= 0.0)
+            break;
+
+          m_Notifier->Wait(std::min(delay, remaining));
+          delay = std::min(2.0 * delay, m_Client->m_PollInterval);
+        }
+
+      counter = m_NumStepsWritten * 10;
       if(m_AllStepsWritten)
         counter += 1;
       MPI_Bcast(&counter, 1, MPI_INT, 0, m_Client->m_Comm);
@@ -533,55 +648,56 @@ void PerStepStreamHandler::GetCurrAvailStep()
     }
 }
 
-void PerStepStreamHandler::UpdateAvailStep()
+void PerStepStreamHandler::UpdateAvailStep(bool allStepsWritten)
 {
-  // testing sleep(m_TimeStepCounter*10);
   if(m_Client->m_Rank > 0)
     {
       return;
     }
 
-  std::ofstream outfile;
+  // write to a temporary and rename it over the host file so that readers
+  // never see a partially written file, and are notified of the change
+  std::string tmpName = m_FileName + ".tmp";
 
-  outfile.open(m_FileName, std::ios::out | std::ios::app);
+  std::ofstream outfile;
+  outfile.open(tmpName, std::ios::out | std::ios::trunc);
 
   if(outfile.fail())
     throw std::ios_base::failure(std::strerror(errno));
 
-  outfile << 1;
-  outfile.flush();
+  outfile << std::string(m_TimeStepCounter, '1');
+  if(allStepsWritten)
+    outfile << 0;
+
   outfile.close();
+
+  if(std::rename(tmpName.c_str(), m_FileName.c_str()))
+    throw std::ios_base::failure(std::strerror(errno));
 }
 
 bool PerStepStreamHandler::NoMoreStep()
 {
-  if((m_NumStepsWritten - m_TimeStepCounter) > 0)
+  int nextStep = m_TimeStepCounter + 1;
+
+  if(m_NumStepsWritten >= nextStep)
     return false;
 
-  if(m_AllStepsWritten && (0 == (m_NumStepsWritten - m_TimeStepCounter)))
+  if(m_AllStepsWritten)
     return true;
 
-  unsigned int counter = 0;
-  unsigned int MAXWAIT = 900;
-
-  while (true)
-  {
-    GetCurrAvailStep();
-    if ((m_NumStepsWritten < 0) && (m_TimeStepCounter > 0))
-      return true; // all finished
+  WaitForStep(nextStep, m_Client->m_StepTimeout);
 
-    if ((m_NumStepsWritten - m_TimeStepCounter) > 0)
-      return false;
+  if((m_NumStepsWritten < 0) && (m_TimeStepCounter > 0))
+    return true; // all finished
 
-    if (m_AllStepsWritten && (0 == (m_NumStepsWritten - m_TimeStepCounter)))
-      return true;
+  if(m_NumStepsWritten >= nextStep)
+    return false;
 
-    sleep(1);
+  if(!m_AllStepsWritten && (m_Client->m_Rank == 0))
+    SENSEI_WARNING("Step " << m_TimeStepCounter << " of \"" << m_FileName
+      << "\" was not available after " << m_Client->m_StepTimeout
+      << " seconds")
 
-    counter++;
-    if(counter > MAXWAIT)
-      return true;
-  }
   return true;
 }
 
@@ -596,7 +712,7 @@ bool PerStepStreamHandler::CloseStream()
   H5Fclose(m_TimeStepId);
   m_TimeStepId = -1;
   if(!m_InReadMode)
-    UpdateAvailStep();
+    UpdateAvailStep(false);
 
   if((m_InReadMode) && (m_Client->m_Rank == 0))
     {
@@ -2293,11 +2409,23 @@ bool WriteStream::Init(const std::string &filename)
   return m_Streamer->IsValid();
 }
 
+bool WriteStream::EndTimeStep()
+{
+  if(m_Streamer->m_TimeStepId < 0)
+    return true;
+
+  if(!WriteNativeAttr(
+      senseiHDF5::ATTRNAME_NUM_MESH, &(m_MeshCounter), H5T_NATIVE_UINT, -1))
+    return false;
+
+  CloseTimeStep();
+
+  return true;
+}
+
 bool WriteStream::AdvanceTimeStep(unsigned long &time_step, double &time)
 {
-  if(m_Streamer->m_TimeStepCounter > 0)
-    WriteNativeAttr(
-      senseiHDF5::ATTRNAME_NUM_MESH, &(m_MeshCounter), H5T_NATIVE_UINT, -1);
+  EndTimeStep();
 
   m_MeshCounter = 0;
   m_Streamer->AdvanceStream();
@@ -2410,12 +2538,7 @@ bool WriteStream::WriteMetadata(sensei::MeshMetadataPtr &md)
 // --------------------------------------------------------------------------
 WriteStream::~WriteStream()
 {
-  if(m_Streamer->m_TimeStepCounter > 0)
-    {
-      WriteNativeAttr(
-        senseiHDF5::ATTRNAME_NUM_MESH, &(m_MeshCounter), H5T_NATIVE_UINT, -1);
-      CloseTimeStep();
-    }
+  EndTimeStep();
   m_Streamer->Summary();
 }
 
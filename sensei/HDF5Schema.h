@@ -96,6 +96,7 @@ public:
 class BasicStream;
 class ReadStream;
 class WriteStream;
+class StepNotifier;
 
 //
 //
@@ -140,6 +141,12 @@ private:
   unsigned int m_TimeStepTotal = 0;
 };
 
+// Each step is written to its own file. The host file records the number of
+// steps that are complete, and is replaced atomically by rank 0 of the writer
+// each time a step is closed. The reader waits for changes to the host file
+// using inotify where available, otherwise, and as a fall back for file
+// systems that do not report changes made on other nodes, by polling with a
+// back off bounded by the poll interval.
 class PerStepStreamHandler : public StreamHandler
 {
 public:
@@ -159,12 +166,22 @@ private:
 
   // hid_t m_HostFileId;
   bool NoMoreStep();
-  void GetCurrAvailStep();
-  void UpdateAvailStep();
+
+  // rank 0 reads the number of steps available from the host file
+  void ReadAvailStep();
+
+  // wait until at least nSteps are available, the writer is done, or the
+  // timeout in seconds expires. the result is broadcast to all ranks.
+  void WaitForStep(int nSteps, double timeout);
+
+  // rank 0 replaces the host file with one recording the steps written
+  void UpdateAvailStep(bool allStepsWritten);
 
   int m_NumStepsWritten = -1; // -1 if not able to detect. otherwise >=1
 
   bool m_AllStepsWritten = false;
+
+  StepNotifier *m_Notifier = nullptr;
 };
 
 //
@@ -189,6 +206,13 @@ public:
 
   bool m_StreamingOn = false;
 
+  // when streaming, the time in seconds the reader waits for the first step
+  // and for each subsequent step, and the longest interval in seconds between
+  // checks of the host file when change notification is not available
+  double m_OpenTimeout = 300.0;
+  double m_StepTimeout = 900.0;
+  double m_PollInterval = 1.0;
+
   sensei::MeshMetadataMap m_AllMeshInfo; // sender
   sensei::MeshMetadataMap m_AllMeshInfoReceiver;
 
@@ -214,6 +238,11 @@ public:
 
   bool AdvanceTimeStep(unsigned long &time_step, double &time);
 
+  // completes the current time step. when streaming the step is made
+  // available to the reader immediately rather than when the next step
+  // begins.
+  bool EndTimeStep();
+
   void Close() {}
   bool WriteMesh(sensei::MeshMetadataPtr &md, svtkCompositeDataSet *svtkPtr);
 
@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <sstream>
 
 namespace
 {
@@ -87,8 +88,7 @@ namespace sensei
 senseiNewMacro(Histogram);
 
 //-----------------------------------------------------------------------------
-Histogram::Histogram() : NumberOfBins(0),
-  Association(svtkDataObject::FIELD_ASSOCIATION_POINTS)
+Histogram::Histogram() : NumberOfBins(0)
 {
 }
 
@@ -100,12 +100,41 @@ Histogram::~Histogram()
 //-----------------------------------------------------------------------------
 void Histogram::Initialize(int bins, const std::string &meshName,
   int association, const std::string& arrayName, const std::string &fileName)
+{
+  DataRequirements reqs;
+  reqs.AddRequirement(meshName, association, arrayName);
+  this->Initialize(bins, reqs, fileName);
+}
+
+//-----------------------------------------------------------------------------
+int Histogram::Initialize(int bins, const DataRequirements &reqs,
+  const std::string &fileName)
 {
   this->NumberOfBins = bins;
-  this->MeshName = meshName;
-  this->ArrayName = arrayName;
-  this->Association = association;
+  this->Requirements = reqs;
   this->FileName = fileName;
+
+  // flatten the requirements. this is the order in which the histograms
+  // are computed and stored
+  this->Arrays.clear();
+  MeshRequirementsIterator mit = this->Requirements.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    ArrayRequirementsIterator ait =
+      this->Requirements.GetArrayRequirementsIterator(mit.MeshName());
+    for (; ait; ++ait)
+      this->Arrays.push_back({mit.MeshName(), ait.Association(), ait.Array()});
+    }
+
+  this->LastResult.clear();
+
+  if (this->Arrays.empty())
+    {
+    SENSEI_ERROR("No arrays were specified")
+    return -1;
+    }
+
+  return 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -133,22 +162,6 @@ bool Histogram::Execute(DataAdaptor* data, DataAdaptor** dataOut)
     return false;
     }
 
-  // get the mesh metadata object
-  MeshMetadataPtr mmd;
-  if (mdMap.GetMeshMetadata(this->MeshName, mmd))
-    {
-    SENSEI_ERROR("Failed to get metadata for mesh \"" << this->MeshName << "\"")
-    return false;
-    }
-
-  // get the mesh object
-  svtkDataObject *dobj = nullptr;
-  if (data->GetMesh(this->MeshName, true, dobj))
-    {
-    SENSEI_ERROR("Failed to get mesh \"" << this->MeshName << "\"")
-    return false;
-    }
-
   int rank = 0;
   MPI_Comm comm = this->GetCommunicator();
   MPI_Comm_rank(comm, &rank);
@@ -170,127 +183,185 @@ bool Histogram::Execute(DataAdaptor* data, DataAdaptor** dataOut)
   int step = data->GetDataTimeStep();
   double time = data->GetDataTime();
 
+  int nArrays = this->Arrays.size();
+
   if (rank == 0)
     {
+    std::ostringstream oss;
+    for (int i = 0; i < nArrays; ++i)
+      {
+      oss << (i ? ", " : "") << "mesh \"" << this->Arrays[i].MeshName
+        << "\" array \"" << this->Arrays[i].ArrayName << "\"";
+      }
+
     SENSEI_STATUS("Step = " << step << " Time = " << time
-      << " Computing the histogram on mesh \""
-      << this->MeshName << "\" array \"" << this->ArrayName
-      << "\" using " << (deviceId < 0 ? "the CPU" : "CUDA GPU ")
+      << " Computing the histogram on " << oss.str()
+      << " using " << (deviceId < 0 ? "the CPU" : "CUDA GPU ")
       << aDevId)
     }
 
-
   // create a new histogram computation. this class does all the work.
   std::shared_ptr<sensei::HistogramInternals>
-    internals(new sensei::HistogramInternals(comm, deviceId, this->NumberOfBins));
+    internals(new sensei::HistogramInternals(comm, deviceId,
+      this->NumberOfBins, nArrays));
 
-  if (!dobj)
-    {
-    // it is not an necessarilly an error if all ranks do not have
-    // a dataset to process. However, all ranks must participate due
-    // to the use of MPI collectives.
-    internals->Initialize();
-    internals->ComputeHistogram();
-    internals->Clear();
-    return true;
-    }
+  internals->Initialize();
 
-  // fetch the array that the hiostogram will be computed on
-  if (data->AddArray(dobj, this->MeshName, this->Association, this->ArrayName))
+  // fetch each mesh once along with all of the arrays needed from it. the
+  // meshes are held until the histograms have been computed
+  std::vector<svtkCompositeDataSetPtr> meshes;
+  int arrayId = 0;
+  MeshRequirementsIterator mit = this->Requirements.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
     {
-    SENSEI_ERROR(<< data->GetClassName() << " failed to add "
-      << (this->Association == svtkDataObject::POINT ? "point" : "cell")
-      << " data array \""  << this->ArrayName << "\"")
-
-    // abort to avoid deadlocks in collective calls
-    MPI_Abort(comm, -1);
-    return false;
-    }
+    const std::string &meshName = mit.MeshName();
 
-  // add the ghost zones
-  if ((mmd->NumGhostCells || SVTKUtils::AMR(mmd)) &&
-    data->AddGhostCellsArray(dobj, this->MeshName))
-    {
-    SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
-    // abort to avoid deadlocks in collective calls
-    MPI_Abort(comm, -1);
-    return false;
-    }
+    // the arrays of this mesh are consecutive
+    int firstArrayId = arrayId;
+    int lastArrayId = firstArrayId;
+    while ((lastArrayId < nArrays) &&
+      (this->Arrays[lastArrayId].MeshName == meshName))
+      ++lastArrayId;
 
-  if (mmd->NumGhostNodes && data->AddGhostNodesArray(dobj, this->MeshName))
-    {
-    SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost nodes.")
-    // abort to avoid deadlocks in collective calls
-    MPI_Abort(comm, -1);
-    return false;
-    }
+    arrayId = lastArrayId;
 
-  // add all blocks of data
-  svtkCompositeDataSetPtr mesh = SVTKUtils::AsCompositeData(comm, dobj, true);
-  svtkSmartPointer<svtkCompositeDataIterator> iter;
-  iter.TakeReference(mesh->NewIterator());
-  for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
-    {
-    // get the local mesh
-    svtkDataObject *curObj = iter->GetCurrentDataObject();
+    // get the mesh metadata object
+    MeshMetadataPtr mmd;
+    if (mdMap.GetMeshMetadata(meshName, mmd))
+      {
+      SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+      // abort to avoid deadlocks in collective calls
+      MPI_Abort(comm, -1);
+      return false;
+      }
 
-    // get the array to compute histogram for
-    svtkDataArray* array = this->GetArray(curObj, this->ArrayName);
-    if (!array)
+    // get the mesh object
+    svtkDataObject *dobj = nullptr;
+    if (data->GetMesh(meshName, true, dobj))
       {
-      SENSEI_WARNING("Data block " << iter->GetCurrentFlatIndex()
-        << " of mesh \"" << this->MeshName << " has no array named \""
-        << this->ArrayName << "\"")
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      // abort to avoid deadlocks in collective calls
+      MPI_Abort(comm, -1);
+      return false;
+      }
+
+    // it is not an necessarilly an error if all ranks do not have
+    // a dataset to process. However, all ranks must participate due
+    // to the use of MPI collectives.
+    if (!dobj)
       continue;
+
+    // fetch the arrays that the hiostograms will be computed on
+    for (int i = firstArrayId; i < lastArrayId; ++i)
+      {
+      const ArrayId &aid = this->Arrays[i];
+      if (data->AddArray(dobj, meshName, aid.Association, aid.ArrayName))
+        {
+        SENSEI_ERROR(<< data->GetClassName() << " failed to add "
+          << (aid.Association == svtkDataObject::POINT ? "point" : "cell")
+          << " data array \""  << aid.ArrayName << "\"")
+
+        // abort to avoid deadlocks in collective calls
+        MPI_Abort(comm, -1);
+        return false;
+        }
       }
 
-    // and get the ghost cell array
-    svtkUnsignedCharArray *ghostArray = dynamic_cast<svtkUnsignedCharArray*>(
-      this->GetArray(curObj, this->GetGhostArrayName()));
+    // add the ghost zones
+    if ((mmd->NumGhostCells || SVTKUtils::AMR(mmd)) &&
+      data->AddGhostCellsArray(dobj, meshName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
+      // abort to avoid deadlocks in collective calls
+      MPI_Abort(comm, -1);
+      return false;
+      }
 
-    // add this blocks contribution to the calculation
-    if (internals->AddLocalData(array, ghostArray))
+    if (mmd->NumGhostNodes && data->AddGhostNodesArray(dobj, meshName))
       {
-      SENSEI_ERROR("Failed to add array \"" << this->ArrayName
-        << "\" data block " << iter->GetCurrentFlatIndex() << " of mesh \""
-        << this->MeshName << "\"")
-      // abort to prevent deadlock in collective calls
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost nodes.")
+      // abort to avoid deadlocks in collective calls
       MPI_Abort(comm, -1);
+      return false;
+      }
+
+    // add all blocks of data
+    svtkCompositeDataSetPtr mesh = SVTKUtils::AsCompositeData(comm, dobj, true);
+    meshes.push_back(mesh);
+
+    svtkSmartPointer<svtkCompositeDataIterator> iter;
+    iter.TakeReference(mesh->NewIterator());
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+      {
+      // get the local mesh
+      svtkDataObject *curObj = iter->GetCurrentDataObject();
+
+      for (int i = firstArrayId; i < lastArrayId; ++i)
+        {
+        const ArrayId &aid = this->Arrays[i];
+
+        // get the array to compute histogram for
+        svtkDataArray* array = this->GetArray(curObj, aid.Association, aid.ArrayName);
+        if (!array)
+          {
+          SENSEI_WARNING("Data block " << iter->GetCurrentFlatIndex()
+            << " of mesh \"" << meshName << " has no array named \""
+            << aid.ArrayName << "\"")
+          continue;
+          }
+
+        // and get the ghost cell array
+        svtkUnsignedCharArray *ghostArray = dynamic_cast<svtkUnsignedCharArray*>(
+          this->GetArray(curObj, aid.Association, this->GetGhostArrayName()));
+
+        // add this blocks contribution to the calculation
+        if (internals->AddLocalData(i, array, ghostArray))
+          {
+          SENSEI_ERROR("Failed to add array \"" << aid.ArrayName
+            << "\" data block " << iter->GetCurrentFlatIndex() << " of mesh \""
+            << meshName << "\"")
+          // abort to prevent deadlock in collective calls
+          MPI_Abort(comm, -1);
+          }
+        }
       }
     }
 
-  // compute the histogram. this is an MPI collective, all MPI ranks must participate.
-  // after this call returns MPI rank 0 holds the histogram
+  // compute the histograms. this is an MPI collective, all MPI ranks must
+  // participate. after this call returns MPI rank 0 holds the histograms
   if (internals->ComputeHistogram())
     {
-    SENSEI_ERROR("Failed to compute the histogram for array \""
-      << this->ArrayName << "\" of mesh \"" << this->MeshName << "\"")
+    SENSEI_ERROR("Failed to compute the histograms")
     // abort to prevent deadlock in collective calls
     MPI_Abort(comm, -1);
     }
 
-  // store a copy of the histogram. this can be acccessed from scripts ofr
+  // store a copy of the histograms. these can be acccessed from scripts for
   // regression testing etc.
-  Histogram::Data result;
+  this->LastResult.resize(nArrays);
 
-  internals->GetHistogram(result.NumberOfBins, result.BinMin,
-    result.BinMax, result.BinWidth, result.Histogram);
+  for (int i = 0; i < nArrays; ++i)
+    {
+    const ArrayId &aid = this->Arrays[i];
+    Histogram::Data &result = this->LastResult[i];
 
-  this->LastResult = result;
+    internals->GetHistogram(i, result.NumberOfBins, result.BinMin,
+      result.BinMax, result.BinWidth, result.Histogram);
 
-  // write the results if on MPI rank 0
-  if (rank == 0)
-    {
-    if (this->FileName.empty())
+    // write the results if on MPI rank 0
+    if (rank == 0)
       {
-      ::Write(step, time, this->MeshName, this->ArrayName, result);
-      }
-    else
-      {
-      if (::Write(this->FileName, step, time, this->MeshName, this->ArrayName, result))
+      if (this->FileName.empty())
         {
-        SENSEI_ERROR("Failed to write histogram.")
-        return false;
+        ::Write(step, time, aid.MeshName, aid.ArrayName, result);
+        }
+      else
+        {
+        if (::Write(this->FileName, step, time, aid.MeshName, aid.ArrayName, result))
+          {
+          SENSEI_ERROR("Failed to write histogram.")
+          return false;
+          }
         }
       }
     }
@@ -301,9 +372,10 @@ bool Histogram::Execute(DataAdaptor* data, DataAdaptor** dataOut)
 }
 
 //-----------------------------------------------------------------------------
-svtkDataArray* Histogram::GetArray(svtkDataObject* dobj, const std::string& arrayname)
+svtkDataArray* Histogram::GetArray(svtkDataObject* dobj, int association,
+  const std::string& arrayname)
 {
-  if (svtkFieldData* fd = dobj->GetAttributesAsFieldData(this->Association))
+  if (svtkFieldData* fd = dobj->GetAttributesAsFieldData(association))
     {
     return fd->GetArray(arrayname.c_str());
     }
@@ -313,10 +385,37 @@ svtkDataArray* Histogram::GetArray(svtkDataObject* dobj, const std::string& arra
 //-----------------------------------------------------------------------------
 int Histogram::GetHistogram(Histogram::Data &result)
 {
-  result = this->LastResult;
+  if (this->LastResult.empty())
+    {
+    result = Histogram::Data();
+    return 0;
+    }
+
+  result = this->LastResult[0];
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int Histogram::GetHistogram(const std::string &meshName, int association,
+  const std::string &arrayName, Histogram::Data &result)
+{
+  int nArrays = this->LastResult.size();
+  for (int i = 0; i < nArrays; ++i)
+    {
+    const ArrayId &aid = this->Arrays[i];
+    if ((aid.MeshName == meshName) && (aid.Association == association) &&
+      (aid.ArrayName == arrayName))
+      {
+      result = this->LastResult[i];
+      return 0;
+      }
+    }
+
+  SENSEI_ERROR("No histogram for " << SVTKUtils::GetAttributesName(association)
+    << " data array \"" << arrayName << "\" on mesh \"" << meshName << "\"")
+  return -1;
+}
+
 //-----------------------------------------------------------------------------
 int Histogram::Finalize()
 {
@@ -2,8 +2,10 @@
 #define Histogram_h
 
 #include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
 #include <mpi.h>
 #include <vector>
+#include <string>
 
 class svtkDataObject;
 class svtkDataArray;
@@ -11,7 +13,11 @@ class svtkDataArray;
 namespace sensei
 {
 
-/// Computes a histogram in parallel.
+/** Computes histograms in parallel. Histograms of any number of arrays, on
+ * one or more meshes, may be computed. Each mesh is fetched once per time
+ * step and the histograms of all of the arrays are computed together, using
+ * one MPI_Allreduce for the ranges and one MPI_Reduce for the counts.
+ */
 class SENSEI_EXPORT Histogram : public AnalysisAdaptor
 {
 public:
@@ -20,11 +26,17 @@ public:
 
   senseiTypeMacro(Histogram, AnalysisAdaptor);
 
-  /// initialize for the run
+  /// initialize for the run, computing the histogram of a single array
   void Initialize(int bins, const std::string &meshName,
     int association, const std::string& arrayName,
     const std::string &fileName);
 
+  /** initialize for the run, computing the histograms of all of the arrays
+   * named in the data requirements. Returns 0 if successful.
+   */
+  int Initialize(int bins, const DataRequirements &reqs,
+    const std::string &fileName);
+
   /// compute the histogram for this time step
   bool Execute(DataAdaptor* data, DataAdaptor**) override;
 
@@ -43,9 +55,15 @@ public:
       std::vector<unsigned int> Histogram; ///< The counts of each bin
   };
 
-  /// return the histogram computed by the most recent call to Execute
+  /// return the histogram of the first array computed by the most recent
+  /// call to Execute
   int GetHistogram(Histogram::Data &data);
 
+  /// return the histogram of the named array computed by the most recent
+  /// call to Execute
+  int GetHistogram(const std::string &meshName, int association,
+    const std::string &arrayName, Histogram::Data &data);
+
 protected:
   Histogram();
   ~Histogram();
@@ -54,14 +72,24 @@ protected:
   void operator=(const Histogram&) = delete;
 
   static const char *GetGhostArrayName();
-  svtkDataArray* GetArray(svtkDataObject* dobj, const std::string& arrayname);
+  svtkDataArray* GetArray(svtkDataObject* dobj, int association,
+    const std::string& arrayname);
 
   int NumberOfBins;
-  std::string MeshName;
-  std::string ArrayName;
-  int Association;
+  DataRequirements Requirements;
   std::string FileName;
-  Histogram::Data LastResult;
+
+private:
+  // identifies the arrays in the order their histograms are computed
+  struct ArrayId
+  {
+    std::string MeshName;
+    int Association;
+    std::string ArrayName;
+  };
+
+  std::vector<ArrayId> Arrays;
+  std::vector<Histogram::Data> LastResult;
 };
 
 }
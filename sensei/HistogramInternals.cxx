@@ -16,6 +16,7 @@
 #include <cstring>
 #include <errno.h>
 #include <limits>
+#include <type_traits>
 
 #include <svtkSmartPointer.h>
 #include <svtkDataArray.h>
@@ -29,6 +30,8 @@
 #include <svtkDataObject.h>
 #include <svtkFieldData.h>
 #include <svtkObjectFactory.h>
+#include <svtkSMPTools.h>
+#include <svtkSMPThreadLocal.h>
 
 namespace sensei
 {
@@ -219,33 +222,201 @@ int block_local_histogram(data_t *data, unsigned char *ghosts,
 
 namespace HistogramInternalsCPU
 {
+/// the number of values binned at a time by the vectorized kernel
+constexpr size_t BatchSize = 256;
+
+/** Computes the min and max of a block's worth of data on the CPU, taking into
+ * account ghost zones. svtkSMPTools is used to split the array across threads,
+ * each of which keeps a private min and max that are merged at the end. This
+ * is the first pass over the data and the range is cached so that the data
+ * is only read once more, when it is binned.
+ *
+ * @param[in] data    the array to calculate the range of
+ * @param[in] ghosts  an array of 0 and non zero, 0 where data is valid. may
+ *                    be null when there are no ghost zones.
+ */
+template <typename data_t>
+struct BlockRange
+{
+  BlockRange(const data_t *data, const unsigned char *ghosts) :
+    Data(data), Ghosts(ghosts), Min(std::numeric_limits<data_t>::max()),
+    Max(std::numeric_limits<data_t>::lowest()) {}
+
+  void Initialize()
+  {
+    this->LocalMin.Local() = std::numeric_limits<data_t>::max();
+    this->LocalMax.Local() = std::numeric_limits<data_t>::lowest();
+  }
+
+  void operator()(svtkIdType begin, svtkIdType end)
+  {
+    const data_t *data = this->Data;
+    const unsigned char *ghosts = this->Ghosts;
+
+    data_t bMin = this->LocalMin.Local();
+    data_t bMax = this->LocalMax.Local();
+
+    if (ghosts)
+      {
+      // select the identity for ghosted values rather than branching
+      for (svtkIdType i = begin; i < end; ++i)
+        {
+        bool valid = ghosts[i] == 0;
+        data_t value = data[i];
+        bMin = std::min(bMin, valid ? value : std::numeric_limits<data_t>::max());
+        bMax = std::max(bMax, valid ? value : std::numeric_limits<data_t>::lowest());
+        }
+      }
+    else
+      {
+      for (svtkIdType i = begin; i < end; ++i)
+        {
+        data_t value = data[i];
+        bMin = std::min(bMin, value);
+        bMax = std::max(bMax, value);
+        }
+      }
+
+    this->LocalMin.Local() = bMin;
+    this->LocalMax.Local() = bMax;
+  }
+
+  void Reduce()
+  {
+    for (auto it = this->LocalMin.begin(); it != this->LocalMin.end(); ++it)
+      this->Min = std::min(this->Min, *it);
+
+    for (auto it = this->LocalMax.begin(); it != this->LocalMax.end(); ++it)
+      this->Max = std::max(this->Max, *it);
+  }
+
+  const data_t *Data;
+  const unsigned char *Ghosts;
+  svtkSMPThreadLocal<data_t> LocalMin;
+  svtkSMPThreadLocal<data_t> LocalMax;
+  data_t Min;
+  data_t Max;
+};
+
 /** Computes a histogram on the CPU. The histgoram must be pre-initialized to
  * zero multiple invokations of the kernel accumulate results for new data.
  *
+ * svtkSMPTools is used to split the array across threads. Each thread bins
+ * into a private histogram and the private histograms are merged into the
+ * result at the end. Values are binned in batches. The bin indices of a
+ * batch are computed first, in a loop free of branches that the compiler can
+ * vectorize, and the counts are updated after. Ghosted values are directed
+ * to an extra bin that is discarded when the private histograms are merged.
+ *
+ * Integer data is binned in double precision so that bins narrower than one
+ * are handled.
+ *
  * @param[in] data      the array to calculate the histogram for
- * @param[in] ghosts    an array of 0 and non zero, 0 where data is valid
- * @param[in] nVals     the length of the array
+ * @param[in] ghosts    an array of 0 and non zero, 0 where data is valid. may
+ *                      be null when there are no ghost zones.
  * @param[in] minVal    the minimum bin value
  * @param[in] width     the width of histogram bins
  * @param[in] nBins     the number of bins + 1.
- * @param[in,out] hist  the histogram
  */
 template <typename data_t>
-void block_local_histogram(data_t *data, unsigned char *ghosts,
-  size_t nVals, data_t minVal, data_t width, unsigned int *hist,
-  size_t nBins)
+struct BlockLocalHistogram
 {
-  (void) nBins;
+  using real_t = typename std::conditional<
+    std::is_floating_point<data_t>::value, data_t, double>::type;
 
-  for (size_t i = 0; i < nVals; ++i)
-    {
-    // find the bin for this value
-    size_t j = (data[i] - minVal) / width;
+  BlockLocalHistogram(const data_t *data, const unsigned char *ghosts,
+    double minVal, double width, size_t nBins) : Data(data), Ghosts(ghosts),
+    MinVal(minVal), Width(width), NumberOfBins(nBins) {}
 
-    // update the bin count if the data point is not from a ghost zone
-    unsigned int inc_valid = ghosts[i] ? 0 : 1;
-    hist[j] += inc_valid;
-    }
+  void Initialize()
+  {
+    // one extra bin collects the ghosted values
+    this->LocalHist.Local().assign(this->NumberOfBins + 1, 0u);
+  }
+
+  void operator()(svtkIdType begin, svtkIdType end)
+  {
+    const data_t *data = this->Data;
+    const unsigned char *ghosts = this->Ghosts;
+    unsigned int *hist = this->LocalHist.Local().data();
+
+    real_t minVal = this->MinVal;
+    real_t width = this->Width;
+    real_t lastBin = this->NumberOfBins - 1;
+    int ghostBin = this->NumberOfBins;
+
+    int bins[BatchSize];
+
+    for (svtkIdType b = begin; b < end; b += BatchSize)
+      {
+      int n = std::min<svtkIdType>(BatchSize, end - b);
+      const data_t *pData = data + b;
+
+      // find the bin for each value. clamping keeps out of range ghosted
+      // values and round off at the upper bound in bounds.
+      for (int i = 0; i < n; ++i)
+        {
+        real_t j = (real_t(pData[i]) - minVal) / width;
+        j = j < real_t(0) ? real_t(0) : j;
+        j = j > lastBin ? lastBin : j;
+        bins[i] = int(j);
+        }
+
+      // send ghosted values to the discarded bin
+      if (ghosts)
+        {
+        const unsigned char *pGhosts = ghosts + b;
+        for (int i = 0; i < n; ++i)
+          bins[i] = pGhosts[i] ? ghostBin : bins[i];
+        }
+
+      // update the bin counts
+      for (int i = 0; i < n; ++i)
+        ++hist[bins[i]];
+      }
+  }
+
+  void Reduce() {}
+
+  /// merge the per-thread histograms into hist
+  void Merge(unsigned int *hist)
+  {
+    for (auto it = this->LocalHist.begin(); it != this->LocalHist.end(); ++it)
+      {
+      const unsigned int *localHist = it->data();
+      for (size_t i = 0; i < this->NumberOfBins; ++i)
+        hist[i] += localHist[i];
+      }
+  }
+
+  const data_t *Data;
+  const unsigned char *Ghosts;
+  double MinVal;
+  double Width;
+  size_t NumberOfBins;
+  svtkSMPThreadLocal<std::vector<unsigned int>> LocalHist;
+};
+
+/// compute the range of the block, see BlockRange
+template <typename data_t>
+void block_local_range(const data_t *data, const unsigned char *ghosts,
+  size_t nVals, data_t &dataMin, data_t &dataMax)
+{
+  BlockRange<data_t> range(data, ghosts);
+  svtkSMPTools::For(0, nVals, range);
+  dataMin = range.Min;
+  dataMax = range.Max;
+}
+
+/// compute the histogram of the block, see BlockLocalHistogram
+template <typename data_t>
+void block_local_histogram(const data_t *data, const unsigned char *ghosts,
+  size_t nVals, double minVal, double width, unsigned int *hist,
+  size_t nBins)
+{
+  BlockLocalHistogram<data_t> histogram(data, ghosts, minVal, width, nBins);
+  svtkSMPTools::For(0, nVals, histogram);
+  histogram.Merge(hist);
 }
 }
 
@@ -256,11 +427,11 @@ HistogramInternals::~HistogramInternals()
 // --------------------------------------------------------------------------
 int HistogramInternals::Clear()
 {
-  this->Min = std::numeric_limits<double>::max();
-  this->Max = std::numeric_limits<double>::lowest();
-  this->Width = 1.0;
-  this->DataCache.clear();
-  this->GhostCache.clear();
+  this->Min.assign(this->NumberOfArrays, std::numeric_limits<double>::max());
+  this->Max.assign(this->NumberOfArrays, std::numeric_limits<double>::lowest());
+  this->Width.assign(this->NumberOfArrays, 1.0);
+  this->DataCache.assign(this->NumberOfArrays, DataCacheType());
+  this->GhostCache.assign(this->NumberOfArrays, GhostCacheType());
   this->Histogram = nullptr;
   return 0;
 }
@@ -272,10 +443,17 @@ int HistogramInternals::Initialize()
 }
 
 // --------------------------------------------------------------------------
-int HistogramInternals::AddLocalData(svtkDataArray *da,
+int HistogramInternals::AddLocalData(int arrayId, svtkDataArray *da,
   svtkUnsignedCharArray *ghosts)
 {
   // validate the input
+  if ((arrayId < 0) || (arrayId >= this->NumberOfArrays))
+    {
+    SENSEI_ERROR("AddLocalData failed, invalid array id " << arrayId
+      << " with " << this->NumberOfArrays << " arrays")
+    return -1;
+    }
+
   if (!da)
     {
     SENSEI_ERROR("AddLocalData failed, null data array")
@@ -357,26 +535,28 @@ int HistogramInternals::AddLocalData(svtkDataArray *da,
 #endif
 #if defined(SENSEI_DEBUG)
       std::cerr << "HistogramInternals::AddLocalData ghosts were not provided,"
-        " allocating on the CPU" << std::endl;
+        " skipping on the CPU" << std::endl;
 #endif
-      // generate ghosts on the CPU
-      pGhosts = std::shared_ptr<unsigned char>(
-        (unsigned char*)malloc(nVals), sensei::MemoryUtils::FreeCpuPtr);
-
-      memset(pGhosts.get(), 0, nVals);
+      // on the CPU the kernels handle a null ghost array, which saves
+      // generating and then reading one
 #if defined(ENABLE_CUDA)
       }
 #endif
     }
 
   // cache the GPU accessible pointer for use in the histogram calculation
-  this->GhostCache[da] = pGhosts;
+  this->GhostCache[arrayId][da] = pGhosts;
 
-  // compute the block min and max
+  // cache the data and compute the block min and max. computing the range
+  // here while the data is first touched means that ComputeHistogram reads
+  // the data only once more.
   switch (da->GetDataType())
     {
     svtkTemplateMacro(
 
+      SVTK_TT blockMin = std::numeric_limits<SVTK_TT>::max();
+      SVTK_TT blockMax = std::numeric_limits<SVTK_TT>::lowest();
+
       std::shared_ptr<SVTK_TT> pDa;
 #if defined(ENABLE_CUDA)
       if (this->DeviceId >= 0)
@@ -388,6 +568,11 @@ int HistogramInternals::AddLocalData(svtkDataArray *da,
         // get a pointer to the data that's usable on the GPU
         pDa = sensei::MemoryUtils::MakeCudaAccessible(
           sensei::SVTKUtils::GetPointer<SVTK_TT>(da), nVals);
+
+        // calculate range taking into account ghost zones on the GPU
+        if (HistogramInternalsCUDA::ComputeRange<SVTK_TT>(pDa, pGhosts,
+          nVals, blockMin, blockMax))
+          return -1;
         }
       else
         {
@@ -398,11 +583,26 @@ int HistogramInternals::AddLocalData(svtkDataArray *da,
 #endif
         pDa = sensei::MemoryUtils::MakeCpuAccessible(
          sensei::SVTKUtils::GetPointer<SVTK_TT>(da), nVals);
+
+        // calculate range taking into account ghost zones on the CPU
+        HistogramInternalsCPU::block_local_range<SVTK_TT>(pDa.get(),
+          pGhosts.get(), nVals, blockMin, blockMax);
 #if defined(ENABLE_CUDA)
         }
+#endif
+#if defined(SENSEI_DEBUG)
+      std::cerr << "HistogramInternals::AddLocalData range ["
+         << blockMin << ", " << blockMax << "]" << std::endl;
 #endif
       // cache the GPU accessible pointer for use in the histogram calculation
-      this->DataCache[da] = pDa;
+      this->DataCache[arrayId][da] = pDa;
+
+      // accumulate the min/max
+      if (blockMin <= blockMax)
+        {
+        this->Min[arrayId] = std::min(this->Min[arrayId], double(blockMin));
+        this->Max[arrayId] = std::max(this->Max[arrayId], double(blockMax));
+        }
     );
     default:
       {
@@ -417,105 +617,42 @@ int HistogramInternals::AddLocalData(svtkDataArray *da,
 // --------------------------------------------------------------------------
 int HistogramInternals::ComputeRange()
 {
-  this->Min = std::numeric_limits<double>::max();
-  this->Max = std::numeric_limits<double>::lowest();
-
-  auto dit = this->DataCache.begin();
-  auto git = this->GhostCache.begin();
-
-  for (; dit != this->DataCache.end(); ++dit, ++git)
-    {
-    // get the data array. arrays in the cache have already been moved to the
-    // GPU if that was neccessary.
-    std::shared_ptr<unsigned char> pGhosts = git->second;
-
-    svtkDataArray *da = dit->first;
-    std::shared_ptr<void> pvDa = dit->second;
-
-    size_t nVals = da->GetNumberOfTuples();
-
-    // compute the block min and max
-    switch (da->GetDataType())
-      {
-      svtkTemplateMacro(
-
-        SVTK_TT blockMin = std::numeric_limits<SVTK_TT>::max();
-        SVTK_TT blockMax = std::numeric_limits<SVTK_TT>::lowest();
-
-        // cast to the correct type. The data will already be in the right place
-        // data movement is handled in AddLocalData
-        std::shared_ptr<SVTK_TT> pDa = std::static_pointer_cast<SVTK_TT>(pvDa);
-
-#if defined(ENABLE_CUDA)
-        if (this->DeviceId >= 0)
-          {
-          // make the requested GPU the active one
-          sensei::CUDAUtils::SetDevice(this->DeviceId);
-          // calculate range taking into account ghost zones on the GPU
-          HistogramInternalsCUDA::ComputeRange<SVTK_TT>(pDa, pGhosts, nVals, blockMin, blockMax);
-#if defined(SENSEI_DEBUG)
-          std::cerr << "HistogramInternals::ComputeRange CUDA ["
-             << blockMin << ", " << blockMax << "]" << std::endl;
-#endif
-          }
-        else
-          {
-#endif
-          // calculate range taking into account ghost zones on the CPU
-          SVTK_TT *rpDa = pDa.get();
-          unsigned char *rpGhosts = pGhosts.get();
-          for (size_t i = 0; i < nVals; ++i)
-            {
-            if (rpGhosts[i] == 0)
-              {
-              SVTK_TT value = rpDa[i];
-              blockMin = std::min(blockMin, value);
-              blockMax = std::max(blockMax, value);
-              }
-            }
-#if defined(SENSEI_DEBUG)
-          std::cerr << "HistogramInternals::ComputeRange CPU ["
-             << blockMin << ", " << blockMax << "]" << std::endl;
-#endif
-#if defined(ENABLE_CUDA)
-          }
-#endif
-        // accumulate the min/max
-        this->Min = std::min(this->Min, double(blockMin));
-        this->Max = std::max(this->Max, double(blockMax));
-        );
-      default:
-        {
-        SENSEI_ERROR("Unsupported dispatch " << da->GetClassName());
-        return -1;
-        }
-      }
-    }
-
-  // check the result
-  if (fabs(this->Max - this->Min) < 1.0e-6)
+  // the block ranges were accumulated in AddLocalData. pack the minima and
+  // the negated maxima of all arrays so that the ranges are computed in a
+  // single reduction
+  int nArrays = this->NumberOfArrays;
+  std::vector<double> range(2*nArrays);
+  for (int i = 0; i < nArrays; ++i)
     {
-    SENSEI_ERROR("Invalid range detected ["
-      << this->Min << ", " << this->Max << "]")
-    return -1;
+    range[i] = this->Min[i];
+    range[nArrays + i] = -this->Max[i];
     }
 
   // compute the min and max across all MPI ranks
-  double gMin = 0.0;
-  double gMax = 0.0;
+  MPI_Allreduce(MPI_IN_PLACE, range.data(), 2*nArrays, MPI_DOUBLE,
+    MPI_MIN, this->Comm);
 
-  MPI_Allreduce(&this->Min, &gMin, 1, MPI_DOUBLE, MPI_MIN, this->Comm);
-  MPI_Allreduce(&this->Max, &gMax, 1, MPI_DOUBLE, MPI_MAX, this->Comm);
+  int retVal = 0;
+  for (int i = 0; i < nArrays; ++i)
+    {
+    this->Min[i] = range[i];
+    this->Max[i] = -range[nArrays + i];
 
-  this->Min = gMin;
-  this->Max = gMax;
+    // check the result
+    if (fabs(this->Max[i] - this->Min[i]) < 1.0e-6)
+      {
+      SENSEI_ERROR("Invalid range detected for array " << i << " ["
+        << this->Min[i] << ", " << this->Max[i] << "]")
+      retVal = -1;
+      }
 
 #if defined(SENSEI_DEBUG)
-   std::cerr << "HistogramInternals::ComputeRange global range ["
-      << gMin << ", " << gMax << "]" << std::endl;
+    std::cerr << "HistogramInternals::ComputeRange global range " << i << " ["
+       << this->Min[i] << ", " << this->Max[i] << "]" << std::endl;
 #endif
+    }
 
-  return 0;
+  return retVal;
 }
 
 // --------------------------------------------------------------------------
@@ -533,13 +670,15 @@ int HistogramInternals::ComputeHistogram()
 int HistogramInternals::InitializeHistogram()
 {
   // now with the min and amax in hand we can calculate the bin width.
-  this->Width = (this->Max - this->Min) / this->NumberOfBins;
+  for (int i = 0; i < this->NumberOfArrays; ++i)
+    this->Width[i] = (this->Max[i] - this->Min[i]) / this->NumberOfBins;
 
-  // allocate space for the histogram and initialize the first time
-  // through. NOTE: There is an extra bin allocated to deal with out-of-bounds
-  // when binning the maximum value. This bin is merged in after the calculations
+  // allocate space for the histograms of all arrays in one contiguous buffer
+  // and initialize the first time through. NOTE: There is an extra bin
+  // allocated to deal with out-of-bounds when binning the maximum value. This
+  // bin is merged in after the calculations
   size_t nBins = this->NumberOfBins + 1;
-  size_t histBytes = nBins*sizeof(unsigned int);
+  size_t histBytes = this->NumberOfArrays*nBins*sizeof(unsigned int);
   unsigned int *pHist = nullptr;
 
 #if defined(ENABLE_CUDA)
@@ -602,66 +741,73 @@ int HistogramInternals::ComputeLocalHistogram()
     return -1;
     }
 
-  auto dit = this->DataCache.begin();
-  auto git = this->GhostCache.begin();
+  // get the size of per thread block shared memory. NOte an extra bin is used
+  // to handle binning of the maximum value. it is merged after the calculations
+  // complete.
+  size_t nBins = this->NumberOfBins + 1;
 
-  for (; dit != this->DataCache.end(); ++dit, ++git)
+  for (int i = 0; i < this->NumberOfArrays; ++i)
     {
-    // get the data array. arrays in the cache have already been moved to the
-    // GPU if that was neccessary.
-    std::shared_ptr<unsigned char> pGhosts = git->second;
+    // the histogram of this array
+    unsigned int *pHist = this->Histogram.get() + i*nBins;
 
-    svtkDataArray *da = dit->first;
-    std::shared_ptr<void> pDa = dit->second;
+    auto dit = this->DataCache[i].begin();
+    auto git = this->GhostCache[i].begin();
 
-    // get the sizes of the datat array
-    size_t nVals = da->GetNumberOfTuples();
+    for (; dit != this->DataCache[i].end(); ++dit, ++git)
+      {
+      // get the data array. arrays in the cache have already been moved to the
+      // GPU if that was neccessary.
+      std::shared_ptr<unsigned char> pGhosts = git->second;
 
-    // get the size of per thread block shared memory. NOte an extra bin is used
-    // to handle binning of the maximum value. it is merged after the calculations
-    // complete.
-    size_t nBins = this->NumberOfBins + 1;
+      svtkDataArray *da = dit->first;
+      std::shared_ptr<void> pDa = dit->second;
 
-    switch (da->GetDataType())
-      {
-      svtkTemplateMacro(
+      // get the sizes of the datat array
+      size_t nVals = da->GetNumberOfTuples();
+
+      switch (da->GetDataType())
+        {
+        svtkTemplateMacro(
 #if defined(ENABLE_CUDA)
-        if (this->DeviceId >= 0)
-          {
+          if (this->DeviceId >= 0)
+            {
 #if defined(SENSEI_DEBUG)
-          std::cerr << "HistogramInternals::ComputeLocalHistogram CUDA" << std::endl;
+            std::cerr << "HistogramInternals::ComputeLocalHistogram CUDA" << std::endl;
 #endif
-          // make the requested GPU the active one
-          sensei::CUDAUtils::SetDevice(this->DeviceId);
-
-          // compute the histgram for this block's worth of data on the GPU. It is
-          // left on the GPU until data for all blocks has been processed.
-          // data is already in the right place, it is moved in AddLocalData
-          if (HistogramInternalsCUDA::block_local_histogram<SVTK_TT>((SVTK_TT*)pDa.get(),
-            pGhosts.get(), nVals, this->Min, this->Width, this->Histogram.get(), nBins))
-            return -1;
-          }
-        else
-          {
+            // make the requested GPU the active one
+            sensei::CUDAUtils::SetDevice(this->DeviceId);
+
+            // compute the histgram for this block's worth of data on the GPU. It is
+            // left on the GPU until data for all blocks has been processed.
+            // data is already in the right place, it is moved in AddLocalData
+            if (HistogramInternalsCUDA::block_local_histogram<SVTK_TT>((SVTK_TT*)pDa.get(),
+              pGhosts.get(), nVals, this->Min[i], this->Width[i], pHist, nBins))
+              return -1;
+            }
+          else
+            {
 #endif
 #if defined(SENSEI_DEBUG)
-          std::cerr << "HistogramInternals::ComputeLocalHistogram CPU" << std::endl;
+            std::cerr << "HistogramInternals::ComputeLocalHistogram CPU" << std::endl;
 #endif
-          // compute the histgram for this block's worth of data on the CPU
-          // data is already in the right place, it is moved in AddLocalData
-          HistogramInternalsCPU::block_local_histogram<SVTK_TT>((SVTK_TT*)pDa.get(),
-            pGhosts.get(), nVals, this->Min, this->Width, this->Histogram.get(), nBins);
+            // compute the histgram for this block's worth of data on the CPU
+            // data is already in the right place, it is moved in AddLocalData
+            HistogramInternalsCPU::block_local_histogram<SVTK_TT>((SVTK_TT*)pDa.get(),
+              pGhosts.get(), nVals, this->Min[i], this->Width[i], pHist, nBins);
 #if defined(ENABLE_CUDA)
-          }
+            }
 #endif
-        );
-      default:
-        {
-        SENSEI_ERROR("Unsupported dispatch " << da->GetClassName());
-        return -1;
+          );
+        default:
+          {
+          SENSEI_ERROR("Unsupported dispatch " << da->GetClassName());
+          return -1;
+          }
         }
       }
     }
+
   return 0;
 }
 
@@ -675,8 +821,11 @@ int HistogramInternals::FinalizeHistogram()
   int rank = 0;
   MPI_Comm_rank(this->Comm, &rank);
 
+  // the histograms of all arrays are stored contiguously and are reduced
+  // together
   size_t nBins = this->NumberOfBins + 1;
-  size_t histBytes = nBins*sizeof(unsigned int);
+  size_t nTotalBins = this->NumberOfArrays*nBins;
+  size_t histBytes = nTotalBins*sizeof(unsigned int);
 
 #if defined(ENABLE_CUDA)
   // make the requested GPU the active one
@@ -687,7 +836,7 @@ int HistogramInternals::FinalizeHistogram()
   // fetch result from the GPU for the MPI parallel part of the reduction
   // this call synchronizes CUDA kernels
   std::shared_ptr<unsigned int> pHist =
-    sensei::MemoryUtils::MakeCpuAccessible(this->Histogram.get(), nBins);
+    sensei::MemoryUtils::MakeCpuAccessible(this->Histogram.get(), nTotalBins);
 
   // allocate a buffer on teh CPU for the result of the MPI parallel reduction
   // the result of the histogram is always coppied to the CPU
@@ -700,11 +849,17 @@ int HistogramInternals::FinalizeHistogram()
 
   // finalize the histogram calculation by summing up contributions from each
   // MPI rank to MPI rank 0
-  MPI_Reduce(pHist.get(), tmp, nBins, MPI_UNSIGNED, MPI_SUM, 0, this->Comm);
+  MPI_Reduce(pHist.get(), tmp, nTotalBins, MPI_UNSIGNED, MPI_SUM, 0, this->Comm);
 
   // merge in the extra bin (see earlier comments)
   if (rank == 0)
-    tmp[this->NumberOfBins - 1] += tmp[this->NumberOfBins];
+    {
+    for (int i = 0; i < this->NumberOfArrays; ++i)
+      {
+      unsigned int *pHisti = tmp + i*nBins;
+      pHisti[this->NumberOfBins - 1] += pHisti[this->NumberOfBins];
+      }
+    }
 
   // Replace the internal copy of the histogram with the finalized result.
   // only MPI rank 0 has the result after this
@@ -714,9 +869,16 @@ int HistogramInternals::FinalizeHistogram()
 }
 
 // --------------------------------------------------------------------------
-int HistogramInternals::GetHistogram(int &nBins, double &binMin, double &binMax,
-  double &binWidth, std::vector<unsigned int> &histogram)
+int HistogramInternals::GetHistogram(int arrayId, int &nBins, double &binMin,
+  double &binMax, double &binWidth, std::vector<unsigned int> &histogram)
 {
+  if ((arrayId < 0) || (arrayId >= this->NumberOfArrays))
+    {
+    SENSEI_ERROR("GetHistogram failed, invalid array id " << arrayId
+      << " with " << this->NumberOfArrays << " arrays")
+    return -1;
+    }
+
   int rank = 0;
   MPI_Comm_rank(this->Comm, &rank);
 
@@ -729,11 +891,11 @@ int HistogramInternals::GetHistogram(int &nBins, double &binMin, double &binMax,
       }
 
     nBins = this->NumberOfBins;
-    binMin = this->Min;
-    binMax = this->Max;
-    binWidth = this->Width;
+    binMin = this->Min[arrayId];
+    binMax = this->Max[arrayId];
+    binWidth = this->Width[arrayId];
 
-    unsigned int *pHist = this->Histogram.get();
+    unsigned int *pHist = this->Histogram.get() + arrayId*(nBins + 1);
     histogram.assign(pHist, pHist + nBins);
     }
 
@@ -16,17 +16,22 @@ class svtkDataArray;
 namespace sensei
 {
 /// Distributed MPI+X paralllel histogram
-/** Computes a histogram on multiple data blocks with one array per block.
- * CUDA will be used for the calculations if ENABLE_CUDA is defined during the
+/** Computes histograms of one or more arrays on multiple data blocks. CUDA
+ * will be used for the calculations if ENABLE_CUDA is defined during the
  * build, otherwise the CPU is used. The data arrays must have only one
  * component.
  *
+ * Each array is identified by an index from 0 to numberOfArrays - 1. The
+ * histograms of all of the arrays are computed together, using one
+ * MPI_Allreduce for the ranges and one MPI_Reduce for the counts regardless
+ * of the number of arrays.
+ *
  * Call the methods in the following order:
  *
  * Initialize
- * AddLocalData (once per local data block)
+ * AddLocalData (once per local data block per array)
  * ComputeHistogram
- * GetHistogram
+ * GetHistogram (once per array)
  * Clear
  *
  * All methods return 0 if successful.
@@ -36,13 +41,12 @@ class HistogramInternals
 public:
     HistogramInternals() = delete;
 
-    HistogramInternals(MPI_Comm comm, int deviceId, int numberOfBins) :
+    HistogramInternals(MPI_Comm comm, int deviceId, int numberOfBins,
+      int numberOfArrays = 1) :
       Comm(comm),
       DeviceId(deviceId),
       NumberOfBins(numberOfBins),
-      Min(std::numeric_limits<double>::max()),
-      Max(std::numeric_limits<double>::lowest()),
-      Width(1.0)
+      NumberOfArrays(numberOfArrays)
     {}
 
     ~HistogramInternals();
@@ -50,43 +54,65 @@ public:
     /** set up for the calculation */
     int Initialize();
 
-    /** add block local contributions */
-    int AddLocalData(svtkDataArray *da, svtkUnsignedCharArray *ghostArray);
+    /** add block local contributions to the histogram of the array with the
+     * given index. the block's range is computed here so that the data is
+     * read only once more in ComputeHistogram */
+    int AddLocalData(int arrayId, svtkDataArray *da,
+      svtkUnsignedCharArray *ghostArray);
+
+    /** add block local contributions to the histogram of the first array */
+    int AddLocalData(svtkDataArray *da, svtkUnsignedCharArray *ghostArray)
+    { return this->AddLocalData(0, da, ghostArray); }
 
-    /** compute the histogram. this call uses MPI collectives, all ranks must
+    /** compute the histograms. this call uses MPI collectives, all ranks must
      * participate */
     int ComputeHistogram();
 
-    /// return the computed histogram, only valid on MPI rank 0
-    int GetHistogram(int &nBins, double &binMin, double &binMax,
+    /// return the computed histogram of the array with the given index, only
+    /// valid on MPI rank 0
+    int GetHistogram(int arrayId, int &nBins, double &binMin, double &binMax,
       double &binWidth, std::vector<unsigned int> &histogram);
 
+    /// return the computed histogram of the first array, only valid on MPI rank 0
+    int GetHistogram(int &nBins, double &binMin, double &binMax,
+      double &binWidth, std::vector<unsigned int> &histogram)
+    {
+      return this->GetHistogram(0, nBins, binMin, binMax, binWidth, histogram);
+    }
+
     /** free all cached memory and reset all internal parameters */
     int Clear();
 
 private:
-    /** compute the global min and max across all MPI ranks and blocks*/
+    /** compute the global min and max across all MPI ranks from the block
+     * ranges accumulated in AddLocalData. the ranges of all arrays are packed
+     * into a single reduction */
     int ComputeRange();
 
-    /** initialize the histogram, must be called after ComputeGlobalRange */
+    /** initialize the histograms, must be called after ComputeGlobalRange */
     int InitializeHistogram();
 
     /** compute the local histgrams */
     int ComputeLocalHistogram();
 
     /** Apply a reduction to locally computed histograms across all ranks.
+     * The histograms of all arrays are concatenated and reduced together.
      * Result is valid only on rank 0 */
     int FinalizeHistogram();
 
 private:
+  using DataCacheType = std::map<svtkDataArray*, std::shared_ptr<void>>;
+  using GhostCacheType = std::map<svtkDataArray*, std::shared_ptr<unsigned char>>;
+
   MPI_Comm Comm;
   int DeviceId;
   int NumberOfBins;
-  double Min;
-  double Max;
-  double Width;
-  std::map<svtkDataArray*, std::shared_ptr<void>> DataCache;
-  std::map<svtkDataArray*, std::shared_ptr<unsigned char>> GhostCache;
+  int NumberOfArrays;
+  std::vector<double> Min;
+  std::vector<double> Max;
+  std::vector<double> Width;
+  std::vector<DataCacheType> DataCache;
+  std::vector<GhostCacheType> GhostCache;
   std::shared_ptr<unsigned int> Histogram;
 };
 
@@ -174,6 +174,8 @@ int IsoSurfacePartitioner::GetPartition(MPI_Comm comm,
     it += 1;
     }
 
+  this->RecordMetrics(comm, mdOut);
+
   return 0;
 }
 
@@ -3,6 +3,7 @@
 #include "Error.h"
 
 #include <cstdlib>
+#include <algorithm>
 
 using seconds_t =
   std::chrono::duration<double, std::chrono::seconds::period>;
@@ -11,7 +12,7 @@ namespace sensei
 {
 
 // --------------------------------------------------------------------------
-MPIManager::MPIManager(int &argc, char **&argv)
+MPIManager::MPIManager(int &argc, char **&argv, int threadLevel)
   : mRank(0),  mSize(1)
 {
   Profiler::Enable(0x01);
@@ -19,9 +20,16 @@ MPIManager::MPIManager(int &argc, char **&argv)
   Profiler::StartEvent("AppInitialize");
 
 #if defined(SENSEI_HAS_MPI)
+  // asynchronous and concurrent analyses make use of MPI_THREAD_MULTIPLE
+  // when the application opts in, and fall back to serial execution
+  // otherwise
+  char *tmp = nullptr;
+  if ((tmp = getenv("SENSEI_MPI_THREAD_MULTIPLE")) && atoi(tmp))
+    threadLevel = MPI_THREAD_MULTIPLE;
+
   int required = MPI_THREAD_SERIALIZED;
   int provided = 0;
-  MPI_Init_thread(&argc, &argv, required, &provided);
+  MPI_Init_thread(&argc, &argv, std::max(threadLevel, required), &provided);
   if (provided < required)
     {
     SENSEI_ERROR("This MPI does not support thread serialized");
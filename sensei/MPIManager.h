@@ -4,6 +4,8 @@
 #include "senseiConfig.h"
 #define SENSEI_HAS_MPI
 
+#include <mpi.h>
+
 namespace sensei
 {
 
@@ -11,6 +13,13 @@ namespace sensei
 // MPI_Init is handled in the constructor, MPI_Finalize is handled in the
 // destructor. Given that this is an application level helper rank and size
 // are reported relatoive to MPI_COMM_WORLD.
+//
+// MPI is initialized with the requested thread level, MPI_THREAD_SERIALIZED
+// by default. Asynchronous and concurrent analyses need MPI_THREAD_MULTIPLE,
+// which an application opts in to by passing it here or by setting the
+// SENSEI_MPI_THREAD_MULTIPLE environment variable to 1. It is not requested
+// by default since MPI may serialize all of its calls when it is granted.
+// Without it asynchronous and concurrent analyses execute synchronously.
 class SENSEI_EXPORT MPIManager
 {
 public:
@@ -18,7 +27,8 @@ public:
   MPIManager(const MPIManager &) = delete;
   void operator=(const MPIManager &) = delete;
 
-  MPIManager(int &argc, char **&argv);
+  MPIManager(int &argc, char **&argv,
+    int threadLevel = MPI_THREAD_SERIALIZED);
   ~MPIManager();
 
   int GetCommRank(){ return mRank; }
@@ -32,7 +32,6 @@ void MappedPartitioner::SetBlockIds(const std::vector<int> &blkIds)
 int MappedPartitioner::GetPartition(MPI_Comm comm, const MeshMetadataPtr &mdIn,
   MeshMetadataPtr &mdOut)
 {
-  (void)comm;
   TimeEvent<128> mark("MappedPartitioner::GetPartition");
 
   mdOut = mdIn->NewCopy();
@@ -40,6 +39,8 @@ int MappedPartitioner::GetPartition(MPI_Comm comm, const MeshMetadataPtr &mdIn,
   mdOut->BlockOwner = this->BlockOwner;
   mdOut->BlockIds = this->BlockIds;
 
+  this->RecordMetrics(comm, mdOut);
+
   return 0;
 }
 
@@ -43,6 +43,7 @@
 
 #include <vector>
 #include <deque>
+#include <atomic>
 #include <sstream>
 #include <sys/time.h>
 #include <cstring>
@@ -191,6 +192,12 @@ int GetFieldsFromCommand(const char* command, const char** field_names,
 namespace sensei
 {
 
+// process wide counts of allocations made and avoided by object pools
+static std::atomic<long long> numNew(0);
+static std::atomic<long long> numReused(0);
+static std::atomic<long long> numBytesNew(0);
+static std::atomic<long long> numBytesReused(0);
+
 // intrernal data used by the memory profiler
 struct MemoryProfiler::InternalsType
 {
@@ -420,6 +427,35 @@ const char *MemoryProfiler::GetFilename() const
   return this->Internals->Filename.c_str();
 }
 
+// --------------------------------------------------------------------------
+void MemoryProfiler::CountAllocations(long long nNew, long long nReused,
+  long long nBytesNew, long long nBytesReused)
+{
+  numNew += nNew;
+  numReused += nReused;
+  numBytesNew += nBytesNew;
+  numBytesReused += nBytesReused;
+}
+
+// --------------------------------------------------------------------------
+void MemoryProfiler::GetAllocations(long long &nNew, long long &nReused,
+  long long &nBytesNew, long long &nBytesReused)
+{
+  nNew = numNew;
+  nReused = numReused;
+  nBytesNew = numBytesNew;
+  nBytesReused = numBytesReused;
+}
+
+// --------------------------------------------------------------------------
+void MemoryProfiler::ResetAllocations()
+{
+  numNew = 0;
+  numReused = 0;
+  numBytesNew = 0;
+  numBytesReused = 0;
+}
+
 
 /*
 std::string system_information::get_memory_description(
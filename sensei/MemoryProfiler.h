@@ -43,6 +43,19 @@ public:
   void SetFilename(const std::string &filename);
   const char *GetFilename() const;
 
+  // Count allocations made and avoided by object pools, see SVTKObjectPool.
+  // The counts are accumulated process wide, over all pools and threads,
+  // independent of whether the profiler is running.
+  static void CountAllocations(long long nNew, long long nReused,
+    long long nBytesNew, long long nBytesReused);
+
+  // Get the process wide allocation counts.
+  static void GetAllocations(long long &nNew, long long &nReused,
+    long long &nBytesNew, long long &nBytesReused);
+
+  // Reset the process wide allocation counts to 0.
+  static void ResetAllocations();
+
   friend void *::profile(void *argp);
 
 private:
@@ -6,6 +6,10 @@
 
 #include <utility>
 #include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 namespace sensei
 {
@@ -384,24 +388,277 @@ int MeshMetadata::Validate(MPI_Comm comm, const MeshMetadataFlags &requiredFlags
   return err ? -1 : 0;
 }
 
+// --------------------------------------------------------------------------
+namespace
+{
+// append the elements of src to dest
+template <typename vec_t>
+void Append(vec_t &dest, vec_t &src)
+{
+  dest.insert(dest.end(), std::make_move_iterator(src.begin()),
+    std::make_move_iterator(src.end()));
+}
+
+// serialize the fields of the local view that describe the decomposition
+void PackDecomp(const MeshMetadata &md, BinaryStream &bs)
+{
+  bs.Pack(md.BlockOwner);
+  bs.Pack(md.BlockIds);
+  bs.Pack(md.NumBlocksLocal);
+  bs.Pack(md.BlockNumPoints);
+  bs.Pack(md.BlockNumCells);
+  bs.Pack(md.BlockCellArraySize);
+  bs.Pack(md.BlockExtents);
+  bs.Pack(md.BlockBounds);
+  bs.Pack(md.BlockLevel);
+  bs.Pack(md.BlocksPerLevel);
+}
+
+// deserialize the decomposition of one rank and append it to the global view
+void UnpackDecomp(BinaryStream &bs, MeshMetadata &md)
+{
+  std::vector<int> blockOwner;
+  std::vector<int> blockIds;
+  std::vector<int> numBlocksLocal;
+  std::vector<long> blockNumPoints;
+  std::vector<long> blockNumCells;
+  std::vector<long> blockCellArraySize;
+  std::vector<std::array<int,6>> blockExtents;
+  std::vector<std::array<double,6>> blockBounds;
+  std::vector<int> blockLevel;
+  std::vector<int> blocksPerLevel;
+
+  bs.Unpack(blockOwner);
+  bs.Unpack(blockIds);
+  bs.Unpack(numBlocksLocal);
+  bs.Unpack(blockNumPoints);
+  bs.Unpack(blockNumCells);
+  bs.Unpack(blockCellArraySize);
+  bs.Unpack(blockExtents);
+  bs.Unpack(blockBounds);
+  bs.Unpack(blockLevel);
+  bs.Unpack(blocksPerLevel);
+
+  Append(md.BlockOwner, blockOwner);
+  Append(md.BlockIds, blockIds);
+  Append(md.NumBlocksLocal, numBlocksLocal);
+  Append(md.BlockNumPoints, blockNumPoints);
+  Append(md.BlockNumCells, blockNumCells);
+  Append(md.BlockCellArraySize, blockCellArraySize);
+  Append(md.BlockExtents, blockExtents);
+  Append(md.BlockBounds, blockBounds);
+  Append(md.BlockLevel, blockLevel);
+
+  // blocks per level are summed rather than concatenated
+  if (md.BlocksPerLevel.size() < blocksPerLevel.size())
+    md.BlocksPerLevel.resize(blocksPerLevel.size(), 0);
+
+  unsigned int nLevels = blocksPerLevel.size();
+  for (unsigned int i = 0; i < nLevels; ++i)
+    md.BlocksPerLevel[i] += blocksPerLevel[i];
+}
+
+// gather the streams of all ranks. the stream of each rank is found at the
+// returned offset in the global stream. this is one MPI_Allgather of the
+// sizes and one MPI_Allgatherv of the data.
+void AllGather(MPI_Comm comm, const BinaryStream &lbs, BinaryStream &gbs,
+  std::vector<int> &offsets)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  std::vector<int> counts(nRanks);
+  counts[rank] = lbs.Size();
+
+  MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+    counts.data(), 1, MPI_INT, comm);
+
+  offsets.resize(nRanks + 1);
+  offsets[0] = 0;
+  for (int i = 0; i < nRanks; ++i)
+    offsets[i + 1] = offsets[i] + counts[i];
+
+  gbs.Clear();
+  gbs.Resize(offsets[nRanks]);
+  gbs.SetReadPos(0);
+  gbs.SetWritePos(offsets[nRanks]);
+
+  if (counts[rank])
+    memcpy(gbs.GetData() + offsets[rank], lbs.GetData(), counts[rank]);
+
+  MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, gbs.GetData(),
+    counts.data(), offsets.data(), MPI_BYTE, comm);
+}
+
+// the global decomposition of a static mesh from a previous call to
+// GlobalizeView. it is valid for the group of ranks it was made on as long
+// as no rank's local decomposition has changed. the entry owns the group,
+// it is freed when the entry is replaced, invalidated or the cache is
+// cleared.
+struct GlobalViewCacheEntry
+{
+  GlobalViewCacheEntry() : Group(MPI_GROUP_NULL), Local(), Global() {}
+
+  ~GlobalViewCacheEntry() { this->FreeGroup(); }
+
+  GlobalViewCacheEntry(const GlobalViewCacheEntry &) = delete;
+  GlobalViewCacheEntry &operator=(const GlobalViewCacheEntry &) = delete;
+
+  // free the group. this is skipped when MPI has already been finalized,
+  // as may happen when the cache is destroyed at exit.
+  void FreeGroup()
+    {
+    if (this->Group != MPI_GROUP_NULL)
+      {
+      int finalized = 0;
+      MPI_Finalized(&finalized);
+      if (!finalized)
+        MPI_Group_free(&this->Group);
+      }
+    this->Group = MPI_GROUP_NULL;
+    }
+
+  MPI_Group Group;
+  std::vector<unsigned char> Local;
+  MeshMetadataPtr Global;
+};
+
+bool GlobalViewCaching = false;
+std::mutex GlobalViewCacheMutex;
+std::map<std::string, GlobalViewCacheEntry> GlobalViewCache;
+}
+
+// --------------------------------------------------------------------------
+void MeshMetadata::SetGlobalViewCaching(bool val)
+{
+  std::lock_guard<std::mutex> lock(GlobalViewCacheMutex);
+
+  GlobalViewCaching = val;
+
+  // the entries free their groups
+  if (!val)
+    GlobalViewCache.clear();
+}
+
+// --------------------------------------------------------------------------
+bool MeshMetadata::GetGlobalViewCaching()
+{
+  std::lock_guard<std::mutex> lock(GlobalViewCacheMutex);
+  return GlobalViewCaching;
+}
+
 // --------------------------------------------------------------------------
 int MeshMetadata::GlobalizeView(MPI_Comm comm)
 {
   TimeEvent<128> mark("MeshMetadata::GlobalizeView");
   if (!this->GlobalView)
     {
-    MPIUtils::GlobalViewV(comm, this->BlockOwner);
-    MPIUtils::GlobalViewV(comm, this->BlockIds);
-    MPIUtils::GlobalViewV(comm, this->NumBlocksLocal);
-    MPIUtils::GlobalViewV(comm, this->BlockNumPoints);
-    MPIUtils::GlobalViewV(comm, this->BlockNumCells);
-    MPIUtils::GlobalViewV(comm, this->BlockCellArraySize);
-    MPIUtils::GlobalViewV(comm, this->BlockExtents);
-    MPIUtils::GlobalViewV(comm, this->BlockBounds);
-    MPIUtils::GlobalViewV(comm, this->BlockArrayRange);
-    MPIUtils::GlobalViewV(comm, this->BlockLevel);
-
-    MPIUtils::GlobalCounts(comm, this->BlocksPerLevel);
+    int nRanks = 1;
+    MPI_Comm_size(comm, &nRanks);
+
+    // serialize the decomposition of the local view
+    BinaryStream lbs;
+    PackDecomp(*this, lbs);
+
+    // when caching, look for the global view of this static mesh made the
+    // last time on this group of ranks. it is used when the local view has
+    // not changed on any rank, which costs a single MPI_Allreduce
+    int useCache = 0;
+    MeshMetadataPtr cached;
+    if (this->StaticMesh && MeshMetadata::GetGlobalViewCaching())
+      {
+      MPI_Group group = MPI_GROUP_NULL;
+      MPI_Comm_group(comm, &group);
+
+      {
+      std::lock_guard<std::mutex> lock(GlobalViewCacheMutex);
+
+      std::map<std::string, GlobalViewCacheEntry>::iterator it =
+        GlobalViewCache.find(this->MeshName);
+
+      int same = MPI_UNEQUAL;
+      if (it != GlobalViewCache.end())
+        MPI_Group_compare(group, it->second.Group, &same);
+
+      if ((same == MPI_IDENT) && (it->second.Local.size() == lbs.Size()) &&
+        std::equal(it->second.Local.begin(), it->second.Local.end(),
+        lbs.GetData()))
+        {
+        useCache = 1;
+        cached = it->second.Global;
+        }
+      else if (it != GlobalViewCache.end())
+        {
+        // the entry is stale, drop it now rather than holding its group
+        // until it is replaced
+        GlobalViewCache.erase(it);
+        }
+      }
+
+      MPI_Group_free(&group);
+
+      MPI_Allreduce(MPI_IN_PLACE, &useCache, 1, MPI_INT, MPI_MIN, comm);
+      }
+
+    // the array ranges change from step to step even when the mesh is
+    // static, so they are exchanged along with the decomposition, or on
+    // their own when the cached decomposition is used
+    std::vector<unsigned char> local;
+    if (useCache)
+      lbs.SetWritePos(0);
+    else if (this->StaticMesh && MeshMetadata::GetGlobalViewCaching())
+      local.assign(lbs.GetData(), lbs.GetData() + lbs.Size());
+
+    lbs.Pack(this->BlockArrayRange);
+
+    // gather the local views of all ranks
+    BinaryStream gbs;
+    std::vector<int> offsets;
+    AllGather(comm, lbs, gbs, offsets);
+
+    // assemble the global view
+    if (useCache)
+      {
+      this->BlockOwner = cached->BlockOwner;
+      this->BlockIds = cached->BlockIds;
+      this->NumBlocksLocal = cached->NumBlocksLocal;
+      this->BlockNumPoints = cached->BlockNumPoints;
+      this->BlockNumCells = cached->BlockNumCells;
+      this->BlockCellArraySize = cached->BlockCellArraySize;
+      this->BlockExtents = cached->BlockExtents;
+      this->BlockBounds = cached->BlockBounds;
+      this->BlockLevel = cached->BlockLevel;
+      this->BlocksPerLevel = cached->BlocksPerLevel;
+      }
+    else
+      {
+      this->BlockOwner.clear();
+      this->BlockIds.clear();
+      this->NumBlocksLocal.clear();
+      this->BlockNumPoints.clear();
+      this->BlockNumCells.clear();
+      this->BlockCellArraySize.clear();
+      this->BlockExtents.clear();
+      this->BlockBounds.clear();
+      this->BlockLevel.clear();
+      this->BlocksPerLevel.clear();
+      }
+
+    this->BlockArrayRange.clear();
+
+    for (int i = 0; i < nRanks; ++i)
+      {
+      gbs.SetReadPos(offsets[i]);
+
+      if (!useCache)
+        UnpackDecomp(gbs, *this);
+
+      std::vector<std::vector<std::array<double,2>>> blockArrayRange;
+      gbs.Unpack(blockArrayRange);
+      Append(this->BlockArrayRange, blockArrayRange);
+      }
 
     STLUtils::ReduceRange(this->BlockBounds, this->Bounds);
     STLUtils::ReduceRange(this->BlockExtents, this->Extent);
@@ -413,6 +670,23 @@ int MeshMetadata::GlobalizeView(MPI_Comm comm)
     this->CellArraySize = STLUtils::Sum(this->BlockCellArraySize);
 
     this->GlobalView = true;
+
+    // cache the global view of the decomposition
+    if (!local.empty())
+      {
+      MPI_Group group = MPI_GROUP_NULL;
+      MPI_Comm_group(comm, &group);
+
+      std::lock_guard<std::mutex> lock(GlobalViewCacheMutex);
+
+      GlobalViewCacheEntry &ent = GlobalViewCache[this->MeshName];
+
+      ent.FreeGroup();
+      ent.Group = group;
+      ent.Local = std::move(local);
+      ent.Global = this->NewCopy();
+      ent.Global->BlockArrayRange.clear();
+      }
     }
 
   return 0;
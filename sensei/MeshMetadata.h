@@ -152,10 +152,20 @@ struct SENSEI_EXPORT MeshMetadata
     const sensei::MeshMetadataFlags &requiredFlags = 0xffffffffffffffff);
 
   /** construct a global view of the metadata. return 0 if successful.
-   * this call uses MPI collectives
+   * this call uses MPI collectives. the block level information of all
+   * ranks is gathered in a single exchange.
    */
   int GlobalizeView(MPI_Comm);
 
+  /** enable/disable caching of the global view of static meshes. when
+   * enabled, GlobalizeView keeps the global decomposition of meshes with
+   * StaticMesh set, by name, and reuses it when no rank's local
+   * decomposition has changed, only array ranges are then exchanged.
+   * disabled by default.
+   */
+  static void SetGlobalViewCaching(bool val);
+  static bool GetGlobalViewCaching();
+
   /** removes all block level information from the instance. initialize
    * the related dataset level information.
    */
@@ -0,0 +1,292 @@
+#include "Partitioner.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <string>
+
+namespace sensei
+{
+
+namespace
+{
+// the length of the overlap of two intervals. intervals that are both of
+// zero length, as in 2D data, overlap with unit length when they coincide.
+// returns a negative value when the intervals do not overlap.
+double Overlap(double lo0, double hi0, double lo1, double hi1, double tol)
+{
+  if ((hi0 - lo0 <= tol) && (hi1 - lo1 <= tol))
+    return std::fabs(lo0 - lo1) <= tol ? 1.0 : -1.0;
+
+  double len = std::min(hi0, hi1) - std::max(lo0, lo1);
+  return len > tol ? len : -1.0;
+}
+
+// a face of a block on a plane perpendicular to one of the axes
+struct Face
+{
+  double Coord;
+  int Block;
+
+  bool operator<(const Face &other) const
+  { return this->Coord < other.Coord; }
+};
+}
+
+// --------------------------------------------------------------------------
+int Partitioner::GetBlockBoxes(const MeshMetadataPtr &md,
+  std::vector<std::array<double,6>> &boxes)
+{
+  unsigned int nBlocks = md->NumBlocks;
+
+  if (md->BlockBounds.size() == nBlocks)
+    {
+    boxes = md->BlockBounds;
+    return 0;
+    }
+
+  if (md->BlockExtents.size() != nBlocks)
+    return -1;
+
+  boxes.resize(nBlocks);
+
+  if ((md->NumLevels > 0) && (md->BlockLevel.size() == nBlocks) &&
+    (md->RefRatio.size() == unsigned(md->NumLevels)))
+    {
+    // AMR boxes are stored as the low and high cell indices on their
+    // level. these are scaled to the index space of the finest level
+    int nLevels = md->NumLevels;
+    std::vector<std::array<double,3>> scale(nLevels);
+    scale[nLevels - 1] = {1.0, 1.0, 1.0};
+    for (int l = nLevels - 2; l >= 0; --l)
+      for (int a = 0; a < 3; ++a)
+        scale[l][a] = scale[l+1][a]*md->RefRatio[l][a];
+
+    for (unsigned int i = 0; i < nBlocks; ++i)
+      {
+      const std::array<int,6> &ext = md->BlockExtents[i];
+      const std::array<double,3> &s = scale[md->BlockLevel[i]];
+      for (int a = 0; a < 3; ++a)
+        {
+        boxes[i][2*a] = s[a]*ext[a];
+        boxes[i][2*a+1] = s[a]*(ext[a+3] + 1);
+        }
+      }
+    }
+  else
+    {
+    // Cartesian extents are point index ranges
+    for (unsigned int i = 0; i < nBlocks; ++i)
+      for (int j = 0; j < 6; ++j)
+        boxes[i][j] = md->BlockExtents[i][j];
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int Partitioner::GetMetrics(const MeshMetadataPtr &md, int nRanks,
+  PartitionMetrics &metrics)
+{
+  metrics.NumCutFaces = 0;
+  metrics.CutArea = 0.0;
+  metrics.MaxSurfaceToVolume = 0.0;
+  metrics.MaxNeighbors = 0;
+  metrics.Imbalance = 1.0;
+
+  std::vector<std::array<double,6>> boxes;
+  if (Partitioner::GetBlockBoxes(md, boxes))
+    return -1;
+
+  int nBlocks = md->NumBlocks;
+  const std::vector<int> &owner = md->BlockOwner;
+  if (owner.size() != unsigned(nBlocks))
+    return -1;
+
+  // coordinates closer than the tolerance are the same
+  double minLen = std::numeric_limits<double>::max();
+  for (int i = 0; i < nBlocks; ++i)
+    for (int a = 0; a < 3; ++a)
+      {
+      double len = boxes[i][2*a+1] - boxes[i][2*a];
+      if (len > 0.0)
+        minLen = std::min(minLen, len);
+      }
+  double tol = minLen < std::numeric_limits<double>::max() ? 1.0e-6*minLen : 0.0;
+
+  // the volume and load of each rank
+  std::vector<double> area(nRanks, 0.0);
+  std::vector<double> volume(nRanks, 0.0);
+  std::vector<double> load(nRanks, 0.0);
+  std::vector<std::set<int>> neighbors(nRanks);
+
+  bool haveCells = md->BlockNumCells.size() == unsigned(nBlocks);
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    int r = owner[i];
+    if ((r < 0) || (r >= nRanks))
+      continue;
+
+    double vol = 1.0;
+    for (int a = 0; a < 3; ++a)
+      {
+      double len = boxes[i][2*a+1] - boxes[i][2*a];
+      vol *= len > tol ? len : 1.0;
+      }
+
+    volume[r] += vol;
+    load[r] += haveCells ? md->BlockNumCells[i] : 1.0;
+    }
+
+  // find the blocks that share a face. along each axis the high faces are
+  // matched to the low faces on the same plane, these are then swept in
+  // order along the next axis to find those that overlap
+  for (int a = 0; a < 3; ++a)
+    {
+    int b = (a + 1) % 3;
+    int c = (a + 2) % 3;
+
+    std::vector<Face> hiFaces;
+    std::vector<Face> loFaces;
+    for (int i = 0; i < nBlocks; ++i)
+      {
+      if ((owner[i] < 0) || (owner[i] >= nRanks) ||
+        (boxes[i][2*a+1] - boxes[i][2*a] <= tol))
+        continue;
+
+      hiFaces.push_back({boxes[i][2*a+1], i});
+      loFaces.push_back({boxes[i][2*a], i});
+      }
+
+    std::sort(hiFaces.begin(), hiFaces.end());
+    std::sort(loFaces.begin(), loFaces.end());
+
+    size_t nHi = hiFaces.size();
+    size_t nLo = loFaces.size();
+    size_t h0 = 0;
+    size_t l0 = 0;
+    while ((h0 < nHi) && (l0 < nLo))
+      {
+      double x = hiFaces[h0].Coord;
+      double y = loFaces[l0].Coord;
+      if (x < y - tol)
+        {
+        ++h0;
+        continue;
+        }
+      if (y < x - tol)
+        {
+        ++l0;
+        continue;
+        }
+
+      // the faces on this plane
+      size_t h1 = h0;
+      while ((h1 < nHi) && (hiFaces[h1].Coord <= x + tol))
+        ++h1;
+
+      size_t l1 = l0;
+      while ((l1 < nLo) && (loFaces[l1].Coord <= x + tol))
+        ++l1;
+
+      // order the low faces along the next axis
+      std::vector<Face> plane;
+      double maxLen = 0.0;
+      for (size_t j = l0; j < l1; ++j)
+        {
+        int bj = loFaces[j].Block;
+        plane.push_back({boxes[bj][2*b], bj});
+        maxLen = std::max(maxLen, boxes[bj][2*b+1] - boxes[bj][2*b]);
+        }
+      std::sort(plane.begin(), plane.end());
+
+      for (size_t j = h0; j < h1; ++j)
+        {
+        int bi = hiFaces[j].Block;
+        const std::array<double,6> &bxi = boxes[bi];
+
+        // only faces starting within the longest face can overlap
+        Face start = {bxi[2*b] - maxLen - tol, 0};
+        std::vector<Face>::iterator it =
+          std::lower_bound(plane.begin(), plane.end(), start);
+
+        for (; (it != plane.end()) && (it->Coord < bxi[2*b+1] + tol); ++it)
+          {
+          int bk = it->Block;
+          const std::array<double,6> &bxk = boxes[bk];
+
+          double ob = Overlap(bxi[2*b], bxi[2*b+1], bxk[2*b], bxk[2*b+1], tol);
+          double oc = Overlap(bxi[2*c], bxi[2*c+1], bxk[2*c], bxk[2*c+1], tol);
+
+          int ri = owner[bi];
+          int rk = owner[bk];
+          if ((ob <= 0.0) || (oc <= 0.0) || (ri == rk))
+            continue;
+
+          double faceArea = ob*oc;
+
+          metrics.NumCutFaces += 1;
+          metrics.CutArea += faceArea;
+
+          area[ri] += faceArea;
+          area[rk] += faceArea;
+
+          neighbors[ri].insert(rk);
+          neighbors[rk].insert(ri);
+          }
+        }
+
+      h0 = h1;
+      l0 = l1;
+      }
+    }
+
+  double meanLoad = 0.0;
+  double maxLoad = 0.0;
+  for (int r = 0; r < nRanks; ++r)
+    {
+    if (volume[r] > 0.0)
+      metrics.MaxSurfaceToVolume =
+        std::max(metrics.MaxSurfaceToVolume, area[r]/volume[r]);
+
+    metrics.MaxNeighbors = std::max(metrics.MaxNeighbors,
+      int(neighbors[r].size()));
+
+    meanLoad += load[r];
+    maxLoad = std::max(maxLoad, load[r]);
+    }
+
+  meanLoad /= nRanks;
+  metrics.Imbalance = meanLoad > 0.0 ? maxLoad/meanLoad : 1.0;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void Partitioner::RecordMetrics(MPI_Comm comm, const MeshMetadataPtr &md)
+{
+  if (!Profiler::Enabled())
+    return;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  PartitionMetrics metrics;
+  if ((rank != 0) || Partitioner::GetMetrics(md, nRanks, metrics))
+    return;
+
+  std::string name = this->GetClassName();
+
+  Profiler::RecordValue((name + "::NumCutFaces").c_str(), metrics.NumCutFaces);
+  Profiler::RecordValue((name + "::CutArea").c_str(), metrics.CutArea);
+  Profiler::RecordValue((name + "::MaxSurfaceToVolume").c_str(),
+    metrics.MaxSurfaceToVolume);
+  Profiler::RecordValue((name + "::MaxNeighbors").c_str(), metrics.MaxNeighbors);
+  Profiler::RecordValue((name + "::Imbalance").c_str(), metrics.Imbalance);
+}
+
+}
@@ -4,7 +4,9 @@
 #include "MeshMetadata.h"
 #include "Error.h"
 
+#include <array>
 #include <memory>
+#include <vector>
 #include <mpi.h>
 
 namespace pugi { class xml_node; }
@@ -14,6 +16,22 @@ namespace sensei
 class Partitioner;
 using PartitionerPtr = std::shared_ptr<sensei::Partitioner>;
 
+/// @brief measures of the quality of a partition.
+///
+/// Blocks are adjacent when they share a face. A face is cut when the blocks
+/// on either side are owned by different ranks. Cut faces are where ghost
+/// exchanges and downstream algorithms communicate, hence lower values
+/// are better. Areas and volumes are in world coordinates when block bounds
+/// are available and in index space otherwise.
+struct SENSEI_EXPORT PartitionMetrics
+{
+  long NumCutFaces;          ///< number of adjacent block pairs on different ranks
+  double CutArea;            ///< total area of the cut faces
+  double MaxSurfaceToVolume; ///< largest ratio of a rank's cut area to its volume
+  int MaxNeighbors;          ///< largest number of ranks a rank shares faces with
+  double Imbalance;          ///< largest over mean number of cells per rank
+};
+
 /// @class Partitioner
 /// @brief represents the way data is partitioned for in-transit operation mode.
 ///
@@ -40,6 +58,23 @@ public:
       return 0;
   }
 
+  // get the box covered by each block, from the block bounds when present,
+  // or else from the block extents of Cartesian and AMR meshes. returns
+  // non-zero if neither is available.
+  static int GetBlockBoxes(const sensei::MeshMetadataPtr &md,
+    std::vector<std::array<double,6>> &boxes);
+
+  // compute the metrics of the partition in the BlockOwner of the metadata.
+  // returns non-zero if the block geometry is not available.
+  static int GetMetrics(const sensei::MeshMetadataPtr &md, int nRanks,
+    sensei::PartitionMetrics &metrics);
+
+  // when the Profiler is enabled compute the metrics of the partition and
+  // record them as values named <class name>::<metric>. this is done on the
+  // first rank of the communicator since all ranks compute the same
+  // partition.
+  void RecordMetrics(MPI_Comm comm, const sensei::MeshMetadataPtr &md);
+
   // enable/disable generation of debugging output
   virtual void SetVerbose(int val){ this->Verbose = val; }
   virtual int GetVerbose(){ return this->Verbose; }
@@ -30,6 +30,8 @@ int PlanarPartitioner::GetPartition(MPI_Comm comm, const MeshMetadataPtr &mdIn,
     ++rankIdx;
     }
 
+  this->RecordMetrics(comm, mdOut);
+
   return 0;
 }
 
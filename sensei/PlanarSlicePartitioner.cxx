@@ -164,6 +164,8 @@ int PlanarSlicePartitioner::GetPartition(MPI_Comm comm,
     it += 1;
     }
 
+  this->RecordMetrics(comm, mdOut);
+
   return 0;
 }
 
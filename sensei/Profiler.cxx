@@ -1,5 +1,6 @@
 #include "Profiler.h"
 #include "MemoryProfiler.h"
+#include "BinaryStream.h"
 #include "Error.h"
 
 #include <sys/time.h>
@@ -14,30 +15,28 @@
 #include <cstdio>
 
 #include <map>
-#include <list>
+#include <deque>
 #include <vector>
+#include <memory>
 #include <iomanip>
 #include <limits>
 #include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
 #include <mutex>
 
 namespace impl
 {
 #if defined(ENABLE_PROFILER)
 
-// container for data captured in a timing Event
+// container for data captured in a timing Event. this is a POD so that
+// events can be recorded without allocating memory. the event name is
+// referred to by an id, see internName.
 struct Event
 {
-  Event();
-
-  // serializes the Event in CSV format into the stream.
-  void ToStream(std::ostream &str) const;
-
   enum { START=0, END=1, DELTA=2 }; // record fields
 
-  // user provided identifier for the record
-  std::string Name;
-
   // Event duration, initially start Time, end Time and duration
   // are recorded. when summarizing this contains min,max and sum
   // of the summariezed set of events
@@ -47,29 +46,123 @@ struct Event
   // else -1
   long long NumBytes;
 
-  // how deep is the Event stack
+  // id of the interned event name
+  int NameId;
+
+  // how deep is the Event stack. -1 marks a value recorded with
+  // RecordValue, which is stored in the duration, and whose start and end
+  // Time are the time it was recorded
   int Depth;
+};
+
+// running statistics of the durations of the events with the same name.
+// the mean and variance are accumulated with Welford's algorithm and merged
+// with Chan et al.'s pairwise update. the bytes reported by the events are
+// summed, events that do not report bytes are not counted.
+struct EventStats
+{
+  EventStats() : Count(0), Min(std::numeric_limits<double>::max()),
+    Max(std::numeric_limits<double>::lowest()), Mean(0.0), M2(0.0),
+    NumBytes(0) {}
+
+  // add the duration and bytes of an event
+  void Update(double dt, long long nBytes);
+
+  // merge the statistics of another set of events
+  void Merge(const EventStats &other);
+
+  long Count;
+  double Min;
+  double Max;
+  double Mean;
+  double M2;
+  long long NumBytes;
+};
+
+// an Event that has been started but not ended
+struct ActiveEvent
+{
+  double StartTime;
+  int NameId;
+  const char *Name;
+};
+
+// an entry in the per-thread cache of interned event names. the cache is
+// keyed by the address of the name passed in by the caller.
+struct NameCacheEntry
+{
+  const char *Key;
+  const char *Name;
+  int NameId;
+};
+
+// the number of entries in the per-thread cache of interned names
+constexpr unsigned int nameCacheSize = 256;
+
+// the number of events a thread records before they are moved to its
+// overflow storage
+constexpr unsigned int bufferSize = 4096;
+
+// Events generated by a thread. Only the thread that owns the log accesses it
+// while events are being recorded, hence no locking is needed. The logs of
+// all threads are merged when the log is written, at which point all other
+// threads are required to be finished.
+struct ThreadLog
+{
+  ThreadLog();
 
-  // the thread id that generated the Event
   std::thread::id Tid;
+
+  // the order in which the thread first recorded an event. used as a
+  // compact thread id in the trace output
+  int Index;
+
+  // the stack of active events
+  std::vector<ActiveEvent> Stack;
+
+  // completed events. when the buffer is full its contents is appended to the
+  // overflow storage, amortizing the cost of allocation
+  std::vector<Event> Buffer;
+  unsigned int Size;
+  std::vector<Event> Overflow;
+
+  // duration statistics indexed by event name id, used by the summary
+  std::vector<EventStats> Stats;
+
+  // interned names used by this thread
+  NameCacheEntry NameCache[nameCacheSize];
 };
 
+using ThreadLogPtr = std::unique_ptr<ThreadLog>;
+
 #if !defined(SENSEI_HAS_MPI)
 using MPI_Comm = void*;
 #define MPI_COMM_NULL nullptr
 #endif
 static MPI_Comm comm = MPI_COMM_NULL;
 
-static int loggingEnabled = 0x00;
+static std::atomic<int> loggingEnabled(0x00);
 
 static std::string timerLogFile = "timer.csv";
 
-using eventLogType = std::list<impl::Event>;
-using threadMapType = std::unordered_map<std::thread::id, eventLogType>;
+static int outputFormat = sensei::Profiler::FORMAT_CSV;
+static std::string traceFile = "timer.json";
+static std::string summaryFile = "timer_summary.csv";
+
+// set once Finalize has written the log files, after which Flush appends
+static bool logWritten = false;
 
-static eventLogType eventLog;
-static threadMapType activeEvents;
-static std::mutex eventLogMutex;
+// all thread's logs. logs are owned here so that they outlive the threads
+// that created them
+static std::vector<ThreadLogPtr> threadLogs;
+static std::mutex threadLogsMutex;
+static thread_local ThreadLog *threadLog = nullptr;
+
+// interned event names. a deque is used so that the addresses of the names
+// are stable.
+static std::deque<std::string> eventNames;
+static std::unordered_map<std::string, int> eventNameIds;
+static std::mutex eventNamesMutex;
 
 // memory profiler
 static sensei::MemoryProfiler memProf;
@@ -82,32 +175,549 @@ static double getSystemTime()
   return tv.tv_sec + tv.tv_usec/1.0e6;
 }
 
+// --------------------------------------------------------------------------
+ThreadLog::ThreadLog() : Tid(std::this_thread::get_id()), Index(0),
+  Buffer(bufferSize), Size(0), NameCache{}
+{
+  this->Stack.reserve(64);
+}
 
 // --------------------------------------------------------------------------
-Event::Event() : Time{0,0,0}, NumBytes(-1ll), Depth(0),
-  Tid(std::this_thread::get_id())
+// get the calling thread's log, creating it on first use
+static ThreadLog *getThreadLog()
 {
+  if (!threadLog)
+    {
+    ThreadLog *log = new ThreadLog;
+    std::lock_guard<std::mutex> lock(threadLogsMutex);
+    log->Index = threadLogs.size();
+    threadLogs.emplace_back(log);
+    threadLog = log;
+    }
+  return threadLog;
 }
 
-//-----------------------------------------------------------------------------
-void Event::ToStream(std::ostream &str) const
+// --------------------------------------------------------------------------
+// get the id of the named event. names are looked up in the thread's cache
+// first, only on a miss is the global table locked. the cache is keyed by
+// address, since callers may reuse a buffer for different names the name
+// itself is compared as well.
+static int internName(ThreadLog *log, const char *name, const char *&iname)
+{
+  NameCacheEntry &ent =
+    log->NameCache[(reinterpret_cast<uintptr_t>(name) >> 3) % nameCacheSize];
+
+  if ((ent.Key == name) && !strcmp(ent.Name, name))
+    {
+    iname = ent.Name;
+    return ent.NameId;
+    }
+
+  std::lock_guard<std::mutex> lock(eventNamesMutex);
+
+  int id = 0;
+  std::unordered_map<std::string, int>::iterator it = eventNameIds.find(name);
+  if (it == eventNameIds.end())
+    {
+    id = eventNames.size();
+    eventNames.emplace_back(name);
+    eventNameIds[name] = id;
+    }
+  else
+    {
+    id = it->second;
+    }
+
+  ent.Key = name;
+  ent.Name = eventNames[id].c_str();
+  ent.NameId = id;
+
+  iname = ent.Name;
+  return id;
+}
+
+// --------------------------------------------------------------------------
+void EventStats::Update(double dt, long long nBytes)
+{
+  this->Count += 1;
+  this->NumBytes += nBytes > 0 ? nBytes : 0;
+  this->Min = std::min(this->Min, dt);
+  this->Max = std::max(this->Max, dt);
+
+  double delta = dt - this->Mean;
+  this->Mean += delta / this->Count;
+  this->M2 += delta * (dt - this->Mean);
+}
+
+// --------------------------------------------------------------------------
+void EventStats::Merge(const EventStats &other)
+{
+  if (other.Count == 0)
+    return;
+
+  long count = this->Count + other.Count;
+  double delta = other.Mean - this->Mean;
+
+  this->Mean += delta * other.Count / count;
+  this->M2 += other.M2 + delta * delta * this->Count * other.Count / count;
+  this->Min = std::min(this->Min, other.Min);
+  this->Max = std::max(this->Max, other.Max);
+  this->Count = count;
+  this->NumBytes += other.NumBytes;
+}
+
+// --------------------------------------------------------------------------
+// record a completed Event
+static void recordEvent(ThreadLog *log, const Event &evt)
+{
+  if (outputFormat & sensei::Profiler::FORMAT_SUMMARY)
+    {
+    if (log->Stats.size() <= unsigned(evt.NameId))
+      log->Stats.resize(evt.NameId + 1);
+
+    log->Stats[evt.NameId].Update(evt.Time[Event::DELTA], evt.NumBytes);
+    }
+
+  if (!(outputFormat &
+    (sensei::Profiler::FORMAT_CSV | sensei::Profiler::FORMAT_TRACE)))
+    return;
+
+  if (log->Size == bufferSize)
+    {
+    log->Overflow.insert(log->Overflow.end(),
+      log->Buffer.begin(), log->Buffer.end());
+    log->Size = 0;
+    }
+
+  log->Buffer[log->Size] = evt;
+  log->Size += 1;
+}
+
+// --------------------------------------------------------------------------
+// serializes the Event in CSV format into the stream.
+static void toStream(std::ostream &str, int rank, const ThreadLog &log,
+  const Event &evt)
+{
+  str << rank << ", " << log.Tid << ", \"" << eventNames[evt.NameId] << "\", "
+    << evt.Time[Event::START] << ", " << evt.Time[Event::END] << ", "
+    << evt.Time[Event::DELTA] << ", " << evt.NumBytes  << ", "
+    << evt.Depth << std::endl;
+}
+
+// --------------------------------------------------------------------------
+// serializes a string as the contents of a JSON string, escaping quotes,
+// backslashes and control characters. event names may be built from user
+// supplied mesh, array and class names.
+static void toJsonString(std::ostream &str, const std::string &s)
+{
+  unsigned long n = s.size();
+  for (unsigned long i = 0; i < n; ++i)
+    {
+    unsigned char c = s[i];
+    if ((c == '"') || (c == '\\'))
+      {
+      str << '\\' << c;
+      }
+    else if (c < 0x20)
+      {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      str << esc;
+      }
+    else
+      {
+      str << c;
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+// serializes the Event as a complete event in the Chrome trace event format,
+// and a recorded value as a counter event. times are in microseconds.
+static void toTrace(std::ostream &str, int rank, const ThreadLog &log,
+  const Event &evt)
+{
+  str << ",\n{\"name\":\"";
+  toJsonString(str, eventNames[evt.NameId]);
+
+  if (evt.Depth < 0)
+    {
+    // the stream's fixed precision is for times, values are written with
+    // full precision
+    std::ostringstream val;
+    val.precision(std::numeric_limits<double>::digits10 + 2);
+    val << evt.Time[Event::DELTA];
+
+    str << "\",\"ph\":\"C\","
+      << "\"ts\":" << 1.0e6*evt.Time[Event::START] << ","
+      << "\"pid\":" << rank << ",\"tid\":" << log.Index << ","
+      << "\"args\":{\"value\":" << val.str() << "}}";
+    return;
+    }
+
+  str << "\",\"ph\":\"X\","
+    << "\"ts\":" << 1.0e6*evt.Time[Event::START] << ","
+    << "\"dur\":" << 1.0e6*evt.Time[Event::DELTA] << ","
+    << "\"pid\":" << rank << ",\"tid\":" << log.Index << ","
+    << "\"args\":{\"bytes\":" << evt.NumBytes << ",\"depth\":"
+    << evt.Depth << "}}";
+}
+
+// --------------------------------------------------------------------------
+// merge the events of all threads, ordered by end time. the mutex protects
+// only the list of logs, not their contents. the events are not locked as
+// they are intended to be accessed only from the main thread, and all other
+// threads are required to have stopped recording by now
+using logEventType = std::pair<const ThreadLog*, const Event*>;
+
+static void getEvents(std::vector<logEventType> &events)
+{
+  std::lock_guard<std::mutex> lock(threadLogsMutex);
+  unsigned int nLogs = threadLogs.size();
+  for (unsigned int i = 0; i < nLogs; ++i)
+    {
+    const ThreadLog *log = threadLogs[i].get();
+
+    unsigned int nOverflow = log->Overflow.size();
+    for (unsigned int j = 0; j < nOverflow; ++j)
+      events.emplace_back(log, &log->Overflow[j]);
+
+    for (unsigned int j = 0; j < log->Size; ++j)
+      events.emplace_back(log, &log->Buffer[j]);
+    }
+
+  std::stable_sort(events.begin(), events.end(),
+    [](const logEventType &l, const logEventType &r) -> bool
+    {
+    return l.second->Time[Event::END] < r.second->Time[Event::END];
+    });
+}
+
+// --------------------------------------------------------------------------
+// merge the statistics of all threads by event name
+using statsMapType = std::map<std::string, EventStats>;
+
+static void getStats(statsMapType &stats)
+{
+  std::lock_guard<std::mutex> lock(threadLogsMutex);
+  unsigned int nLogs = threadLogs.size();
+  for (unsigned int i = 0; i < nLogs; ++i)
+    {
+    const ThreadLog *log = threadLogs[i].get();
+
+    unsigned int nIds = log->Stats.size();
+    for (unsigned int j = 0; j < nIds; ++j)
+      {
+      if (log->Stats[j].Count)
+        stats[eventNames[j]].Merge(log->Stats[j]);
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+static void packStats(sensei::BinaryStream &bs, const statsMapType &stats)
+{
+  bs.Pack(stats.size());
+
+  statsMapType::const_iterator it = stats.begin();
+  statsMapType::const_iterator end = stats.end();
+  for (; it != end; ++it)
+    {
+    bs.Pack(it->first);
+    bs.Pack(it->second.Count);
+    bs.Pack(it->second.Min);
+    bs.Pack(it->second.Max);
+    bs.Pack(it->second.Mean);
+    bs.Pack(it->second.M2);
+    bs.Pack(it->second.NumBytes);
+    }
+}
+
+// --------------------------------------------------------------------------
+static void unpackAndMergeStats(sensei::BinaryStream &bs, statsMapType &stats)
+{
+  size_t nStats = 0;
+  bs.Unpack(nStats);
+
+  for (size_t i = 0; i < nStats; ++i)
+    {
+    std::string name;
+    EventStats es;
+    bs.Unpack(name);
+    bs.Unpack(es.Count);
+    bs.Unpack(es.Min);
+    bs.Unpack(es.Max);
+    bs.Unpack(es.Mean);
+    bs.Unpack(es.M2);
+    bs.Unpack(es.NumBytes);
+    stats[name].Merge(es);
+    }
+}
+
+#if defined(SENSEI_HAS_MPI)
+// --------------------------------------------------------------------------
+// reduce the statistics to rank 0 over a binary tree. ranks may have
+// recorded different sets of events, hence the statistics are reduced by name.
+static void reduceStats(MPI_Comm comm, statsMapType &stats)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &nRanks);
+
+  for (int step = 1; step < nRanks; step *= 2)
+    {
+    if (rank % (2*step))
+      {
+      // send to the partner and drop out
+      sensei::BinaryStream bs;
+      packStats(bs, stats);
+
+      unsigned long nBytes = bs.Size();
+      MPI_Send(&nBytes, 1, MPI_UNSIGNED_LONG, rank - step, 0, comm);
+      MPI_Send(bs.GetData(), nBytes, MPI_BYTE, rank - step, 0, comm);
+      return;
+      }
+    else if (rank + step < nRanks)
+      {
+      // receive from the partner and merge
+      unsigned long nBytes = 0;
+      MPI_Recv(&nBytes, 1, MPI_UNSIGNED_LONG, rank + step, 0, comm,
+        MPI_STATUS_IGNORE);
+
+      sensei::BinaryStream bs;
+      bs.Resize(nBytes);
+      MPI_Recv(bs.GetData(), nBytes, MPI_BYTE, rank + step, 0, comm,
+        MPI_STATUS_IGNORE);
+      bs.SetWritePos(nBytes);
+
+      unpackAndMergeStats(bs, stats);
+      }
+    }
+}
+#endif
+
+// --------------------------------------------------------------------------
+// serializes the statistics in CSV format
+static void toSummary(std::ostream &str, const statsMapType &stats,
+  bool header)
+{
+  str.precision(std::numeric_limits<double>::digits10 + 2);
+  str.setf(std::ios::scientific, std::ios::floatfield);
+
+  if (header)
+    str << "# name, count, min, max, mean, variance, bytes" << std::endl;
+
+  statsMapType::const_iterator it = stats.begin();
+  statsMapType::const_iterator end = stats.end();
+  for (; it != end; ++it)
+    {
+    const EventStats &es = it->second;
+    str << "\"" << it->first << "\", " << es.Count << ", " << es.Min << ", "
+      << es.Max << ", " << es.Mean << ", " << es.M2 / es.Count << ", "
+      << es.NumBytes << std::endl;
+    }
+}
+
+// --------------------------------------------------------------------------
+// get the rank of this process for reporting
+static int getRank()
 {
-#if defined(ENABLE_PROFILER)
   int rank = 0;
 #if defined(SENSEI_HAS_MPI)
   int ini = 0, fin = 0;
   MPI_Initialized(&ini);
   MPI_Finalized(&fin);
-  if (ini && !fin)
+  if (ini && !fin && (impl::comm != MPI_COMM_NULL))
     MPI_Comm_rank(impl::comm, &rank);
 #endif
-  str << rank << ", " << this->Tid << ", \"" << this->Name << "\", "
-    << this->Time[START] << ", " << this->Time[END] << ", "
-    << this->Time[DELTA] << ", " << this->NumBytes  << ", "
-    << this->Depth << std::endl;
-#else
-  (void)str;
+  return rank;
+}
+
+// --------------------------------------------------------------------------
+// discard the completed events of all threads. the statistics are kept so
+// that the summary covers the whole run, see clearStats
+static void clearEvents()
+{
+  std::lock_guard<std::mutex> lock(threadLogsMutex);
+  unsigned int nLogs = threadLogs.size();
+  for (unsigned int i = 0; i < nLogs; ++i)
+    {
+    threadLogs[i]->Size = 0;
+    threadLogs[i]->Overflow.clear();
+    }
+}
+
+// --------------------------------------------------------------------------
+// discard the statistics of all threads
+static void clearStats()
+{
+  std::lock_guard<std::mutex> lock(threadLogsMutex);
+  unsigned int nLogs = threadLogs.size();
+  for (unsigned int i = 0; i < nLogs; ++i)
+    threadLogs[i]->Stats.clear();
+}
+
+// --------------------------------------------------------------------------
+// serialize the process name record and the events of this rank in the
+// Chrome trace event format. every record starts with a comma
+static void toTrace(std::ostream &str, int rank)
+{
+  str << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+    << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+
+  std::vector<logEventType> events;
+  getEvents(events);
+
+  unsigned long nEvents = events.size();
+  for (unsigned long i = 0; i < nEvents; ++i)
+    toTrace(str, rank, *events[i].first, *events[i].second);
+}
+
+// --------------------------------------------------------------------------
+// append records to a trace file written previously, by moving its closing
+// brackets to the end. if the file does not exist it is created.
+static int appendTrace(const char *fileName, const std::string &records)
+{
+  static const char header[] = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  static const char footer[] = "\n]}\n";
+  static const long footerLen = sizeof(footer) - 1;
+
+  FILE *fh = fopen(fileName, "r+");
+  if (!fh)
+    {
+    // a new file. the records start with a comma which is skipped
+    std::string doc(header);
+    doc.append(records, 2, std::string::npos);
+    doc.append(footer);
+    return sensei::Profiler::WriteCStdio(fileName, "w", doc);
+    }
+
+  char tail[footerLen] = {0};
+  if (fseek(fh, -footerLen, SEEK_END) || (fread(tail, 1, footerLen, fh) != size_t(footerLen)) ||
+    strncmp(tail, footer, footerLen) || fseek(fh, -footerLen, SEEK_END))
+    {
+    SENSEI_ERROR("Failed to append to \"" << fileName
+      << "\" it is not a trace written by the profiler")
+    fclose(fh);
+    return -1;
+    }
+
+  std::string str(records);
+  str.append(footer);
+
+  long nBytes = str.size();
+  long nwritten = fwrite(str.c_str(), 1, nBytes, fh);
+  fclose(fh);
+
+  if (nwritten != nBytes)
+    {
+    const char *estr = strerror(errno);
+    SENSEI_ERROR("Failed to write " << nBytes << " bytes. " << estr)
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// write the recorded events and statistics in the enabled output formats.
+// when collective all ranks in the communicator write their part of the
+// shared files with MPI-IO, and the statistics are reduced across ranks.
+// otherwise only the calling rank writes with C stdio. when appending the
+// events are added to the files written before, otherwise the files are
+// replaced.
+static int writeLog(bool collective, bool append)
+{
+  int rank = 0;
+  int nRanks = 1;
+#if defined(SENSEI_HAS_MPI)
+  if (collective)
+    {
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nRanks);
+    }
+  else
+    {
+    rank = getRank();
+    }
+#endif
+
+  int ierr = 0;
+
+  if (outputFormat & sensei::Profiler::FORMAT_CSV)
+    {
+    // serialize the logged events in CSV format
+    std::ostringstream oss;
+
+    if ((rank == 0) && !append)
+      oss << "# rank, thread, Name, start Time, end Time, delta, bytes, Depth" << std::endl;
+
+    sensei::Profiler::ToStream(oss);
+
+    if (collective)
+      ierr += sensei::Profiler::WriteMpiIo(comm, timerLogFile.c_str(), oss.str());
+    else
+      ierr += sensei::Profiler::WriteCStdio(timerLogFile.c_str(),
+        append ? "a" : "w", oss.str());
+    }
+
+  if (outputFormat & sensei::Profiler::FORMAT_TRACE)
+    {
+    // serialize the logged events in the Chrome trace event format. each
+    // rank names its process, after which every record starts with a
+    // comma, making the concatenation of all ranks valid JSON
+    std::ostringstream oss;
+    oss.precision(3);
+    oss.setf(std::ios::fixed, std::ios::floatfield);
+
+    if (append)
+      {
+      toTrace(oss, rank);
+      ierr += appendTrace(traceFile.c_str(), oss.str());
+      }
+    else
+      {
+      if (rank == 0)
+        oss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+      std::ostringstream recs;
+      recs.precision(3);
+      recs.setf(std::ios::fixed, std::ios::floatfield);
+      toTrace(recs, rank);
+
+      // the first record of the file does not start with a comma
+      oss << (rank == 0 ? recs.str().substr(1) : recs.str());
+
+      if (rank == nRanks - 1)
+        oss << "\n]}\n";
+
+      if (collective)
+        ierr += sensei::Profiler::WriteMpiIo(comm, traceFile.c_str(), oss.str());
+      else
+        ierr += sensei::Profiler::WriteCStdio(traceFile.c_str(), "w", oss.str());
+      }
+    }
+
+  if (outputFormat & sensei::Profiler::FORMAT_SUMMARY)
+    {
+    // reduce the per event name statistics across threads and ranks
+    statsMapType stats;
+    getStats(stats);
+#if defined(SENSEI_HAS_MPI)
+    if (collective)
+      reduceStats(comm, stats);
 #endif
+    if ((rank == 0) && !(append && stats.empty()))
+      {
+      std::ostringstream oss;
+      toSummary(oss, stats, !append);
+      ierr += sensei::Profiler::WriteCStdio(summaryFile.c_str(),
+        append ? "a" : "w", oss.str());
+      }
+    }
+
+  return ierr ? -1 : 0;
 }
 #endif
 }
@@ -145,6 +755,36 @@ void Profiler::SetTimerLogFile(const std::string &file)
 #endif
 }
 
+// ----------------------------------------------------------------------------
+void Profiler::SetOutputFormat(int format)
+{
+#if defined(ENABLE_PROFILER)
+  impl::outputFormat = format;
+#else
+  (void)format;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Profiler::SetTraceFile(const std::string &file)
+{
+#if defined(ENABLE_PROFILER)
+  impl::traceFile = file;
+#else
+  (void)file;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+void Profiler::SetSummaryFile(const std::string &file)
+{
+#if defined(ENABLE_PROFILER)
+  impl::summaryFile = file;
+#else
+  (void)file;
+#endif
+}
+
 // ----------------------------------------------------------------------------
 void Profiler::SetMemProfLogFile(const std::string &file)
 {
@@ -173,19 +813,19 @@ int Profiler::Validate()
   if (impl::loggingEnabled & 0x01)
     {
 #if !defined(NDEBUG)
-    impl::threadMapType::iterator tmit = impl::activeEvents.begin();
-    impl::threadMapType::iterator tmend = impl::activeEvents.end();
-    for (; tmit != tmend; ++tmit)
+    std::lock_guard<std::mutex> lock(impl::threadLogsMutex);
+    unsigned int nLogs = impl::threadLogs.size();
+    for (unsigned int i = 0; i < nLogs; ++i)
       {
-      unsigned int nLeft = tmit->second.size();
+      const impl::ThreadLog &log = *impl::threadLogs[i];
+      unsigned int nLeft = log.Stack.size();
       if (nLeft > 0)
         {
         std::ostringstream oss;
-        impl::eventLogType::iterator it = tmit->second.begin();
-        impl::eventLogType::iterator end = tmit->second.end();
-        for (; it != end; ++it)
-          it->ToStream(oss);
-        SENSEI_ERROR("Thread " << tmit->first << " has " << nLeft
+        for (unsigned int j = 0; j < nLeft; ++j)
+          oss << "\"" << log.Stack[j].Name << "\" started at "
+            << log.Stack[j].StartTime << std::endl;
+        SENSEI_ERROR("Thread " << log.Tid << " has " << nLeft
           << " unmatched active events. " << std::endl
           << oss.str())
         ierr += 1;
@@ -207,13 +847,14 @@ int Profiler::ToStream(std::ostream &os)
     os.precision(std::numeric_limits<double>::digits10 + 2);
     os.setf(std::ios::scientific, std::ios::floatfield);
 
-    // not locking this as it's intended to be accessed only from the main
-    // thread, and all other threads are required to be finished by now
-    impl::eventLogType::iterator iter = impl::eventLog.begin();
-    impl::eventLogType::iterator end = impl::eventLog.end();
+    std::vector<impl::logEventType> events;
+    impl::getEvents(events);
 
-    for (; iter != end; ++iter)
-      iter->ToStream(os);
+    int rank = impl::getRank();
+
+    unsigned long nEvents = events.size();
+    for (unsigned long i = 0; i < nEvents; ++i)
+      impl::toStream(os, rank, *events[i].first, *events[i].second);
     }
 #else
   (void)os;
@@ -242,6 +883,9 @@ int Profiler::Initialize()
     }
 #endif
 
+  // the files are replaced by the next Finalize
+  impl::logWritten = false;
+
   // look for overrides in the environment
   char *tmp = nullptr;
   if ((tmp = getenv("PROFILER_ENABLE")))
@@ -250,6 +894,24 @@ int Profiler::Initialize()
   if ((tmp = getenv("PROFILER_LOG_FILE")))
     impl::timerLogFile = tmp;
 
+  if ((tmp = getenv("PROFILER_FORMAT")))
+    {
+    std::string fmts(tmp);
+    impl::outputFormat = 0;
+    if (fmts.find("csv") != std::string::npos)
+      impl::outputFormat |= FORMAT_CSV;
+    if (fmts.find("trace") != std::string::npos)
+      impl::outputFormat |= FORMAT_TRACE;
+    if (fmts.find("summary") != std::string::npos)
+      impl::outputFormat |= FORMAT_SUMMARY;
+    }
+
+  if ((tmp = getenv("PROFILER_TRACE_FILE")))
+    impl::traceFile = tmp;
+
+  if ((tmp = getenv("PROFILER_SUMMARY_FILE")))
+    impl::summaryFile = tmp;
+
   if ((tmp = getenv("MEMPROF_LOG_FILE")))
     impl::memProf.SetFilename(tmp);
 
@@ -264,6 +926,9 @@ int Profiler::Initialize()
     std::cerr << "Profiler configured with Event logging "
       << (impl::loggingEnabled & 0x01 ? "enabled" : "disabled")
       << " and memory logging " << (impl::loggingEnabled & 0x02 ? "enabled" : "disabled")
+      << ", output format" << (impl::outputFormat & FORMAT_CSV ? " csv" : "")
+      << (impl::outputFormat & FORMAT_TRACE ? " trace" : "")
+      << (impl::outputFormat & FORMAT_SUMMARY ? " summary" : "")
       << ", timer log file \"" << impl::timerLogFile
       << "\", memory profiler log file \"" << impl::memProf.GetFilename()
       << "\", sampling interval " << impl::memProf.GetInterval()
@@ -330,11 +995,20 @@ int Profiler::WriteMpiIo(MPI_Comm comm, const char *fileName,
 int Profiler::Flush()
 {
 #if defined(ENABLE_PROFILER)
-  std::ostringstream oss;
-  Profiler::ToStream(oss);
-  Profiler::WriteCStdio(impl::timerLogFile.c_str(), "a", oss.str());
-  Profiler::Validate();
-  impl::eventLog.clear();
+  if (impl::loggingEnabled & 0x01)
+    {
+    // before Finalize the events are kept, Finalize replaces the files and
+    // writes all of them
+    Profiler::Validate();
+    if (!impl::logWritten)
+      return 0;
+
+    // not collective, MPI may have been finalized. the statistics were
+    // cleared by Finalize, only those of the flushed events are appended
+    impl::writeLog(false, true);
+    impl::clearEvents();
+    impl::clearStats();
+    }
 #endif
   return 0;
 }
@@ -385,27 +1059,12 @@ int Profiler::Finalize()
 
   if (impl::loggingEnabled & 0x01)
     {
-    int rank = 0;
-#if defined(SENSEI_HAS_MPI)
-    if (ok)
-      MPI_Comm_rank(impl::comm, &rank);
-#endif
-
-    // serialize the logged events in CSV format
-    std::ostringstream oss;
-
-    if (rank == 0)
-      oss << "# rank, thread, Name, start Time, end Time, delta, bytes, Depth" << std::endl;
-
-    Profiler::ToStream(oss);
+    impl::writeLog(ok, false);
+    impl::logWritten = true;
 
     // free up resources
-    impl::eventLog.clear();
-
-    if (ok)
-      Profiler::WriteMpiIo(impl::comm, impl::timerLogFile.c_str(), oss.str());
-    else
-      Profiler::WriteCStdio(impl::timerLogFile.c_str(), "w", oss.str());
+    impl::clearEvents();
+    impl::clearStats();
     }
 
   // output the memory use profile and clean up resources
@@ -425,7 +1084,6 @@ int Profiler::Finalize()
 bool Profiler::Enabled()
 {
 #if defined(ENABLE_PROFILER)
-  std::lock_guard<std::mutex> lock(impl::eventLogMutex);
   return impl::loggingEnabled & 0x01;
 #else
   return false;
@@ -436,7 +1094,6 @@ bool Profiler::Enabled()
 void Profiler::Enable(int arg)
 {
 #if defined(ENABLE_PROFILER)
-  std::lock_guard<std::mutex> lock(impl::eventLogMutex);
   impl::loggingEnabled = arg;
 #else
   (void)arg;
@@ -447,7 +1104,6 @@ void Profiler::Enable(int arg)
 void Profiler::Disable()
 {
 #if defined(ENABLE_PROFILER)
-  std::lock_guard<std::mutex> lock(impl::eventLogMutex);
   impl::loggingEnabled = 0x00;
 #endif
 }
@@ -458,14 +1114,15 @@ int Profiler::StartEvent(const char* eventname, long long nbytes)
 #if defined(ENABLE_PROFILER)
   if (impl::loggingEnabled & 0x01)
     {
-    impl::Event evt;
-    evt.Name = eventname;
-    evt.Time[impl::Event::START] = impl::getSystemTime();
-    evt.NumBytes = nbytes;
+    impl::ThreadLog *log = impl::getThreadLog();
 
-    std::lock_guard<std::mutex> lock(impl::eventLogMutex);
-    impl::activeEvents[evt.Tid].push_back(evt);
+    impl::ActiveEvent evt;
+    evt.NameId = impl::internName(log, eventname, evt.Name);
+    evt.StartTime = impl::getSystemTime();
+
+    log->Stack.push_back(evt);
     }
+  (void)nbytes;
 #else
   (void)eventname;
   (void)nbytes;
@@ -483,36 +1140,38 @@ int Profiler::EndEvent(const char* eventname, long long nbytes)
     double endTime = impl::getSystemTime();
 
     // get this thread's Event log
-    std::thread::id tid = std::this_thread::get_id();
-
-    std::lock_guard<std::mutex> lock(impl::eventLogMutex);
-    impl::threadMapType::iterator iter = impl::activeEvents.find(tid);
-    if (iter == impl::activeEvents.end())
+    impl::ThreadLog *log = impl::getThreadLog();
+    if (log->Stack.empty())
       {
       SENSEI_ERROR("failed to end Event \"" << eventname
-        << "\" thread  " << tid << " has no events")
+        << "\" thread  " << log->Tid << " has no events")
       return -1;
       }
 
-    impl::Event evt(std::move(iter->second.back()));
-    iter->second.pop_back();
+    const impl::ActiveEvent &active = log->Stack.back();
 
 #ifdef NDEBUG
     (void)eventname;
 #else
-    if (strcmp(eventname, evt.Name.c_str()) != 0)
+    if (strcmp(eventname, active.Name) != 0)
       {
       SENSEI_ERROR("Mismatched startEvent/endEvent. Expecting: '"
-        << evt.Name << "' Got: '" << eventname << "'")
+        << active.Name << "' Got: '" << eventname << "'")
       abort();
       }
 #endif
+
+    impl::Event evt;
+    evt.Time[impl::Event::START] = active.StartTime;
     evt.Time[impl::Event::END] = endTime;
-    evt.Time[impl::Event::DELTA] = endTime - evt.Time[impl::Event::START];
+    evt.Time[impl::Event::DELTA] = endTime - active.StartTime;
     evt.NumBytes = nbytes;
-    evt.Depth = iter->second.size();
+    evt.NameId = active.NameId;
 
-    impl::eventLog.emplace_back(std::move(evt));
+    log->Stack.pop_back();
+    evt.Depth = log->Stack.size();
+
+    impl::recordEvent(log, evt);
     }
 #else
   (void)eventname;
@@ -521,4 +1180,33 @@ int Profiler::EndEvent(const char* eventname, long long nbytes)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+int Profiler::RecordValue(const char *name, double value)
+{
+#if defined(ENABLE_PROFILER)
+  if (impl::loggingEnabled & 0x01)
+    {
+    double now = impl::getSystemTime();
+
+    impl::ThreadLog *log = impl::getThreadLog();
+
+    const char *iname = nullptr;
+
+    impl::Event evt;
+    evt.Time[impl::Event::START] = now;
+    evt.Time[impl::Event::END] = now;
+    evt.Time[impl::Event::DELTA] = value;
+    evt.NumBytes = -1;
+    evt.NameId = impl::internName(log, name, iname);
+    evt.Depth = -1;
+
+    impl::recordEvent(log, evt);
+    }
+#else
+  (void)name;
+  (void)value;
+#endif
+  return 0;
+}
+
 }
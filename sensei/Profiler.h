@@ -15,9 +15,35 @@ namespace sensei
 // A class containing methods managing memory and time profiling
 // Each timed event logs rank, event name, start and end time, and
 // duration.
+//
+// Events are recorded without locking in buffers private to each thread.
+// Event names are interned, a recorded event refers to its name by id. The
+// buffers of all threads are merged when the log is written by Flush or
+// Finalize, or serialized by ToStream. These read the other threads' buffers
+// without synchronization, hence they may only be called while no other
+// thread records events, for instance after thread pools and asynchronous
+// analyses have been finalized.
 class SENSEI_EXPORT Profiler
 {
 public:
+  // Output formats. These may be combined.
+  //
+  //   FORMAT_CSV     -- each rank's events in CSV format are written to the
+  //                     timer log file.
+  //   FORMAT_TRACE   -- each rank's events are written to the trace file in
+  //                     the Chrome trace event JSON format which can be
+  //                     loaded in Perfetto or chrome://tracing. Processes are
+  //                     ranks and threads are numbered in the order they
+  //                     first recorded an event.
+  //   FORMAT_SUMMARY -- per event name count, min, max, mean and variance of
+  //                     the event durations, and the total of the bytes
+  //                     reported by the events, are accumulated as events are
+  //                     recorded, reduced across ranks, and written to the
+  //                     summary file by rank 0. Individual events are not
+  //                     stored unless another format is also enabled.
+  //
+  enum {FORMAT_CSV = 0x01, FORMAT_TRACE = 0x02, FORMAT_SUMMARY = 0x04};
+
   // Initialize logging from environment variables, and/or the timer
   // API below. This is a collective call with respect to the timer's
   // communicator.
@@ -29,6 +55,10 @@ public:
   //               0x01 -- event profiling enabled
   //               0x02 -- memory profiling enabled
   //   PROFILER_LOG_FILE   : path to write timer log to
+  //   PROFILER_FORMAT     : comma separated list of output formats, one or
+  //                         more of csv, trace, summary
+  //   PROFILER_TRACE_FILE : path to write the trace to
+  //   PROFILER_SUMMARY_FILE : path to write the summary to
   //   MEMPROF_LOG_FILE    : path to write memory profiler log to
   //   MEMPROF_INTERVAL    : number of seconds between memory recordings
   //
@@ -36,12 +66,14 @@ public:
 
   // Finalize the log. this is where logs are written and cleanup occurs.
   // All processes in the communicator must call, and it must be called
-  // prior to MPI_Finalize.
+  // prior to MPI_Finalize. No other thread may be recording events.
   static int Finalize();
 
   // this can occur after MPI_Finalize. It should only be called by rank 0.
-  // Any remaining events will be appeneded to the log file. This is necessary
-  // to time MPI_Initialize/Finalize and log associated I/O.
+  // Any remaining events will be appeneded to the log files in each of the
+  // enabled output formats. This is necessary to time MPI_Initialize/Finalize
+  // and log associated I/O. Before Finalize the events are kept and written
+  // by Finalize. No other thread may be recording events.
   static int Flush();
 
   // Sets the communicator for MPI calls. This must be called prior to
@@ -54,6 +86,18 @@ public:
   // default value; Timer.csv
   static void SetTimerLogFile(const std::string &fileName);
 
+  // Sets the output format(s), see above. Overriden by PROFILER_FORMAT
+  // environment variable. default value: FORMAT_CSV
+  static void SetOutputFormat(int format);
+
+  // Sets the path to write the trace to. Overriden by PROFILER_TRACE_FILE
+  // environment variable. default value: timer.json
+  static void SetTraceFile(const std::string &fileName);
+
+  // Sets the path to write the summary to. Overriden by PROFILER_SUMMARY_FILE
+  // environment variable. default value: timer_summary.csv
+  static void SetSummaryFile(const std::string &fileName);
+
   // Sets the path to write the timer log to
   // overriden by MEMPROF_LOG_FILE environment variable
   // default value: MemProfLog.csv
@@ -85,6 +129,15 @@ public:
   // must match when calling endEvent() to mark the end of the event.
   static int EndEvent(const char *eventname, long long nbytes=-1ll);
 
+  // @brief Record a value that is not a duration.
+  //
+  // Values are written in all output formats. In the CSV log a value is a
+  // record whose start and end time are the time it was recorded, whose
+  // delta is the value, and whose depth is -1. In the trace it is a counter
+  // event. In the summary values are summarized per name in the same way as
+  // event durations.
+  static int RecordValue(const char *name, double value);
+
   // write contents of the string to the file.
   static int WriteCStdio(const char *fileName, const char *mode,
      const std::string &str);
@@ -98,7 +151,8 @@ public:
   // will report errors if not
   static int Validate();
 
-  // setnd the current contents of the log to the stream
+  // setnd the current contents of the log to the stream. No other thread
+  // may be recording events.
   static int ToStream(std::ostream &os);
 };
 
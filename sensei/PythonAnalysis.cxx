@@ -1,16 +1,20 @@
 #include "PythonAnalysis.h"
 #include "DataAdaptor.h"
+#include "BinaryStream.h"
+#include "Profiler.h"
 #include "Error.h"
 
 #include <svtkObjectFactory.h>
 #include <mpi4py/mpi4py.MPI_api.h>
 #include <string>
+#include <vector>
 #include <cstdio>
 #include <cstring>
 #include <errno.h>
 #include <Python.h>
 
 #include "senseiPyString.h"
+#include "senseiPyGILState.h"
 
 // Macro to report error through sensei's normal mechanism
 // and include Python exception info and stack
@@ -109,14 +113,13 @@ int runString(PyObject *module, const std::string &code)
   return 0;
 }
 
+// read the script on rank 0 and broadcast it to the other ranks
 static
-int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
+int readScript(MPI_Comm comm, const std::string &scriptFile, std::string &script)
 {
-  // read and broadcast the script
   int rank = 0;
   MPI_Comm_rank(comm, &rank);
 
-  char *script = nullptr;
   long scriptLen = 0;
 
   if (rank == 0)
@@ -136,10 +139,9 @@ int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
     scriptLen = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    script = static_cast<char*>(malloc(scriptLen+1));
-    script[scriptLen] = '\0';
+    script.resize(scriptLen);
 
-    long nrd = fread(script, 1, scriptLen, f);
+    long nrd = fread(&script[0], 1, scriptLen, f);
 
     fclose(f);
 
@@ -150,12 +152,11 @@ int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
         << std::endl << estr)
       scriptLen = -1;
       MPI_Bcast(&scriptLen, 1, MPI_LONG, 0, comm);
-      free(script);
       return -1;
       }
 
     MPI_Bcast(&scriptLen, 1, MPI_LONG, 0, comm);
-    MPI_Bcast(script, scriptLen, MPI_CHAR, 0, comm);
+    MPI_Bcast(&script[0], scriptLen, MPI_CHAR, 0, comm);
     }
   else
     {
@@ -164,12 +165,19 @@ int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
     if (scriptLen < 1)
       return -1;
 
-    script = static_cast<char*>(malloc(scriptLen+1));
-    script[scriptLen] = '\0';
+    script.resize(scriptLen);
 
-    MPI_Bcast(script, scriptLen, MPI_CHAR, 0, comm);
+    MPI_Bcast(&script[0], scriptLen, MPI_CHAR, 0, comm);
     }
 
+  return 0;
+}
+
+// run the script in the __main__ module
+static
+int loadScript(const std::string &scriptFile, const std::string &script,
+  PyObject *&module)
+{
   // this does some internal initialization
   module = PyImport_AddModule("__main__");
   Py_INCREF(module);
@@ -179,11 +187,313 @@ int loadScript(MPI_Comm comm, const std::string &scriptFile, PyObject *&module)
   if (runString(module, script))
     {
     SENSEI_ERROR("Failed to import the script \"" << scriptFile << "\"")
-    free(script);
     return -1;
     }
 
-  free(script);
+  return 0;
+}
+
+// Python code that resolves the import closure of the analysis on rank 0
+// and imports it from memory on the other ranks.
+static
+const char *importBroadcastSource = R"py(
+import sys, os, ast, marshal, importlib, importlib.abc, importlib.machinery, importlib.util
+
+SOURCE, BYTECODE, EXTENSION = 0, 1, 2
+
+def script_imports(src):
+    """ the modules imported by a script, found without running it """
+    names = []
+    try:
+        tree = ast.parse(src)
+    except SyntaxError:
+        return names
+    for node in ast.walk(tree):
+        if isinstance(node, ast.Import):
+            names += [a.name for a in node.names]
+        elif isinstance(node, ast.ImportFrom) and node.module and not node.level:
+            names.append(node.module)
+    return names
+
+def valid_bytecode(data, origin):
+    """ check that cached byte code is that of the source """
+    if len(data) < 16 or data[:4] != importlib.util.MAGIC_NUMBER:
+        return False
+    flags = int.from_bytes(data[4:8], 'little')
+    if flags & 1:
+        # hash based. those that are checked against the source are not used
+        return not flags & 2
+    st = os.stat(origin)
+    return int.from_bytes(data[8:12], 'little') == int(st.st_mtime) & 0xFFFFFFFF \
+        and int.from_bytes(data[12:16], 'little') == st.st_size & 0xFFFFFFFF
+
+def read(path):
+    with open(path, 'rb') as f:
+        return f.read()
+
+def resolve(names, script, copy_extensions):
+    """ import the modules and return the files of all of the modules that
+    were imported as a result, as a list of (name, kind, is package, origin,
+    real path, data) """
+    names = list(names) + script_imports(script)
+    before = set(sys.modules)
+    for name in names:
+        try:
+            importlib.import_module(name)
+        except Exception as e:
+            sys.stderr.write('WARNING: Failed to import %s. %s\n'%(name, str(e)))
+
+    closure = []
+    for name in set(sys.modules) - before:
+        spec = getattr(sys.modules[name], '__spec__', None)
+        if spec is None or not spec.has_location or not spec.origin:
+            continue
+        origin = spec.origin
+        is_pkg = spec.submodule_search_locations is not None
+        loader = spec.loader
+        try:
+            if isinstance(loader, importlib.machinery.ExtensionFileLoader):
+                real = os.path.realpath(origin)
+                closure.append((name, EXTENSION, is_pkg, origin, real,
+                    read(origin) if copy_extensions else b''))
+            elif isinstance(loader, importlib.machinery.SourcelessFileLoader):
+                closure.append((name, BYTECODE, is_pkg, origin, '', read(origin)))
+            elif isinstance(loader, importlib.machinery.SourceFileLoader):
+                data = read(spec.cached) if spec.cached and \
+                    os.path.isfile(spec.cached) else b''
+                if valid_bytecode(data, origin):
+                    closure.append((name, BYTECODE, is_pkg, origin, '', data))
+                else:
+                    closure.append((name, SOURCE, is_pkg, origin, '', read(origin)))
+        except OSError:
+            # left to the other ranks to find
+            pass
+    return closure
+
+def mapped_files():
+    """ the files mapped into this process """
+    try:
+        with open('/proc/self/maps') as f:
+            return set(l.split(None, 5)[5].strip() for l in f if len(l.split(None, 5)) > 5)
+    except OSError:
+        return set()
+
+class MemoryLoader(importlib.abc.Loader):
+    """ executes source or byte code received from rank 0 """
+    def __init__(self, kind, origin, data):
+        self.kind = kind
+        self.origin = origin
+        self.data = data
+
+    def create_module(self, spec):
+        return None
+
+    def exec_module(self, module):
+        if self.kind == BYTECODE:
+            code = marshal.loads(memoryview(self.data)[16:])
+        else:
+            code = compile(self.data, self.origin, 'exec', dont_inherit=True)
+        self.data = None
+        exec(code, module.__dict__)
+
+class ExtensionLoader(importlib.abc.Loader):
+    """ loads an extension module from a node local copy of the file received
+    from rank 0, or from its original location when it was not sent or is
+    already loaded, as when this process links to it """
+    def __init__(self, origin, path, data):
+        self.origin = origin
+        self.path = path
+        self.data = data
+        self.loader = None
+
+    def create_module(self, spec):
+        path = self.origin
+        if self.path:
+            path = self.path
+            with open(path, 'wb') as f:
+                f.write(self.data)
+        self.data = None
+        self.loader = importlib.machinery.ExtensionFileLoader(spec.name, path)
+        try:
+            return self.loader.create_module(
+                importlib.util.spec_from_file_location(spec.name, path, loader=self.loader))
+        finally:
+            if self.path:
+                os.unlink(path)
+
+    def exec_module(self, module):
+        module.__file__ = self.origin
+        self.loader.exec_module(module)
+
+class MemoryFinder(importlib.abc.MetaPathFinder):
+    """ finds the modules received from rank 0. each is served once, later
+    imports of the same name are left to the default finders """
+    def __init__(self, modules, ext_dir, rank):
+        self.modules = modules
+        self.ext_dir = ext_dir
+        self.rank = rank
+        self.mapped = mapped_files() if ext_dir else set()
+
+    def find_spec(self, name, path=None, target=None):
+        entry = self.modules.pop(name, None)
+        if entry is None:
+            return None
+        kind, is_pkg, origin, real, data = entry
+        if kind == EXTENSION:
+            local = ''
+            if self.ext_dir and data and real not in self.mapped:
+                local = os.path.join(self.ext_dir, 'sensei_%d_%s'%(
+                    self.rank, os.path.basename(origin)))
+            loader = ExtensionLoader(origin, local, data)
+        else:
+            loader = MemoryLoader(kind, origin, data)
+        spec = importlib.machinery.ModuleSpec(name, loader,
+            origin=origin, is_package=is_pkg)
+        spec.has_location = True
+        if is_pkg:
+            spec.submodule_search_locations = [os.path.dirname(origin)]
+        return spec
+
+def install(modules, ext_dir, rank):
+    sys.meta_path.insert(0, MemoryFinder(modules, ext_dir, rank))
+)py";
+
+// import the modules needed by the analysis on rank 0 and broadcast their
+// source, byte code, and when extDir is set extension modules. the other
+// ranks then import them from memory rather than from the file system.
+static
+int broadcastImports(MPI_Comm comm, const std::vector<std::string> &imports,
+  const std::string &script, const std::string &extDir, int verbose)
+{
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  PyObject *helpers = PyModule_New("sensei_import_broadcast");
+  if (runString(helpers, importBroadcastSource))
+    {
+    SENSEI_ERROR("Failed to load the import broadcast helpers")
+    Py_DECREF(helpers);
+    return -1;
+    }
+
+  sensei::BinaryStream bs;
+
+  if (rank == 0)
+    {
+    sensei::TimeEvent<128> mark("PythonAnalysis::ResolveImports");
+
+    PyObject *names = PyList_New(imports.size());
+    for (size_t i = 0; i < imports.size(); ++i)
+      PyList_SET_ITEM(names, i, C_STRING_TO_PY_STRING(imports[i].c_str()));
+
+    PyObject *closure = PyObject_CallMethod(helpers, "resolve", "(Nsi)",
+      names, script.c_str(), int(!extDir.empty()));
+
+    // the other ranks import from the file system when this fails
+    int nModules = 0;
+    if (!closure || !PyList_Check(closure))
+      {
+      SENSEI_PYTHON_ERROR("Failed to resolve the modules to broadcast")
+      Py_XDECREF(closure);
+      bs.Pack(nModules);
+      }
+    else
+      {
+      nModules = PyList_Size(closure);
+      bs.Pack(nModules);
+
+      for (int i = 0; i < nModules; ++i)
+        {
+        const char *name = nullptr;
+        const char *origin = nullptr;
+        const char *real = nullptr;
+        int kind = 0;
+        int isPkg = 0;
+        PyObject *bytes = nullptr;
+        char *data = nullptr;
+        Py_ssize_t dataLen = 0;
+
+        if (!PyArg_ParseTuple(PyList_GET_ITEM(closure, i), "sipssS",
+          &name, &kind, &isPkg, &origin, &real, &bytes) ||
+          PyBytes_AsStringAndSize(bytes, &data, &dataLen))
+          {
+          SENSEI_PYTHON_ERROR("Failed to pack module " << i)
+          nModules = 0;
+          bs.SetWritePos(0);
+          bs.Pack(nModules);
+          break;
+          }
+
+        bs.Pack(std::string(name));
+        bs.Pack(kind);
+        bs.Pack(isPkg);
+        bs.Pack(std::string(origin));
+        bs.Pack(std::string(real));
+        bs.Pack((unsigned long)dataLen);
+        bs.Pack(data, dataLen);
+        }
+
+      Py_DECREF(closure);
+      }
+
+    if (verbose)
+      {
+      SENSEI_STATUS("Broadcasting " << nModules << " modules in "
+        << bs.Size() << " bytes for import")
+      }
+    }
+
+  {
+  sensei::TimeEvent<128> mark("PythonAnalysis::BroadcastImports");
+  bs.Broadcast(comm, 0);
+  }
+
+  if (rank != 0)
+    {
+    sensei::TimeEvent<128> mark("PythonAnalysis::InstallImports");
+
+    int nModules = 0;
+    bs.Unpack(nModules);
+
+    PyObject *modules = PyDict_New();
+    for (int i = 0; i < nModules; ++i)
+      {
+      std::string name;
+      int kind = 0;
+      int isPkg = 0;
+      std::string origin;
+      std::string real;
+      const char *data = nullptr;
+
+      bs.Unpack(name);
+      bs.Unpack(kind);
+      bs.Unpack(isPkg);
+      bs.Unpack(origin);
+      bs.Unpack(real);
+      unsigned long dataLen = bs.UnpackView(data);
+
+      PyObject *entry = Py_BuildValue("(iNssN)", kind, PyBool_FromLong(isPkg),
+        origin.c_str(), real.c_str(), PyBytes_FromStringAndSize(data, dataLen));
+
+      PyDict_SetItemString(modules, name.c_str(), entry);
+      Py_DECREF(entry);
+      }
+
+    PyObject *ret = PyObject_CallMethod(helpers, "install", "(Nsi)",
+      modules, extDir.c_str(), rank);
+
+    if (!ret)
+      {
+      SENSEI_PYTHON_ERROR("Failed to install the broadcast modules")
+      Py_DECREF(helpers);
+      return -1;
+      }
+
+    Py_DECREF(ret);
+    }
+
+  Py_DECREF(helpers);
+
   return 0;
 }
 
@@ -192,19 +502,33 @@ namespace sensei
 
 struct PythonAnalysis::InternalsType
 {
-  InternalsType() : Module(nullptr), Initialize(nullptr),
-    Execute(nullptr), Finalize(nullptr) {}
+  InternalsType() : BroadcastImports(0), Module(nullptr),
+    Initialize(nullptr), Execute(nullptr), Finalize(nullptr),
+    MainThreadState(nullptr), OwnInterpreter(false) {}
 
   ~InternalsType();
 
+  // load the script, set the globals, and call its Initialize function.
+  // called with the GIL held
+  int Load(MPI_Comm comm, int verbose);
+
   std::string ScriptModule;
   std::string ScriptFile;
   std::string InitializeSource;
 
+  int BroadcastImports;
+  std::vector<std::string> Imports;
+  std::string ExtensionDirectory;
+
   PyObject *Module;
   PyObject *Initialize;
   PyObject *Execute;
   PyObject *Finalize;
+
+  // the thread state of the thread that started the interpreter, saved
+  // while the GIL is released
+  PyThreadState *MainThreadState;
+  bool OwnInterpreter;
 };
 
 //-----------------------------------------------------------------------------
@@ -248,9 +572,33 @@ void PythonAnalysis::SetScriptFile(const std::string &scriptName)
   this->Internals->ScriptFile = scriptName;
 }
 
+//-----------------------------------------------------------------------------
+void PythonAnalysis::SetBroadcastImports(int val)
+{
+  this->Internals->BroadcastImports = val;
+}
+
+//-----------------------------------------------------------------------------
+void PythonAnalysis::AddImport(const std::string &moduleName)
+{
+  this->Internals->Imports.push_back(moduleName);
+}
+
+//-----------------------------------------------------------------------------
+void PythonAnalysis::SetExtensionDirectory(const std::string &dirName)
+{
+  this->Internals->ExtensionDirectory = dirName;
+}
+
 //-----------------------------------------------------------------------------
 int PythonAnalysis::Finalize()
 {
+  if (!Py_IsInitialized())
+    return 0;
+
+  {
+  senseiPyGILState gil;
+
   if (this->Internals->Finalize)
     callFunction("Finalize", this->Internals->Finalize, nullptr);
 
@@ -263,8 +611,16 @@ int PythonAnalysis::Finalize()
   this->Internals->Execute = nullptr;
   this->Internals->Finalize = nullptr;
   this->Internals->Module = nullptr;
+  }
 
-  Py_Finalize();
+  // shut down the interpreter we started, from the thread that started it
+  if (this->Internals->OwnInterpreter)
+    {
+    PyEval_RestoreThread(this->Internals->MainThreadState);
+    this->Internals->MainThreadState = nullptr;
+    this->Internals->OwnInterpreter = false;
+    Py_Finalize();
+    }
 
   return 0;
 }
@@ -272,62 +628,119 @@ int PythonAnalysis::Finalize()
 //-----------------------------------------------------------------------------
 int PythonAnalysis::Initialize()
 {
-  // initialize the interpreter
-  Py_SetProgramName(C_STRING_LITERAL("PythonAnalysis"));
-  Py_Initialize();
+  TimeEvent<128> mark("PythonAnalysis::Initialize");
 
-  if (!this->Internals->ScriptFile.empty() && !this->Internals->ScriptModule.empty())
+  // initialize the interpreter, unless it is running already as when
+  // SENSEI is used from a Python application
+  this->Internals->OwnInterpreter = !Py_IsInitialized();
+  if (this->Internals->OwnInterpreter)
+    {
+    TimeEvent<128> mark("PythonAnalysis::StartInterpreter");
+    Py_SetProgramName(C_STRING_LITERAL("PythonAnalysis"));
+    Py_Initialize();
+#if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#endif
+    }
+
+  int ierr = 0;
+  {
+  senseiPyGILState gil;
+  ierr = this->Internals->Load(this->GetCommunicator(), this->GetVerbose());
+  }
+
+  // release the GIL while control is in C++. this lets the simulation's
+  // other threads use the interpreter, and lets Execute be called from a
+  // thread other than this one as it is when executing asynchronously
+  if (this->Internals->OwnInterpreter)
+    this->Internals->MainThreadState = PyEval_SaveThread();
+
+  return ierr;
+}
+
+//-----------------------------------------------------------------------------
+int PythonAnalysis::InternalsType::Load(MPI_Comm comm, int verbose)
+{
+  if (!this->ScriptFile.empty() && !this->ScriptModule.empty())
     {
     SENSEI_ERROR("Both a script file and script module were provided. "
       "You must provide either a script module or a script file not both")
     return -1;
     }
 
-  if (this->Internals->ScriptFile.empty() && this->Internals->ScriptModule.empty())
+  if (this->ScriptFile.empty() && this->ScriptModule.empty())
     {
     SENSEI_ERROR("Neither a script file nor script module were provided. "
       "You must provide either a script file or script module")
     return -1;
     }
 
-  if (!this->Internals->ScriptFile.empty())
+  // read and broadcast the script
+  std::string script;
+  if (!this->ScriptFile.empty())
+    {
+    TimeEvent<128> mark("PythonAnalysis::ReadScript");
+    if (readScript(comm, this->ScriptFile, script))
+      return -1;
+    }
+
+  // import the modules needed by the analysis on rank 0 and let the other
+  // ranks import them from memory
+  if (this->BroadcastImports)
+    {
+    std::vector<std::string> imports({"mpi4py", "mpi4py.MPI",
+      "sensei.PythonAnalysis"});
+
+    imports.insert(imports.end(), this->Imports.begin(), this->Imports.end());
+
+    if (!this->ScriptModule.empty())
+      imports.push_back(this->ScriptModule);
+
+    if (broadcastImports(comm, imports, script,
+      this->ExtensionDirectory, verbose))
+      return -1;
+    }
+
+  {
+  TimeEvent<128> mark("PythonAnalysis::LoadScript");
+  if (!this->ScriptFile.empty())
     {
-    // read, boradcast, and run the script
-    if (loadScript(this->GetCommunicator(), this->Internals->ScriptFile,
-      this->Internals->Module))
+    // run the script
+    if (loadScript(this->ScriptFile, script, this->Module))
       return -1;
     }
   else
     {
     // import the script
-    PyObject *module = PyImport_ImportModule(this->Internals->ScriptModule.c_str());
+    PyObject *module = PyImport_ImportModule(this->ScriptModule.c_str());
 
     if (!module || PyErr_Occurred())
       {
       SENSEI_PYTHON_ERROR("Failed to import module \""
-        << this->Internals->ScriptModule  << "\"")
+        << this->ScriptModule  << "\"")
       return -1;
       }
 
-    this->Internals->Module = module;
+    this->Module = module;
     }
+  }
 
   // look for AnalysisAdaptor API
-  int ierr = getFunction(this->Internals->Module,
-    this->Internals->ScriptModule, "Initialize", false,
-    this->Internals->Initialize);
+  int ierr = getFunction(this->Module,
+    this->ScriptModule, "Initialize", false,
+    this->Initialize);
 
-  ierr += getFunction(this->Internals->Module,
-    this->Internals->ScriptModule, "Execute", true,
-    this->Internals->Execute);
+  ierr += getFunction(this->Module,
+    this->ScriptModule, "Execute", true,
+    this->Execute);
 
-  ierr += getFunction(this->Internals->Module,
-    this->Internals->ScriptModule, "Finalize", false,
-    this->Internals->Finalize);
+  ierr += getFunction(this->Module,
+    this->ScriptModule, "Finalize", false,
+    this->Finalize);
 
   if (ierr)
     {
-    SENSEI_ERROR("Module \"" << this->Internals->ScriptModule <<
+    SENSEI_ERROR("Module \"" << this->ScriptModule <<
       "\" does not provide the required API. The API consists of the "
       "following functions defined at global scope:\n\n    Initialize() -> int\n"
       "    Execute(dataAdaptor) -> int\n    Finalize() -> int\n\nOnly Execute is "
@@ -336,22 +749,25 @@ int PythonAnalysis::Initialize()
     }
 
   // import the sensei wrapper and mpi4py
-  if (runString(this->Internals->Module,
+  {
+  TimeEvent<128> mark("PythonAnalysis::ImportBaseline");
+  if (runString(this->Module,
     "from mpi4py import *\n"
     "from sensei.PythonAnalysis import *\n"))
     {
     SENSEI_ERROR("Failed to import baseline modules")
     return -1;
     }
+  }
 
   // set the communicator
-  PyModule_AddObject(this->Internals->Module,
-    "comm", PyMPIComm_New(this->GetCommunicator()));
+  PyModule_AddObject(this->Module,
+    "comm", PyMPIComm_New(comm));
 
   // set provided globals
-  if (!this->Internals->InitializeSource.empty())
+  if (!this->InitializeSource.empty())
     {
-    if (runString(this->Internals->Module, this->Internals->InitializeSource))
+    if (runString(this->Module, this->InitializeSource))
       {
       SENSEI_ERROR("Failed to run initialize source")
       return -1;
@@ -359,8 +775,11 @@ int PythonAnalysis::Initialize()
     }
 
   // call the provided initialize function
-  if (this->Internals->Initialize)
-    return callFunction("Initialize", this->Internals->Initialize, nullptr);
+  if (this->Initialize)
+    {
+    TimeEvent<128> mark("PythonAnalysis::ScriptInitialize");
+    return callFunction("Initialize", this->Initialize, nullptr);
+    }
 
   return 0;
 }
@@ -380,6 +799,9 @@ bool PythonAnalysis::Execute(DataAdaptor *daIn, DataAdaptor **daOut)
     return false;
     }
 
+  // this may be called from any thread, the GIL is released on return
+  senseiPyGILState gil;
+
   // wrap the data adaptor instance
   PyObject *pyDataAdaptor = SWIG_NewPointerObj(
     SWIG_as_voidptr(daIn), SWIGTYPE_p_sensei__DataAdaptor, 0);
@@ -35,13 +35,41 @@ class DataAdaptor;
  * module or the file approach, but not both.
  *
  * The active MPI communicator is made available to the script through the
- * global variable `comm`.
+ * global variable `comm`. This is the analysis' own duplicate of the
+ * communicator passed to SetCommunicator, the script's collectives never
+ * match those of the simulation.
+ *
+ * The GIL is held only while the script runs and is released when control
+ * returns to C++. Execute may therefore be called from a thread other than
+ * the one that called Initialize, and the simulation's threads may use the
+ * interpreter in between. For asynchronous execution, in which the script
+ * processes a snapshot of each time step on a dedicated thread while the
+ * simulation advances, wrap the analysis in an AsyncAnalysisAdaptor, or set
+ * the async attribute in the ConfigurableAnalysis XML. Initialize and
+ * Finalize must be called from the same thread. When the interpreter was
+ * started by the application, as when SENSEI is used from Python, it is
+ * left running by Finalize.
  *
  * To fine tune run time behavior we provide "initialization source". The
  * initialization source (see SetInitializeSource) is provided in a string and
  * will be executed prior to your script functions. This lets you set global
  * variables that can modify the scripts run time behavior.
  *
+ * At scale importing the script's dependencies, such as numpy, mpi4py and the
+ * sensei module, from a shared file system on every rank can dominate start
+ * up. When import broadcasting is enabled (see SetBroadcastImports) rank 0
+ * imports mpi4py, the sensei module, the modules added with AddImport, the
+ * script module, and those imported at the top of the script file, and
+ * broadcasts the byte code (or source when it has no valid cache) of every
+ * module that was imported as a result. The other ranks then import these
+ * from memory. Extension modules are loaded from their original location
+ * without searching the `PYTHONPATH`, unless an extension directory on node
+ * local storage is given (see SetExtensionDirectory) in which case they are
+ * broadcast too and each rank loads its own copy from there. Libraries that
+ * the extensions locate relative to themselves must then be found by other
+ * means. The time spent in each phase of start up is recorded by the
+ * Profiler.
+ *
  * The compiled artifacts of this class and the sensei Python module  must be
  * findable in both the `PYTHONPATH` and the `LD_LIBRARY_PATH`
  * (`DYLD_LIBRARY_PATH` on Mac OS)
@@ -92,6 +120,23 @@ public:
    */
   void SetInitializeSource(const std::string &source);
 
+  /** When set, rank 0 imports the modules needed by the analysis and
+   * broadcasts them, the other ranks import them from memory rather than
+   * the file system. The default is 0.
+   */
+  void SetBroadcastImports(int val);
+
+  /** Add a module to import on rank 0 and broadcast when import broadcasting
+   * is enabled. Use this for modules imported by the script other than at
+   * the top of the file, or by its dependencies on ranks other than 0.
+   */
+  void AddImport(const std::string &moduleName);
+
+  /** Set a node local directory to copy broadcast extension modules to.
+   * When not set extension modules are not broadcast.
+   */
+  void SetExtensionDirectory(const std::string &dirName);
+
   /**  Initialize the interpreter. One must set file name or module name before
    * initialization.
    */
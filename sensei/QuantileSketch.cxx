@@ -0,0 +1,729 @@
+#include "QuantileSketch.h"
+#include "DataAdaptor.h"
+#include "MeshMetadata.h"
+#include "MeshMetadataMap.h"
+#include "SVTKUtils.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <svtkCompositeDataIterator.h>
+#include <svtkCompositeDataSet.h>
+#include <svtkDataArray.h>
+#include <svtkDataObject.h>
+#include <svtkFieldData.h>
+#include <svtkObjectFactory.h>
+#include <svtkSmartPointer.h>
+#include <svtkUnsignedCharArray.h>
+
+#include <sdiy/master.hpp>
+#include <sdiy/reduce.hpp>
+#include <sdiy/partners/merge.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+// a weighted point summarizing a set of values
+struct Centroid
+{
+  double Mean;
+  double Weight;
+
+  bool operator<(const Centroid &other) const
+  { return this->Mean < other.Mean; }
+};
+
+/* A merging t-digest. Values are buffered and periodically merged into a
+ * sorted set of centroids. The weight a centroid may have depends on its
+ * position in the distribution through the scale function
+ *
+ *   k(q) = C/(2 pi) asin(2 q - 1)
+ *
+ * which allows only small centroids near the tails so that extreme quantiles
+ * are estimated accurately. The number of centroids is O(C) regardless of
+ * the number of values added. Digests are merged by merging their centroids
+ * in the same way.
+ */
+class TDigest
+{
+public:
+  TDigest() : TDigest(100.0) {}
+
+  explicit TDigest(double compression) : Compression(compression),
+    TotalWeight(0.0), Min(std::numeric_limits<double>::max()),
+    Max(std::numeric_limits<double>::lowest()) {}
+
+  // add the values not marked as ghosts. ghosts may be null
+  template <typename data_t>
+  void Add(const data_t *vals, const unsigned char *ghosts, size_t n)
+  {
+    size_t limit = this->BufferLimit();
+    for (size_t i = 0; i < n; ++i)
+      {
+      double val = vals[i];
+      if ((ghosts && ghosts[i]) || std::isnan(val))
+        continue;
+
+      this->Buffer.push_back({val, 1.0});
+      this->TotalWeight += 1.0;
+      this->Min = std::min(this->Min, val);
+      this->Max = std::max(this->Max, val);
+
+      if (this->Buffer.size() >= limit)
+        this->Compress();
+      }
+  }
+
+  // merge another digest into this one
+  void Merge(const TDigest &other)
+  {
+    if (other.TotalWeight <= 0.0)
+      return;
+
+    this->Buffer.insert(this->Buffer.end(),
+      other.Centroids.begin(), other.Centroids.end());
+
+    this->Buffer.insert(this->Buffer.end(),
+      other.Buffer.begin(), other.Buffer.end());
+
+    this->TotalWeight += other.TotalWeight;
+    this->Min = std::min(this->Min, other.Min);
+    this->Max = std::max(this->Max, other.Max);
+
+    this->Compress();
+  }
+
+  // merge buffered values and centroids
+  void Compress()
+  {
+    if (this->Buffer.empty())
+      return;
+
+    std::vector<Centroid> all;
+    all.swap(this->Buffer);
+    all.insert(all.end(), this->Centroids.begin(), this->Centroids.end());
+    std::sort(all.begin(), all.end());
+
+    this->Centroids.clear();
+
+    double total = this->TotalWeight;
+    double wSoFar = 0.0;
+    double wLimit = total*this->QLimit(0.0);
+
+    Centroid cur = all[0];
+    size_t n = all.size();
+    for (size_t i = 1; i < n; ++i)
+      {
+      const Centroid &next = all[i];
+      double w = cur.Weight + next.Weight;
+      if (wSoFar + w <= wLimit)
+        {
+        // the merged centroid stays within its size limit
+        cur.Mean += (next.Mean - cur.Mean)*next.Weight/w;
+        cur.Weight = w;
+        }
+      else
+        {
+        wSoFar += cur.Weight;
+        this->Centroids.push_back(cur);
+        wLimit = total*this->QLimit(wSoFar/total);
+        cur = next;
+        }
+      }
+
+    this->Centroids.push_back(cur);
+  }
+
+  // estimate the value at quantile q. the digest must be compressed
+  double Quantile(double q) const
+  {
+    size_t n = this->Centroids.size();
+    if (n == 0)
+      return std::numeric_limits<double>::quiet_NaN();
+
+    if (n == 1)
+      return this->Centroids[0].Mean;
+
+    double index = q*this->TotalWeight;
+    if (index <= 0.0)
+      return this->Min;
+
+    if (index >= this->TotalWeight)
+      return this->Max;
+
+    // the weight of a centroid is taken to be centered on its mean.
+    // interpolate between the centers and, at the ends, the extrema
+    const Centroid &first = this->Centroids[0];
+    if (index < 0.5*first.Weight)
+      return this->Min + (first.Mean - this->Min)*index/(0.5*first.Weight);
+
+    double cum = 0.5*first.Weight;
+    for (size_t i = 0; i < n - 1; ++i)
+      {
+      const Centroid &left = this->Centroids[i];
+      const Centroid &right = this->Centroids[i+1];
+
+      double dw = 0.5*(left.Weight + right.Weight);
+      if (index < cum + dw)
+        return left.Mean + (right.Mean - left.Mean)*(index - cum)/dw;
+
+      cum += dw;
+      }
+
+    const Centroid &last = this->Centroids[n-1];
+    return last.Mean + (this->Max - last.Mean)*(index - cum)/(0.5*last.Weight);
+  }
+
+  double GetTotalWeight() const { return this->TotalWeight; }
+
+  // serialize the compressed digest as
+  // n, total weight, min, max, mean_0, weight_0, ... mean_n-1, weight_n-1
+  void Pack(std::vector<double> &buf) const
+  {
+    buf.push_back(this->Centroids.size());
+    buf.push_back(this->TotalWeight);
+    buf.push_back(this->Min);
+    buf.push_back(this->Max);
+
+    size_t n = this->Centroids.size();
+    for (size_t i = 0; i < n; ++i)
+      {
+      buf.push_back(this->Centroids[i].Mean);
+      buf.push_back(this->Centroids[i].Weight);
+      }
+  }
+
+  // deserialize a digest written by Pack starting at pos
+  void Unpack(const std::vector<double> &buf, size_t &pos)
+  {
+    size_t n = buf[pos];
+    this->TotalWeight = buf[pos+1];
+    this->Min = buf[pos+2];
+    this->Max = buf[pos+3];
+    pos += 4;
+
+    this->Buffer.clear();
+    this->Centroids.resize(n);
+    for (size_t i = 0; i < n; ++i, pos += 2)
+      this->Centroids[i] = {buf[pos], buf[pos+1]};
+  }
+
+private:
+  // the number of values to buffer before merging them
+  size_t BufferLimit() const
+  { return std::max<size_t>(64, 10*this->Compression); }
+
+  // the largest quantile that a centroid starting at q may extend to
+  double QLimit(double q) const
+  {
+    double k = this->Compression/(2.0*M_PI)*std::asin(2.0*q - 1.0) + 1.0;
+    if (k >= 0.25*this->Compression)
+      return 1.0;
+    return 0.5*(std::sin(2.0*M_PI*k/this->Compression) + 1.0);
+  }
+
+  double Compression;
+  double TotalWeight;
+  double Min;
+  double Max;
+  std::vector<Centroid> Centroids;
+  std::vector<Centroid> Buffer;
+};
+
+// the per rank state reduced across ranks. one digest per array.
+struct SketchBlock
+{
+  static void *create() { return new SketchBlock; }
+  static void destroy(void *b) { delete static_cast<SketchBlock*>(b); }
+
+  std::vector<TDigest> Digests;
+};
+
+// **************************************************************************
+int Write(const std::string &fileName, int step, double time,
+  const std::string &meshName, const std::string &arrayName,
+  const std::vector<double> &quantiles, const std::vector<double> &values,
+  double count)
+{
+  std::ostringstream oss;
+  oss << std::setprecision(6);
+
+  oss << "step : " << step << std::endl
+    << "time : " << time << std::endl
+    << "count : " << std::fixed << std::setprecision(0) << count << std::endl;
+
+  oss.unsetf(std::ios_base::floatfield);
+  oss << std::setprecision(6);
+
+  size_t nq = quantiles.size();
+  for (size_t i = 0; i < nq; ++i)
+    oss << quantiles[i] << " : " << values[i] << std::endl;
+
+  if (fileName.empty())
+    {
+    std::cout << "Quantiles mesh \"" << meshName << "\" data array \""
+      << arrayName << "\"" << std::endl << oss.str();
+    return 0;
+    }
+
+  char fname[1024] = {'\0'};
+  snprintf(fname, 1024, "%s_%s_%s_%d.txt", fileName.c_str(),
+    meshName.c_str(), arrayName.c_str(), step);
+
+  FILE *file = fopen(fname, "w");
+  if (!file)
+    {
+    char *estr = strerror(errno);
+    SENSEI_ERROR("Failed to open \"" << fname << "\"" << std::endl << estr)
+    return -1;
+    }
+
+  fprintf(file, "%s", oss.str().c_str());
+  fclose(file);
+
+  return 0;
+}
+}
+
+namespace sensei
+{
+
+struct QuantileSketch::InternalsType
+{
+  InternalsType() : Window(1), Compression(100.0) {}
+
+  // identifies the arrays in the order their sketches are stored
+  struct ArrayId
+  {
+    std::string MeshName;
+    int Association;
+    std::string ArrayName;
+  };
+
+  // add the local data of the current step to the sketches
+  int AddLocalData(DataAdaptor *data, MPI_Comm comm,
+    std::vector<TDigest> &digests);
+
+  // merge the digests across ranks. the result is left on rank 0
+  void Reduce(std::vector<TDigest> &digests);
+
+  DataRequirements Requirements;
+  std::vector<ArrayId> Arrays;
+  std::vector<double> Quantiles;
+  int Window;
+  double Compression;
+  std::string FileName;
+
+  // the per step local digests in the time window, or when the window is 0
+  // the digest of all steps
+  std::vector<std::deque<TDigest>> History;
+
+  // quantiles computed at the last step, on rank 0
+  std::vector<std::vector<double>> Result;
+
+  std::unique_ptr<sdiy::Master> Master;
+};
+
+// --------------------------------------------------------------------------
+int QuantileSketch::InternalsType::AddLocalData(DataAdaptor *data,
+  MPI_Comm comm, std::vector<TDigest> &digests)
+{
+  TimeEvent<128> mark("QuantileSketch::AddLocalData");
+
+  MeshMetadataMap mdMap;
+  if (mdMap.Initialize(data))
+    {
+    SENSEI_ERROR("Failed to get metadata")
+    return -1;
+    }
+
+  int nArrays = this->Arrays.size();
+  int arrayId = 0;
+
+  // fetch each mesh once along with all of the arrays needed from it
+  MeshRequirementsIterator mit = this->Requirements.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    const std::string &meshName = mit.MeshName();
+
+    // the arrays of this mesh are consecutive
+    int firstArrayId = arrayId;
+    int lastArrayId = firstArrayId;
+    while ((lastArrayId < nArrays) &&
+      (this->Arrays[lastArrayId].MeshName == meshName))
+      ++lastArrayId;
+
+    arrayId = lastArrayId;
+
+    MeshMetadataPtr mmd;
+    if (mdMap.GetMeshMetadata(meshName, mmd))
+      {
+      SENSEI_ERROR("Failed to get metadata for mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    svtkDataObject *dobj = nullptr;
+    if (data->GetMesh(meshName, true, dobj))
+      {
+      SENSEI_ERROR("Failed to get mesh \"" << meshName << "\"")
+      return -1;
+      }
+
+    // not all ranks need to have data
+    if (!dobj)
+      continue;
+
+    // take the reference so that the mesh is released on every return
+    svtkSmartPointer<svtkDataObject> dobjPtr;
+    dobjPtr.TakeReference(dobj);
+
+    for (int i = firstArrayId; i < lastArrayId; ++i)
+      {
+      const ArrayId &aid = this->Arrays[i];
+      if (data->AddArray(dobj, meshName, aid.Association, aid.ArrayName))
+        {
+        SENSEI_ERROR(<< data->GetClassName() << " failed to add "
+          << SVTKUtils::GetAttributesName(aid.Association)
+          << " data array \""  << aid.ArrayName << "\"")
+        return -1;
+        }
+      }
+
+    if ((mmd->NumGhostCells || SVTKUtils::AMR(mmd)) &&
+      data->AddGhostCellsArray(dobj, meshName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost cells.")
+      return -1;
+      }
+
+    if (mmd->NumGhostNodes && data->AddGhostNodesArray(dobj, meshName))
+      {
+      SENSEI_ERROR(<< data->GetClassName() << " failed to add ghost nodes.")
+      return -1;
+      }
+
+    svtkCompositeDataSetPtr mesh = SVTKUtils::AsCompositeData(comm, dobj, false);
+    svtkSmartPointer<svtkCompositeDataIterator> iter;
+    iter.TakeReference(mesh->NewIterator());
+    for (iter->InitTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
+      {
+      svtkDataObject *curObj = iter->GetCurrentDataObject();
+
+      for (int i = firstArrayId; i < lastArrayId; ++i)
+        {
+        const ArrayId &aid = this->Arrays[i];
+
+        svtkFieldData *fd = curObj->GetAttributesAsFieldData(aid.Association);
+        svtkDataArray *da = fd ? fd->GetArray(aid.ArrayName.c_str()) : nullptr;
+        if (!da)
+          {
+          SENSEI_WARNING("Data block " << iter->GetCurrentFlatIndex()
+            << " of mesh \"" << meshName << " has no array named \""
+            << aid.ArrayName << "\"")
+          continue;
+          }
+
+        if (da->GetNumberOfComponents() != 1)
+          {
+          SENSEI_ERROR("Quantiles of array \"" << aid.ArrayName
+            << "\" cannot be computed because the array has "
+            << da->GetNumberOfComponents() << " components")
+          return -1;
+          }
+
+        svtkUnsignedCharArray *ghosts = svtkUnsignedCharArray::SafeDownCast(
+          fd->GetArray("svtkGhostType"));
+
+        const unsigned char *pGhosts = ghosts ? ghosts->GetPointer(0) : nullptr;
+        size_t nVals = da->GetNumberOfTuples();
+
+        switch (da->GetDataType())
+          {
+          svtkTemplateMacro(
+            const SVTK_TT *pDa = SVTKUtils::GetPointer<SVTK_TT>(da);
+            digests[i].Add(pDa, pGhosts, nVals);
+            );
+          default:
+            {
+            SENSEI_ERROR("Unsupported dispatch " << da->GetClassName());
+            return -1;
+            }
+          }
+        }
+      }
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void QuantileSketch::InternalsType::Reduce(std::vector<TDigest> &digests)
+{
+  TimeEvent<128> mark("QuantileSketch::Reduce");
+
+  int nRanks = this->Master->communicator().size();
+
+  SketchBlock *block = this->Master->block<SketchBlock>(0);
+  block->Digests.swap(digests);
+
+  // merge the digests pairwise up a tree. only the digests are communicated
+  sdiy::ContiguousAssigner assigner(nRanks, nRanks);
+  sdiy::RegularDecomposer<sdiy::DiscreteBounds> decomposer(1,
+    sdiy::interval(0, nRanks - 1), nRanks);
+  sdiy::RegularMergePartners partners(decomposer, 2);
+
+  sdiy::reduce(*this->Master, assigner, partners,
+    [](SketchBlock *b, const sdiy::ReduceProxy &rp,
+      const sdiy::RegularMergePartners &)
+    {
+    size_t nDigests = b->Digests.size();
+
+    // merge incoming digests
+    for (int i = 0; i < rp.in_link().size(); ++i)
+      {
+      int gid = rp.in_link().target(i).gid;
+      if (gid == rp.gid())
+        continue;
+
+      std::vector<double> buf;
+      rp.dequeue(gid, buf);
+
+      size_t pos = 0;
+      for (size_t j = 0; j < nDigests; ++j)
+        {
+        TDigest in;
+        in.Unpack(buf, pos);
+        b->Digests[j].Merge(in);
+        }
+      }
+
+    // send to the next level
+    if (rp.out_link().size())
+      {
+      const sdiy::BlockID &target = rp.out_link().target(0);
+      if (target.gid != rp.gid())
+        {
+        std::vector<double> buf;
+        for (size_t j = 0; j < nDigests; ++j)
+          b->Digests[j].Pack(buf);
+
+        rp.enqueue(target, buf);
+        }
+      }
+    });
+
+  block->Digests.swap(digests);
+}
+
+
+//----------------------------------------------------------------------------
+senseiNewMacro(QuantileSketch);
+
+//----------------------------------------------------------------------------
+QuantileSketch::QuantileSketch() : Internals(new InternalsType)
+{
+}
+
+//----------------------------------------------------------------------------
+QuantileSketch::~QuantileSketch()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+int QuantileSketch::Initialize(const DataRequirements &reqs,
+  const std::vector<double> &quantiles, int window, double compression,
+  const std::string &fileName)
+{
+  TimeEvent<128> mark("QuantileSketch::Initialize");
+
+  InternalsType &internals = *this->Internals;
+
+  internals.Requirements = reqs;
+  internals.Quantiles = quantiles;
+  internals.Window = std::max(0, window);
+  internals.Compression = std::max(20.0, compression);
+  internals.FileName = fileName;
+
+  size_t nq = quantiles.size();
+  for (size_t i = 0; i < nq; ++i)
+    {
+    if ((quantiles[i] < 0.0) || (quantiles[i] > 1.0))
+      {
+      SENSEI_ERROR("Invalid quantile " << quantiles[i]
+        << ". Quantiles must be in [0, 1]")
+      return -1;
+      }
+    }
+
+  // flatten the requirements. this is the order in which the sketches are
+  // stored and communicated
+  internals.Arrays.clear();
+  MeshRequirementsIterator mit = reqs.GetMeshRequirementsIterator();
+  for (; mit; ++mit)
+    {
+    ArrayRequirementsIterator ait =
+      reqs.GetArrayRequirementsIterator(mit.MeshName());
+    for (; ait; ++ait)
+      internals.Arrays.push_back({mit.MeshName(), ait.Association(), ait.Array()});
+    }
+
+  if (internals.Arrays.empty())
+    {
+    SENSEI_ERROR("No arrays were specified")
+    return -1;
+    }
+
+  int nArrays = internals.Arrays.size();
+  internals.History.assign(nArrays, std::deque<TDigest>());
+  internals.Result.assign(nArrays, std::vector<double>());
+
+  // one block per rank holds the digests being reduced
+  MPI_Comm comm = this->GetCommunicator();
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  internals.Master.reset(new sdiy::Master(comm, 1, -1,
+    &SketchBlock::create, &SketchBlock::destroy));
+
+  internals.Master->add(rank, new SketchBlock, new sdiy::Link);
+
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+bool QuantileSketch::Execute(DataAdaptor *data, DataAdaptor **dataOut)
+{
+  TimeEvent<128> mark("QuantileSketch::Execute");
+
+  // we do not return anything
+  if (dataOut)
+    *dataOut = nullptr;
+
+  InternalsType &internals = *this->Internals;
+
+  if (!internals.Master)
+    {
+    SENSEI_ERROR("Not initialized")
+    return false;
+    }
+
+  MPI_Comm comm = this->GetCommunicator();
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+
+  int nArrays = internals.Arrays.size();
+
+  // sketch this step's data
+  std::vector<TDigest> step(nArrays, TDigest(internals.Compression));
+  if (internals.AddLocalData(data, comm, step))
+    {
+    SENSEI_ERROR("Failed to sketch the data at step " << data->GetDataTimeStep())
+    // abort to prevent deadlock in collective calls
+    MPI_Abort(comm, -1);
+    return false;
+    }
+
+  // update the time window and merge the steps in it
+  std::vector<TDigest> local(nArrays, TDigest(internals.Compression));
+  for (int i = 0; i < nArrays; ++i)
+    {
+    step[i].Compress();
+
+    std::deque<TDigest> &hist = internals.History[i];
+    if (internals.Window == 0)
+      {
+      if (hist.empty())
+        hist.push_back(step[i]);
+      else
+        hist.back().Merge(step[i]);
+      }
+    else
+      {
+      hist.push_back(step[i]);
+      while (int(hist.size()) > internals.Window)
+        hist.pop_front();
+      }
+
+    std::deque<TDigest>::iterator it = hist.begin();
+    std::deque<TDigest>::iterator end = hist.end();
+    for (; it != end; ++it)
+      local[i].Merge(*it);
+    }
+
+  // merge across ranks
+  internals.Reduce(local);
+
+  // report
+  if (rank == 0)
+    {
+    int timeStep = data->GetDataTimeStep();
+    double time = data->GetDataTime();
+
+    size_t nq = internals.Quantiles.size();
+    for (int i = 0; i < nArrays; ++i)
+      {
+      std::vector<double> &result = internals.Result[i];
+      result.resize(nq);
+
+      for (size_t j = 0; j < nq; ++j)
+        result[j] = local[i].Quantile(internals.Quantiles[j]);
+
+      const InternalsType::ArrayId &aid = internals.Arrays[i];
+      if (Write(internals.FileName, timeStep, time, aid.MeshName,
+        aid.ArrayName, internals.Quantiles, result, local[i].GetTotalWeight()))
+        {
+        SENSEI_ERROR("Failed to write the quantiles")
+        return false;
+        }
+      }
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int QuantileSketch::GetQuantiles(const std::string &meshName, int association,
+  const std::string &arrayName, std::vector<double> &values)
+{
+  InternalsType &internals = *this->Internals;
+
+  int nArrays = internals.Arrays.size();
+  for (int i = 0; i < nArrays; ++i)
+    {
+    const InternalsType::ArrayId &aid = internals.Arrays[i];
+    if ((aid.MeshName == meshName) && (aid.Association == association) &&
+      (aid.ArrayName == arrayName))
+      {
+      values = internals.Result[i];
+      return 0;
+      }
+    }
+
+  SENSEI_ERROR("No quantiles for " << SVTKUtils::GetAttributesName(association)
+    << " data array \"" << arrayName << "\" on mesh \"" << meshName << "\"")
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+int QuantileSketch::Finalize()
+{
+  TimeEvent<128> mark("QuantileSketch::Finalize");
+
+  this->Internals->History.clear();
+  this->Internals->Master.reset();
+
+  return 0;
+}
+
+}
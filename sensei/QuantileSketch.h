@@ -0,0 +1,77 @@
+#ifndef sensei_QuantileSketch_h
+#define sensei_QuantileSketch_h
+
+#include "AnalysisAdaptor.h"
+#include "DataRequirements.h"
+
+#include <mpi.h>
+#include <string>
+#include <vector>
+
+namespace sensei
+{
+
+/** Computes approximate quantiles of one or more arrays using a mergeable
+ * sketch. Each rank summarizes its blocks in a t-digest, a small sorted set
+ * of weighted centroids whose size is bounded by the compression parameter
+ * independent of the number of values summarized. The digests are merged
+ * across ranks using a tree reduction so that the communication cost is that
+ * of the sketch rather than of the data. The quantiles are estimated from
+ * the merged digest on rank 0, with accuracy that is best near the tails.
+ *
+ * Quantiles may be accumulated over a time window. With a window of N the
+ * quantiles reported at each step are those of the data from the last N
+ * steps. With a window of 0 they are those of all steps processed so far.
+ *
+ * Ghost zones are excluded. The data arrays must have only one component.
+ */
+class SENSEI_EXPORT QuantileSketch : public AnalysisAdaptor
+{
+public:
+  /// allocates a new instance
+  static QuantileSketch *New();
+
+  senseiTypeMacro(QuantileSketch, AnalysisAdaptor);
+
+  /** Initialize the adaptor.
+   *
+   * @param[in] reqs        names the arrays to compute quantiles of
+   * @param[in] quantiles   the quantiles to report, each in [0, 1]
+   * @param[in] window      the number of steps to accumulate, or 0 for all
+   * @param[in] compression bounds the size of the sketch. larger values
+   *                        improve accuracy. 100 is a reasonable choice.
+   * @param[in] fileName    when not empty results are written to files
+   *                        starting with this name, otherwise to stdout
+   * @returns zero if successful.
+   */
+  int Initialize(const DataRequirements &reqs,
+    const std::vector<double> &quantiles, int window, double compression,
+    const std::string &fileName);
+
+  /// add the current step to the sketches and report the quantiles
+  bool Execute(DataAdaptor *data, DataAdaptor **dataOut) override;
+
+  /// release the sketches
+  int Finalize() override;
+
+  /** Get the quantiles of the named array computed by the most recent call
+   * to Execute. Only valid on rank 0. Returns zero if successful.
+   */
+  int GetQuantiles(const std::string &meshName, int association,
+    const std::string &arrayName, std::vector<double> &values);
+
+protected:
+  QuantileSketch();
+  ~QuantileSketch();
+
+  QuantileSketch(const QuantileSketch&) = delete;
+  void operator=(const QuantileSketch&) = delete;
+
+private:
+  struct InternalsType;
+  InternalsType *Internals;
+};
+
+}
+
+#endif
@@ -0,0 +1,885 @@
+#include "SVTKContour.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <svtkDataObject.h>
+#include <svtkDataSet.h>
+#include <svtkPointSet.h>
+#include <svtkImageData.h>
+#include <svtkRectilinearGrid.h>
+#include <svtkStructuredGrid.h>
+#include <svtkPolyData.h>
+#include <svtkPoints.h>
+#include <svtkCellArray.h>
+#include <svtkCellType.h>
+#include <svtkPointData.h>
+#include <svtkCellData.h>
+#include <svtkDataArray.h>
+#include <svtkAOSDataArrayTemplate.h>
+#include <svtkDoubleArray.h>
+#include <svtkUnsignedCharArray.h>
+#include <svtkIdList.h>
+#include <svtkMatrix3x3.h>
+#include <svtkSMPTools.h>
+#include <svtkSMPThreadLocal.h>
+#include <svtkSMPThreadLocalObject.h>
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+
+namespace sensei
+{
+namespace SVTKContour
+{
+namespace
+{
+// tetrahedra splitting a hexahedron. vertices are numbered by their offset
+// i + 2j + 4k from the first vertex. all share the diagonal from 0 to 7, hence
+// a face shared by two structured cells is split the same way by both.
+const int HexTets[6][4] = {{0,1,3,7}, {0,1,5,7}, {0,2,3,7},
+  {0,2,6,7}, {0,4,5,7}, {0,4,6,7}};
+
+// triangles splitting a quadrilateral numbered i + 2j
+const int QuadTris[2][3] = {{0,1,3}, {0,2,3}};
+
+// tetrahedra splitting the other 3D cells, in SVTK's vertex order
+const int TetraTets[1][4] = {{0,1,2,3}};
+const int WedgeTets[3][4] = {{0,1,2,3}, {1,2,3,4}, {2,3,4,5}};
+const int PyramidTets[2][4] = {{0,1,2,4}, {0,2,3,4}};
+
+const int TriangleTris[1][3] = {{0,1,2}};
+
+// SVTK's hexahedron and quad vertex order to the i + 2j + 4k numbering
+const int HexOrder[8] = {0,1,3,2,4,5,7,6};
+const int QuadOrder[4] = {0,1,3,2};
+
+// identifies an edge crossed by the contour of a given value
+struct EdgeKey
+{
+  svtkIdType Lo;
+  svtkIdType Hi;
+  int Value;
+
+  bool operator==(const EdgeKey &o) const
+    { return (this->Lo == o.Lo) && (this->Hi == o.Hi) && (this->Value == o.Value); }
+};
+
+struct EdgeKeyHash
+{
+  size_t operator()(const EdgeKey &k) const
+    {
+    size_t h = std::hash<svtkIdType>()(k.Lo);
+    h ^= std::hash<svtkIdType>()(k.Hi) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>()(k.Value) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+    }
+};
+
+// the output generated by one thread. output points lie on edges of the
+// input and are interpolated from the end points when the outputs of the
+// threads are merged.
+struct LocalOutput
+{
+  std::unordered_map<EdgeKey, svtkIdType, EdgeKeyHash> EdgeMap;
+  std::vector<svtkIdType> EdgePoints;   // the end points of each edge
+  std::vector<double> EdgeWeights;      // the weight of the second end point
+  std::vector<svtkIdType> Tris;         // 3 edges per triangle
+  std::vector<svtkIdType> TriCells;     // the input cell of each triangle
+  std::vector<svtkIdType> Lines;        // 2 edges per line
+  std::vector<svtkIdType> LineCells;    // the input cell of each line
+};
+
+using LocalOutputs = svtkSMPThreadLocal<LocalOutput>;
+
+// contours the simplices a cell is split into. a point is above the
+// contour when its value is greater or equal to the contour value.
+class ContourBase
+{
+public:
+  ContourBase(const double *field, const std::vector<double> &values,
+    const unsigned char *ghosts, LocalOutputs &outputs) : Field(field),
+    Values(values.data()), NumValues(values.size()), Ghosts(ghosts),
+    Outputs(outputs) {}
+
+  // get the output point on the edge between input points a and b
+  svtkIdType Edge(LocalOutput &out, svtkIdType a, svtkIdType b, int v)
+    {
+    // order the end points so that neighboring cells compute the same point
+    if (a > b)
+      std::swap(a, b);
+
+    EdgeKey key{a, b, v};
+    auto it = out.EdgeMap.find(key);
+    if (it != out.EdgeMap.end())
+      return it->second;
+
+    svtkIdType id = out.EdgeWeights.size();
+
+    double fa = this->Field[a];
+    double fb = this->Field[b];
+
+    out.EdgePoints.push_back(a);
+    out.EdgePoints.push_back(b);
+    out.EdgeWeights.push_back((this->Values[v] - fa)/(fb - fa));
+
+    out.EdgeMap.emplace(key, id);
+
+    return id;
+    }
+
+  void Tetra(LocalOutput &out, const svtkIdType *p, svtkIdType cellId, int v)
+    {
+    double val = this->Values[v];
+
+    int above[4];
+    int nAbove = 0;
+    for (int i = 0; i < 4; ++i)
+      {
+      above[i] = this->Field[p[i]] >= val;
+      nAbove += above[i];
+      }
+
+    if ((nAbove == 0) || (nAbove == 4))
+      return;
+
+    if (nAbove != 2)
+      {
+      // one point is separated from the other three
+      int s = 0;
+      while (above[s] != (nAbove == 1))
+        ++s;
+
+      for (int i = 0; i < 4; ++i)
+        {
+        if (i != s)
+          out.Tris.push_back(this->Edge(out, p[s], p[i], v));
+        }
+
+      out.TriCells.push_back(cellId);
+      }
+    else
+      {
+      // two points on each side, the crossed edges form a quadrilateral
+      int a[2];
+      int b[2];
+      for (int i = 0, na = 0, nb = 0; i < 4; ++i)
+        {
+        if (above[i])
+          a[na++] = i;
+        else
+          b[nb++] = i;
+        }
+
+      svtkIdType e0 = this->Edge(out, p[a[0]], p[b[0]], v);
+      svtkIdType e1 = this->Edge(out, p[a[0]], p[b[1]], v);
+      svtkIdType e2 = this->Edge(out, p[a[1]], p[b[1]], v);
+      svtkIdType e3 = this->Edge(out, p[a[1]], p[b[0]], v);
+
+      svtkIdType tris[6] = {e0, e1, e2, e0, e2, e3};
+      out.Tris.insert(out.Tris.end(), tris, tris + 6);
+
+      out.TriCells.push_back(cellId);
+      out.TriCells.push_back(cellId);
+      }
+    }
+
+  void Triangle(LocalOutput &out, const svtkIdType *p, svtkIdType cellId, int v)
+    {
+    double val = this->Values[v];
+
+    int above[3];
+    int nAbove = 0;
+    for (int i = 0; i < 3; ++i)
+      {
+      above[i] = this->Field[p[i]] >= val;
+      nAbove += above[i];
+      }
+
+    if ((nAbove == 0) || (nAbove == 3))
+      return;
+
+    // one point is separated from the other two
+    int s = 0;
+    while (above[s] != (nAbove == 1))
+      ++s;
+
+    for (int i = 0; i < 3; ++i)
+      {
+      if (i != s)
+        out.Lines.push_back(this->Edge(out, p[s], p[i], v));
+      }
+
+    out.LineCells.push_back(cellId);
+    }
+
+  // contour a cell given its points and its split into simplices of N points
+  template <int N>
+  void Cell(LocalOutput &out, svtkIdType cellId, const svtkIdType *pts,
+    int nPts, const int (*simplices)[N], int nSimplices)
+    {
+    double lo = this->Field[pts[0]];
+    double hi = lo;
+    for (int i = 1; i < nPts; ++i)
+      {
+      double f = this->Field[pts[i]];
+      lo = std::min(lo, f);
+      hi = std::max(hi, f);
+      }
+
+    for (int v = 0; v < this->NumValues; ++v)
+      {
+      // skip when all points are on the same side
+      double val = this->Values[v];
+      if ((val <= lo) || (val > hi))
+        continue;
+
+      for (int s = 0; s < nSimplices; ++s)
+        {
+        svtkIdType sp[N];
+        for (int i = 0; i < N; ++i)
+          sp[i] = pts[simplices[s][i]];
+
+        if (N == 4)
+          this->Tetra(out, sp, cellId, v);
+        else
+          this->Triangle(out, sp, cellId, v);
+        }
+      }
+    }
+
+  const double *Field;
+  const double *Values;
+  int NumValues;
+  const unsigned char *Ghosts;
+  LocalOutputs &Outputs;
+};
+
+// contours the cells of image data, rectilinear and structured grids
+class StructuredContour : public ContourBase
+{
+public:
+  StructuredContour(const int dims[3], const double *field,
+    const std::vector<double> &values, const unsigned char *ghosts,
+    LocalOutputs &outputs) : ContourBase(field, values, ghosts, outputs),
+    NumAxes(0)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      this->CellDims[i] = std::max(dims[i] - 1, 1);
+      if (dims[i] > 1)
+        this->Axes[this->NumAxes++] = i;
+      }
+
+    this->Stride[0] = 1;
+    this->Stride[1] = dims[0];
+    this->Stride[2] = svtkIdType(dims[0])*dims[1];
+
+    // offsets from a cell's first point to the others, numbered i + 2j + 4k
+    // over the axes along which the cells have extent
+    int nPts = 1 << this->NumAxes;
+    for (int q = 0; q < nPts; ++q)
+      {
+      this->Offsets[q] = 0;
+      for (int a = 0; a < this->NumAxes; ++a)
+        {
+        if (q & (1 << a))
+          this->Offsets[q] += this->Stride[this->Axes[a]];
+        }
+      }
+    }
+
+  svtkIdType GetNumberOfCells() const
+    { return svtkIdType(this->CellDims[0])*this->CellDims[1]*this->CellDims[2]; }
+
+  void operator()(svtkIdType c0, svtkIdType c1)
+    {
+    // lines and vertices have no contour
+    if (this->NumAxes < 2)
+      return;
+
+    LocalOutput &out = this->Outputs.Local();
+
+    svtkIdType cx = this->CellDims[0];
+    svtkIdType cxy = cx*this->CellDims[1];
+
+    svtkIdType pts[8];
+    for (svtkIdType c = c0; c < c1; ++c)
+      {
+      if (this->Ghosts && this->Ghosts[c])
+        continue;
+
+      svtkIdType i = c % cx;
+      svtkIdType j = (c / cx) % this->CellDims[1];
+      svtkIdType k = c / cxy;
+
+      svtkIdType p0 = i + j*this->Stride[1] + k*this->Stride[2];
+
+      if (this->NumAxes == 3)
+        {
+        for (int q = 0; q < 8; ++q)
+          pts[q] = p0 + this->Offsets[q];
+
+        this->Cell<4>(out, c, pts, 8, HexTets, 6);
+        }
+      else
+        {
+        for (int q = 0; q < 4; ++q)
+          pts[q] = p0 + this->Offsets[q];
+
+        this->Cell<3>(out, c, pts, 4, QuadTris, 2);
+        }
+      }
+    }
+
+  int CellDims[3];
+  int Axes[3];
+  int NumAxes;
+  svtkIdType Stride[3];
+  svtkIdType Offsets[8];
+};
+
+// contours the cells of unstructured grids and polydata
+class ExplicitContour : public ContourBase
+{
+public:
+  ExplicitContour(svtkDataSet *input, const double *field,
+    const std::vector<double> &values, const unsigned char *ghosts,
+    LocalOutputs &outputs) : ContourBase(field, values, ghosts, outputs),
+    Input(input) {}
+
+  void operator()(svtkIdType c0, svtkIdType c1)
+    {
+    LocalOutput &out = this->Outputs.Local();
+    svtkIdList *ids = this->CellPoints.Local();
+
+    svtkIdType pts[8];
+    for (svtkIdType c = c0; c < c1; ++c)
+      {
+      if (this->Ghosts && this->Ghosts[c])
+        continue;
+
+      int type = this->Input->GetCellType(c);
+      this->Input->GetCellPoints(c, ids);
+      const svtkIdType *p = ids->GetPointer(0);
+
+      switch (type)
+        {
+        case SVTK_TETRA:
+          this->Cell<4>(out, c, p, 4, TetraTets, 1);
+          break;
+        case SVTK_HEXAHEDRON:
+          for (int q = 0; q < 8; ++q)
+            pts[q] = p[HexOrder[q]];
+          this->Cell<4>(out, c, pts, 8, HexTets, 6);
+          break;
+        case SVTK_VOXEL:
+          this->Cell<4>(out, c, p, 8, HexTets, 6);
+          break;
+        case SVTK_WEDGE:
+          this->Cell<4>(out, c, p, 6, WedgeTets, 3);
+          break;
+        case SVTK_PYRAMID:
+          this->Cell<4>(out, c, p, 5, PyramidTets, 2);
+          break;
+        case SVTK_TRIANGLE:
+          this->Cell<3>(out, c, p, 3, TriangleTris, 1);
+          break;
+        case SVTK_QUAD:
+          for (int q = 0; q < 4; ++q)
+            pts[q] = p[QuadOrder[q]];
+          this->Cell<3>(out, c, pts, 4, QuadTris, 2);
+          break;
+        case SVTK_PIXEL:
+          this->Cell<3>(out, c, p, 4, QuadTris, 2);
+          break;
+        }
+      }
+    }
+
+  svtkDataSet *Input;
+  svtkSMPThreadLocalObject<svtkIdList> CellPoints;
+};
+
+// --------------------------------------------------------------------------
+// get the point dimensions of structured data, returns false if the data is
+// not structured
+bool GetDimensions(svtkDataSet *input, int dims[3])
+{
+  if (svtkImageData *im = dynamic_cast<svtkImageData*>(input))
+    im->GetDimensions(dims);
+  else if (svtkRectilinearGrid *rg = dynamic_cast<svtkRectilinearGrid*>(input))
+    rg->GetDimensions(dims);
+  else if (svtkStructuredGrid *sg = dynamic_cast<svtkStructuredGrid*>(input))
+    sg->GetDimensions(dims);
+  else
+    return false;
+  return true;
+}
+
+// --------------------------------------------------------------------------
+// contour the field and merge the output of the threads into polydata.
+// when fieldName is not empty the field is passed to the output.
+svtkPolyData *Contour(svtkDataSet *input, const double *field,
+  const std::vector<double> &values, const std::string &fieldName)
+{
+  svtkIdType nCells = input->GetNumberOfCells();
+
+  // look up the ghost cells before going parallel, the lookup is cached
+  svtkUnsignedCharArray *ghostArray = input->GetCellGhostArray();
+  const unsigned char *ghosts = ghostArray ? ghostArray->GetPointer(0) : nullptr;
+
+  LocalOutputs outputs;
+
+  int dims[3] = {0};
+  if (GetDimensions(input, dims))
+    {
+    StructuredContour contour(dims, field, values, ghosts, outputs);
+    svtkSMPTools::For(0, contour.GetNumberOfCells(), contour);
+    }
+  else if (nCells)
+    {
+    // polydata builds its cell links on first access, do that here
+    input->GetCellType(0);
+
+    ExplicitContour contour(input, field, values, ghosts, outputs);
+    svtkSMPTools::For(0, nCells, contour);
+    }
+
+  // size the output
+  svtkIdType nPts = 0;
+  svtkIdType nTris = 0;
+  svtkIdType nLines = 0;
+  for (LocalOutputs::iterator it = outputs.begin(); it != outputs.end(); ++it)
+    {
+    nPts += (*it).EdgeWeights.size();
+    nTris += (*it).TriCells.size();
+    nLines += (*it).LineCells.size();
+    }
+
+  // use double precision when the input does
+  int coordType = SVTK_FLOAT;
+  if (svtkPointSet *ps = dynamic_cast<svtkPointSet*>(input))
+    {
+    if (ps->GetPoints())
+      coordType = ps->GetPoints()->GetDataType();
+    }
+  else if (svtkRectilinearGrid *rg = dynamic_cast<svtkRectilinearGrid*>(input))
+    {
+    if (rg->GetXCoordinates())
+      coordType = rg->GetXCoordinates()->GetDataType();
+    }
+
+  svtkPolyData *output = svtkPolyData::New();
+
+  svtkPoints *points = svtkPoints::New(coordType);
+  points->SetNumberOfPoints(nPts);
+
+  svtkPointData *pdIn = input->GetPointData();
+  svtkPointData *pdOut = output->GetPointData();
+  pdOut->CopyFieldOff("svtkGhostType");
+  pdOut->InterpolateAllocate(pdIn, nPts);
+
+  svtkDoubleArray *fieldOut = nullptr;
+  if (!fieldName.empty())
+    {
+    fieldOut = svtkDoubleArray::New();
+    fieldOut->SetName(fieldName.c_str());
+    fieldOut->SetNumberOfTuples(nPts);
+    }
+
+  svtkCellData *cdIn = input->GetCellData();
+  svtkCellData *cdOut = output->GetCellData();
+  cdOut->CopyFieldOff("svtkGhostType");
+  cdOut->CopyAllocate(cdIn, nLines + nTris);
+
+  svtkCellArray *lines = svtkCellArray::New();
+  lines->AllocateExact(nLines, 2*nLines);
+
+  svtkCellArray *polys = svtkCellArray::New();
+  polys->AllocateExact(nTris, 3*nTris);
+
+  // polydata numbers lines before polygons
+  svtkIdType ptOffs = 0;
+  svtkIdType lineId = 0;
+  svtkIdType triId = nLines;
+  for (LocalOutputs::iterator it = outputs.begin(); it != outputs.end(); ++it)
+    {
+    LocalOutput &out = *it;
+
+    svtkIdType n = out.EdgeWeights.size();
+    for (svtkIdType e = 0; e < n; ++e)
+      {
+      svtkIdType a = out.EdgePoints[2*e];
+      svtkIdType b = out.EdgePoints[2*e + 1];
+      double w = out.EdgeWeights[e];
+
+      double xa[3];
+      double xb[3];
+      input->GetPoint(a, xa);
+      input->GetPoint(b, xb);
+
+      double x[3];
+      for (int i = 0; i < 3; ++i)
+        x[i] = xa[i] + w*(xb[i] - xa[i]);
+
+      svtkIdType id = ptOffs + e;
+      points->SetPoint(id, x);
+      pdOut->InterpolateEdge(pdIn, id, a, b, w);
+
+      if (fieldOut)
+        fieldOut->SetValue(id, field[a] + w*(field[b] - field[a]));
+      }
+
+    svtkIdType nl = out.LineCells.size();
+    for (svtkIdType l = 0; l < nl; ++l)
+      {
+      svtkIdType ids[2] = {out.Lines[2*l] + ptOffs, out.Lines[2*l + 1] + ptOffs};
+      lines->InsertNextCell(2, ids);
+      cdOut->CopyData(cdIn, out.LineCells[l], lineId++);
+      }
+
+    svtkIdType nt = out.TriCells.size();
+    for (svtkIdType t = 0; t < nt; ++t)
+      {
+      svtkIdType ids[3] = {out.Tris[3*t] + ptOffs,
+        out.Tris[3*t + 1] + ptOffs, out.Tris[3*t + 2] + ptOffs};
+      polys->InsertNextCell(3, ids);
+      cdOut->CopyData(cdIn, out.TriCells[t], triId++);
+      }
+
+    ptOffs += n;
+    }
+
+  output->SetPoints(points);
+  points->Delete();
+
+  output->SetLines(lines);
+  lines->Delete();
+
+  output->SetPolys(polys);
+  polys->Delete();
+
+  if (fieldOut)
+    {
+    pdOut->AddArray(fieldOut);
+    fieldOut->Delete();
+    }
+
+  return output;
+}
+
+// --------------------------------------------------------------------------
+// compute the distance to the plane of points on a grid with axis aligned
+// coordinates. the distance is separable along the axes.
+void SeparableDistance(const int dims[3], const std::vector<double> *coords,
+  const std::array<double,3> &point, const std::array<double,3> &normal,
+  double *field)
+{
+  std::vector<double> d[3];
+  for (int a = 0; a < 3; ++a)
+    {
+    d[a].resize(dims[a]);
+    for (int i = 0; i < dims[a]; ++i)
+      d[a][i] = normal[a]*(coords[a][i] - point[a]);
+    }
+
+  const double *dx = d[0].data();
+  const double *dy = d[1].data();
+  const double *dz = d[2].data();
+
+  svtkIdType nx = dims[0];
+  svtkIdType ny = dims[1];
+
+  svtkSMPTools::For(0, ny*dims[2], [&](svtkIdType r0, svtkIdType r1)
+    {
+    for (svtkIdType r = r0; r < r1; ++r)
+      {
+      double dyz = dy[r % ny] + dz[r / ny];
+      double *row = field + r*nx;
+      for (svtkIdType i = 0; i < nx; ++i)
+        row[i] = dx[i] + dyz;
+      }
+    });
+}
+
+// --------------------------------------------------------------------------
+// compute the distance to the plane of each point
+void SliceField(svtkDataSet *input, const std::array<double,3> &point,
+  const std::array<double,3> &normal, std::vector<double> &field)
+{
+  svtkIdType nPts = input->GetNumberOfPoints();
+  field.resize(nPts);
+
+  int dims[3] = {0};
+  std::vector<double> coords[3];
+
+  svtkImageData *im = dynamic_cast<svtkImageData*>(input);
+  svtkRectilinearGrid *rg = dynamic_cast<svtkRectilinearGrid*>(input);
+
+  if (im && (!im->GetDirectionMatrix() || im->GetDirectionMatrix()->IsIdentity()))
+    {
+    im->GetDimensions(dims);
+
+    double x0[3];
+    double dx[3];
+    im->GetOrigin(x0);
+    im->GetSpacing(dx);
+
+    for (int a = 0; a < 3; ++a)
+      {
+      coords[a].resize(dims[a]);
+      for (int i = 0; i < dims[a]; ++i)
+        coords[a][i] = x0[a] + i*dx[a];
+      }
+
+    SeparableDistance(dims, coords, point, normal, field.data());
+    }
+  else if (rg)
+    {
+    rg->GetDimensions(dims);
+
+    svtkDataArray *x[3] = {rg->GetXCoordinates(),
+      rg->GetYCoordinates(), rg->GetZCoordinates()};
+
+    for (int a = 0; a < 3; ++a)
+      {
+      coords[a].resize(dims[a]);
+      for (int i = 0; i < dims[a]; ++i)
+        coords[a][i] = x[a]->GetComponent(i, 0);
+      }
+
+    SeparableDistance(dims, coords, point, normal, field.data());
+    }
+  else
+    {
+    double *pf = field.data();
+    svtkSMPTools::For(0, nPts, [&](svtkIdType i0, svtkIdType i1)
+      {
+      double x[3];
+      for (svtkIdType i = i0; i < i1; ++i)
+        {
+        input->GetPoint(i, x);
+        pf[i] = normal[0]*(x[0] - point[0]) + normal[1]*(x[1] - point[1])
+          + normal[2]*(x[2] - point[2]);
+        }
+      });
+    }
+}
+
+// --------------------------------------------------------------------------
+// copy the first component of the array
+void GetComponent(svtkDataArray *da, std::vector<double> &field)
+{
+  svtkIdType n = da->GetNumberOfTuples();
+  int nComps = da->GetNumberOfComponents();
+
+  field.resize(n);
+  double *pf = field.data();
+
+  switch (da->GetDataType())
+    {
+    svtkTemplateMacro(
+      if (svtkAOSDataArrayTemplate<SVTK_TT> *aos =
+        dynamic_cast<svtkAOSDataArrayTemplate<SVTK_TT>*>(da))
+        {
+        const SVTK_TT *pa = aos->GetPointer(0);
+        svtkSMPTools::For(0, n, [&](svtkIdType i0, svtkIdType i1)
+          {
+          for (svtkIdType i = i0; i < i1; ++i)
+            pf[i] = pa[i*nComps];
+          });
+        return;
+        }
+      );
+    }
+
+  // other memory layouts
+  svtkSMPTools::For(0, n, [&](svtkIdType i0, svtkIdType i1)
+    {
+    for (svtkIdType i = i0; i < i1; ++i)
+      pf[i] = da->GetComponent(i, 0);
+    });
+}
+
+// --------------------------------------------------------------------------
+// convert cell centered values to points by averaging the cells that use
+// each point
+void CellToPoint(svtkDataSet *input, const std::vector<double> &cellField,
+  std::vector<double> &field)
+{
+  svtkIdType nPts = input->GetNumberOfPoints();
+  field.assign(nPts, 0.0);
+
+  double *pf = field.data();
+  const double *cf = cellField.data();
+
+  int dims[3] = {0};
+  if (GetDimensions(input, dims))
+    {
+    int cdims[3];
+    for (int a = 0; a < 3; ++a)
+      cdims[a] = std::max(dims[a] - 1, 1);
+
+    svtkIdType nx = dims[0];
+    svtkIdType ny = dims[1];
+    svtkIdType cx = cdims[0];
+    svtkIdType cxy = cx*cdims[1];
+
+    svtkSMPTools::For(0, ny*dims[2], [&](svtkIdType r0, svtkIdType r1)
+      {
+      for (svtkIdType r = r0; r < r1; ++r)
+        {
+        int j = r % ny;
+        int k = r / ny;
+
+        // the cells around the point along each axis
+        int j0 = std::max(j - 1, 0);
+        int j1 = std::min(j, cdims[1] - 1);
+        int k0 = std::max(k - 1, 0);
+        int k1 = std::min(k, cdims[2] - 1);
+
+        for (int i = 0; i < nx; ++i)
+          {
+          int i0 = std::max(i - 1, 0);
+          int i1 = std::min(i, cdims[0] - 1);
+
+          double sum = 0.0;
+          int n = 0;
+          for (int kk = k0; kk <= k1; ++kk)
+            for (int jj = j0; jj <= j1; ++jj)
+              for (int ii = i0; ii <= i1; ++ii, ++n)
+                sum += cf[ii + jj*cx + kk*cxy];
+
+          pf[r*nx + i] = sum/n;
+          }
+        }
+      });
+    }
+  else
+    {
+    std::vector<int> count(nPts, 0);
+
+    svtkIdList *ids = svtkIdList::New();
+    svtkIdType nCells = input->GetNumberOfCells();
+    for (svtkIdType c = 0; c < nCells; ++c)
+      {
+      input->GetCellPoints(c, ids);
+      svtkIdType n = ids->GetNumberOfIds();
+      for (svtkIdType i = 0; i < n; ++i)
+        {
+        svtkIdType p = ids->GetId(i);
+        pf[p] += cf[c];
+        count[p] += 1;
+        }
+      }
+    ids->Delete();
+
+    for (svtkIdType p = 0; p < nPts; ++p)
+      {
+      if (count[p])
+        pf[p] /= count[p];
+      }
+    }
+}
+}
+
+// --------------------------------------------------------------------------
+int IsoSurface(svtkDataSet *input, const std::string &arrayName,
+  int arrayCen, const std::vector<double> &values, svtkPolyData *&output)
+{
+  TimeEvent<128> mark("SVTKContour::IsoSurface");
+
+  output = nullptr;
+
+  if ((arrayCen != svtkDataObject::POINT) && (arrayCen != svtkDataObject::CELL))
+    {
+    SENSEI_ERROR("Invalid array centering " << arrayCen)
+    return -1;
+    }
+
+  svtkDataArray *da = input->GetAttributesAsFieldData(arrayCen)->GetArray(arrayName.c_str());
+  if (!da)
+    {
+    SENSEI_ERROR("No " << (arrayCen == svtkDataObject::POINT ? "point" : "cell")
+      << " data array named \"" << arrayName << "\"")
+    return -1;
+    }
+
+  std::vector<double> field;
+  if (arrayCen == svtkDataObject::POINT)
+    {
+    GetComponent(da, field);
+    output = Contour(input, field.data(), values, "");
+    }
+  else
+    {
+    std::vector<double> cellField;
+    GetComponent(da, cellField);
+    CellToPoint(input, cellField, field);
+    output = Contour(input, field.data(), values, arrayName);
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int Slice(svtkDataSet *input, const std::array<double,3> &point,
+  const std::array<double,3> &normal, svtkPolyData *&output)
+{
+  TimeEvent<128> mark("SVTKContour::Slice");
+
+  output = nullptr;
+
+  if ((normal[0] == 0.0) && (normal[1] == 0.0) && (normal[2] == 0.0))
+    {
+    SENSEI_ERROR("Invalid slice normal " << normal[0] << ", "
+      << normal[1] << ", " << normal[2])
+    return -1;
+    }
+
+  std::vector<double> field;
+  SliceField(input, point, normal, field);
+
+  output = Contour(input, field.data(), std::vector<double>(1, 0.0), "");
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+bool Intersects(const std::array<double,6> &bounds,
+  const std::array<double,3> &point, const std::array<double,3> &normal)
+{
+  // the plane passes through the box when the corners are not all on the
+  // same side
+  double minD = 0.0;
+  double maxD = 0.0;
+  for (int q = 0; q < 8; ++q)
+    {
+    double d = 0.0;
+    for (int j = 0; j < 3; ++j)
+      d += normal[j]*(bounds[2*j + ((q >> j) & 1)] - point[j]);
+
+    minD = q ? std::min(minD, d) : d;
+    maxD = q ? std::max(maxD, d) : d;
+    }
+
+  return (minD <= 0.0) && (maxD >= 0.0);
+}
+
+// --------------------------------------------------------------------------
+bool Intersects(const std::array<double,2> &range,
+  const std::vector<double> &values)
+{
+  unsigned int n = values.size();
+  for (unsigned int i = 0; i < n; ++i)
+    {
+    if ((values[i] >= range[0]) && (values[i] <= range[1]))
+      return true;
+    }
+  return false;
+}
+
+}
+}
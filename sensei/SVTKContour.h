@@ -0,0 +1,80 @@
+#ifndef SVTKContour_h
+#define SVTKContour_h
+
+/// @file
+
+#include "senseiConfig.h"
+
+#include <array>
+#include <vector>
+#include <string>
+
+class svtkDataSet;
+class svtkPolyData;
+
+namespace sensei
+{
+/** Planar slices and iso-surfaces computed directly on SVTK data sets,
+ * without conversion to VTK. Cells are split into tetrahedra (triangles in
+ * 2D) which are contoured independently. The split of structured cells is
+ * the same on shared faces so that the output is crack free. Hexahedra in
+ * unstructured grids are split about their 0-6 diagonal, which is crack free
+ * when neighboring cells are ordered consistently, as is the case for meshes
+ * generated from structured blocks. Supported cells are tetrahedra,
+ * hexahedra, voxels, wedges, pyramids, triangles, quads and pixels, other
+ * cells are skipped.
+ *
+ * Cells marked in the svtkGhostType cell array are skipped so that the
+ * extracts of neighboring blocks do not overlap. Point data is interpolated
+ * onto the output and cell data is copied, ghost arrays are not passed.
+ * Cells are processed in parallel using SVTK's SMP tools. Output points are
+ * shared by the cells processed on the same thread.
+ */
+namespace SVTKContour
+{
+/** Compute iso-surfaces of the first component of the named array.  Cell
+ * centered arrays are converted to point centered by averaging the cells
+ * around each point, in which case the converted array is passed to the
+ * output under the same name. Without ghost cells the converted values on
+ * block boundaries are averaged over one side only, which can leave small
+ * gaps between the iso-surfaces of neighboring blocks.
+ *
+ * @param[in] input the data set to compute the iso-surfaces of
+ * @param[in] arrayName the name of the array
+ * @param[in] arrayCen svtkDataObject::POINT or svtkDataObject::CELL
+ * @param[in] values the iso-values
+ * @param[out] output a new svtkPolyData holding the iso-surfaces, which the
+ *                    caller must delete
+ * @returns zero if successful
+ */
+SENSEI_EXPORT
+int IsoSurface(svtkDataSet *input, const std::string &arrayName,
+  int arrayCen, const std::vector<double> &values, svtkPolyData *&output);
+
+/** Compute the slice through the plane defined by a point and a normal.
+ *
+ * @param[in] input the data set to slice
+ * @param[in] point a point on the plane
+ * @param[in] normal the plane's normal
+ * @param[out] output a new svtkPolyData holding the slice, which the caller
+ *                    must delete
+ * @returns zero if successful
+ */
+SENSEI_EXPORT
+int Slice(svtkDataSet *input, const std::array<double,3> &point,
+  const std::array<double,3> &normal, svtkPolyData *&output);
+
+/// returns true if the plane passes through the bounding box
+SENSEI_EXPORT
+bool Intersects(const std::array<double,6> &bounds,
+  const std::array<double,3> &point, const std::array<double,3> &normal);
+
+/// returns true if any of the values lie in the closed range
+SENSEI_EXPORT
+bool Intersects(const std::array<double,2> &range,
+  const std::vector<double> &values);
+}
+
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "SVTKObjectPool.h"
+#include "MemoryProfiler.h"
+#include "Profiler.h"
+
+#include <svtkInformation.h>
+
+namespace sensei
+{
+
+// --------------------------------------------------------------------------
+static
+long long getArrayBytes(svtkObjectBase *obj)
+{
+  svtkDataArray *arr = svtkDataArray::SafeDownCast(obj);
+  if (!arr)
+    return 0;
+
+  return static_cast<long long>(arr->GetSize())*arr->GetDataTypeSize();
+}
+
+// --------------------------------------------------------------------------
+SVTKObjectPool::~SVTKObjectPool()
+{
+  this->Clear();
+}
+
+// --------------------------------------------------------------------------
+void SVTKObjectPool::SetEnabled(bool enabled)
+{
+  if (!enabled)
+    this->Clear();
+
+  this->Enabled = enabled;
+}
+
+// --------------------------------------------------------------------------
+void SVTKObjectPool::Track(svtkObjectBase *obj)
+{
+  MemoryProfiler::CountAllocations(1, 0, getArrayBytes(obj), 0);
+
+  if (!this->Enabled)
+    return;
+
+  // the pool's reference, the caller's is the one returned by New
+  obj->Register(nullptr);
+  this->InUse.push_back(obj);
+}
+
+// --------------------------------------------------------------------------
+svtkDataObject *SVTKObjectPool::GetFreeObject(std::type_index type)
+{
+  auto it = this->Free.find(KeyType(type, 0));
+  if ((it == this->Free.end()) || it->second.empty())
+    return nullptr;
+
+  svtkObjectBase *obj = it->second.back();
+  it->second.pop_back();
+
+  // the caller's reference, the pool's is kept
+  obj->Register(nullptr);
+  this->InUse.push_back(obj);
+
+  MemoryProfiler::CountAllocations(0, 1, 0, 0);
+
+  return static_cast<svtkDataObject*>(obj);
+}
+
+// --------------------------------------------------------------------------
+svtkDataArray *SVTKObjectPool::GetFreeArray(std::type_index type, int nComps,
+  svtkIdType nTuples)
+{
+  auto it = this->Free.find(KeyType(type, nComps));
+  if ((it == this->Free.end()) || it->second.empty())
+    return nullptr;
+
+  ListType &arrays = it->second;
+
+  // find the smallest array large enough to hold the data, and the largest
+  // array
+  svtkIdType nValues = nTuples*nComps;
+  long bestFit = -1;
+  long largest = 0;
+  long nArrays = arrays.size();
+  for (long i = 0; i < nArrays; ++i)
+    {
+    svtkIdType size = static_cast<svtkDataArray*>(arrays[i])->GetSize();
+
+    if ((size >= nValues) && ((bestFit < 0) ||
+      (size < static_cast<svtkDataArray*>(arrays[bestFit])->GetSize())))
+      bestFit = i;
+
+    if (size > static_cast<svtkDataArray*>(arrays[largest])->GetSize())
+      largest = i;
+    }
+
+  if (bestFit < 0)
+    {
+    // none is large enough. release the largest so that the pool does not
+    // accumulate arrays that can not be reused when the size grows
+    arrays[largest]->UnRegister(nullptr);
+    arrays.erase(arrays.begin() + largest);
+    return nullptr;
+    }
+
+  svtkDataArray *arr = static_cast<svtkDataArray*>(arrays[bestFit]);
+  arrays.erase(arrays.begin() + bestFit);
+
+  // this does not reallocate since the storage is large enough. clear
+  // the name and cached ranges left from the previous use
+  arr->SetNumberOfTuples(nTuples);
+  arr->SetName(nullptr);
+  arr->SetLookupTable(nullptr);
+  if (arr->HasInformation())
+    arr->GetInformation()->Clear();
+  arr->DataChanged();
+  arr->Modified();
+
+  // the caller's reference, the pool's is kept
+  arr->Register(nullptr);
+  this->InUse.push_back(arr);
+
+  MemoryProfiler::CountAllocations(0, 1, 0, getArrayBytes(arr));
+
+  return arr;
+}
+
+// --------------------------------------------------------------------------
+int SVTKObjectPool::Recycle()
+{
+  TimeEvent<128> mark("SVTKObjectPool::Recycle");
+
+  // resetting a data object releases the objects it holds, which may then be
+  // recycled. repeat until nothing more is released.
+  int nRecycled = 0;
+  bool released = true;
+  while (released)
+    {
+    released = false;
+
+    unsigned long i = 0;
+    while (i < this->InUse.size())
+      {
+      svtkObjectBase *obj = this->InUse[i];
+
+      if (obj->GetReferenceCount() > 1)
+        {
+        ++i;
+        continue;
+        }
+
+      // only the pool references it
+      int nComps = 0;
+      if (svtkDataObject *dobj = svtkDataObject::SafeDownCast(obj))
+        {
+        dobj->Initialize();
+        released = true;
+        }
+      else if (svtkDataArray *arr = svtkDataArray::SafeDownCast(obj))
+        {
+        nComps = arr->GetNumberOfComponents();
+        }
+
+      this->Free[KeyType(typeid(*obj), nComps)].push_back(obj);
+
+      this->InUse[i] = this->InUse.back();
+      this->InUse.pop_back();
+
+      ++nRecycled;
+      }
+    }
+
+  return nRecycled;
+}
+
+// --------------------------------------------------------------------------
+void SVTKObjectPool::Clear()
+{
+  unsigned long n = this->InUse.size();
+  for (unsigned long i = 0; i < n; ++i)
+    this->InUse[i]->UnRegister(nullptr);
+
+  this->InUse.clear();
+
+  auto it = this->Free.begin();
+  auto end = this->Free.end();
+  for (; it != end; ++it)
+    {
+    n = it->second.size();
+    for (unsigned long i = 0; i < n; ++i)
+      it->second[i]->UnRegister(nullptr);
+    }
+
+  this->Free.clear();
+}
+
+// --------------------------------------------------------------------------
+unsigned long SVTKObjectPool::GetNumberOfObjectsInUse() const
+{
+  return this->InUse.size();
+}
+
+// --------------------------------------------------------------------------
+unsigned long SVTKObjectPool::GetNumberOfObjectsFree() const
+{
+  unsigned long n = 0;
+
+  auto it = this->Free.begin();
+  auto end = this->Free.end();
+  for (; it != end; ++it)
+    n += it->second.size();
+
+  return n;
+}
+
+}
@@ -0,0 +1,137 @@
+#ifndef sensei_SVTKObjectPool_h
+#define sensei_SVTKObjectPool_h
+
+#include "senseiConfig.h"
+
+#include <svtkDataArray.h>
+#include <svtkDataObject.h>
+
+#include <map>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace sensei
+{
+
+/** A per-step pool of SVTK data objects and arrays that data adaptors can
+ * opt into to avoid rebuilding the same meshes from fresh heap allocations
+ * every time step.
+ *
+ * NewObject and NewArray return a new reference that the caller releases
+ * with Delete, exactly as the objects' own New. The pool keeps its own
+ * reference to each object it hands out. Recycle, typically called from
+ * DataAdaptor::ReleaseData, returns to the pool the objects whose only
+ * remaining reference is the pool's, objects still in use elsewhere are left
+ * alone and checked again at the next call. Recycled data objects are reset
+ * with Initialize, which releases their points, cells and arrays so that
+ * these may be recycled in turn. Recycled arrays keep their storage, and a
+ * request for an array of the same class and number of components is served
+ * with the smallest recycled array that holds the requested number of
+ * tuples, no allocation is made in that case.
+ *
+ * Arrays handed out by the pool must own their storage, the caller must not
+ * pass them a pointer with SetArray or SetVoidArray.
+ *
+ * When disabled, which is the default, NewObject and NewArray allocate and
+ * nothing is pooled. In both cases the number of allocations made and
+ * avoided is reported through MemoryProfiler::CountAllocations so that the
+ * savings can be measured.
+ *
+ * The pool is not thread safe.
+ */
+class SENSEI_EXPORT SVTKObjectPool
+{
+public:
+  SVTKObjectPool() : Enabled(false) {}
+  ~SVTKObjectPool();
+
+  SVTKObjectPool(const SVTKObjectPool &) = delete;
+  void operator=(const SVTKObjectPool &) = delete;
+
+  /// Enable or disable pooling. Disabling releases all pooled objects.
+  void SetEnabled(bool enabled);
+  bool GetEnabled() const { return this->Enabled; }
+
+  /// Get a new or recycled data object. The caller must Delete it.
+  template <typename object_t>
+  object_t *NewObject();
+
+  /** Get a new or recycled array of the given number of components and
+   * tuples. The contents of a recycled array are undefined, its name is
+   * cleared. The caller must Delete it.
+   */
+  template <typename array_t>
+  array_t *NewArray(int nComps, svtkIdType nTuples);
+
+  /** Return the objects and arrays that are no longer referenced outside of
+   * the pool to the pool. Returns the number of objects recycled.
+   */
+  int Recycle();
+
+  /// Release all pooled objects, including those in use elsewhere.
+  void Clear();
+
+  /// Get the number of objects handed out and not yet recycled.
+  unsigned long GetNumberOfObjectsInUse() const;
+
+  /// Get the number of objects available for reuse.
+  unsigned long GetNumberOfObjectsFree() const;
+
+private:
+  // objects are pooled by their type and arrays also by their number of
+  // components
+  using KeyType = std::pair<std::type_index, int>;
+  using ListType = std::vector<svtkObjectBase*>;
+
+  svtkDataObject *GetFreeObject(std::type_index type);
+  svtkDataArray *GetFreeArray(std::type_index type, int nComps,
+    svtkIdType nTuples);
+
+  void Track(svtkObjectBase *obj);
+
+  bool Enabled;
+  ListType InUse;
+  std::map<KeyType, ListType> Free;
+};
+
+// --------------------------------------------------------------------------
+template <typename object_t>
+object_t *SVTKObjectPool::NewObject()
+{
+  if (this->Enabled)
+    {
+    svtkDataObject *obj = this->GetFreeObject(typeid(object_t));
+    if (obj)
+      return static_cast<object_t*>(obj);
+    }
+
+  object_t *obj = object_t::New();
+  this->Track(obj);
+
+  return obj;
+}
+
+// --------------------------------------------------------------------------
+template <typename array_t>
+array_t *SVTKObjectPool::NewArray(int nComps, svtkIdType nTuples)
+{
+  if (this->Enabled)
+    {
+    svtkDataArray *arr = this->GetFreeArray(typeid(array_t), nComps, nTuples);
+    if (arr)
+      return static_cast<array_t*>(arr);
+    }
+
+  array_t *arr = array_t::New();
+  arr->SetNumberOfComponents(nComps);
+  arr->SetNumberOfTuples(nTuples);
+  this->Track(arr);
+
+  return arr;
+}
+
+}
+
+#endif
@@ -1,23 +1,32 @@
 #include "SliceExtract.h"
 #include "MeshMetadataMap.h"
+#include "DataRequirements.h"
 #include "PlanarSlicePartitioner.h"
 #include "IsoSurfacePartitioner.h"
 #include "InTransitDataAdaptor.h"
-#include "VTKPosthocIO.h"
 #include "SVTKDataAdaptor.h"
+#include "SVTKContour.h"
 #include "SVTKUtils.h"
 #include "Profiler.h"
 #include "Error.h"
+#if defined(ENABLE_VTK_IO)
+#include "VTKPosthocIO.h"
+#endif
 
 #include <svtkObjectFactory.h>
 #include <svtkCellData.h>
 #include <svtkDataObject.h>
+#include <svtkDataSet.h>
+#include <svtkPolyData.h>
 #include <svtkCompositeDataSet.h>
 #include <svtkCompositeDataIterator.h>
 #include <svtkMultiBlockDataSet.h>
 #include <svtkOverlappingAMR.h>
 #include <svtkUniformGridAMRDataIterator.h>
 
+#include <set>
+
+#if defined(ENABLE_VTK_FILTERS)
 #include <vtkDataObjectAlgorithm.h>
 #include <vtkCellDataToPointData.h>
 #include <vtkContourFilter.h>
@@ -30,6 +39,7 @@ using vtkCellDataToPointDataPtr = vtkSmartPointer<vtkCellDataToPointData>;
 using vtkContourFilterPtr = vtkSmartPointer<vtkContourFilter>;
 using vtkCutterPtr = vtkSmartPointer<vtkCutter>;
 using vtkPlanePtr = vtkSmartPointer<vtkPlane>;
+#endif
 
 namespace sensei
 {
@@ -37,11 +47,16 @@ namespace sensei
 struct SliceExtract::InternalsType
 {
   InternalsType() : Operation(OP_PLANAR_SLICE), NumIsoValues(0),
-    EnablePartitioner(1), EnableWriter(1)
+    EnablePartitioner(1), UseVTK(0), NumBlocksSkipped(0)
   {
     this->SlicePartitioner = PlanarSlicePartitioner::New();
     this->IsoValPartitioner = IsoSurfacePartitioner::New();
+#if defined(ENABLE_VTK_IO)
+    this->EnableWriter = 1;
     this->Writer = VTKPosthocIOPtr::New();
+#else
+    this->EnableWriter = 0;
+#endif
   }
 
   int Operation;
@@ -54,9 +69,79 @@ struct SliceExtract::InternalsType
   IsoSurfacePartitionerPtr IsoValPartitioner;
   PlanarSlicePartitionerPtr SlicePartitioner;
   int EnableWriter;
+  int UseVTK;
+  long NumBlocksSkipped;
+#if defined(ENABLE_VTK_IO)
   VTKPosthocIOPtr Writer;
+#endif
 };
 
+namespace
+{
+// --------------------------------------------------------------------------
+// make a list of the local blocks whose bounds do not intersect the plane
+void GetBlocksOffPlane(const MeshMetadataPtr &md,
+  const std::array<double,3> &point, const std::array<double,3> &normal,
+  std::set<int> &skip)
+{
+  unsigned int nLocal = md->BlockIds.size();
+  if (md->BlockBounds.size() != nLocal)
+    return;
+
+  for (unsigned int i = 0; i < nLocal; ++i)
+    {
+    if (!SVTKContour::Intersects(md->BlockBounds[i], point, normal))
+      skip.insert(md->BlockIds[i]);
+    }
+}
+
+// --------------------------------------------------------------------------
+// make a list of the local blocks whose range of the named array does not
+// include any of the values
+void GetBlocksOutOfRange(const MeshMetadataPtr &md,
+  const std::string &arrayName, const std::vector<double> &values,
+  std::set<int> &skip)
+{
+  unsigned int nLocal = md->BlockIds.size();
+  if (md->BlockArrayRange.size() != nLocal)
+    return;
+
+  for (int j = 0; j < md->NumArrays; ++j)
+    {
+    if (md->ArrayName[j] != arrayName)
+      continue;
+
+    for (unsigned int i = 0; i < nLocal; ++i)
+      {
+      if ((md->BlockArrayRange[i].size() == unsigned(md->NumArrays)) &&
+        !SVTKContour::Intersects(md->BlockArrayRange[i][j], values))
+        skip.insert(md->BlockIds[i]);
+      }
+    }
+}
+
+// --------------------------------------------------------------------------
+// get the id of the block the iterator points to
+long GetBlockId(svtkCompositeDataSet *input, svtkCompositeDataIterator *it)
+{
+  // VTK's iterators for AMR datasets behave differently than for
+  // multiblock datasets.
+  svtkUniformGridAMRDataIterator *amrIt =
+    dynamic_cast<svtkUniformGridAMRDataIterator*>(it);
+
+  svtkOverlappingAMR *amrMesh = dynamic_cast<svtkOverlappingAMR*>(input);
+
+  if (amrIt && amrMesh)
+    {
+    int level = amrIt->GetCurrentLevel();
+    int index = amrIt->GetCurrentIndex();
+    return amrMesh->GetAMRBlockSourceIndex(level, index);
+    }
+
+  return it->GetCurrentFlatIndex() - 1;
+}
+}
+
 
 
 //-----------------------------------------------------------------------------
@@ -83,9 +168,34 @@ void SliceExtract::EnablePartitioner(int val)
 // --------------------------------------------------------------------------
 void SliceExtract::EnableWriter(int val)
 {
+#if !defined(ENABLE_VTK_IO)
+  if (val)
+    SENSEI_WARNING("Writing the extracts requires VTK IO, which is disabled in this build")
+  val = 0;
+#endif
   this->Internals->EnableWriter = val;
 }
 
+// --------------------------------------------------------------------------
+int SliceExtract::SetUseVTK(int val)
+{
+#if !defined(ENABLE_VTK_FILTERS)
+  if (val)
+    {
+    SENSEI_ERROR("The VTK filters are disabled in this build")
+    return -1;
+    }
+#endif
+  this->Internals->UseVTK = val;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+long SliceExtract::GetNumberOfBlocksSkipped() const
+{
+  return this->Internals->NumBlocksSkipped;
+}
+
 // --------------------------------------------------------------------------
 int SliceExtract::SetOperation(int op)
 {
@@ -157,19 +267,37 @@ void SliceExtract::SetVerbose(int val)
 // --------------------------------------------------------------------------
 int SliceExtract::SetWriterOutputDir(const std::string &outputDir)
 {
+#if defined(ENABLE_VTK_IO)
   return this->Internals->Writer->SetOutputDir(outputDir);
+#else
+  (void)outputDir;
+  SENSEI_ERROR("Writing the extracts requires VTK IO, which is disabled in this build")
+  return -1;
+#endif
 }
 
 // --------------------------------------------------------------------------
 int SliceExtract::SetWriterMode(const std::string &mode)
 {
+#if defined(ENABLE_VTK_IO)
   return this->Internals->Writer->SetMode(mode);
+#else
+  (void)mode;
+  SENSEI_ERROR("Writing the extracts requires VTK IO, which is disabled in this build")
+  return -1;
+#endif
 }
 
 // --------------------------------------------------------------------------
 int SliceExtract::SetWriterWriter(const std::string &writer)
 {
+#if defined(ENABLE_VTK_IO)
   return this->Internals->Writer->SetWriter(writer);
+#else
+  (void)writer;
+  SENSEI_ERROR("Writing the extracts requires VTK IO, which is disabled in this build")
+  return -1;
+#endif
 }
 
 // --------------------------------------------------------------------------
@@ -268,6 +396,10 @@ bool SliceExtract::ExecuteIsoSurface(DataAdaptor* daIn, DataAdaptor **daOut)
     return false;
     }
 
+  // find the blocks that do not need to be processed
+  std::set<int> skip;
+  GetBlocksOutOfRange(md, arrayName, isoVals, skip);
+
   // get the mesh
   svtkDataObject *dobj = nullptr;
   if (daIn->GetMesh(meshName, false, dobj))
@@ -307,7 +439,8 @@ bool SliceExtract::ExecuteIsoSurface(DataAdaptor* daIn, DataAdaptor **daOut)
 
   // compute the iso-surfaces
   svtkCompositeDataSet *isoMesh = nullptr;
-  if (this->IsoSurface(cdo.Get(), arrayName, arrayCentering, isoVals, isoMesh))
+  if (this->IsoSurface(cdo.Get(), arrayName, arrayCentering, isoVals,
+    skip, isoMesh))
     {
     SENSEI_ERROR("Failed to extract slice")
     return false;
@@ -367,6 +500,7 @@ bool SliceExtract::ExecuteSlice(DataAdaptor *daIn, DataAdaptor **daOut)
   // figure out what the simulation can provide
   MeshMetadataFlags flags;
   flags.SetBlockDecomp();
+  flags.SetBlockBounds();
 
   MeshMetadataMap mdm;
   if (mdm.Initialize(daIn, flags))
@@ -391,6 +525,14 @@ bool SliceExtract::ExecuteSlice(DataAdaptor *daIn, DataAdaptor **daOut)
       return false;
       }
 
+    // find the blocks that do not need to be processed
+    std::array<double,3> point, normal;
+    this->Internals->SlicePartitioner->GetPoint(point);
+    this->Internals->SlicePartitioner->GetNormal(normal);
+
+    std::set<int> skip;
+    GetBlocksOffPlane(md, point, normal, skip);
+
     // get the mesh
     svtkDataObject *dobj = nullptr;
     if (daIn->GetMesh(meshName, mit.StructureOnly(), dobj))
@@ -437,10 +579,7 @@ bool SliceExtract::ExecuteSlice(DataAdaptor *daIn, DataAdaptor **daOut)
 
     // compute the slice
     svtkCompositeDataSet *sliceMesh = nullptr;
-    std::array<double,3> point, normal;
-    this->Internals->SlicePartitioner->GetPoint(point);
-    this->Internals->SlicePartitioner->GetNormal(normal);
-    if (this->Slice(cdo.Get(), point, normal, sliceMesh))
+    if (this->Slice(cdo.Get(), point, normal, skip, sliceMesh))
       {
       SENSEI_ERROR("Failed to extract slice")
       return false;
@@ -483,33 +622,40 @@ bool SliceExtract::ExecuteSlice(DataAdaptor *daIn, DataAdaptor **daOut)
 // --------------------------------------------------------------------------
 int SliceExtract::IsoSurface(svtkCompositeDataSet *input,
   const std::string &arrayName, int arrayCen, const std::vector<double> &vals,
-  svtkCompositeDataSet *&output)
+  const std::set<int> &skip, svtkCompositeDataSet *&output)
 {
   TimeEvent<128> mark("SliceExtract::IsoSurface");
+
+#if defined(ENABLE_VTK_FILTERS)
   // build pipeline
-  vtkContourFilterPtr contour = vtkContourFilterPtr::New();
-  contour->SetComputeScalars(1);
+  vtkContourFilterPtr contour;
+  vtkCellDataToPointDataPtr cdpd;
+  if (this->Internals->UseVTK)
+    {
+    contour = vtkContourFilterPtr::New();
+    contour->SetComputeScalars(1);
 
-  contour->SetInputArrayToProcess(0, 0, 0,
-    svtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
+    contour->SetInputArrayToProcess(0, 0, 0,
+      svtkDataObject::FIELD_ASSOCIATION_POINTS, arrayName.c_str());
 
-  unsigned int nVals = vals.size();
-  contour->SetNumberOfContours(nVals);
-  for (unsigned int i = 0; i < nVals; ++i)
-    contour->SetValue(i, vals[i]);
+    unsigned int nVals = vals.size();
+    contour->SetNumberOfContours(nVals);
+    for (unsigned int i = 0; i < nVals; ++i)
+      contour->SetValue(i, vals[i]);
 
-  // when processing cell data first convert to point data
-  vtkCellDataToPointDataPtr cdpd;
-  if (arrayCen == svtkDataObject::CELL)
-    {
-    cdpd = vtkCellDataToPointDataPtr::New();
-    cdpd->SetPassCellData(1);
-    /* in newer VTK one can select specific arrays to convert
-     * it is important not to convert vtkGhostType.
-    cdpd->SetProcessAllArrays(0);
-    cdpd->AddCellDataArray(arrayName.c_str());*/
-    contour->SetInputConnection(cdpd->GetOutputPort());
+    // when processing cell data first convert to point data
+    if (arrayCen == svtkDataObject::CELL)
+      {
+      cdpd = vtkCellDataToPointDataPtr::New();
+      cdpd->SetPassCellData(1);
+      /* in newer VTK one can select specific arrays to convert
+       * it is important not to convert vtkGhostType.
+      cdpd->SetProcessAllArrays(0);
+      cdpd->AddCellDataArray(arrayName.c_str());*/
+      contour->SetInputConnection(cdpd->GetOutputPort());
+      }
     }
+#endif
 
   // allocate output
   svtkCompositeDataIterator *it = input->NewIterator();
@@ -522,55 +668,61 @@ int SliceExtract::IsoSurface(svtkCompositeDataSet *input,
   svtkMultiBlockDataSet *mbds = svtkMultiBlockDataSet::New();
   mbds->SetNumberOfBlocks(nBlocks);
 
-  // VTK's iterators for AMR datasets behave differently than for multiblock
-  // datasets.  we are going to have to handle AMR data as a special case for
-  // now.
-  svtkUniformGridAMRDataIterator *amrIt = dynamic_cast<svtkUniformGridAMRDataIterator*>(it);
-  svtkOverlappingAMR *amrMesh = dynamic_cast<svtkOverlappingAMR*>(input);
-
   // process data
   it->SetSkipEmptyNodes(1);
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
     // get the current block
-    long bid = 0;
-    if (amrIt)
-      {
-      // special case for AMR
-      int level = amrIt->GetCurrentLevel();
-      int index = amrIt->GetCurrentIndex();
-      bid = amrMesh->GetAMRBlockSourceIndex(level, index);
-      }
-    else
+    long bid = GetBlockId(input, it);
+
+    // skip blocks where the metadata shows there are no iso-surfaces
+    if (skip.count(bid))
       {
-      // other composite data
-      bid = it->GetCurrentFlatIndex() - 1;
+      this->Internals->NumBlocksSkipped += 1;
+      continue;
       }
 
     svtkDataObject *dobjIn = it->GetCurrentDataObject();
+    svtkDataObject *dobjOut = nullptr;
 
-    // convert to VTK
-    vtkDataObject *vdobjIn = SVTKUtils::VTKObjectFactory::New(dobjIn);
+#if defined(ENABLE_VTK_FILTERS)
+    if (this->Internals->UseVTK)
+      {
+      // convert to VTK
+      vtkDataObject *vdobjIn = SVTKUtils::VTKObjectFactory::New(dobjIn);
 
-    // run the pipeline on the block
-    if (arrayCen == svtkDataObject::CELL)
-      cdpd->SetInputData(vdobjIn);
-    else
-      contour->SetInputData(vdobjIn);
-    contour->SetOutput(nullptr);
-    contour->Update();
+      // run the pipeline on the block
+      if (arrayCen == svtkDataObject::CELL)
+        cdpd->SetInputData(vdobjIn);
+      else
+        contour->SetInputData(vdobjIn);
+      contour->SetOutput(nullptr);
+      contour->Update();
 
-    // get the contour
-    vtkDataObject *vdobjOut = contour->GetOutput();
+      // convert to SVTK
+      dobjOut = SVTKUtils::SVTKObjectFactory::New(contour->GetOutput());
 
-    // convert to SVTK
-    svtkDataObject *dobjOut = SVTKUtils::SVTKObjectFactory::New(vdobjOut);
+      vdobjIn->Delete();
+      }
+    else
+#endif
+      {
+      svtkDataSet *ds = dynamic_cast<svtkDataSet*>(dobjIn);
+      svtkPolyData *pd = nullptr;
+      if (!ds || SVTKContour::IsoSurface(ds, arrayName, arrayCen, vals, pd))
+        {
+        SENSEI_ERROR("Failed to compute iso-surfaces on block " << bid)
+        it->Delete();
+        mbds->Delete();
+        return -1;
+        }
+      dobjOut = pd;
+      }
 
     // save the extract
     mbds->SetBlock(bid, dobjOut);
 
     dobjOut->Delete();
-    vdobjIn->Delete();
     }
 
   it->Delete();
@@ -583,18 +735,24 @@ int SliceExtract::IsoSurface(svtkCompositeDataSet *input,
 // --------------------------------------------------------------------------
 int SliceExtract::Slice(svtkCompositeDataSet *input,
   const std::array<double,3> &point, const std::array<double,3> &normal,
-  svtkCompositeDataSet *&output)
+  const std::set<int> &skip, svtkCompositeDataSet *&output)
 {
   TimeEvent<128> mark("SliceExtract::Slice");
 
+#if defined(ENABLE_VTK_FILTERS)
   // build pipeline
-  vtkCutterPtr slice = vtkCutterPtr::New();
+  vtkCutterPtr slice;
+  if (this->Internals->UseVTK)
+    {
+    slice = vtkCutterPtr::New();
 
-  vtkPlanePtr plane = vtkPlanePtr::New();
-  plane->SetOrigin(const_cast<double*>(point.data()));
-  plane->SetNormal(const_cast<double*>(normal.data()));
+    vtkPlanePtr plane = vtkPlanePtr::New();
+    plane->SetOrigin(const_cast<double*>(point.data()));
+    plane->SetNormal(const_cast<double*>(normal.data()));
 
-  slice->SetCutFunction(plane.GetPointer());
+    slice->SetCutFunction(plane.GetPointer());
+    }
+#endif
 
   // allocate output
   svtkCompositeDataIterator *it = input->NewIterator();
@@ -612,28 +770,53 @@ int SliceExtract::Slice(svtkCompositeDataSet *input,
   for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
     {
     // get the current block
-    unsigned int bid = it->GetCurrentFlatIndex() - 1;
+    long bid = GetBlockId(input, it);
+
+    // skip blocks where the metadata shows the plane does not pass through
+    if (skip.count(bid))
+      {
+      this->Internals->NumBlocksSkipped += 1;
+      continue;
+      }
+
     svtkDataObject *dobjIn = it->GetCurrentDataObject();
+    svtkDataObject *dobjOut = nullptr;
 
-    // convert to VTK
-    vtkDataObject *vdobjIn = SVTKUtils::VTKObjectFactory::New(dobjIn);
+#if defined(ENABLE_VTK_FILTERS)
+    if (this->Internals->UseVTK)
+      {
+      // convert to VTK
+      vtkDataObject *vdobjIn = SVTKUtils::VTKObjectFactory::New(dobjIn);
 
-    // set up and run the pipeline
-    slice->SetInputData(vdobjIn);
-    slice->SetOutput(nullptr);
-    slice->Update();
+      // set up and run the pipeline
+      slice->SetInputData(vdobjIn);
+      slice->SetOutput(nullptr);
+      slice->Update();
 
-    // get the slice
-    vtkDataObject *vdobjOut = slice->GetOutput();
+      // convert to SVTK
+      dobjOut = SVTKUtils::SVTKObjectFactory::New(slice->GetOutput());
 
-    // convert to SVTK
-    svtkDataObject *dobjOut = SVTKUtils::SVTKObjectFactory::New(vdobjOut);
+      vdobjIn->Delete();
+      }
+    else
+#endif
+      {
+      svtkDataSet *ds = dynamic_cast<svtkDataSet*>(dobjIn);
+      svtkPolyData *pd = nullptr;
+      if (!ds || SVTKContour::Slice(ds, point, normal, pd))
+        {
+        SENSEI_ERROR("Failed to slice block " << bid)
+        it->Delete();
+        mbds->Delete();
+        return -1;
+        }
+      dobjOut = pd;
+      }
 
     // save the extract
     mbds->SetBlock(bid, dobjOut);
 
     dobjOut->Delete();
-    vdobjIn->Delete();
     }
 
   it->Delete();
@@ -649,6 +832,14 @@ int SliceExtract::WriteExtract(long timeStep, double time,
 {
   TimeEvent<128> mark("SliceExtract::WriteExtract");
 
+#if !defined(ENABLE_VTK_IO)
+  (void)timeStep;
+  (void)time;
+  (void)mesh;
+  (void)input;
+  SENSEI_ERROR("Writing the extracts requires VTK IO, which is disabled in this build")
+  return -1;
+#else
   SVTKDataAdaptor *dataAdaptor = SVTKDataAdaptor::New();
 
   dataAdaptor->SetDataObject(mesh, input);
@@ -665,17 +856,20 @@ int SliceExtract::WriteExtract(long timeStep, double time,
   dataAdaptor->Delete();
 
   return 0;
+#endif
 }
 
 // --------------------------------------------------------------------------
 int SliceExtract::Finalize()
 {
   TimeEvent<128> mark("SliceExtract::Finalize");
+#if defined(ENABLE_VTK_IO)
   if (this->Internals->Writer->Finalize())
     {
     SENSEI_ERROR("Failed to finalize the writer")
     return -1;
     }
+#endif
   return 0;
 }
 }
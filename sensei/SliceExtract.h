@@ -6,6 +6,7 @@
 #include <vector>
 #include <array>
 #include <string>
+#include <set>
 
 /// @cond
 class svtkCompositeDataSet;
@@ -16,7 +17,14 @@ namespace sensei { class DataRequirements; }
 namespace sensei
 {
 
-/// Extract a slice defined by a point and a normal and writes it to disk
+/** Extract a slice defined by a point and a normal, or iso-surfaces of an
+ * array, and writes them to disk. The extracts are computed directly on the
+ * SVTK data by the kernels in SVTKContour. Blocks which the block bounds or
+ * array ranges in the simulation's metadata show do not contain any part of
+ * the extract are skipped. When built with VTK filters the extracts may
+ * instead be computed by converting to VTK and running vtkCutter and
+ * vtkContourFilter. Writing requires VTK IO.
+ */
 class SENSEI_EXPORT SliceExtract : public AnalysisAdaptor
 {
 public:
@@ -35,6 +43,16 @@ public:
   /// Enable the use of an optimized partitioner
   void EnablePartitioner(int val);
 
+  /** Compute the extracts with VTK's filters rather than the native SVTK
+   * kernels. This requires VTK filters to be enabled in the build, and
+   * converts each block to VTK and back. Returns zero if successful.
+   */
+  int SetUseVTK(int val);
+
+  /// Get the total number of blocks skipped because the metadata showed
+  /// that they contain no part of the extract.
+  long GetNumberOfBlocksSkipped() const;
+
   enum {OP_ISO_SURFACE=0, OP_PLANAR_SLICE=1};
 
   /** Set which operation will be used. Valid values are OP_ISO_SURFACE=0,
@@ -119,11 +137,13 @@ private:
     bool ExecuteIsoSurface(DataAdaptor *daIn, DataAdaptor **daOut);
 
     int Slice(svtkCompositeDataSet *input, const std::array<double,3> &point,
-      const std::array<double,3> &normal, svtkCompositeDataSet *&output);
+      const std::array<double,3> &normal, const std::set<int> &skip,
+      svtkCompositeDataSet *&output);
 
     int IsoSurface(svtkCompositeDataSet *input,
       const std::string &arrayName, int arrayCen,
-      const std::vector<double> &vals, svtkCompositeDataSet *&output);
+      const std::vector<double> &vals, const std::set<int> &skip,
+      svtkCompositeDataSet *&output);
 
     int WriteExtract(long timeStep, double time, const std::string &mesh,
       svtkCompositeDataSet *input);
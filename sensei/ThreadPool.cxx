@@ -0,0 +1,82 @@
+#include "ThreadPool.h"
+#include "Error.h"
+
+#include <algorithm>
+
+namespace sensei
+{
+
+// --------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+  this->Finalize();
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::Initialize(int nThreads)
+{
+  if (this->Active)
+    {
+    SENSEI_ERROR("The thread pool is already initialized")
+    return -1;
+    }
+
+  if (nThreads < 1)
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  this->Active = true;
+
+  this->Threads.reserve(nThreads);
+  for (int i = 0; i < nThreads; ++i)
+    this->Threads.emplace_back(&ThreadPool::Run, this);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int ThreadPool::Finalize()
+{
+  {
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+  if (!this->Active)
+    return 0;
+  this->Active = false;
+  }
+
+  this->QueueCondition.notify_all();
+
+  unsigned int nThreads = this->Threads.size();
+  for (unsigned int i = 0; i < nThreads; ++i)
+    this->Threads[i].join();
+
+  this->Threads.clear();
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+void ThreadPool::Run()
+{
+  while (true)
+    {
+    std::function<void()> task;
+
+    {
+    std::unique_lock<std::mutex> lock(this->QueueMutex);
+
+    this->QueueCondition.wait(lock,
+      [this](){ return !this->Active || !this->Queue.empty(); });
+
+    // drain the queue before shutting down
+    if (this->Queue.empty())
+      return;
+
+    task = std::move(this->Queue.front());
+    this->Queue.pop_front();
+    }
+
+    task();
+    }
+}
+
+}
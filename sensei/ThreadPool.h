@@ -0,0 +1,87 @@
+#ifndef sensei_ThreadPool_h
+#define sensei_ThreadPool_h
+
+#include "senseiConfig.h"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace sensei
+{
+
+/** A fixed size pool of threads that execute tasks pushed onto a shared
+ * queue. Tasks are executed in the order they were pushed, as threads become
+ * available. A std::future is returned for each task that can be used to wait
+ * for completion and retrieve the result.
+ *
+ * The pool is intended to be long lived, threads are created in Initialize
+ * and joined in Finalize (or the destructor).
+ */
+class SENSEI_EXPORT ThreadPool
+{
+public:
+  ThreadPool() : Active(false) {}
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  void operator=(const ThreadPool &) = delete;
+
+  /** Start the threads. If nThreads is less than 1 the number of hardware
+   * threads is used. Returns 0 if successful.
+   */
+  int Initialize(int nThreads);
+
+  /// Wait for queued tasks to complete and join the threads.
+  int Finalize();
+
+  /// Get the number of threads in the pool. 0 when not initialized.
+  int GetNumberOfThreads() const { return this->Threads.size(); }
+
+  /** Queue a task for execution. The callable must take no arguments. The
+   * returned future becomes ready when the task completes.
+   */
+  template <typename task_t>
+  std::future<typename std::result_of<task_t()>::type> Push(task_t &&task);
+
+private:
+  void Run();
+
+  bool Active;
+  std::vector<std::thread> Threads;
+  std::deque<std::function<void()>> Queue;
+  std::mutex QueueMutex;
+  std::condition_variable QueueCondition;
+};
+
+// --------------------------------------------------------------------------
+template <typename task_t>
+std::future<typename std::result_of<task_t()>::type>
+ThreadPool::Push(task_t &&task)
+{
+  using result_t = typename std::result_of<task_t()>::type;
+
+  // packaged_task is move only, std::function requires copyable callables
+  auto ptask = std::make_shared<std::packaged_task<result_t()>>(
+    std::forward<task_t>(task));
+
+  std::future<result_t> result = ptask->get_future();
+
+  {
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+  this->Queue.emplace_back([ptask](){ (*ptask)(); });
+  }
+
+  this->QueueCondition.notify_one();
+
+  return result;
+}
+
+}
+
+#endif
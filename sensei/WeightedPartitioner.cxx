@@ -0,0 +1,571 @@
+#include "WeightedPartitioner.h"
+#include "XMLUtils.h"
+#include "STLUtils.h"
+#include "Profiler.h"
+
+#include <pugixml.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <sstream>
+
+namespace sensei
+{
+using namespace STLUtils; // for operator<<
+
+namespace
+{
+// the variables that may be used in a weight expression
+const char *VariableNames[] = {"cells", "points", "cell_array_size"};
+constexpr int NumVariables = 3;
+
+// an expression is compiled into a sequence of stack machine instructions
+enum {OP_CONST, OP_VAR, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG};
+
+struct Instruction
+{
+  int Code;
+  double Value;
+};
+
+using Program = std::vector<Instruction>;
+
+// recursive descent parser for the weight expression grammar
+//
+// expr   := term (('+' | '-') term)*
+// term   := factor (('*' | '/') factor)*
+// factor := number | variable | '(' expr ')' | '-' factor
+class Parser
+{
+public:
+  Parser(const std::string &str) : Str(str), Pos(0) {}
+
+  int Parse(Program &prog)
+  {
+    prog.clear();
+    if (this->Expression(prog))
+      return -1;
+
+    if (this->Peek())
+      return this->Error("unexpected character");
+
+    return 0;
+  }
+
+private:
+  // skip white space and return the next character, 0 at the end
+  char Peek()
+  {
+    while ((this->Pos < this->Str.size()) && std::isspace(this->Str[this->Pos]))
+      ++this->Pos;
+    return this->Pos < this->Str.size() ? this->Str[this->Pos] : 0;
+  }
+
+  int Error(const char *msg)
+  {
+    SENSEI_ERROR("Failed to parse weight expression \"" << this->Str
+      << "\", " << msg << " at position " << this->Pos)
+    return -1;
+  }
+
+  int Expression(Program &prog)
+  {
+    if (this->Term(prog))
+      return -1;
+
+    char c = 0;
+    while (((c = this->Peek()) == '+') || (c == '-'))
+      {
+      ++this->Pos;
+      if (this->Term(prog))
+        return -1;
+      prog.push_back({c == '+' ? OP_ADD : OP_SUB, 0.0});
+      }
+
+    return 0;
+  }
+
+  int Term(Program &prog)
+  {
+    if (this->Factor(prog))
+      return -1;
+
+    char c = 0;
+    while (((c = this->Peek()) == '*') || (c == '/'))
+      {
+      ++this->Pos;
+      if (this->Factor(prog))
+        return -1;
+      prog.push_back({c == '*' ? OP_MUL : OP_DIV, 0.0});
+      }
+
+    return 0;
+  }
+
+  int Factor(Program &prog)
+  {
+    char c = this->Peek();
+
+    if (c == '(')
+      {
+      ++this->Pos;
+      if (this->Expression(prog))
+        return -1;
+      if (this->Peek() != ')')
+        return this->Error("missing )");
+      ++this->Pos;
+      return 0;
+      }
+
+    if (c == '-')
+      {
+      ++this->Pos;
+      if (this->Factor(prog))
+        return -1;
+      prog.push_back({OP_NEG, 0.0});
+      return 0;
+      }
+
+    if (std::isdigit(c) || (c == '.'))
+      {
+      const char *p0 = this->Str.c_str() + this->Pos;
+      char *p1 = nullptr;
+      double val = strtod(p0, &p1);
+      this->Pos += p1 - p0;
+      prog.push_back({OP_CONST, val});
+      return 0;
+      }
+
+    if (std::isalpha(c) || (c == '_'))
+      {
+      size_t p0 = this->Pos;
+      while ((this->Pos < this->Str.size()) &&
+        (std::isalnum(this->Str[this->Pos]) || (this->Str[this->Pos] == '_')))
+        ++this->Pos;
+
+      std::string name = this->Str.substr(p0, this->Pos - p0);
+      for (int i = 0; i < NumVariables; ++i)
+        {
+        if (name == VariableNames[i])
+          {
+          prog.push_back({OP_VAR, double(i)});
+          return 0;
+          }
+        }
+
+      this->Pos = p0;
+      return this->Error("unknown variable");
+      }
+
+    return this->Error(c ? "unexpected character" : "unexpected end");
+  }
+
+  const std::string &Str;
+  size_t Pos;
+};
+
+// --------------------------------------------------------------------------
+double Evaluate(const Program &prog, const double *vars,
+  std::vector<double> &stack)
+{
+  stack.clear();
+
+  size_t n = prog.size();
+  for (size_t i = 0; i < n; ++i)
+    {
+    const Instruction &inst = prog[i];
+    switch (inst.Code)
+      {
+      case OP_CONST:
+        stack.push_back(inst.Value);
+        break;
+      case OP_VAR:
+        stack.push_back(vars[int(inst.Value)]);
+        break;
+      case OP_NEG:
+        stack.back() = -stack.back();
+        break;
+      default:
+        {
+        double b = stack.back();
+        stack.pop_back();
+        double &a = stack.back();
+        if (inst.Code == OP_ADD)
+          a += b;
+        else if (inst.Code == OP_SUB)
+          a -= b;
+        else if (inst.Code == OP_MUL)
+          a *= b;
+        else
+          a /= b;
+        }
+      }
+    }
+
+  return stack.back();
+}
+
+// --------------------------------------------------------------------------
+// spread the low 21 bits of i so that there are two zero bits between each
+uint64_t SpreadBits(uint64_t i)
+{
+  i &= 0x1fffff;
+  i = (i | (i << 32)) & 0x1f00000000ffff;
+  i = (i | (i << 16)) & 0x1f0000ff0000ff;
+  i = (i | (i << 8)) & 0x100f00f00f00f00f;
+  i = (i | (i << 4)) & 0x10c30c30c30c30c3;
+  i = (i | (i << 2)) & 0x1249249249249249;
+  return i;
+}
+
+// --------------------------------------------------------------------------
+// convert the coordinates of a point on a 2^21 grid to the transposed form
+// of its index on the Hilbert curve, following J. Skilling, "Programming the
+// Hilbert curve", AIP Conf. Proc. 707, 2004.
+void HilbertTranspose(uint64_t x[3])
+{
+  constexpr uint64_t m = uint64_t(1) << 20;
+
+  // inverse undo
+  for (uint64_t q = m; q > 1; q >>= 1)
+    {
+    uint64_t p = q - 1;
+    for (int i = 0; i < 3; ++i)
+      {
+      if (x[i] & q)
+        {
+        x[0] ^= p;
+        }
+      else
+        {
+        uint64_t t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+        }
+      }
+    }
+
+  // Gray encode
+  for (int i = 1; i < 3; ++i)
+    x[i] ^= x[i-1];
+
+  uint64_t t = 0;
+  for (uint64_t q = m; q > 1; q >>= 1)
+    {
+    if (x[2] & q)
+      t ^= q - 1;
+    }
+
+  for (int i = 0; i < 3; ++i)
+    x[i] ^= t;
+}
+
+// --------------------------------------------------------------------------
+// order the blocks along a space filling curve through the centers of
+// their boxes
+void CurveOrder(const std::vector<std::array<double,6>> &boxes, int curve,
+  std::vector<int> &order)
+{
+  int nBlocks = boxes.size();
+
+  double lo[3] = {std::numeric_limits<double>::max(),
+    std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+  double hi[3] = {std::numeric_limits<double>::lowest(),
+    std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      double c = 0.5*(boxes[i][2*j] + boxes[i][2*j+1]);
+      lo[j] = std::min(lo[j], c);
+      hi[j] = std::max(hi[j], c);
+      }
+    }
+
+  // quantize the centers and interleave the bits
+  std::vector<uint64_t> keys(nBlocks);
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    uint64_t x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      double c = 0.5*(boxes[i][2*j] + boxes[i][2*j+1]);
+      double ext = hi[j] - lo[j];
+      x[j] = ext > 0.0 ? uint64_t((c - lo[j])/ext*double(0x1fffff)) : 0;
+      }
+
+    if (curve == WeightedPartitioner::CURVE_HILBERT)
+      {
+      HilbertTranspose(x);
+      keys[i] = (SpreadBits(x[0]) << 2) | (SpreadBits(x[1]) << 1) |
+        SpreadBits(x[2]);
+      }
+    else
+      {
+      keys[i] = SpreadBits(x[0]) | (SpreadBits(x[1]) << 1) |
+        (SpreadBits(x[2]) << 2);
+      }
+    }
+
+  std::stable_sort(order.begin(), order.end(),
+    [&keys](int a, int b) { return keys[a] < keys[b]; });
+}
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::SetMethod(int method)
+{
+  if ((method != METHOD_LPT) && (method != METHOD_SFC))
+    {
+    SENSEI_ERROR("Invalid method " << method)
+    return -1;
+    }
+
+  this->Method = method;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::SetCurve(int curve)
+{
+  if ((curve != CURVE_MORTON) && (curve != CURVE_HILBERT))
+    {
+    SENSEI_ERROR("Invalid curve " << curve)
+    return -1;
+    }
+
+  this->Curve = curve;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::SetWeightExpression(const std::string &expr)
+{
+  Program prog;
+  if (Parser(expr).Parse(prog))
+    return -1;
+
+  this->WeightExpression = expr;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::GetCurveOrder(const MeshMetadataPtr &md, int curve,
+  std::vector<int> &order)
+{
+  order.resize(md->NumBlocks);
+  std::iota(order.begin(), order.end(), 0);
+
+  std::vector<std::array<double,6>> boxes;
+  if (Partitioner::GetBlockBoxes(md, boxes))
+    return -1;
+
+  CurveOrder(boxes, curve, order);
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::GetBlockWeights(const MeshMetadataPtr &md,
+  std::vector<double> &weights)
+{
+  Program prog;
+  if (Parser(this->WeightExpression).Parse(prog))
+    return -1;
+
+  // sizes that were not provided are zero
+  unsigned int nBlocks = md->NumBlocks;
+  const std::vector<long> *sizes[NumVariables] = {&md->BlockNumCells,
+    &md->BlockNumPoints, &md->BlockCellArraySize};
+
+  weights.resize(nBlocks);
+
+  double total = 0.0;
+  std::vector<double> stack;
+  for (unsigned int i = 0; i < nBlocks; ++i)
+    {
+    double vars[NumVariables];
+    for (int j = 0; j < NumVariables; ++j)
+      vars[j] = sizes[j]->size() == nBlocks ? (*sizes[j])[i] : 0.0;
+
+    double w = Evaluate(prog, vars, stack);
+    if (!(w >= 0.0))
+      {
+      SENSEI_ERROR("Block " << i << " has invalid weight " << w
+        << " computed from \"" << this->WeightExpression << "\"")
+      return -1;
+      }
+
+    weights[i] = w;
+    total += w;
+    }
+
+  // with no information about the cost all blocks are equal
+  if (total <= 0.0)
+    weights.assign(nBlocks, 1.0);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::GetPartition(MPI_Comm comm,
+  const MeshMetadataPtr &mdIn, MeshMetadataPtr &mdOut)
+{
+  TimeEvent<128> mark("WeightedPartitioner::GetPartition");
+
+  std::vector<double> weights;
+  if (this->GetBlockWeights(mdIn, weights))
+    return -1;
+
+  int nRanks = 1;
+  MPI_Comm_size(comm, &nRanks);
+
+  mdOut = mdIn->NewCopy();
+
+  int nBlocks = mdOut->NumBlocks;
+  mdOut->BlockOwner.resize(nBlocks);
+
+  std::vector<int> order(nBlocks);
+  std::iota(order.begin(), order.end(), 0);
+
+  std::vector<double> load(nRanks, 0.0);
+
+  if (this->Method == METHOD_LPT)
+    {
+    // place the heaviest remaining block on the least loaded rank. ties are
+    // broken by block id and rank so that all ranks compute the same result
+    std::stable_sort(order.begin(), order.end(),
+      [&weights](int a, int b) { return weights[a] > weights[b]; });
+
+    using RankLoad = std::pair<double,int>;
+    std::priority_queue<RankLoad, std::vector<RankLoad>,
+      std::greater<RankLoad>> ranks;
+
+    for (int j = 0; j < nRanks; ++j)
+      ranks.push(RankLoad(0.0, j));
+
+    for (int i = 0; i < nBlocks; ++i)
+      {
+      int bid = order[i];
+
+      RankLoad rl = ranks.top();
+      ranks.pop();
+
+      mdOut->BlockOwner[bid] = rl.second;
+      rl.first += weights[bid];
+      load[rl.second] = rl.first;
+
+      ranks.push(rl);
+      }
+    }
+  else
+    {
+    // order the blocks along the curve, or by id when the block geometry
+    // is not known
+    WeightedPartitioner::GetCurveOrder(mdIn, this->Curve, order);
+
+    // cut the curve into segments of equal weight. a block goes to the
+    // segment containing its midpoint
+    double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+
+    double pos = 0.0;
+    for (int i = 0; i < nBlocks; ++i)
+      {
+      int bid = order[i];
+      double w = weights[bid];
+
+      int owner = std::min(nRanks - 1, int(nRanks*(pos + 0.5*w)/total));
+
+      mdOut->BlockOwner[bid] = owner;
+      load[owner] += w;
+
+      pos += w;
+      }
+    }
+
+  // report the decomp
+  int rank = 0;
+  MPI_Comm_rank(comm, &rank);
+  if ((rank == 0) && this->GetVerbose())
+    {
+    double maxLoad = *std::max_element(load.begin(), load.end());
+    double meanLoad = std::accumulate(load.begin(), load.end(), 0.0)/nRanks;
+
+    std::ostringstream oss;
+    oss << this->GetClassName() << ": NumBlocks=" << nBlocks << " method="
+      << (this->Method == METHOD_LPT ? "lpt" :
+      (this->Curve == CURVE_HILBERT ? "sfc curve=hilbert" : "sfc curve=morton"))
+      << " maxLoad="
+      << maxLoad << " meanLoad=" << meanLoad << " imbalance="
+      << (meanLoad > 0.0 ? maxLoad/meanLoad : 1.0);
+
+    if (this->GetVerbose() > 2)
+      {
+      oss << std::endl << "weights=" << weights << std::endl
+        << "sender BlockOwner=" << mdIn->BlockOwner << std::endl
+        << "receiver BlockOwner=" << mdOut->BlockOwner;
+      }
+
+    SENSEI_STATUS(<< oss.str())
+    }
+
+  this->RecordMetrics(comm, mdOut);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int WeightedPartitioner::Initialize(pugi::xml_node &node)
+{
+  TimeEvent<128> mark("WeightedPartitioner::Initialize");
+
+  std::string method = node.attribute("method").as_string(
+    this->Method == METHOD_LPT ? "lpt" : "sfc");
+  if (method == "lpt")
+    {
+    this->Method = METHOD_LPT;
+    }
+  else if (method == "sfc")
+    {
+    this->Method = METHOD_SFC;
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid method \"" << method << "\". Use lpt or sfc")
+    return -1;
+    }
+
+  std::string curve = node.attribute("curve").as_string(
+    this->Curve == CURVE_HILBERT ? "hilbert" : "morton");
+  if (curve == "hilbert")
+    {
+    this->Curve = CURVE_HILBERT;
+    }
+  else if (curve == "morton")
+    {
+    this->Curve = CURVE_MORTON;
+    }
+  else
+    {
+    SENSEI_ERROR("Invalid curve \"" << curve << "\". Use hilbert or morton")
+    return -1;
+    }
+
+  pugi::xml_attribute weight = node.attribute("weight");
+  if (weight && this->SetWeightExpression(weight.value()))
+    return -1;
+
+  SENSEI_STATUS("Configured " << this->GetClassName() << " method=" << method
+    << (this->Method == METHOD_SFC ? " curve=" + curve : std::string())
+    << " weight=\"" << this->WeightExpression << "\"")
+
+  return 0;
+}
+
+}
@@ -0,0 +1,127 @@
+#ifndef sensei_WeightedPartitioner_h
+#define sensei_WeightedPartitioner_h
+
+#include "Partitioner.h"
+#include <string>
+#include <vector>
+
+namespace sensei
+{
+
+class WeightedPartitioner;
+using WeightedPartitionerPtr = std::shared_ptr<sensei::WeightedPartitioner>;
+
+/// @class WeightedPartitioner
+/// @brief balances the cost of the blocks assigned to each rank.
+///
+/// The cost of each block is given by a weight expression evaluated on the
+/// block's size. The expression may use the numbers of cells and points and
+/// the cell array size of the block, named 'cells', 'points' and
+/// 'cell_array_size', numeric constants, the operators + - * / and
+/// parentheses. The default weight is the sum of the three sizes, which is
+/// proportional to the amount of data moved. Sizes that the sender does not
+/// provide are zero, blocks are weighted equally when all weights are zero.
+///
+/// Two methods are available. The longest processing time (LPT) method
+/// assigns blocks in order of decreasing weight to the rank with the least
+/// load, which comes within 4/3 of the optimal balance but scatters the
+/// blocks. The space filling curve (SFC) method orders blocks along a Morton
+/// or Hilbert curve through the centers of their bounds, or of their extents
+/// for Cartesian and AMR meshes without bounds, and cuts the curve into
+/// contiguous segments of equal weight. This gives each rank spatially
+/// adjacent blocks, and the Hilbert curve, which has no jumps, the smaller
+/// surface between ranks. SFC falls back to block id order when neither
+/// bounds nor extents are available.
+///
+/// In XML:
+///
+/// <partitioner type="weighted" method="lpt" weight="cells + 0.5*points"/>
+/// <partitioner type="weighted" method="sfc" curve="hilbert"/>
+class SENSEI_EXPORT WeightedPartitioner : public sensei::Partitioner
+{
+public:
+  static sensei::WeightedPartitionerPtr New()
+  { return WeightedPartitionerPtr(new WeightedPartitioner); }
+
+  const char *GetClassName() override { return "WeightedPartitioner"; }
+
+  enum {METHOD_LPT=0, METHOD_SFC=1};
+  enum {CURVE_MORTON=0, CURVE_HILBERT=1};
+
+  // set the method used to assign blocks, one of METHOD_LPT or METHOD_SFC
+  int SetMethod(int method);
+  int GetMethod() { return this->Method; }
+
+  // set the curve used by the SFC method, one of CURVE_MORTON or
+  // CURVE_HILBERT
+  int SetCurve(int curve);
+  int GetCurve() { return this->Curve; }
+
+  // set the expression used to compute the weight of each block. returns
+  // non-zero if the expression could not be parsed.
+  int SetWeightExpression(const std::string &expr);
+  const std::string &GetWeightExpression() { return this->WeightExpression; }
+
+  // order the blocks along the given curve through the centers of their
+  // bounds or extents. returns non-zero if neither is available.
+  static int GetCurveOrder(const sensei::MeshMetadataPtr &md, int curve,
+    std::vector<int> &order);
+
+  // compute the weight of each block in the metadata
+  int GetBlockWeights(const sensei::MeshMetadataPtr &md,
+    std::vector<double> &weights);
+
+  // Initialize from the 'method', 'curve' and 'weight' attributes
+  int Initialize(pugi::xml_node &node) override;
+
+  // given an existing partitioning of data passed in the first MeshMetadata
+  // argument,return a new partittioning in the second MeshMetadata argument.
+  int GetPartition(MPI_Comm comm, const sensei::MeshMetadataPtr &in,
+    sensei::MeshMetadataPtr &out) override;
+
+protected:
+  WeightedPartitioner() : Method(METHOD_LPT), Curve(CURVE_MORTON),
+    WeightExpression("cells + points + cell_array_size") {}
+
+  WeightedPartitioner(const WeightedPartitioner &) = default;
+
+  int Method;
+  int Curve;
+  std::string WeightExpression;
+};
+
+class SpaceFillingCurvePartitioner;
+using SpaceFillingCurvePartitionerPtr = std::shared_ptr<sensei::SpaceFillingCurvePartitioner>;
+
+/// @class SpaceFillingCurvePartitioner
+/// @brief cuts a Hilbert curve through the blocks into segments of equal
+/// weight.
+///
+/// This is the WeightedPartitioner configured with the SFC method and the
+/// Hilbert curve, which keeps the blocks on each rank together and reduces
+/// the number of ranks that exchange ghost zones or take part in a slice.
+///
+/// In XML:
+///
+/// <partitioner type="space_filling_curve" curve="hilbert" weight="cells"/>
+class SENSEI_EXPORT SpaceFillingCurvePartitioner : public sensei::WeightedPartitioner
+{
+public:
+  static sensei::SpaceFillingCurvePartitionerPtr New()
+  { return SpaceFillingCurvePartitionerPtr(new SpaceFillingCurvePartitioner); }
+
+  const char *GetClassName() override { return "SpaceFillingCurvePartitioner"; }
+
+protected:
+  SpaceFillingCurvePartitioner()
+  {
+    this->Method = METHOD_SFC;
+    this->Curve = CURVE_HILBERT;
+  }
+
+  SpaceFillingCurvePartitioner(const SpaceFillingCurvePartitioner &) = default;
+};
+
+}
+
+#endif
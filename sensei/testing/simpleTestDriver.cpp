@@ -150,7 +150,9 @@ int addArray(svtkDataObject *mesh, const std::string &meshName,
 
 int main(int argc, char **argv)
 {
-  MPI_Init(&argc, &argv);
+  // request thread multiple so analyses may be executed concurrently
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
 
   if (argc != 2)
     {
@@ -175,6 +177,9 @@ int main(int argc, char **argv)
 
   for (int i = 0; i < 5; ++i)
     {
+    // a simulation would modify its data in place here
+    aa->PrepareToModify();
+
     da->SetDataTimeStep(i);
     da->SetDataTime(i);
     aa->Execute(da, nullptr);
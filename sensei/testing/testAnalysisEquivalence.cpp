@@ -0,0 +1,319 @@
+#include "ProgrammableDataAdaptor.h"
+#include "ConfigurableAnalysis.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <pugixml.hpp>
+
+#include <svtkMultiBlockDataSet.h>
+#include <svtkImageData.h>
+#include <svtkCellData.h>
+#include <svtkDoubleArray.h>
+#include <svtkDataObject.h>
+#include <svtkSmartPointer.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Runs the same histograms through ConfigurableAnalysis executing them in
+// order, concurrently, where the simulation data is shared through the
+// CachingDataAdaptor, and asynchronously with zero-copy and deep-copy
+// snapshots, and checks that every mode writes the same histograms each time
+// step. The simulation updates its data in place between time steps, after
+// calling PrepareToModify, such that an analysis that read data from the
+// wrong step would compute a different histogram.
+//
+// usage: testAnalysisEquivalence [num steps]
+
+namespace
+{
+// the number of cells in x and y, each rank has one layer in z
+const int gnx = 64;
+const int gny = 64;
+
+// the simulation's data, updated in place each step
+svtkSmartPointer<svtkDoubleArray> values;
+
+// the number of bins of each histogram, also used to name its output
+const int bins[] = {10, 7, 5};
+
+// --------------------------------------------------------------------------
+void updateValues(int step, int rank)
+{
+  std::mt19937 gen(1000*step + rank);
+  std::normal_distribution<double> dist(step, 0.5 + 0.1*step);
+
+  double *vals = values->GetPointer(0);
+  for (long i = 0; i < gnx*gny; ++i)
+    vals[i] = dist(gen);
+}
+
+// --------------------------------------------------------------------------
+int getNumMeshes(unsigned int &n)
+{
+  n = 1;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int getMeshMetadata(unsigned int i, sensei::MeshMetadataPtr &mdp)
+{
+  if (i != 0)
+    return -1;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  mdp = sensei::MeshMetadata::New();
+  mdp->MeshName = "mesh";
+  mdp->MeshType = SVTK_MULTIBLOCK_DATA_SET;
+  mdp->BlockType = SVTK_IMAGE_DATA;
+  mdp->NumBlocks = nRanks;
+  mdp->NumBlocksLocal = {1};
+  mdp->NumArrays = 1;
+  mdp->ArrayName = {"values"};
+  mdp->ArrayCentering = {svtkDataObject::CELL};
+  mdp->ArrayComponents = {1};
+  mdp->ArrayType = {SVTK_DOUBLE};
+  mdp->BlockIds = {0};
+  mdp->BlockOwner = {rank};
+  mdp->BlockExtents = {{0, gnx, 0, gny, rank, rank+1}};
+  mdp->BlockNumCells = {gnx*gny};
+  mdp->BlockNumPoints = {(gnx+1)*(gny+1)*2};
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int getMesh(const std::string &meshName, bool, svtkDataObject *&mesh)
+{
+  if (meshName != "mesh")
+    return -1;
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  svtkImageData *im = svtkImageData::New();
+  im->SetExtent(0, gnx, 0, gny, rank, rank+1);
+
+  svtkMultiBlockDataSet *mb = svtkMultiBlockDataSet::New();
+  mb->SetNumberOfBlocks(nRanks);
+  mb->SetBlock(rank, im);
+  im->Delete();
+
+  mesh = mb;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int addArray(svtkDataObject *mesh, const std::string &meshName,
+  int assoc, const std::string &name)
+{
+  if ((meshName != "mesh") || (assoc != svtkDataObject::CELL) ||
+    (name != "values"))
+    return -1;
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  svtkMultiBlockDataSet *mb = dynamic_cast<svtkMultiBlockDataSet*>(mesh);
+  svtkImageData *im = mb ? dynamic_cast<svtkImageData*>(mb->GetBlock(rank)) : nullptr;
+  if (!im)
+    return -1;
+
+  // pass the simulation's array without copying it
+  im->GetCellData()->AddArray(values);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+std::string makeConfig(const char *mode)
+{
+  std::string m(mode);
+
+  std::ostringstream oss;
+  oss << "<sensei" << (m == "concurrent" ? " concurrent_threads=\"2\"" : "")
+    << ">" << std::endl;
+
+  for (int i = 0; i < 3; ++i)
+    {
+    oss << "  <analysis type=\"histogram\" mesh=\"mesh\" array=\"values\""
+      " association=\"cell\" bins=\"" << bins[i] << "\" file=\"" << m << "_"
+      << bins[i] << "\" enabled=\"1\"";
+
+    // the last analysis executes in order in all modes
+    if ((m == "concurrent") && (i < 2))
+      oss << " concurrent=\"1\"";
+    else if ((m == "async") && (i < 2))
+      oss << " async=\"1\" async_queue_length=\"2\""
+        << (i == 0 ? " async_copy=\"deep\"" : "");
+
+    oss << "/>" << std::endl;
+    }
+
+  oss << "</sensei>" << std::endl;
+
+  return oss.str();
+}
+
+// --------------------------------------------------------------------------
+int run(const char *mode, int nSteps, int rank)
+{
+  pugi::xml_document doc;
+  if (!doc.load_string(makeConfig(mode).c_str()))
+    {
+    SENSEI_ERROR("Failed to parse the " << mode << " configuration")
+    return -1;
+    }
+
+  sensei::ProgrammableDataAdaptor *da = sensei::ProgrammableDataAdaptor::New();
+  da->SetGetNumberOfMeshesCallback(getNumMeshes);
+  da->SetGetMeshMetadataCallback(getMeshMetadata);
+  da->SetGetMeshCallback(getMesh);
+  da->SetAddArrayCallback(addArray);
+
+  sensei::ConfigurableAnalysis *aa = sensei::ConfigurableAnalysis::New();
+  if (aa->Initialize(doc.child("sensei")))
+    {
+    SENSEI_ERROR("Failed to initialize the " << mode << " analyses")
+    return -1;
+    }
+
+  int status = 0;
+  for (int step = 0; step < nSteps; ++step)
+    {
+    // analyses executing asynchronously may still reference the last
+    // step's data
+    aa->PrepareToModify();
+
+    updateValues(step, rank);
+
+    da->SetDataTimeStep(step);
+    da->SetDataTime(step);
+
+    if (!aa->Execute(da, nullptr))
+      {
+      SENSEI_ERROR("Failed to execute the " << mode << " analyses")
+      status = -1;
+      }
+
+    da->ReleaseData();
+    }
+
+  aa->Finalize();
+
+  aa->Delete();
+  da->Delete();
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+std::string fileName(const char *mode, int nBins, int step)
+{
+  std::ostringstream oss;
+  oss << mode << "_" << nBins << "_mesh_values_" << step << ".txt";
+  return oss.str();
+}
+
+// --------------------------------------------------------------------------
+int readFile(const std::string &name, std::string &contents)
+{
+  std::ifstream ifs(name);
+  if (!ifs)
+    {
+    SENSEI_ERROR("Failed to read \"" << name << "\"")
+    return -1;
+    }
+
+  std::ostringstream oss;
+  oss << ifs.rdbuf();
+  contents = oss.str();
+
+  return 0;
+}
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 8;
+
+  values = svtkSmartPointer<svtkDoubleArray>::New();
+  values->SetName("values");
+  values->SetNumberOfTuples(gnx*gny);
+
+  const char *modes[] = {"serial", "concurrent", "async"};
+
+  int status = 0;
+  for (const char *mode : modes)
+    status |= run(mode, nSteps, rank);
+
+  // the histograms are written by rank 0. those of the serial run are the
+  // reference
+  if (rank == 0)
+    {
+    for (int nBins : bins)
+      {
+      for (int step = 0; step < nSteps; ++step)
+        {
+        std::string ref;
+        if (readFile(fileName("serial", nBins, step), ref))
+          {
+          status = -1;
+          continue;
+          }
+
+        for (int i = 1; i < 3; ++i)
+          {
+          std::string hist;
+          if (readFile(fileName(modes[i], nBins, step), hist))
+            {
+            status = -1;
+            }
+          else if (hist != ref)
+            {
+            SENSEI_ERROR("The " << modes[i] << " histogram with " << nBins
+              << " bins at step " << step << " differs from the serial one"
+              << std::endl << hist << std::endl << ref)
+            status = -1;
+            }
+          }
+        }
+      }
+
+    for (const char *mode : modes)
+      for (int nBins : bins)
+        for (int step = 0; step < nSteps; ++step)
+          remove(fileName(mode, nBins, step).c_str());
+
+    if (status == 0)
+      std::cerr << "The serial, concurrent, and asynchronous analyses"
+        " computed the same histograms" << std::endl;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  values = nullptr;
+
+  MPI_Finalize();
+
+  return status ? -1 : 0;
+}
@@ -0,0 +1,219 @@
+#include "senseiConfig.h"
+#include "AnalysisScheduler.h"
+#include "SVTKDataAdaptor.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <pugixml.hpp>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkPointData.h>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+// Drives the AnalysisScheduler through a series of time steps with one
+// analysis per policy, and checks the steps at which each executes. The
+// solver takes one second per step and each execution half a second. The
+// data array's global maximum, which is reached on the last rank, follows a
+// fixed series.
+//
+// When the profiler is available the fraction of the solver's time used by
+// the analysis with a time budget is checked in the default CSV log. By the
+// last step it executed 4 times, 2 of 20 seconds.
+//
+// usage: testAnalysisScheduler
+
+const char *config =
+  "<sensei>"
+  // every step
+  "  <analysis type=\"a\"/>"
+  // every third step
+  "  <analysis type=\"b\" min_interval=\"3\"/>"
+  // when the max changes by more than 10%
+  "  <analysis type=\"c\">"
+  "    <trigger mesh=\"mesh\" array=\"data\" association=\"point\""
+  "       metric=\"max\" change=\"0.1\"/>"
+  "  </analysis>"
+  // the same, and at least every 4 steps
+  "  <analysis type=\"d\" max_interval=\"4\">"
+  "    <trigger mesh=\"mesh\" array=\"data\" metric=\"max\" change=\"0.1\"/>"
+  "  </analysis>"
+  // at most 12% of the solver time
+  "  <analysis type=\"e\" time_budget=\"0.12\"/>"
+  "</sensei>";
+
+const int nSteps = 20;
+
+const double maxVals[nSteps] = {1.0, 1.05, 1.2, 1.25, 1.3, 1.5, 1.5, 1.5,
+  1.5, 1.5, 1.5, 1.5, 1.5, 1.5, 1.5, 1.0, 1.0, 1.0, 1.0, 1.0};
+
+const std::vector<std::vector<int>> expected = {
+  {0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19},
+  {0,3,6,9,12,15,18},
+  {0,2,5,15},
+  {0,2,5,9,13,15,19},
+  {0,8,12,16}};
+
+// --------------------------------------------------------------------------
+svtkImageData *newMesh(double maxVal, int rank, int nRanks)
+{
+  svtkDoubleArray *da = svtkDoubleArray::New();
+  da->SetName("data");
+  da->SetNumberOfTuples(8);
+  for (int i = 0; i < 8; ++i)
+    da->SetValue(i, maxVal*(rank + 1)/nRanks*i/7.0);
+
+  svtkImageData *im = svtkImageData::New();
+  im->SetDimensions(8, 1, 1);
+  im->GetPointData()->AddArray(da);
+  da->Delete();
+
+  return im;
+}
+
+// --------------------------------------------------------------------------
+// check the number of time fractions recorded for an analysis in the CSV log
+// and the last one's value
+int checkTimeFraction(const std::string &fileName, int id, long nExpected,
+  double expected)
+{
+  std::ostringstream oss;
+  oss << "\"AnalysisScheduler::" << id << "::TimeFraction\"";
+  std::string name = oss.str();
+
+  std::ifstream ifs(fileName);
+  std::string line;
+  long n = 0;
+  double value = 0.0;
+  while (std::getline(ifs, line))
+    {
+    // rank, thread, name, start, end, value, bytes, depth
+    size_t pos = line.find(name);
+    if (pos == std::string::npos)
+      continue;
+
+    pos = line.find(',', pos);
+    pos = line.find(',', pos + 1);
+    pos = line.find(',', pos + 1);
+    value = atof(line.c_str() + pos + 1);
+    ++n;
+    }
+
+  if ((n != nExpected) || (std::fabs(value - expected) > 1e-12))
+    {
+    SENSEI_ERROR("The log \"" << fileName << "\" has " << n << " time "
+      "fractions for analysis " << id << " the last is " << value
+      << ". expected " << nExpected << " and " << expected)
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+#if defined(ENABLE_PROFILER)
+  std::string logFile = "testAnalysisScheduler.csv";
+  sensei::Profiler::SetTimerLogFile(logFile);
+  sensei::Profiler::SetOutputFormat(sensei::Profiler::FORMAT_CSV);
+  sensei::Profiler::Enable(0x01);
+  sensei::Profiler::Initialize();
+#endif
+
+  pugi::xml_document doc;
+  doc.load_string(config);
+
+  sensei::AnalysisScheduler scheduler;
+
+  unsigned int nAnalyses = 0;
+  pugi::xml_node root = doc.child("sensei");
+  for (pugi::xml_node node = root.child("analysis"); node;
+    node = node.next_sibling("analysis"))
+    {
+    if (scheduler.AddAnalyses(++nAnalyses, node))
+      {
+      SENSEI_ERROR("Failed to add analysis " << nAnalyses)
+      MPI_Abort(MPI_COMM_WORLD, -1);
+      }
+    }
+
+  int status = 0;
+  std::vector<std::vector<int>> executed(nAnalyses);
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkImageData *im = newMesh(maxVals[step], rank, nRanks);
+
+    sensei::SVTKDataAdaptor *data = sensei::SVTKDataAdaptor::New();
+    data->SetDataTimeStep(step);
+    data->SetDataObject("mesh", im);
+    im->Delete();
+
+    // ranks measure different times, the max is used
+    std::vector<int> execute;
+    if (scheduler.Schedule(MPI_COMM_WORLD, data, rank ? 0.5 : 1.0, execute))
+      {
+      SENSEI_ERROR("Failed to schedule step " << step)
+      status = -1;
+      }
+
+    for (unsigned int i = 0; i < execute.size(); ++i)
+      {
+      if (execute[i])
+        {
+        executed[i].push_back(step);
+        scheduler.SetExecutionTime(i, rank ? 0.25 : 0.5);
+        }
+      }
+
+    data->ReleaseData();
+    data->Delete();
+    }
+
+  for (unsigned int i = 0; i < nAnalyses; ++i)
+    {
+    // executions are counted for the analyses that have a policy
+    if ((executed[i] != expected[i]) || (scheduler.GetActive(i) != (i > 0)) ||
+      (i && ((scheduler.GetNumberOfExecutions(i) != long(expected[i].size())) ||
+      (scheduler.GetNumberOfSteps(i) != nSteps))))
+      {
+      std::ostringstream oss;
+      for (int step : executed[i])
+        oss << " " << step;
+      SENSEI_ERROR("Analysis " << i << " executed at steps" << oss.str())
+      status = -1;
+      }
+    }
+
+#if defined(ENABLE_PROFILER)
+  sensei::Profiler::Finalize();
+
+  if (rank == 0)
+    {
+    if (checkTimeFraction(logFile, 4, long(nRanks)*nSteps, 0.1))
+      status = -1;
+    remove(logFile.c_str());
+    }
+#endif
+
+  if ((status == 0) && (rank == 0))
+    std::cerr << "The analyses executed as scheduled" << std::endl;
+
+  MPI_Finalize();
+
+  return status;
+}
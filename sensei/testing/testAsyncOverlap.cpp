@@ -0,0 +1,225 @@
+#include "AsyncAnalysisAdaptor.h"
+#include "SVTKDataAdaptor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <svtkCompositeDataIterator.h>
+#include <svtkCompositeDataSet.h>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkPointData.h>
+#include <svtkObjectFactory.h>
+#include <svtkSmartPointer.h>
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+// Measures how much of an analysis executed asynchronously on zero-copy
+// snapshots overlaps with the simulation. The simulation and the analysis
+// each take a fixed time per step. The simulation updates its data either
+// in place, calling PrepareToModify which waits for the analysis, or in a
+// buffer that the analysis does not reference, chosen by the reference
+// count of the arrays, as the oscillator miniapp does. With fresh buffers
+// the run must take markedly less than the sum of the simulation and
+// analysis times. In both cases the analysis checks that the data it is
+// processing was not modified while it ran.
+//
+// usage: testAsyncOverlap [num steps] [ms per step]
+
+using seconds_t =
+  std::chrono::duration<double, std::chrono::seconds::period>;
+
+// checks the data of each step after taking its time
+class SlowAnalysis : public sensei::AnalysisAdaptor
+{
+public:
+  static SlowAnalysis *New();
+  senseiTypeMacro(SlowAnalysis, sensei::AnalysisAdaptor);
+
+  bool Execute(sensei::DataAdaptor *data, sensei::DataAdaptor **) override
+  {
+    long step = data->GetDataTimeStep();
+
+    svtkDataObject *mesh = nullptr;
+    if (data->GetMesh("mesh", false, mesh) ||
+      data->AddArray(mesh, "mesh", svtkDataObject::POINT, "data"))
+      {
+      SENSEI_ERROR("Failed to get the data of step " << step)
+      return false;
+      }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(this->Delay));
+
+    // the adaptor presents the image as a block of a composite dataset
+    bool ok = true;
+    svtkCompositeDataIterator *it =
+      svtkCompositeDataSet::SafeDownCast(mesh)->NewIterator();
+    for (it->InitTraversal(); ok && !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      svtkDoubleArray *da = svtkDoubleArray::SafeDownCast(
+        svtkDataSet::SafeDownCast(it->GetCurrentDataObject())->
+        GetPointData()->GetArray("data"));
+
+      ok = da && (da->GetNumberOfTuples() == 1024);
+      svtkIdType n = ok ? da->GetNumberOfTuples() : 0;
+      for (svtkIdType i = 0; ok && (i < n); ++i)
+        ok = da->GetValue(i) == step;
+      }
+    it->Delete();
+
+    mesh->Delete();
+
+    if (!ok)
+      {
+      SENSEI_ERROR("The data of step " << step
+        << " was missing or modified while it was processed")
+      return false;
+      }
+
+    return true;
+  }
+
+  int Finalize() override { return 0; }
+
+  int Delay = 0;
+};
+
+senseiNewMacro(SlowAnalysis);
+
+// --------------------------------------------------------------------------
+int run(bool freshBuffers, int nSteps, int delay, double &runTime,
+  int &nBuffers)
+{
+  SlowAnalysis *analysis = SlowAnalysis::New();
+  analysis->Delay = delay;
+
+  sensei::AsyncAnalysisAdaptor *async = sensei::AsyncAnalysisAdaptor::New();
+  async->SetAnalysisAdaptor(analysis);
+  async->SetSnapshotMode(sensei::AsyncAnalysisAdaptor::ZERO_COPY);
+
+  if (async->Initialize() || !async->GetAsynchronous())
+    {
+    SENSEI_ERROR("Failed to initialize asynchronous execution")
+    return -1;
+    }
+
+  // the simulation's buffers. a buffer referenced only from here is not in
+  // use by the analysis
+  std::vector<svtkSmartPointer<svtkDoubleArray>> buffers;
+
+  std::chrono::high_resolution_clock::time_point t0 =
+    std::chrono::high_resolution_clock::now();
+
+  int status = 0;
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkDoubleArray *da = nullptr;
+    if (freshBuffers)
+      {
+      for (unsigned int i = 0; !da && (i < buffers.size()); ++i)
+        if (buffers[i]->GetReferenceCount() == 1)
+          da = buffers[i];
+      }
+    else if (!buffers.empty())
+      {
+      if (async->PrepareToModify())
+        {
+        SENSEI_ERROR("Failed to prepare to modify step " << step)
+        status = -1;
+        }
+      da = buffers[0];
+      }
+
+    if (!da)
+      {
+      buffers.push_back(svtkSmartPointer<svtkDoubleArray>::New());
+      da = buffers.back();
+      da->SetName("data");
+      da->SetNumberOfTuples(1024);
+      }
+
+    // the simulation updates its data
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    for (int i = 0; i < 1024; ++i)
+      da->SetValue(i, step);
+
+    svtkImageData *im = svtkImageData::New();
+    im->SetDimensions(1024, 1, 1);
+    im->GetPointData()->AddArray(da);
+
+    sensei::SVTKDataAdaptor *data = sensei::SVTKDataAdaptor::New();
+    data->SetDataTimeStep(step);
+    data->SetDataObject("mesh", im);
+    im->Delete();
+
+    if (!async->Execute(data, nullptr))
+      {
+      SENSEI_ERROR("Failed to execute step " << step)
+      status = -1;
+      }
+
+    data->ReleaseData();
+    data->Delete();
+    }
+
+  if (async->Finalize())
+    {
+    SENSEI_ERROR("Failed to finalize")
+    status = -1;
+    }
+
+  std::chrono::high_resolution_clock::time_point t1 =
+    std::chrono::high_resolution_clock::now();
+
+  runTime = seconds_t(t1 - t0).count();
+  nBuffers = buffers.size();
+
+  async->Delete();
+  analysis->Delete();
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 10;
+  int delay = argc > 2 ? atoi(argv[2]) : 50;
+
+  // the time taken when the simulation and analysis are serialized
+  double serialTime = 2.0e-3*nSteps*delay;
+
+  int status = 0;
+
+  double inPlaceTime = 0.0;
+  int nInPlaceBuffers = 0;
+  status |= run(false, nSteps, delay, inPlaceTime, nInPlaceBuffers);
+
+  double freshTime = 0.0;
+  int nFreshBuffers = 0;
+  status |= run(true, nSteps, delay, freshTime, nFreshBuffers);
+
+  std::cerr << "serialized " << serialTime << " s, in place with"
+    " PrepareToModify " << inPlaceTime << " s, fresh buffers " << freshTime
+    << " s using " << nFreshBuffers << " buffers" << std::endl;
+
+  // the analysis of one step overlaps the simulation of the next. with one
+  // step in flight two buffers suffice
+  if ((freshTime > 0.75*serialTime) || (nFreshBuffers > 2))
+    {
+    SENSEI_ERROR("The analysis did not overlap the simulation. "
+      << freshTime << " s with " << nFreshBuffers << " buffers")
+    status = -1;
+    }
+
+  MPI_Finalize();
+
+  return status;
+}
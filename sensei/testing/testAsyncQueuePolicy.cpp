@@ -0,0 +1,188 @@
+#include "AsyncAnalysisAdaptor.h"
+#include "SVTKDataAdaptor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkPointData.h>
+#include <svtkObjectFactory.h>
+
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+// Drives an AsyncAnalysisAdaptor wrapping an analysis that is slower than
+// the simulation with each of the queue policies, and checks that all time
+// steps are processed when blocking, that steps are dropped otherwise, and
+// that all ranks process the same steps. The analysis is slower on some
+// ranks than on others, and issues a collective each step which would not
+// match if the ranks dropped different steps.
+//
+// usage: testAsyncQueuePolicy [num steps]
+
+// records the steps it processes
+class SlowAnalysis : public sensei::AnalysisAdaptor
+{
+public:
+  static SlowAnalysis *New();
+  senseiTypeMacro(SlowAnalysis, sensei::AnalysisAdaptor);
+
+  bool Execute(sensei::DataAdaptor *data, sensei::DataAdaptor **) override
+  {
+    long step = data->GetDataTimeStep();
+
+    long maxStep = step;
+    MPI_Allreduce(MPI_IN_PLACE, &maxStep, 1, MPI_LONG, MPI_MAX,
+      this->GetCommunicator());
+
+    if (maxStep != step)
+      {
+      SENSEI_ERROR("Ranks processed different steps " << step
+        << " and " << maxStep)
+      return false;
+      }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(this->Delay));
+
+    this->Steps.push_back(step);
+
+    return true;
+  }
+
+  int Finalize() override { return 0; }
+
+  int Delay = 0;
+  std::vector<long> Steps;
+};
+
+senseiNewMacro(SlowAnalysis);
+
+// --------------------------------------------------------------------------
+int runPolicy(int policy, const char *policyName, int nSteps, int rank)
+{
+  SlowAnalysis *analysis = SlowAnalysis::New();
+  analysis->Delay = rank % 2 ? 8 : 4;
+
+  sensei::AsyncAnalysisAdaptor *async = sensei::AsyncAnalysisAdaptor::New();
+  async->SetAnalysisAdaptor(analysis);
+  async->SetMaxQueueLength(2);
+  async->SetQueuePolicy(policy);
+  async->SetSnapshotMode(sensei::AsyncAnalysisAdaptor::DEEP_COPY);
+
+  if (async->Initialize())
+    {
+    SENSEI_ERROR("Failed to initialize")
+    return -1;
+    }
+
+  // Finalize reverts to synchronous mode
+  bool blocking = (policy == sensei::AsyncAnalysisAdaptor::BLOCK) ||
+    !async->GetAsynchronous();
+
+  int status = 0;
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkDoubleArray *da = svtkDoubleArray::New();
+    da->SetName("data");
+    da->SetNumberOfTuples(8);
+    for (int i = 0; i < 8; ++i)
+      da->SetValue(i, step);
+
+    svtkImageData *im = svtkImageData::New();
+    im->SetDimensions(8, 1, 1);
+    im->GetPointData()->AddArray(da);
+    da->Delete();
+
+    sensei::SVTKDataAdaptor *data = sensei::SVTKDataAdaptor::New();
+    data->SetDataTimeStep(step);
+    data->SetDataObject("mesh", im);
+    im->Delete();
+
+    if (!async->Execute(data, nullptr))
+      {
+      SENSEI_ERROR("Failed to execute step " << step)
+      status = -1;
+      }
+
+    data->ReleaseData();
+    data->Delete();
+
+    // the simulation is faster than the analysis
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+  if (async->Finalize())
+    {
+    SENSEI_ERROR("Failed to finalize")
+    status = -1;
+    }
+
+  long nDropped = async->GetNumberOfDroppedSteps();
+  long nProcessed = analysis->Steps.size();
+
+  long checkSum = 0;
+  for (long i = 0; i < nProcessed; ++i)
+    checkSum += (i + 1)*analysis->Steps[i];
+
+  // all ranks process the same steps
+  long vals[6] = {nProcessed, -nProcessed, nDropped, -nDropped,
+    checkSum, -checkSum};
+
+  MPI_Allreduce(MPI_IN_PLACE, vals, 6, MPI_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+  if ((vals[0] != -vals[1]) || (vals[2] != -vals[3]) || (vals[4] != -vals[5]))
+    {
+    SENSEI_ERROR("Using " << policyName << " ranks processed " << nProcessed
+      << " steps and dropped " << nDropped << " differently")
+    status = -1;
+    }
+
+  if ((nProcessed + nDropped != nSteps) || (blocking && nDropped) ||
+    (!blocking && !nDropped))
+    {
+    SENSEI_ERROR("Using " << policyName << " processed " << nProcessed
+      << " and dropped " << nDropped << " of " << nSteps << " steps")
+    status = -1;
+    }
+
+  if ((status == 0) && (rank == 0))
+    {
+    std::cerr << policyName << " processed " << nProcessed << " and dropped "
+      << nDropped << " of " << nSteps << " steps" << std::endl;
+    }
+
+  async->Delete();
+  analysis->Delete();
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 32;
+
+  int status = 0;
+  status |= runPolicy(sensei::AsyncAnalysisAdaptor::BLOCK,
+    "block", nSteps, rank);
+
+  status |= runPolicy(sensei::AsyncAnalysisAdaptor::DROP_NEWEST,
+    "drop_newest", nSteps, rank);
+
+  status |= runPolicy(sensei::AsyncAnalysisAdaptor::DROP_OLDEST,
+    "drop_oldest", nSteps, rank);
+
+  MPI_Finalize();
+
+  return status;
+}
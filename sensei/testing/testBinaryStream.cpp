@@ -0,0 +1,269 @@
+#include "BinaryStream.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Checks packing into a BinaryStream, unpacking from a non-owning view with
+// and without copies, and broadcasting over a communicator other than
+// MPI_COMM_WORLD from a root other than 0. Then measures the throughput of
+// MeshMetadata::ToStream and FromStream on metadata describing a large
+// number of blocks, and checks that the metadata survives the round trip.
+//
+// usage: testBinaryStream [number of blocks] [repetitions]
+
+using clockType = std::chrono::high_resolution_clock;
+using secondsType = std::chrono::duration<double>;
+
+// --------------------------------------------------------------------------
+int checkPackUnpack()
+{
+  int status = 0;
+
+  // pack enough values for many reallocations
+  unsigned long n = 100000;
+  std::vector<double> vals(n);
+  std::iota(vals.begin(), vals.end(), 0.0);
+
+  sensei::BinaryStream bs;
+  for (unsigned long i = 0; i < n; ++i)
+    bs.Pack(vals[i]);
+  bs.Pack(vals);
+
+  if (bs.Size() != (2*n*sizeof(double) + sizeof(unsigned long)))
+    {
+    SENSEI_ERROR("Wrong size " << bs.Size())
+    status = -1;
+    }
+
+  // unpacking from a view references the packed data
+  sensei::BinaryStream view(bs.GetData(), bs.Size());
+  view.SetReadPos(n*sizeof(double));
+
+  const double *pvals = nullptr;
+  unsigned long nv = view.UnpackView(pvals);
+
+  if (!view.IsView() || (nv != n) ||
+    ((const unsigned char*)pvals != bs.GetData() + (n*sizeof(double) +
+    sizeof(unsigned long))) || !std::equal(vals.begin(), vals.end(), pvals))
+    {
+    SENSEI_ERROR("Unpacking a view copied the data or unpacked wrong values")
+    status = -1;
+    }
+
+  // and unpacking with a copy gives the same values
+  std::vector<double> vals2;
+  view.SetReadPos(n*sizeof(double));
+  view.Unpack(vals2);
+
+  if (vals2 != vals)
+    {
+    SENSEI_ERROR("Unpacking from a view unpacked wrong values")
+    status = -1;
+    }
+
+  // packing into a view copies it, leaving the original data untouched
+  view.Pack(1.0);
+  if (view.IsView() || (view.GetData() == bs.GetData()) ||
+    (view.Size() != bs.Size() + sizeof(double)))
+    {
+    SENSEI_ERROR("Packing into a view did not copy it")
+    status = -1;
+    }
+
+  // also when packing over data already in the view
+  sensei::BinaryStream view2(bs.GetData(), bs.Size());
+  view2.SetWritePos(0);
+  view2.Pack(-1.0);
+
+  double v0 = 0.0;
+  view2.SetReadPos(0);
+  view2.Unpack(v0);
+
+  if (view2.IsView() || (view2.GetData() == bs.GetData()) || (v0 != -1.0) ||
+    (*(const double*)bs.GetData() != vals[0]))
+    {
+    SENSEI_ERROR("Packing into a view after SetWritePos modified the data")
+    status = -1;
+    }
+
+  // vectors of arrays
+  std::vector<std::array<int,6>> exts(1000);
+  for (unsigned int i = 0; i < exts.size(); ++i)
+    exts[i] = {int(i), int(i) + 1, 2, 3, 4, int(5*i)};
+
+  sensei::BinaryStream abs;
+  abs.Pack(exts);
+
+  std::vector<std::array<int,6>> exts2;
+  abs.Unpack(exts2);
+
+  if (exts2 != exts)
+    {
+    SENSEI_ERROR("Wrong vector of arrays unpacked")
+    status = -1;
+    }
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int checkBroadcast()
+{
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // broadcast from the last rank of each half of the ranks
+  MPI_Comm comm = MPI_COMM_NULL;
+  MPI_Comm_split(MPI_COMM_WORLD, rank % 2, rank, &comm);
+
+  int subRank = 0;
+  int subRanks = 1;
+  MPI_Comm_rank(comm, &subRank);
+  MPI_Comm_size(comm, &subRanks);
+
+  int root = subRanks - 1;
+
+  sensei::BinaryStream bs;
+  std::string msg = "broadcast from " + std::to_string(rank);
+  if (subRank == root)
+    {
+    bs.Pack(msg);
+    for (int i = 0; i < 100000; ++i)
+      bs.Pack(i);
+    }
+
+  bs.Broadcast(comm, root);
+
+  int status = 0;
+
+  std::string rmsg;
+  bs.Unpack(rmsg);
+
+  std::vector<int> ints(100000);
+  bs.Unpack(ints.data(), ints.size());
+
+  int rootRank = rank;
+  MPI_Bcast(&rootRank, 1, MPI_INT, root, comm);
+  msg = "broadcast from " + std::to_string(rootRank);
+
+  for (int i = 0; i < 100000; ++i)
+    {
+    if (ints[i] != i)
+      {
+      status = -1;
+      break;
+      }
+    }
+
+  if ((rmsg != msg) || status)
+    {
+    SENSEI_ERROR("Wrong data broadcast")
+    status = -1;
+    }
+
+  MPI_Comm_free(&comm);
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+sensei::MeshMetadataPtr newMetadata(int nBlocks)
+{
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "mesh";
+  md->NumBlocks = nBlocks;
+  md->NumBlocksLocal = {nBlocks};
+  md->NumArrays = 2;
+  md->ArrayName = {"pressure", "velocity"};
+  md->ArrayCentering = {0, 1};
+  md->ArrayComponents = {1, 3};
+  md->ArrayType = {11, 11};
+  md->ArrayRange = {{{0.0, 1.0}}, {{-1.0, 1.0}}};
+
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    md->BlockOwner.push_back(i % 64);
+    md->BlockIds.push_back(i);
+    md->BlockNumPoints.push_back(4913);
+    md->BlockNumCells.push_back(4096);
+    md->BlockCellArraySize.push_back(0);
+    md->BlockExtents.push_back({16*i, 16*(i + 1), 0, 16, 0, 16});
+    md->BlockBounds.push_back({1.0*i, i + 1.0, 0.0, 1.0, 0.0, 1.0});
+    md->BlockArrayRange.push_back({{{0.0, 1.0*i}}, {{-1.0*i, 1.0}}});
+    }
+
+  return md;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nBlocks = argc > 1 ? atoi(argv[1]) : 100000;
+  int nReps = argc > 2 ? atoi(argv[2]) : 10;
+
+  int status = 0;
+  if (checkPackUnpack() || checkBroadcast())
+    status = -1;
+
+  // measure the throughput of metadata serialization
+  sensei::MeshMetadataPtr md = newMetadata(nBlocks);
+
+  double packTime = 0.0;
+  double unpackTime = 0.0;
+  unsigned long nBytes = 0;
+  for (int i = 0; i < nReps; ++i)
+    {
+    sensei::BinaryStream bs;
+
+    clockType::time_point t0 = clockType::now();
+    md->ToStream(bs);
+    clockType::time_point t1 = clockType::now();
+
+    sensei::MeshMetadataPtr md2 = sensei::MeshMetadata::New();
+    md2->FromStream(bs);
+    clockType::time_point t2 = clockType::now();
+
+    packTime += secondsType(t1 - t0).count();
+    unpackTime += secondsType(t2 - t1).count();
+    nBytes = bs.Size();
+
+    if ((md2->BlockIds != md->BlockIds) ||
+      (md2->BlockExtents != md->BlockExtents) ||
+      (md2->BlockBounds != md->BlockBounds) ||
+      (md2->BlockArrayRange != md->BlockArrayRange) ||
+      (md2->ArrayName != md->ArrayName))
+      {
+      SENSEI_ERROR("The metadata changed in the round trip")
+      status = -1;
+      break;
+      }
+    }
+
+  if (rank == 0)
+    {
+    double mb = double(nBytes)*nReps/(1024.0*1024.0);
+    std::cerr << "MeshMetadata with " << nBlocks << " blocks is " << nBytes
+      << " bytes. ToStream " << mb/packTime << " MiB/s FromStream "
+      << mb/unpackTime << " MiB/s" << std::endl;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return status;
+}
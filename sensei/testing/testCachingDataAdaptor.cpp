@@ -0,0 +1,224 @@
+#include "CachingDataAdaptor.h"
+#include "SVTKDataAdaptor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkCompositeDataSet.h>
+#include <svtkCompositeDataIterator.h>
+#include <svtkPointData.h>
+#include <svtkUnsignedCharArray.h>
+#include <svtkObjectFactory.h>
+
+#include <string>
+#include <iostream>
+
+// Checks that the CachingDataAdaptor fetches each mesh, array, and ghost
+// array from the decorated adaptor once per time step no matter how many
+// times it is requested, and that the hit and miss counts and byte totals
+// account for all of the requests. Each step a number of clients, standing
+// in for the analyses of a ConfigurableAnalysis, request the same data.
+//
+// usage: testCachingDataAdaptor [num clients] [num steps] [num values]
+
+// serves the ghost nodes array and counts the calls made by the cache
+class CountingDataAdaptor : public sensei::SVTKDataAdaptor
+{
+public:
+  static CountingDataAdaptor *New();
+  senseiTypeMacro(CountingDataAdaptor, sensei::SVTKDataAdaptor);
+
+  int GetMesh(const std::string &meshName, bool structureOnly,
+    svtkDataObject *&mesh) override
+  {
+    ++this->NumGetMesh;
+    return this->Superclass::GetMesh(meshName, structureOnly, mesh);
+  }
+
+  int AddGhostNodesArray(svtkDataObject *mesh,
+    const std::string &meshName) override
+  {
+    ++this->NumAddGhosts;
+    return this->Superclass::AddArray(mesh, meshName, svtkDataObject::POINT,
+      "svtkGhostType");
+  }
+
+  int AddArray(svtkDataObject *mesh, const std::string &meshName,
+    int association, const std::string &arrayName) override
+  {
+    ++this->NumAddArray;
+    return this->Superclass::AddArray(mesh, meshName, association, arrayName);
+  }
+
+  int NumGetMesh = 0;
+  int NumAddGhosts = 0;
+  int NumAddArray = 0;
+};
+
+senseiNewMacro(CountingDataAdaptor);
+
+// --------------------------------------------------------------------------
+svtkImageData *newMesh(long nVals)
+{
+  svtkDoubleArray *da = svtkDoubleArray::New();
+  da->SetName("data");
+  da->SetNumberOfTuples(nVals);
+
+  svtkUnsignedCharArray *ghosts = svtkUnsignedCharArray::New();
+  ghosts->SetName("svtkGhostType");
+  ghosts->SetNumberOfTuples(nVals);
+
+  for (long i = 0; i < nVals; ++i)
+    {
+    da->SetValue(i, i);
+    ghosts->SetValue(i, (i == 0) || (i == nVals - 1) ? 1 : 0);
+    }
+
+  svtkImageData *im = svtkImageData::New();
+  im->SetDimensions(nVals, 1, 1);
+  im->GetPointData()->AddArray(da);
+  im->GetPointData()->AddArray(ghosts);
+
+  da->Delete();
+  ghosts->Delete();
+
+  return im;
+}
+
+// --------------------------------------------------------------------------
+// request the data as an analysis would. returns the number of values in
+// the data array or -1 if there was an error
+long fetch(sensei::DataAdaptor *da, bool structureOnly)
+{
+  svtkDataObject *dobj = nullptr;
+  if (da->GetMesh("mesh", structureOnly, dobj) ||
+    da->AddGhostNodesArray(dobj, "mesh") ||
+    da->AddArray(dobj, "mesh", svtkDataObject::POINT, "data"))
+    {
+    SENSEI_ERROR("Failed to fetch the data")
+    if (dobj)
+      dobj->Delete();
+    return -1;
+    }
+
+  // the adaptor serves the image as a block of a multiblock dataset
+  long nVals = -1;
+  svtkCompositeDataSet *cd = dynamic_cast<svtkCompositeDataSet*>(dobj);
+  svtkCompositeDataIterator *it = cd ? cd->NewIterator() : nullptr;
+  if (it)
+    {
+    it->InitTraversal();
+    svtkImageData *im = it->IsDoneWithTraversal() ? nullptr :
+      dynamic_cast<svtkImageData*>(it->GetCurrentDataObject());
+
+    svtkDataArray *data = im ? im->GetPointData()->GetArray("data") : nullptr;
+    svtkDataArray *ghosts = im ?
+      im->GetPointData()->GetArray("svtkGhostType") : nullptr;
+
+    if (data && ghosts &&
+      (data->GetNumberOfTuples() == ghosts->GetNumberOfTuples()))
+      nVals = data->GetNumberOfTuples();
+
+    it->Delete();
+    }
+
+  dobj->Delete();
+
+  return nVals;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int nClients = argc > 1 ? atoi(argv[1]) : 4;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 3;
+  long nVals = argc > 3 ? atol(argv[3]) : 1000;
+
+  // bytes moved by each request of the arrays
+  long long arrayBytes = nVals*(sizeof(double) + sizeof(unsigned char));
+
+  sensei::CachingDataAdaptor *cache = sensei::CachingDataAdaptor::New();
+
+  int status = 0;
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkImageData *im = newMesh(nVals);
+
+    CountingDataAdaptor *source = CountingDataAdaptor::New();
+    source->SetDataTimeStep(step);
+    source->SetDataTime(step);
+    source->SetDataObject("mesh", im);
+    im->Delete();
+
+    cache->SetDataAdaptor(source);
+    cache->ResetStatistics();
+
+    // the first client needs the geometry, the rest only the structure.
+    // all are served from the full mesh
+    for (int i = 0; i < nClients; ++i)
+      {
+      if (fetch(cache, i > 0) != nVals)
+        {
+        SENSEI_ERROR("Client " << i << " got the wrong data at step " << step)
+        status = -1;
+        }
+      }
+
+    if ((source->NumGetMesh != 1) || (source->NumAddGhosts != 1) ||
+      (source->NumAddArray != 1))
+      {
+      SENSEI_ERROR("The cache made " << source->NumGetMesh << " GetMesh, "
+        << source->NumAddGhosts << " AddGhostNodesArray, and "
+        << source->NumAddArray << " AddArray calls at step " << step
+        << " but expected one of each")
+      status = -1;
+      }
+
+    sensei::CachingDataAdaptor::StatisticsType stats;
+    cache->GetStatistics(stats);
+
+    if ((stats.MeshMisses != 1) || (stats.MeshHits != nClients - 1) ||
+      (stats.ArrayMisses != 2) || (stats.ArrayHits != 2*(nClients - 1)) ||
+      (stats.BytesServed < (nClients - 1)*arrayBytes) ||
+      (stats.BytesFetched < arrayBytes))
+      {
+      SENSEI_ERROR("Wrong statistics at step " << step << ". mesh hits "
+        << stats.MeshHits << " misses " << stats.MeshMisses << " array hits "
+        << stats.ArrayHits << " misses " << stats.ArrayMisses << " bytes served "
+        << stats.BytesServed << " fetched " << stats.BytesFetched)
+      status = -1;
+      }
+
+    // after the data is released the next request is a miss
+    cache->ReleaseData();
+
+    if (fetch(cache, false) != nVals)
+      {
+      SENSEI_ERROR("Failed to fetch after release at step " << step)
+      status = -1;
+      }
+
+    if ((source->NumGetMesh != 2) || (source->NumAddArray != 2))
+      {
+      SENSEI_ERROR("ReleaseData did not invalidate the cache at step " << step)
+      status = -1;
+      }
+
+    cache->SetDataAdaptor(nullptr);
+    source->Delete();
+
+    std::cerr << "step " << step << " served " << stats.MeshHits << " meshes and "
+      << stats.ArrayHits << " arrays (" << stats.BytesServed << " bytes) from "
+      << stats.MeshMisses << " meshes and " << stats.ArrayMisses << " arrays ("
+      << stats.BytesFetched << " bytes) fetched" << std::endl;
+    }
+
+  cache->Delete();
+
+  MPI_Finalize();
+
+  return status;
+}
@@ -0,0 +1,141 @@
+#include "MeshMetadata.h"
+#include "MPIUtils.h"
+#include "STLUtils.h"
+#include "Error.h"
+
+#include <mpi.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Checks the global view made by MeshMetadata::GlobalizeView against one made
+// field by field with MPIUtils::GlobalViewV. Each rank has a different number
+// of blocks, some none at all. The views are compared for a number of steps
+// with global view caching of a static mesh disabled and enabled. The array
+// ranges change every step and must be current when the cached decomposition
+// is used. Halfway the decomposition changes, after which the cached view
+// must no longer be used.
+//
+// usage: testGlobalizeView [steps]
+
+using namespace sensei::STLUtils;
+
+// --------------------------------------------------------------------------
+sensei::MeshMetadataPtr newLocalView(int rank, int step, int nSteps)
+{
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "mesh";
+  md->StaticMesh = 1;
+  md->NumArrays = 2;
+  md->ArrayRange.resize(2);
+
+  // change the decomposition halfway through
+  int nLocal = (rank + (2*step >= nSteps ? 1 : 0)) % 3;
+  md->NumBlocks = nLocal;
+  md->NumBlocksLocal = {nLocal};
+
+  for (int i = 0; i < nLocal; ++i)
+    {
+    int bid = 10*rank + i;
+    md->BlockOwner.push_back(rank);
+    md->BlockIds.push_back(bid);
+    md->BlockNumPoints.push_back(8*(bid + 1));
+    md->BlockNumCells.push_back(bid + 1);
+    md->BlockExtents.push_back({0, bid, 0, 1, 0, 1});
+    md->BlockBounds.push_back({0.0, bid + 1.0, 0.0, 1.0, 0.0, 1.0});
+    md->BlockArrayRange.push_back({{{-1.0*step, 1.0*bid}},
+      {{0.0, 1.0*step*bid}}});
+    }
+
+  return md;
+}
+
+// --------------------------------------------------------------------------
+template <typename vec_t>
+int compare(const char *name, const vec_t &a, const vec_t &b)
+{
+  if (a != b)
+    {
+    SENSEI_ERROR(<< name << " is " << a << " but should be " << b)
+    return -1;
+    }
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int checkView(MPI_Comm comm, int rank, int step, int nSteps)
+{
+  sensei::MeshMetadataPtr md = newLocalView(rank, step, nSteps);
+  md->GlobalizeView(comm);
+
+  sensei::MeshMetadataPtr ref = newLocalView(rank, step, nSteps);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockOwner);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockIds);
+  sensei::MPIUtils::GlobalViewV(comm, ref->NumBlocksLocal);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockNumPoints);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockNumCells);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockExtents);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockBounds);
+  sensei::MPIUtils::GlobalViewV(comm, ref->BlockArrayRange);
+  ReduceRange(ref->BlockArrayRange, ref->ArrayRange);
+
+  int status = 0;
+  if (compare("BlockOwner", md->BlockOwner, ref->BlockOwner) ||
+    compare("BlockIds", md->BlockIds, ref->BlockIds) ||
+    compare("NumBlocksLocal", md->NumBlocksLocal, ref->NumBlocksLocal) ||
+    compare("BlockNumPoints", md->BlockNumPoints, ref->BlockNumPoints) ||
+    compare("BlockNumCells", md->BlockNumCells, ref->BlockNumCells) ||
+    compare("BlockExtents", md->BlockExtents, ref->BlockExtents) ||
+    compare("BlockBounds", md->BlockBounds, ref->BlockBounds) ||
+    compare("BlockArrayRange", md->BlockArrayRange, ref->BlockArrayRange) ||
+    compare("ArrayRange", md->ArrayRange, ref->ArrayRange))
+    status = -1;
+
+  if (md->NumBlocks != int(ref->BlockIds.size()))
+    {
+    SENSEI_ERROR("NumBlocks is " << md->NumBlocks << " but should be "
+      << ref->BlockIds.size())
+    status = -1;
+    }
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 6;
+
+  int status = 0;
+  for (int cache = 0; cache < 2; ++cache)
+    {
+    sensei::MeshMetadata::SetGlobalViewCaching(cache);
+
+    for (int step = 0; step < nSteps; ++step)
+      {
+      if (checkView(MPI_COMM_WORLD, rank, step, nSteps))
+        {
+        SENSEI_ERROR("Wrong global view at step " << step << " with caching "
+          << (cache ? "enabled" : "disabled"))
+        status = -1;
+        }
+      }
+    }
+
+  sensei::MeshMetadata::SetGlobalViewCaching(false);
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  if ((rank == 0) && (status == 0))
+    std::cerr << "The global views are correct" << std::endl;
+
+  MPI_Finalize();
+
+  return status;
+}
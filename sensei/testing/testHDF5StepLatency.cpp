@@ -0,0 +1,176 @@
+#include "HDF5Schema.h"
+#include "Error.h"
+
+#include <mpi.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+
+// Measures the latency between the writer completing a step of an HDF5
+// per-step stream and the reader opening it. The first half of the ranks
+// write and the second half read. The writer records the wall clock time at
+// which it ends each step and sends these to the reader when done. The
+// reader records the time at which it opens each step. The clocks are
+// assumed to be synchronized, as they are when the ranks share a node.
+//
+// usage: testHDF5StepLatency [num steps] [seconds between steps]
+//          [stream name] [poll interval]
+
+using seconds_t =
+  std::chrono::duration<double, std::chrono::seconds::period>;
+
+// --------------------------------------------------------------------------
+double wallTime()
+{
+  return seconds_t(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// --------------------------------------------------------------------------
+int write(MPI_Comm comm, const std::string &name, int nSteps,
+  double interval, std::vector<double> &closeTime)
+{
+  senseiHDF5::WriteStream *writer = new senseiHDF5::WriteStream(comm, true);
+  writer->Init(name);
+
+  for (int i = 0; i < nSteps; ++i)
+    {
+    // simulate the work of a time step
+    std::this_thread::sleep_for(seconds_t(interval));
+
+    unsigned long step = i;
+    double time = i;
+    if (!writer->AdvanceTimeStep(step, time))
+      {
+      SENSEI_ERROR("Failed to begin step " << i)
+      return -1;
+      }
+
+    // the step is complete, make it available to the reader
+    closeTime[i] = wallTime();
+
+    if (!writer->EndTimeStep())
+      {
+      SENSEI_ERROR("Failed to end step " << i)
+      return -1;
+      }
+    }
+
+  delete writer;
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int read(MPI_Comm comm, const std::string &name, int nSteps,
+  double pollInterval, std::vector<double> &openTime)
+{
+  senseiHDF5::ReadStream *reader = new senseiHDF5::ReadStream(comm, true);
+  reader->m_OpenTimeout = 60.0;
+  reader->m_StepTimeout = 60.0;
+  reader->m_PollInterval = pollInterval;
+
+  if (!reader->Init(name))
+    {
+    SENSEI_ERROR("Failed to open \"" << name << "\"")
+    return -1;
+    }
+
+  int nRead = 0;
+  unsigned long step = 0;
+  double time = 0.0;
+  while ((nRead < nSteps) && reader->AdvanceTimeStep(step, time))
+    {
+    if (step < openTime.size())
+      openTime[step] = wallTime();
+    ++nRead;
+    }
+
+  delete reader;
+
+  if (nRead != nSteps)
+    {
+    SENSEI_ERROR("Read " << nRead << " steps but expected " << nSteps)
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  if (nRanks < 2)
+    {
+    SENSEI_ERROR("At least 2 ranks are required")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  int nSteps = argc > 1 ? atoi(argv[1]) : 10;
+  double interval = argc > 2 ? atof(argv[2]) : 0.1;
+  std::string name = argc > 3 ? argv[3] : "h5latency";
+  double pollInterval = argc > 4 ? atof(argv[4]) : 1.0;
+
+  // the first half of the ranks write, the second half read
+  int nWriters = nRanks / 2;
+  int writer = rank < nWriters;
+  int readerRoot = nWriters;
+
+  MPI_Comm comm = MPI_COMM_NULL;
+  MPI_Comm_split(MPI_COMM_WORLD, writer, rank, &comm);
+
+  std::vector<double> stepTime(nSteps, 0.0);
+  int result = 0;
+
+  if (writer)
+    {
+    result = write(comm, name, nSteps, interval, stepTime);
+    if (rank == 0)
+      MPI_Send(stepTime.data(), nSteps, MPI_DOUBLE, readerRoot, 0, MPI_COMM_WORLD);
+    }
+  else
+    {
+    result = read(comm, name, nSteps, pollInterval, stepTime);
+    if (rank == readerRoot)
+      {
+      std::vector<double> closeTime(nSteps);
+      MPI_Recv(closeTime.data(), nSteps, MPI_DOUBLE, 0, 0,
+        MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+      // report the latency
+      double minLat = std::numeric_limits<double>::max();
+      double maxLat = 0.0;
+      double sumLat = 0.0;
+      for (int i = 0; i < nSteps; ++i)
+        {
+        double lat = std::max(0.0, stepTime[i] - closeTime[i]);
+        minLat = std::min(minLat, lat);
+        maxLat = std::max(maxLat, lat);
+        sumLat += lat;
+        }
+
+      std::cerr << "writer to reader step latency over " << nSteps
+        << " steps with poll interval " << pollInterval << " s: min "
+        << 1.0e3*minLat << " ms, max " << 1.0e3*maxLat << " ms, mean "
+        << 1.0e3*sumLat/nSteps << " ms" << std::endl;
+      }
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &result, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Comm_free(&comm);
+  MPI_Finalize();
+
+  return result;
+}
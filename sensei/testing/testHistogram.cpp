@@ -7,6 +7,7 @@
 #include "Error.h"
 #include "Histogram.h"
 #include "SVTKDataAdaptor.h"
+#include "DataRequirements.h"
 
 //#define GENERATE_SEQUENCE
 //#define GENERATE_HISTOGRAM
@@ -118,14 +119,27 @@ int main(int argc, char **argv)
   for (unsigned int i = 0; i < nVals; ++i)
     *da->GetPointer(i) = vals[i];
 
+  svtkDoubleArray *da2 = svtkDoubleArray::New();
+  da2->DeepCopy(da);
+  da2->SetName("normal_copy");
+
   svtkImageData *im = svtkImageData::New();
   im->SetDimensions(gNx, gNy, gNz);
   im->GetPointData()->AddArray(da);
+  im->GetPointData()->AddArray(da2);
+  da2->Delete();
+
+  // a second mesh with the same data
+  svtkImageData *im2 = svtkImageData::New();
+  im2->SetDimensions(gNx, gNy, gNz);
+  im2->GetPointData()->AddArray(da);
   da->Delete();
 
   sensei::SVTKDataAdaptor *dataAdaptor = sensei::SVTKDataAdaptor::New();
   dataAdaptor->SetDataObject("mesh", im);
+  dataAdaptor->SetDataObject("mesh2", im2);
   im->Delete();
+  im2->Delete();
 
   sensei::Histogram *analysisAdaptor = sensei::Histogram::New();
 
@@ -133,7 +147,6 @@ int main(int argc, char **argv)
      "normal", "");
 
   analysisAdaptor->Execute(dataAdaptor, nullptr);
-  dataAdaptor->Delete();
 
 
   sensei::Histogram::Data result;
@@ -144,6 +157,35 @@ int main(int argc, char **argv)
   analysisAdaptor->Finalize();
   analysisAdaptor->Delete();
 
+  // compute the histograms of multiple arrays on multiple meshes together,
+  // each must match the single array result
+  sensei::DataRequirements reqs;
+  reqs.AddRequirement("mesh", svtkDataObject::POINT,
+    std::vector<std::string>({"normal", "normal_copy"}));
+  reqs.AddRequirement("mesh2", svtkDataObject::POINT, "normal");
+
+  analysisAdaptor = sensei::Histogram::New();
+  analysisAdaptor->Initialize(gNBins, reqs, "");
+  analysisAdaptor->Execute(dataAdaptor, nullptr);
+
+  const char *meshNames[] = {"mesh", "mesh", "mesh2"};
+  const char *arrayNames[] = {"normal", "normal_copy", "normal"};
+  for (int i = 0; i < 3; ++i)
+    {
+    if (analysisAdaptor->GetHistogram(meshNames[i], svtkDataObject::POINT,
+      arrayNames[i], result) ||
+      validateHistogram(result.BinMin, result.BinMax, result.Histogram))
+      {
+      SENSEI_ERROR("Histogram of \"" << arrayNames[i] << "\" on \""
+        << meshNames[i] << "\" is incorrect")
+      status = -1;
+      }
+    }
+
+  analysisAdaptor->Finalize();
+  analysisAdaptor->Delete();
+  dataAdaptor->Delete();
+
   MPI_Finalize();
 
   return status;
@@ -0,0 +1,143 @@
+import sys, gc, time, weakref
+import svtk, svtk.numpy_support as svtknp
+import numpy as np
+
+# Checks that AOS and SOA arrays are shared with NumPy without copies, that
+# the lifetime of shared memory follows the SVTK reference count, and
+# compares the time of a reduction through the array interface, which copies
+# SOA arrays, and through the buffer protocol.
+#
+# usage: testNumpyZeroCopy.py [array size in MB]
+
+size_mb = float(sys.argv[1]) if len(sys.argv) > 1 else 8.0
+n_comps = 3
+n_tups = int(size_mb*2**20/(8*n_comps))
+
+def check(cond, msg):
+    if not cond:
+        sys.stderr.write('ERROR: %s\n'%(msg))
+        sys.exit(-1)
+
+# an AOS array viewed from NumPy
+a = svtk.svtkDoubleArray()
+a.SetNumberOfComponents(n_comps)
+a.SetNumberOfTuples(4)
+for i in range(4*n_comps):
+    a.SetValue(i, i)
+
+na = svtknp.svtk_to_numpy(a)
+check(na.shape == (4, n_comps), 'wrong shape %s'%(str(na.shape)))
+na[2,1] = 42.0
+check(a.GetComponent(2, 1) == 42.0, 'AOS array was copied')
+
+# the view holds a reference to the SVTK array
+del a
+gc.collect()
+check(na[3,2] == 11.0, 'AOS array was released while viewed')
+
+# an SOA array with one component per NumPy array, equally spaced, is viewed
+# as a whole
+blk = np.arange(n_comps*4, dtype=np.float64).reshape(n_comps, 4)
+s = svtk.svtk_array_from_buffer([blk[i] for i in range(n_comps)])
+check(s.GetNumberOfComponents() == n_comps and s.GetNumberOfTuples() == 4,
+      'wrong SOA array size')
+check(s.GetComponent(1, 2) == blk[2,1], 'wrong SOA array value')
+
+ns = svtknp.svtk_to_numpy(s)
+check(np.shares_memory(ns, blk), 'SOA array was copied')
+check(np.array_equal(ns, blk.T), 'wrong SOA array view')
+
+# separately allocated components are copied as a whole when they are not
+# equally spaced, and are always shared one at a time
+comps = [np.full(4, i, dtype=np.float32) for i in range(n_comps)]
+s = svtk.svtk_array_from_buffer(comps)
+ns = svtknp.svtk_to_numpy(s)
+check(ns.shape == (4, n_comps) and ns[1,2] == 2.0, 'wrong SOA array copy')
+nc = np.asarray(s.buffer(1))
+check(np.shares_memory(nc, comps[1]), 'SOA component was copied')
+
+# a SVTK array made from NumPy keeps it alive until it is deleted, not until
+# its Python object is collected
+d = np.arange(8, dtype=np.float64)
+wd = weakref.ref(d)
+im = svtk.svtkImageData()
+da = svtknp.numpy_to_svtk(d)
+da.SetName('data')
+im.GetPointData().AddArray(da)
+del d, da
+gc.collect()
+check(wd() is not None, 'NumPy array was released while in use')
+check(im.GetPointData().GetArray('data').GetComponent(7, 0) == 7.0,
+      'wrong value after the Python object was collected')
+im.GetPointData().RemoveArray('data')
+gc.collect()
+check(wd() is None, 'NumPy array was not released')
+
+# arrays returned by svtk_array_from_buffer and NewInstance are owned by
+# Python, which holds the only reference. arrays returned by accessors are
+# not, and releasing them leaves the reference count unchanged
+d = np.arange(8, dtype=np.float64)
+wd = weakref.ref(d)
+da = svtk.svtk_array_from_buffer(d)
+check(da.GetReferenceCount() == 1,
+      'new array has %d references'%(da.GetReferenceCount()))
+di = da.NewInstance()
+check(di.GetReferenceCount() == 1,
+      'new instance has %d references'%(di.GetReferenceCount()))
+del di
+da.SetName('data')
+im = svtk.svtkImageData()
+im.GetPointData().AddArray(da)
+check(da.GetReferenceCount() == 2, 'AddArray did not take a reference')
+ga = im.GetPointData().GetArray('data')
+check(da.GetReferenceCount() == 2, 'GetArray took a reference')
+del ga
+gc.collect()
+check(da.GetReferenceCount() == 2, 'releasing a borrowed array unreferenced it')
+im.GetPointData().RemoveArray('data')
+check(da.GetReferenceCount() == 1, 'RemoveArray leaked the array')
+del d, da
+gc.collect()
+check(wd() is None, 'NumPy array was not released with its owner')
+
+# a type that cannot be imported raises
+for t in (svtk.SVTK_BIT, svtk.SVTK_STRING, 9999):
+    for obj in (np.arange(4.0), [np.arange(4.0), np.arange(4.0)]):
+        try:
+            svtk.svtk_array_from_buffer(obj, 0, t)
+            check(False, 'type %d was imported'%(t))
+        except TypeError:
+            pass
+
+# DLPack
+if hasattr(np, 'from_dlpack'):
+    a = svtknp.numpy_to_svtk(np.arange(6, dtype=np.int32).reshape(3, 2))
+    nd = np.from_dlpack(a)
+    check(nd.shape == (3, 2) and nd[2,1] == 5, 'wrong DLPack view')
+
+# compare the reductions
+def old_path(arr):
+    return np.array(svtknp.svtk_array_handle(arr), copy=False)
+
+def new_path(arr):
+    return svtknp.svtk_to_numpy(arr)
+
+def reduce(arr, path):
+    t0 = time.perf_counter()
+    val = path(arr).sum()
+    return time.perf_counter() - t0, val
+
+vals = np.random.default_rng(1).random((n_tups, n_comps))
+aos = svtknp.numpy_to_svtk(vals)
+blk = np.ascontiguousarray(vals.T)
+soa = svtk.svtk_array_from_buffer([blk[i] for i in range(n_comps)])
+
+sys.stderr.write('reduction over %g MB\n'%(size_mb))
+for name, arr in (('AOS', aos), ('SOA', soa)):
+    t_old, v_old = reduce(arr, old_path)
+    t_new, v_new = reduce(arr, new_path)
+    check(np.isclose(v_old, v_new), '%s sums differ'%(name))
+    sys.stderr.write('%s array interface %g s, buffer protocol %g s, ' \
+        'speed up %g\n'%(name, t_old, t_new, t_old/max(t_new, 1e-9)))
+
+sys.exit(0)
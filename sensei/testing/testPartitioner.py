@@ -57,3 +57,12 @@ mdOut = p.GetPartition(comm, mdIn)
 if rank == 0:
     sys.stderr.write('== MappedPartitioner ==\n')
     sys.stderr.write('receiver MeshMetadata = %s\n'%(str(mdOut)))
+
+mdIn.BlockNumCells = [(i % 3 + 1)*1000 for i in range(0,numSenderBlocks)]
+p = WeightedPartitioner.New()
+p.SetWeightExpression('cells')
+mdOut = p.GetPartition(comm, mdIn)
+
+if rank == 0:
+    sys.stderr.write('== WeightedPartitioner ==\n')
+    sys.stderr.write('receiver MeshMetadata = %s\n'%(str(mdOut)))
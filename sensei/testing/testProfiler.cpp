@@ -0,0 +1,311 @@
+#include "Profiler.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <sys/time.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+// A microbenchmark of the overhead of recording events. Each thread records
+// nested events using a handful of names, as is typical of TimeEvent marks
+// in the data adaptors, and the rate of events per second per thread is
+// reported.
+//
+// When output formats are given the profiler is finalized and the trace and
+// summary files are checked. The number of events in the trace and the total
+// event count of the summary, reduced across ranks, must match the number of
+// events recorded. Rank 0 flushes before finalization, which
+// must keep its events and statistics for finalization to write, and records
+// and flushes a few more afterwards, which must be appended to the files
+// written by finalization, along with a recorded value. The name of one of
+// the events must be escaped in the trace.
+//
+// usage: testProfiler [num threads] [num events per thread] [csv,trace,summary]
+
+using seconds_t =
+  std::chrono::duration<double, std::chrono::seconds::period>;
+
+// --------------------------------------------------------------------------
+void recordEvents(long nEvents, double &runTime)
+{
+  static const char *names[] = {"testProfiler::outer",
+    "testProfiler::inner_1", "testProfiler::inner_2",
+    "testProfiler::inner_3"};
+
+  std::chrono::high_resolution_clock::time_point t0 =
+    std::chrono::high_resolution_clock::now();
+
+  // each iteration records 4 events
+  long nIts = nEvents / 4;
+  for (long i = 0; i < nIts; ++i)
+    {
+    sensei::Profiler::StartEvent(names[0]);
+    for (int j = 1; j < 4; ++j)
+      {
+      sensei::TimeEvent<128> event(names[j]);
+      }
+    sensei::Profiler::EndEvent(names[0]);
+    }
+
+  std::chrono::high_resolution_clock::time_point t1 =
+    std::chrono::high_resolution_clock::now();
+
+  runTime = seconds_t(t1 - t0).count();
+}
+
+// --------------------------------------------------------------------------
+// time the clock used by the profiler. each event reads it twice.
+double clockTime(long nEvents)
+{
+  std::chrono::high_resolution_clock::time_point t0 =
+    std::chrono::high_resolution_clock::now();
+
+  struct timeval tv;
+  long sum = 0;
+  for (long i = 0; i < 2*nEvents; ++i)
+    {
+    gettimeofday(&tv, nullptr);
+    sum += tv.tv_usec;
+    }
+
+  std::chrono::high_resolution_clock::time_point t1 =
+    std::chrono::high_resolution_clock::now();
+
+  return sum ? seconds_t(t1 - t0).count() : 0.0;
+}
+
+// --------------------------------------------------------------------------
+// check that the trace is a complete JSON document
+int checkTrace(const std::string &fileName, long nExpected,
+  long nValuesExpected)
+{
+  std::ifstream ifs(fileName);
+  std::string trace((std::istreambuf_iterator<char>(ifs)),
+    std::istreambuf_iterator<char>());
+
+  if ((trace.find("{\"displayTimeUnit\"") != 0) ||
+    (trace.rfind("]}") != trace.size() - 3))
+    {
+    SENSEI_ERROR("Invalid trace in \"" << fileName << "\"")
+    return -1;
+    }
+
+  long nEvents = 0;
+  size_t pos = 0;
+  while ((pos = trace.find("\"ph\":\"X\"", pos)) != std::string::npos)
+    {
+    ++nEvents;
+    ++pos;
+    }
+
+  long nValues = 0;
+  pos = 0;
+  while ((pos = trace.find("\"ph\":\"C\"", pos)) != std::string::npos)
+    {
+    ++nValues;
+    ++pos;
+    }
+
+  if ((nEvents != nExpected) || (nValues != nValuesExpected))
+    {
+    SENSEI_ERROR("The trace in \"" << fileName << "\" has " << nEvents
+      << " events and " << nValues << " values but expected " << nExpected
+      << " and " << nValuesExpected)
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// an event name containing characters that are escaped in JSON strings, and
+// the name as it must appear in the trace
+const char *escapedName = "testProfiler::\"quoted\"\\path\t";
+const char *escapedJson = "\"testProfiler::\\\"quoted\\\"\\\\path\\u0009\"";
+
+// check that the name of the event is escaped in the trace
+int checkEscaped(const std::string &fileName)
+{
+  std::ifstream ifs(fileName);
+  std::string trace((std::istreambuf_iterator<char>(ifs)),
+    std::istreambuf_iterator<char>());
+
+  if (trace.find(escapedJson) == std::string::npos)
+    {
+    SENSEI_ERROR("The event name was not escaped in \"" << fileName << "\"")
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+// check that the summary accounts for all of the events
+int checkSummary(const std::string &fileName, long nExpected)
+{
+  std::ifstream ifs(fileName);
+  std::string line;
+  long nEvents = 0;
+  while (std::getline(ifs, line))
+    {
+    if (line.empty() || (line[0] == '#'))
+      continue;
+
+    // name, count, min, max, mean, variance, bytes
+    size_t pos = line.rfind('"');
+    nEvents += atol(line.c_str() + pos + 2);
+    }
+
+  if (nEvents != nExpected)
+    {
+    SENSEI_ERROR("The summary in \"" << fileName << "\" has " << nEvents
+      << " events but expected " << nExpected)
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int provided = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nThreads = argc > 1 ? atoi(argv[1]) : 4;
+  long nEvents = argc > 2 ? atol(argv[2]) : 400000;
+  nEvents = 4*(nEvents/4);
+
+  int format = sensei::Profiler::FORMAT_CSV;
+  bool finalize = argc > 3;
+  if (finalize)
+    {
+    std::string fmts(argv[3]);
+    format = (fmts.find("csv") != std::string::npos ?
+        sensei::Profiler::FORMAT_CSV : 0) |
+      (fmts.find("trace") != std::string::npos ?
+        sensei::Profiler::FORMAT_TRACE : 0) |
+      (fmts.find("summary") != std::string::npos ?
+        sensei::Profiler::FORMAT_SUMMARY : 0);
+    }
+
+  std::string traceFile = "testProfiler.json";
+  std::string summaryFile = "testProfiler_summary.csv";
+
+  sensei::Profiler::SetCommunicator(MPI_COMM_WORLD);
+  sensei::Profiler::SetOutputFormat(format);
+  sensei::Profiler::SetTimerLogFile("testProfiler.csv");
+  sensei::Profiler::SetTraceFile(traceFile);
+  sensei::Profiler::SetSummaryFile(summaryFile);
+  sensei::Profiler::Initialize();
+  sensei::Profiler::Enable(0x01);
+
+  // record events on the threads
+  std::vector<double> runTime(nThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nThreads; ++i)
+    threads.emplace_back(recordEvents, nEvents, std::ref(runTime[i]));
+
+  for (int i = 0; i < nThreads; ++i)
+    threads[i].join();
+
+  // check that all events were recorded
+  std::ostringstream oss;
+  sensei::Profiler::ToStream(oss);
+
+  std::string log = oss.str();
+  long nRecorded = 0;
+  for (size_t i = 0; i < log.size(); ++i)
+    nRecorded += log[i] == '\n' ? 1 : 0;
+
+  long nExpected = (format & (sensei::Profiler::FORMAT_CSV |
+    sensei::Profiler::FORMAT_TRACE)) ? nThreads*nEvents : 0;
+
+  int result = 0;
+  if ((nRecorded != nExpected) || sensei::Profiler::Validate())
+    {
+    SENSEI_ERROR("Recorded " << nRecorded << " events but expected "
+      << nExpected)
+    result = -1;
+    }
+
+  // report the rate
+  double maxTime = 0.0;
+  for (int i = 0; i < nThreads; ++i)
+    maxTime = std::max(maxTime, runTime[i]);
+
+  MPI_Allreduce(MPI_IN_PLACE, &maxTime, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  double clkTime = clockTime(nEvents);
+
+  if (rank == 0)
+    {
+    std::cerr << "recorded " << nEvents << " events on each of " << nThreads
+      << " threads in " << maxTime << " seconds. " << nEvents/maxTime
+      << " events per second per thread, " << 1.0e9*maxTime/nEvents
+      << " ns per event of which " << 1.0e9*clkTime/nEvents
+      << " ns are spent reading the clock" << std::endl;
+    }
+
+  if (finalize)
+    {
+    // a flush keeps the statistics for the summary
+    if (rank == 0)
+      sensei::Profiler::Flush();
+
+    // write the requested formats and check them
+    sensei::Profiler::Finalize();
+
+    long nSummarized = long(nRanks)*nThreads*nEvents;
+
+    if (rank == 0)
+      {
+      if ((format & sensei::Profiler::FORMAT_TRACE) &&
+        checkTrace(traceFile, nSummarized, 0))
+        result = -1;
+
+      if ((format & sensei::Profiler::FORMAT_SUMMARY) &&
+        checkSummary(summaryFile, nSummarized))
+        result = -1;
+
+      // events and a value recorded after finalization are appended by a
+      // flush. one event has a name that must be escaped in the trace
+      double flushTime = 0.0;
+      recordEvents(4, flushTime);
+      sensei::Profiler::StartEvent(escapedName);
+      sensei::Profiler::EndEvent(escapedName);
+      sensei::Profiler::RecordValue("testProfiler::value", 0.125);
+      sensei::Profiler::Flush();
+
+      if ((format & sensei::Profiler::FORMAT_TRACE) &&
+        (checkTrace(traceFile, nSummarized + 5, 1) ||
+        checkEscaped(traceFile)))
+        result = -1;
+
+      if ((format & sensei::Profiler::FORMAT_SUMMARY) &&
+        checkSummary(summaryFile, nSummarized + 6))
+        result = -1;
+      }
+    }
+  else
+    {
+    sensei::Profiler::Disable();
+    }
+
+  MPI_Finalize();
+
+  return result;
+}
@@ -0,0 +1,50 @@
+import sys, time, threading
+
+# Checks that a Python analysis executed asynchronously with a drop policy
+# runs on the background thread, sees the data of the steps it is given, and
+# that steps are dropped while it is busy. Used by
+# testPythonAnalysisAsync.xml.
+
+delay = 0.5
+meshName = 'mesh'
+arrayName = 'values'
+
+initThread = None
+steps = []
+
+def check(cond, msg):
+    if not cond:
+        raise RuntimeError('rank %d: %s'%(comm.Get_rank(), msg))
+
+def Initialize():
+    global initThread
+    initThread = threading.get_ident()
+
+def Execute(adaptor):
+    check(threading.get_ident() != initThread,
+          'Execute was called from the thread that called Initialize')
+
+    mesh = adaptor.GetMesh(meshName, False)
+    adaptor.AddArray(mesh, meshName, 1, arrayName)
+    it = mesh.NewIterator()
+    n = 0
+    while not it.IsDoneWithTraversal():
+        n += it.GetCurrentDataObject().GetCellData() \
+            .GetArray(arrayName).GetNumberOfTuples()
+        it.GoToNextItem()
+    check(n > 0, 'no values in step %d'%(adaptor.GetDataTimeStep()))
+
+    steps.append(adaptor.GetDataTimeStep())
+
+    # let the simulation run ahead so that steps are dropped
+    time.sleep(delay)
+    return True
+
+def Finalize():
+    check(len(steps) > 0, 'no steps were processed')
+    check(steps == sorted(set(steps)), 'steps out of order %s'%(str(steps)))
+    check(len(steps) < 5, 'no steps were dropped')
+    check(steps[-1] == 4, 'the newest step was dropped %s'%(str(steps)))
+    if comm.Get_rank() == 0:
+        sys.stderr.write('processed steps %s\n'%(str(steps)))
+    return 0
@@ -0,0 +1,178 @@
+#include "QuantileSketch.h"
+#include "SVTKDataAdaptor.h"
+#include "SVTKUtils.h"
+#include "DataRequirements.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkPointData.h>
+#include <svtkUnsignedCharArray.h>
+#include <svtkObjectFactory.h>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+
+// Checks the quantiles computed by QuantileSketch over a time window. At
+// step s each rank contributes its share of n values evenly spaced on
+// [s, s + 1), along with ghosted values that must be ignored. With a window
+// of w the data seen at step s is uniform on [s - w + 1, s + 1) once the
+// window has filled, and the q quantile is s - w + 1 + w q.
+//
+// usage: testQuantileSketch [num values] [num steps] [window]
+
+// serves the ghost nodes array along with the mesh
+class GhostDataAdaptor : public sensei::SVTKDataAdaptor
+{
+public:
+  static GhostDataAdaptor *New();
+  senseiTypeMacro(GhostDataAdaptor, sensei::SVTKDataAdaptor);
+
+  int AddGhostNodesArray(svtkDataObject *mesh,
+    const std::string &meshName) override
+  {
+    return this->AddArray(mesh, meshName, svtkDataObject::POINT,
+      "svtkGhostType");
+  }
+};
+
+senseiNewMacro(GhostDataAdaptor);
+
+// --------------------------------------------------------------------------
+svtkImageData *newMesh(long nTotal, int step)
+{
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  long blockSize = nTotal/nRanks;
+  long nLarge = nTotal%nRanks;
+  long nLocal = blockSize + (rank < nLarge ? 1 : 0);
+  long start = rank*blockSize + (rank < nLarge ? rank : nLarge);
+
+  // one ghosted value at each end of the block
+  long nVals = nLocal + 2;
+
+  svtkDoubleArray *da = svtkDoubleArray::New();
+  da->SetName("data");
+  da->SetNumberOfTuples(nVals);
+
+  svtkUnsignedCharArray *ghosts = svtkUnsignedCharArray::New();
+  ghosts->SetName("svtkGhostType");
+  ghosts->SetNumberOfTuples(nVals);
+
+  double *pDa = da->GetPointer(0);
+  unsigned char *pGhosts = ghosts->GetPointer(0);
+
+  pDa[0] = -1.0e6;
+  pGhosts[0] = 1;
+
+  for (long i = 0; i < nLocal; ++i)
+    {
+    pDa[i+1] = step + (start + i + 0.5)/nTotal;
+    pGhosts[i+1] = 0;
+    }
+
+  pDa[nVals-1] = 1.0e6;
+  pGhosts[nVals-1] = 1;
+
+  svtkImageData *im = svtkImageData::New();
+  im->SetDimensions(nVals, 1, 1);
+  im->GetPointData()->AddArray(da);
+  im->GetPointData()->AddArray(ghosts);
+
+  da->Delete();
+  ghosts->Delete();
+
+  return im;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  long nTotal = argc > 1 ? atol(argv[1]) : 100000;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 4;
+  int window = argc > 3 ? atoi(argv[3]) : 2;
+
+  std::vector<double> quantiles({0.0, 0.001, 0.01, 0.1, 0.25, 0.5,
+    0.75, 0.9, 0.99, 0.999, 1.0});
+
+  sensei::DataRequirements reqs;
+  reqs.AddRequirement("mesh", svtkDataObject::POINT, "data");
+
+  sensei::QuantileSketch *sketch = sensei::QuantileSketch::New();
+  if (sketch->Initialize(reqs, quantiles, window, 200.0, ""))
+    {
+    SENSEI_ERROR("Failed to initialize")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  int status = 0;
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkImageData *im = newMesh(nTotal, step);
+
+    GhostDataAdaptor *dataAdaptor = GhostDataAdaptor::New();
+    dataAdaptor->SetDataTimeStep(step);
+    dataAdaptor->SetDataTime(step);
+    dataAdaptor->SetDataObject("mesh", im);
+    im->Delete();
+
+    if (!sketch->Execute(dataAdaptor, nullptr))
+      {
+      SENSEI_ERROR("Failed to execute at step " << step)
+      status = -1;
+      }
+
+    dataAdaptor->Delete();
+
+    if (rank != 0)
+      continue;
+
+    std::vector<double> values;
+    if (sketch->GetQuantiles("mesh", svtkDataObject::POINT, "data", values))
+      {
+      SENSEI_ERROR("Failed to get the quantiles at step " << step)
+      status = -1;
+      continue;
+      }
+
+    // the data in the window is uniform on [lo, step + 1)
+    int nWin = window ? std::min(window, step + 1) : step + 1;
+    double lo = step + 1 - nWin;
+
+    size_t nq = quantiles.size();
+    for (size_t i = 0; i < nq; ++i)
+      {
+      double expected = lo + nWin*quantiles[i];
+      // the error of a t-digest with compression 200 is well within 1% of
+      // the range, and smaller near the tails
+      double err = std::fabs(values[i] - expected)/nWin;
+      double tol = 0.01*std::sqrt(4.0*quantiles[i]*(1.0 - quantiles[i])) + 1.0e-4;
+      if (err > tol)
+        {
+        SENSEI_ERROR("Step " << step << " quantile " << quantiles[i]
+          << " is " << values[i] << " but expected " << expected)
+        status = -1;
+        }
+      }
+    }
+
+  sketch->Finalize();
+  sketch->Delete();
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return status;
+}
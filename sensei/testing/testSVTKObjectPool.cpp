@@ -0,0 +1,191 @@
+#include "SVTKObjectPool.h"
+#include "MemoryProfiler.h"
+#include "Error.h"
+
+#include <svtkCellData.h>
+#include <svtkFloatArray.h>
+#include <svtkImageData.h>
+#include <svtkMultiBlockDataSet.h>
+#include <svtkUnsignedCharArray.h>
+
+#include <iostream>
+#include <vector>
+
+// Builds a multiblock of image data with two cell data arrays per block for
+// a number of steps, in the way a data adaptor would, with the object pool
+// disabled and enabled. With the pool enabled all objects are allocated in
+// the first step and recycled in the following steps. Also checks that
+// objects that are still referenced outside of the pool are not recycled and
+// that arrays are reused when fewer tuples are requested.
+//
+// usage: testSVTKObjectPool [number of blocks] [steps]
+
+// --------------------------------------------------------------------------
+svtkMultiBlockDataSet *newMesh(sensei::SVTKObjectPool &pool, int nBlocks,
+  int step)
+{
+  svtkMultiBlockDataSet *mb = pool.NewObject<svtkMultiBlockDataSet>();
+  mb->SetNumberOfBlocks(nBlocks);
+
+  for (int i = 0; i < nBlocks; ++i)
+    {
+    svtkImageData *im = pool.NewObject<svtkImageData>();
+    im->SetExtent(0, 16, 0, 16, 0, 16);
+
+    svtkIdType nCells = im->GetNumberOfCells();
+
+    svtkFloatArray *data = pool.NewArray<svtkFloatArray>(1, nCells);
+    data->SetName("data");
+    data->FillValue(float(step));
+    im->GetCellData()->AddArray(data);
+    data->Delete();
+
+    svtkUnsignedCharArray *ghosts =
+      pool.NewArray<svtkUnsignedCharArray>(1, nCells);
+    ghosts->SetName("svtkGhostType");
+    ghosts->FillValue(0);
+    im->GetCellData()->AddArray(ghosts);
+    ghosts->Delete();
+
+    mb->SetBlock(i, im);
+    im->Delete();
+    }
+
+  return mb;
+}
+
+// --------------------------------------------------------------------------
+int checkCounts(const char *what, long long nNew, long long nReused)
+{
+  long long nNewOut = 0;
+  long long nReusedOut = 0;
+  long long nBytesNew = 0;
+  long long nBytesReused = 0;
+  sensei::MemoryProfiler::GetAllocations(nNewOut, nReusedOut,
+    nBytesNew, nBytesReused);
+
+  std::cerr << what << " " << nNewOut << " new (" << nBytesNew
+    << " bytes) " << nReusedOut << " recycled (" << nBytesReused
+    << " bytes)" << std::endl;
+
+  if ((nNewOut != nNew) || (nReusedOut != nReused))
+    {
+    SENSEI_ERROR(<< what << " " << nNewOut << " new and " << nReusedOut
+      << " recycled but should be " << nNew << " new and " << nReused
+      << " recycled")
+    return -1;
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int checkSteps(int nBlocks, int nSteps, bool enabled)
+{
+  sensei::MemoryProfiler::ResetAllocations();
+
+  sensei::SVTKObjectPool pool;
+  pool.SetEnabled(enabled);
+
+  for (int step = 0; step < nSteps; ++step)
+    {
+    svtkMultiBlockDataSet *mb = newMesh(pool, nBlocks, step);
+
+    // the analysis would run here
+    svtkImageData *im = svtkImageData::SafeDownCast(mb->GetBlock(0));
+    if (im->GetCellData()->GetArray("data")->GetTuple1(0) != step)
+      {
+      SENSEI_ERROR("Wrong data at step " << step)
+      return -1;
+      }
+
+    mb->Delete();
+    pool.Recycle();
+    }
+
+  // per block an image and two arrays, and the multiblock
+  long long nPerStep = 3*nBlocks + 1;
+
+  return checkCounts(enabled ? "pool enabled" : "pool disabled",
+    enabled ? nPerStep : nSteps*nPerStep,
+    enabled ? (nSteps - 1)*nPerStep : 0);
+}
+
+// --------------------------------------------------------------------------
+int checkInUse()
+{
+  sensei::MemoryProfiler::ResetAllocations();
+
+  sensei::SVTKObjectPool pool;
+  pool.SetEnabled(true);
+
+  // an analysis keeps a reference to a block past the end of the step
+  svtkMultiBlockDataSet *mb = newMesh(pool, 2, 1);
+  svtkImageData *kept = svtkImageData::SafeDownCast(mb->GetBlock(1));
+  kept->Register(nullptr);
+  mb->Delete();
+  pool.Recycle();
+
+  // the kept block and its arrays remain in use
+  if (pool.GetNumberOfObjectsInUse() != 3)
+    {
+    SENSEI_ERROR("The objects in use are " << pool.GetNumberOfObjectsInUse()
+      << " but should be 3")
+    return -1;
+    }
+
+  // building the next step must not modify the kept block's data
+  mb = newMesh(pool, 2, 2);
+  int status = 0;
+  if ((kept->GetCellData()->GetArray("data")->GetTuple1(0) != 1.0) ||
+    (kept == mb->GetBlock(0)) || (kept == mb->GetBlock(1)))
+    {
+    SENSEI_ERROR("An object that is in use was recycled")
+    status = -1;
+    }
+
+  // once released, it is recycled
+  mb->Delete();
+  kept->UnRegister(nullptr);
+  pool.Recycle();
+
+  if ((pool.GetNumberOfObjectsInUse() != 0) ||
+    (pool.GetNumberOfObjectsFree() != 10))
+    {
+    SENSEI_ERROR("The objects in use are " << pool.GetNumberOfObjectsInUse()
+      << " and free are " << pool.GetNumberOfObjectsFree()
+      << " but should be 0 and 10")
+    status = -1;
+    }
+
+  // a smaller array reuses the storage of a larger one
+  svtkFloatArray *small = pool.NewArray<svtkFloatArray>(1, 100);
+  if ((small->GetNumberOfTuples() != 100) || small->GetName())
+    {
+    SENSEI_ERROR("The recycled array was not reset")
+    status = -1;
+    }
+  small->Delete();
+
+  if (checkCounts("in use", 10, 5) || status)
+    return -1;
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int nBlocks = argc > 1 ? atoi(argv[1]) : 64;
+  int nSteps = argc > 2 ? atoi(argv[2]) : 8;
+
+  int status = 0;
+  if (checkSteps(nBlocks, nSteps, false) ||
+    checkSteps(nBlocks, nSteps, true) || checkInUse())
+    status = -1;
+
+  if (status == 0)
+    std::cerr << "The object pool recycled the objects" << std::endl;
+
+  return status;
+}
@@ -0,0 +1,344 @@
+#include "SliceExtract.h"
+#include "SVTKDataAdaptor.h"
+#include "Error.h"
+
+#include <mpi.h>
+#include <svtkDoubleArray.h>
+#include <svtkImageData.h>
+#include <svtkPolyData.h>
+#include <svtkPoints.h>
+#include <svtkCellArray.h>
+#include <svtkPointData.h>
+#include <svtkCellData.h>
+#include <svtkMultiBlockDataSet.h>
+#include <svtkCompositeDataSet.h>
+#include <svtkCompositeDataIterator.h>
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+// Checks the planar slices and iso-surfaces computed by SliceExtract on a
+// unit cube split into blocks of image data, and reports the time taken.
+// The point data is the distance from the center of the cube, the iso
+// surface of value r is a sphere of area 4 pi r^2. The cell data is the x
+// coordinate, which is linear so that the conversion to point data is exact
+// away from block boundaries, its iso-surfaces and slices perpendicular to
+// an axis have unit area. Blocks that the block
+// bounds and array ranges show do not contain the extract must be skipped.
+// When built with VTK filters the time taken by the VTK path is reported
+// for comparison.
+//
+// usage: testSliceExtract [cells per axis] [blocks per axis] [repeats]
+
+// --------------------------------------------------------------------------
+double distance(double x, double y, double z)
+{
+  return std::sqrt((x - 0.5)*(x - 0.5) + (y - 0.5)*(y - 0.5) + (z - 0.5)*(z - 0.5));
+}
+
+// --------------------------------------------------------------------------
+svtkImageData *newBlock(int nCells, int nBlocks, int bi, int bj, int bk)
+{
+  int m = nCells/nBlocks;
+  double dx = 1.0/nCells;
+
+  svtkImageData *im = svtkImageData::New();
+  im->SetDimensions(m + 1, m + 1, m + 1);
+  im->SetSpacing(dx, dx, dx);
+  im->SetOrigin(bi*m*dx, bj*m*dx, bk*m*dx);
+
+  double x0[3];
+  im->GetOrigin(x0);
+
+  svtkDoubleArray *pd = svtkDoubleArray::New();
+  pd->SetName("data");
+  pd->SetNumberOfTuples(im->GetNumberOfPoints());
+  double *ppd = pd->GetPointer(0);
+
+  for (int k = 0, q = 0; k <= m; ++k)
+    for (int j = 0; j <= m; ++j)
+      for (int i = 0; i <= m; ++i, ++q)
+        ppd[q] = distance(x0[0] + i*dx, x0[1] + j*dx, x0[2] + k*dx);
+
+  svtkDoubleArray *cd = svtkDoubleArray::New();
+  cd->SetName("cdata");
+  cd->SetNumberOfTuples(im->GetNumberOfCells());
+  double *pcd = cd->GetPointer(0);
+
+  for (int k = 0, q = 0; k < m; ++k)
+    for (int j = 0; j < m; ++j)
+      for (int i = 0; i < m; ++i, ++q)
+        pcd[q] = x0[0] + (i + 0.5)*dx;
+
+  im->GetPointData()->AddArray(pd);
+  im->GetCellData()->AddArray(cd);
+
+  pd->Delete();
+  cd->Delete();
+
+  return im;
+}
+
+// --------------------------------------------------------------------------
+// sum the area of the triangles in the extract on all ranks
+double area(sensei::DataAdaptor *da)
+{
+  double a = 0.0;
+
+  svtkDataObject *dobj = nullptr;
+  if (da && !da->GetMesh("mesh", false, dobj))
+    {
+    svtkCompositeDataSet *cd = dynamic_cast<svtkCompositeDataSet*>(dobj);
+    svtkCompositeDataIterator *it = cd->NewIterator();
+    for (it->InitTraversal(); !it->IsDoneWithTraversal(); it->GoToNextItem())
+      {
+      svtkPolyData *pd = dynamic_cast<svtkPolyData*>(it->GetCurrentDataObject());
+      if (!pd)
+        continue;
+
+      svtkCellArray *polys = pd->GetPolys();
+      svtkIdType npts = 0;
+      const svtkIdType *pts = nullptr;
+      for (polys->InitTraversal(); polys->GetNextCell(npts, pts);)
+        {
+        double p[3][3];
+        for (int i = 0; i < 3; ++i)
+          pd->GetPoint(pts[i], p[i]);
+
+        double u[3];
+        double v[3];
+        for (int i = 0; i < 3; ++i)
+          {
+          u[i] = p[1][i] - p[0][i];
+          v[i] = p[2][i] - p[0][i];
+          }
+
+        double n[3] = {u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2],
+          u[0]*v[1] - u[1]*v[0]};
+
+        a += 0.5*std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+        }
+      }
+    it->Delete();
+    dobj->Delete();
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &a, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  return a;
+}
+
+// --------------------------------------------------------------------------
+// run the extract, returns the area and the time taken per run. the extract
+// releases the data after each run so the mesh is passed to the adaptor each
+// time
+int run(svtkMultiBlockDataSet *mbds, sensei::SVTKDataAdaptor *da,
+  sensei::SliceExtract *se, int nReps, double &a, double &t, long &nSkipped)
+{
+  long nSkipped0 = se->GetNumberOfBlocksSkipped();
+
+  sensei::DataAdaptor *daOut = nullptr;
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  double t0 = MPI_Wtime();
+
+  for (int i = 0; i < nReps; ++i)
+    {
+    if (daOut)
+      daOut->Delete();
+
+    da->SetDataObject("mesh", mbds);
+
+    if (!se->Execute(da, &daOut))
+      {
+      SENSEI_ERROR("Failed to execute")
+      return -1;
+      }
+    }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  t = (MPI_Wtime() - t0)/nReps;
+
+  a = area(daOut);
+
+  if (daOut)
+    daOut->Delete();
+
+  nSkipped = (se->GetNumberOfBlocksSkipped() - nSkipped0)/nReps;
+  MPI_Allreduce(MPI_IN_PLACE, &nSkipped, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int check(const std::string &name, double a, double expectedArea,
+  double tol, long nSkipped, long expectedSkipped, double t)
+{
+  int rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  int status = 0;
+  if (std::fabs(a - expectedArea) > tol*expectedArea)
+    {
+    SENSEI_ERROR(<< name << " area is " << a << " but expected " << expectedArea)
+    status = -1;
+    }
+
+  if (nSkipped != expectedSkipped)
+    {
+    SENSEI_ERROR(<< name << " skipped " << nSkipped << " blocks but expected "
+      << expectedSkipped)
+    status = -1;
+    }
+
+  if (rank == 0)
+    std::cerr << name << " area " << a << " skipped " << nSkipped
+      << " blocks in " << t << " s" << std::endl;
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nCells = argc > 1 ? atoi(argv[1]) : 64;
+  int nBlocks = argc > 2 ? atoi(argv[2]) : 4;
+  int nReps = argc > 3 ? atoi(argv[3]) : 1;
+
+  if (nCells % nBlocks)
+    {
+    SENSEI_ERROR("The number of cells must be a multiple of the number of blocks")
+    MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+  // the slice plane and iso-value
+  double xSlice = 0.3;
+  double isoVal = 0.3;
+
+  // the blocks are distributed round robin. count those the extracts miss
+  int nTotal = nBlocks*nBlocks*nBlocks;
+
+  svtkMultiBlockDataSet *mbds = svtkMultiBlockDataSet::New();
+  mbds->SetNumberOfBlocks(nTotal);
+
+  long nOffPlane = 0;
+  long nOutOfRange[2] = {0, 0};
+  for (int bk = 0, bid = 0; bk < nBlocks; ++bk)
+    {
+    for (int bj = 0; bj < nBlocks; ++bj)
+      {
+      for (int bi = 0; bi < nBlocks; ++bi, ++bid)
+        {
+        double x0 = double(bi)/nBlocks;
+        double x1 = double(bi + 1)/nBlocks;
+        if ((xSlice < x0) || (xSlice > x1))
+          ++nOffPlane;
+
+        if (bid % nRanks != rank)
+          continue;
+
+        svtkImageData *im = newBlock(nCells, nBlocks, bi, bj, bk);
+
+        const char *names[2] = {"data", "cdata"};
+        svtkDataArray *arrays[2] = {im->GetPointData()->GetArray(names[0]),
+          im->GetCellData()->GetArray(names[1])};
+
+        for (int i = 0; i < 2; ++i)
+          {
+          double rng[2];
+          arrays[i]->GetRange(rng);
+          if ((isoVal < rng[0]) || (isoVal > rng[1]))
+            ++nOutOfRange[i];
+          }
+
+        mbds->SetBlock(bid, im);
+        im->Delete();
+        }
+      }
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, nOutOfRange, 2, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  sensei::SVTKDataAdaptor *da = sensei::SVTKDataAdaptor::New();
+  da->SetDataTimeStep(0);
+  da->SetDataTime(0.0);
+
+  int status = 0;
+
+  // the VTK path is run for comparison when it is available
+  int nKernels = 1;
+#if defined(ENABLE_VTK_FILTERS)
+  nKernels = 2;
+#endif
+
+  double times[2][3] = {{0.0}};
+  for (int useVTK = 0; useVTK < nKernels; ++useVTK)
+    {
+    std::string kernel = useVTK ? "VTK " : "SVTK ";
+
+    // planar slice
+    sensei::SliceExtract *se = sensei::SliceExtract::New();
+    se->EnableWriter(0);
+    se->SetUseVTK(useVTK);
+    se->SetOperation(sensei::SliceExtract::OP_PLANAR_SLICE);
+    se->SetPoint({xSlice, 0.5, 0.5});
+    se->SetNormal({1.0, 0.0, 0.0});
+    se->AddDataRequirement("mesh", svtkDataObject::POINT, {"data"});
+
+    double a = 0.0;
+    long nSkipped = 0;
+    if (run(mbds, da, se, nReps, a, times[useVTK][0], nSkipped) ||
+      check(kernel + "slice", a, 1.0, 1.0e-6, nSkipped, nOffPlane,
+      times[useVTK][0]))
+      status = -1;
+
+    se->Delete();
+
+    // iso-surfaces of point and cell data
+    const char *names[2] = {"data", "cdata"};
+    int centering[2] = {svtkDataObject::POINT, svtkDataObject::CELL};
+    double areas[2] = {4.0*M_PI*isoVal*isoVal, 1.0};
+    double tols[2] = {0.02, 1.0e-6};
+    for (int i = 0; i < 2; ++i)
+      {
+      se = sensei::SliceExtract::New();
+      se->EnableWriter(0);
+      se->SetUseVTK(useVTK);
+      se->SetOperation(sensei::SliceExtract::OP_ISO_SURFACE);
+      se->SetIsoValues("mesh", names[i], centering[i], {isoVal});
+
+      if (run(mbds, da, se, nReps, a, times[useVTK][i+1], nSkipped) ||
+        check(kernel + names[i] + " iso-surface", a, areas[i], tols[i],
+        nSkipped, nOutOfRange[i], times[useVTK][i+1]))
+        status = -1;
+
+      se->Delete();
+      }
+    }
+
+  if ((nKernels > 1) && (rank == 0))
+    {
+    std::cerr << "speed up over VTK: slice " << times[1][0]/times[0][0]
+      << " point iso-surface " << times[1][1]/times[0][1]
+      << " cell iso-surface " << times[1][2]/times[0][2] << std::endl;
+    }
+
+  da->Delete();
+  mbds->Delete();
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return status;
+}
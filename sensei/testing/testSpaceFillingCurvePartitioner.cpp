@@ -0,0 +1,190 @@
+#include "WeightedPartitioner.h"
+#include "BlockPartitioner.h"
+#include "PlanarPartitioner.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Checks the space filling curves used to order blocks and the metrics used
+// to compare partitions, and reports the metrics of the partitions made by
+// the block, planar, LPT, Morton and Hilbert partitioners of a cube of
+// blocks. Consecutive blocks on the Hilbert curve must share a face. The
+// metrics of a pair of blocks split between two ranks are known exactly.
+// Partitions along either curve must cut fewer faces than LPT, which
+// ignores adjacency.
+//
+// usage: testSpaceFillingCurvePartitioner [blocks per axis]
+
+// --------------------------------------------------------------------------
+sensei::MeshMetadataPtr newCube(int n, bool bounds)
+{
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "mesh";
+  md->NumBlocks = n*n*n;
+
+  for (int k = 0, q = 0; k < n; ++k)
+    {
+    for (int j = 0; j < n; ++j)
+      {
+      for (int i = 0; i < n; ++i, ++q)
+        {
+        md->BlockIds.push_back(q);
+        md->BlockOwner.push_back(0);
+        md->BlockNumCells.push_back(1000);
+
+        if (bounds)
+          md->BlockBounds.push_back({double(i), i + 1.0, double(j), j + 1.0,
+            double(k), k + 1.0});
+        else
+          md->BlockExtents.push_back({10*i, 10*(i + 1), 10*j, 10*(j + 1),
+            10*k, 10*(k + 1)});
+        }
+      }
+    }
+
+  return md;
+}
+
+// --------------------------------------------------------------------------
+int checkMetrics()
+{
+  // two blocks side by side, from bounds and from extents
+  int status = 0;
+  for (int i = 0; i < 2; ++i)
+    {
+    sensei::MeshMetadataPtr md = newCube(2, i == 0);
+    md->NumBlocks = 2;
+    md->BlockIds.resize(2);
+    md->BlockOwner = {0, 1};
+    md->BlockNumCells.resize(2);
+    md->BlockBounds.resize(i == 0 ? 2 : 0);
+    md->BlockExtents.resize(i == 0 ? 0 : 2);
+
+    double expectedArea = i == 0 ? 1.0 : 100.0;
+    double expectedRatio = i == 0 ? 1.0 : 0.1;
+
+    sensei::PartitionMetrics m;
+    if (sensei::Partitioner::GetMetrics(md, 2, m) || (m.NumCutFaces != 1) ||
+      (m.CutArea != expectedArea) || (m.MaxNeighbors != 1) ||
+      (std::fabs(m.MaxSurfaceToVolume - expectedRatio) > 1.0e-12) ||
+      (m.Imbalance != 1.0))
+      {
+      SENSEI_ERROR("Wrong metrics from " << (i == 0 ? "bounds" : "extents")
+        << " NumCutFaces=" << m.NumCutFaces << " CutArea=" << m.CutArea
+        << " MaxNeighbors=" << m.MaxNeighbors << " MaxSurfaceToVolume="
+        << m.MaxSurfaceToVolume << " Imbalance=" << m.Imbalance)
+      status = -1;
+      }
+    }
+
+  return status;
+}
+
+// --------------------------------------------------------------------------
+int checkHilbert(int n)
+{
+  sensei::MeshMetadataPtr md = newCube(n, true);
+
+  std::vector<int> order;
+  if (sensei::WeightedPartitioner::GetCurveOrder(md,
+    sensei::WeightedPartitioner::CURVE_HILBERT, order))
+    {
+    SENSEI_ERROR("Failed to order the blocks")
+    return -1;
+    }
+
+  for (int q = 1; q < md->NumBlocks; ++q)
+    {
+    const std::array<double,6> &b0 = md->BlockBounds[order[q-1]];
+    const std::array<double,6> &b1 = md->BlockBounds[order[q]];
+
+    double dist = std::fabs(b1[0] - b0[0]) + std::fabs(b1[2] - b0[2]) +
+      std::fabs(b1[4] - b0[4]);
+
+    if (dist != 1.0)
+      {
+      SENSEI_ERROR("Blocks " << order[q-1] << " and " << order[q]
+        << " are consecutive on the Hilbert curve but not adjacent")
+      return -1;
+      }
+    }
+
+  return 0;
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int n = argc > 1 ? atoi(argv[1]) : 8;
+
+  int status = 0;
+  if (checkMetrics() || checkHilbert(n))
+    status = -1;
+
+  // compare the partitions of a cube of blocks
+  sensei::MeshMetadataPtr md = newCube(n, true);
+
+  sensei::WeightedPartitionerPtr lpt = sensei::WeightedPartitioner::New();
+  lpt->SetMethod(sensei::WeightedPartitioner::METHOD_LPT);
+
+  sensei::WeightedPartitionerPtr morton = sensei::WeightedPartitioner::New();
+  morton->SetMethod(sensei::WeightedPartitioner::METHOD_SFC);
+  morton->SetCurve(sensei::WeightedPartitioner::CURVE_MORTON);
+
+  sensei::PlanarPartitionerPtr planar = sensei::PlanarPartitioner::New();
+  planar->SetPlaneSize(n*n);
+
+  sensei::PartitionerPtr parts[] = {sensei::BlockPartitioner::New(), planar,
+    lpt, morton, sensei::SpaceFillingCurvePartitioner::New()};
+
+  const char *names[] = {"block", "planar", "lpt", "morton", "hilbert"};
+
+  long cutFaces[5] = {0};
+  for (int i = 0; i < 5; ++i)
+    {
+    sensei::MeshMetadataPtr mdOut;
+    sensei::PartitionMetrics m;
+    if (parts[i]->GetPartition(MPI_COMM_WORLD, md, mdOut) ||
+      sensei::Partitioner::GetMetrics(mdOut, nRanks, m))
+      {
+      SENSEI_ERROR("Failed to partition with " << names[i])
+      status = -1;
+      continue;
+      }
+
+    cutFaces[i] = m.NumCutFaces;
+
+    if (rank == 0)
+      std::cerr << names[i] << " on " << nRanks << " ranks: NumCutFaces="
+        << m.NumCutFaces << " CutArea=" << m.CutArea << " MaxSurfaceToVolume="
+        << m.MaxSurfaceToVolume << " MaxNeighbors=" << m.MaxNeighbors
+        << " Imbalance=" << m.Imbalance << std::endl;
+    }
+
+  if ((nRanks > 1) && ((cutFaces[3] >= cutFaces[2]) ||
+    (cutFaces[4] >= cutFaces[2])))
+    {
+    SENSEI_ERROR("The curves cut " << cutFaces[3] << " and " << cutFaces[4]
+      << " faces, not fewer than the " << cutFaces[2] << " cut by LPT")
+    status = -1;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return status;
+}
@@ -0,0 +1,171 @@
+#include "WeightedPartitioner.h"
+#include "BlockPartitioner.h"
+#include "MeshMetadata.h"
+#include "Error.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Checks the balance of the partitions made by the WeightedPartitioner on a
+// mesh whose blocks vary in size, as happens with AMR. The blocks form a
+// cube, those in one corner are refined and have many more cells than the
+// rest. The LPT partition must be within 4/3 of the lower bound on the
+// optimal load, and the SFC partition within one block of the mean load.
+// The weight expression parser is checked on an expression using each of
+// the operators. The imbalance of the BlockPartitioner is reported for
+// comparison.
+//
+// usage: testWeightedPartitioner [blocks per axis] [refinement factor]
+
+// --------------------------------------------------------------------------
+double maxLoad(const sensei::MeshMetadataPtr &md,
+  const std::vector<double> &weights, int nRanks, int &status)
+{
+  std::vector<double> load(nRanks, 0.0);
+  for (int i = 0; i < md->NumBlocks; ++i)
+    {
+    int owner = md->BlockOwner[i];
+    if ((owner < 0) || (owner >= nRanks))
+      {
+      SENSEI_ERROR("Block " << i << " has invalid owner " << owner)
+      status = -1;
+      continue;
+      }
+    load[owner] += weights[i];
+    }
+
+  // all ranks must arrive at the same partition
+  std::vector<int> owners(md->BlockOwner);
+  MPI_Allreduce(MPI_IN_PLACE, owners.data(), owners.size(), MPI_INT,
+    MPI_MAX, MPI_COMM_WORLD);
+
+  if (owners != md->BlockOwner)
+    {
+    SENSEI_ERROR("The partition differs across ranks")
+    status = -1;
+    }
+
+  return *std::max_element(load.begin(), load.end());
+}
+
+// --------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  MPI_Init(&argc, &argv);
+
+  int rank = 0;
+  int nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  int nBlocksAxis = argc > 1 ? atoi(argv[1]) : 6;
+  int refinement = argc > 2 ? atoi(argv[2]) : 8;
+
+  // a cube of blocks, those in the low corner are refined
+  sensei::MeshMetadataPtr md = sensei::MeshMetadata::New();
+  md->MeshName = "mesh";
+  md->NumBlocks = nBlocksAxis*nBlocksAxis*nBlocksAxis;
+
+  int baseCells = 16*16*16;
+  for (int k = 0, q = 0; k < nBlocksAxis; ++k)
+    {
+    for (int j = 0; j < nBlocksAxis; ++j)
+      {
+      for (int i = 0; i < nBlocksAxis; ++i, ++q)
+        {
+        bool refined = (i < nBlocksAxis/2) && (j < nBlocksAxis/2) &&
+          (k < nBlocksAxis/3);
+
+        long nCells = refined ? refinement*baseCells : baseCells;
+        long nPts = refined ? refinement*17*17*17 : 17*17*17;
+
+        md->BlockIds.push_back(q);
+        md->BlockOwner.push_back(q % nRanks);
+        md->BlockNumCells.push_back(nCells);
+        md->BlockNumPoints.push_back(nPts);
+        md->BlockBounds.push_back({double(i), i + 1.0, double(j), j + 1.0,
+          double(k), k + 1.0});
+        }
+      }
+    }
+
+  int status = 0;
+
+  // check the expression parser
+  sensei::WeightedPartitionerPtr wp = sensei::WeightedPartitioner::New();
+
+  std::vector<double> weights;
+  if (wp->SetWeightExpression("2*(cells + points) - points/2") ||
+    wp->GetBlockWeights(md, weights) ||
+    (weights[0] != 2.0*(md->BlockNumCells[0] + md->BlockNumPoints[0]) -
+      md->BlockNumPoints[0]/2.0))
+    {
+    SENSEI_ERROR("Failed to evaluate a valid expression")
+    status = -1;
+    }
+
+  // the blocks are weighted by their number of cells
+  wp->SetWeightExpression("cells");
+  wp->GetBlockWeights(md, weights);
+
+  double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+  double maxWeight = *std::max_element(weights.begin(), weights.end());
+  double meanLoad = total/nRanks;
+  double optLoad = std::max(meanLoad, maxWeight);
+
+  // the block count partitioner for comparison
+  sensei::MeshMetadataPtr mdOut;
+  sensei::BlockPartitionerPtr bp = sensei::BlockPartitioner::New();
+  bp->GetPartition(MPI_COMM_WORLD, md, mdOut);
+  double blockLoad = maxLoad(mdOut, weights, nRanks, status);
+
+  // longest processing time first
+  wp->SetMethod(sensei::WeightedPartitioner::METHOD_LPT);
+  if (wp->GetPartition(MPI_COMM_WORLD, md, mdOut))
+    {
+    SENSEI_ERROR("LPT partitioning failed")
+    status = -1;
+    }
+  double lptLoad = maxLoad(mdOut, weights, nRanks, status);
+
+  if (lptLoad > 4.0/3.0*optLoad)
+    {
+    SENSEI_ERROR("LPT max load " << lptLoad << " exceeds 4/3 of " << optLoad)
+    status = -1;
+    }
+
+  // space filling curve
+  wp->SetMethod(sensei::WeightedPartitioner::METHOD_SFC);
+  if (wp->GetPartition(MPI_COMM_WORLD, md, mdOut))
+    {
+    SENSEI_ERROR("SFC partitioning failed")
+    status = -1;
+    }
+  double sfcLoad = maxLoad(mdOut, weights, nRanks, status);
+
+  if (sfcLoad > meanLoad + maxWeight)
+    {
+    SENSEI_ERROR("SFC max load " << sfcLoad << " exceeds "
+      << meanLoad + maxWeight)
+    status = -1;
+    }
+
+  if (rank == 0)
+    {
+    std::cerr << "imbalance (max/mean load) on " << nRanks << " ranks:"
+      << " block " << blockLoad/meanLoad << " lpt " << lptLoad/meanLoad
+      << " sfc " << sfcLoad/meanLoad << std::endl;
+    }
+
+  MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return status;
+}
@@ -0,0 +1,431 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    svtkSMPTools.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+
+// A dependency free implementation using a persistent pool of std::thread.
+//
+// The range of a For is split into chunks of grain size. The chunks are
+// divided into contiguous ranges, one per worker, that are pushed onto the
+// workers' queues. A worker pops a range from the back of its own queue and
+// splits it in halves, pushing the upper half back onto its queue, until a
+// single chunk remains which it executes. Idle workers steal half of the
+// range at the front of another worker's queue, which is the largest
+// available, so that work moves from busy to idle threads with little
+// contention. The thread calling For takes part by stealing single chunks
+// until all of the chunks of its For have been executed.
+//
+// The number of threads taking part may be changed with Initialize at any
+// time, threads are started on demand and are kept for the life of the
+// process. It defaults to the SVTK_SMP_MAX_THREADS environment variable, or
+// else to 1. Defaulting to the number of hardware threads would oversubscribe
+// the cores when several MPI ranks share a node, which is the common case in
+// SENSEI, as each rank would start a thread per core.
+//
+// A For called from within a chunk is executed sequentially by the calling
+// thread. Any number of threads may call For concurrently.
+
+#include "svtkSMPTools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using svtk::detail::smp::ExecuteFunctorPtrType;
+
+// the maximum number of threads
+const int MaxThreads = 256;
+
+// the state of a For
+struct Job
+{
+  ExecuteFunctorPtrType Execute;
+  void* Functor;
+  svtkIdType First;
+  svtkIdType Last;
+  svtkIdType Grain;
+
+  std::atomic<svtkIdType> Remaining; // chunks not yet executed
+  bool Finished;                    // set when the last chunk completes
+  std::mutex Mutex;
+  std::condition_variable Done;
+};
+
+// a range of the chunks of a job
+struct Task
+{
+  Job* J;
+  svtkIdType Begin;
+  svtkIdType End;
+};
+
+struct WorkQueue
+{
+  std::mutex Mutex;
+  std::deque<Task> Tasks;
+};
+
+// the depth of nested chunk execution by the current thread
+thread_local int ParallelScope = 0;
+
+class ThreadPool
+{
+public:
+  static ThreadPool& GetInstance()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  ~ThreadPool();
+
+  void SetNumberOfThreads(int numThreads);
+  int GetNumberOfThreads() const { return this->NumberOfThreads; }
+
+  void For(svtkIdType first, svtkIdType last, svtkIdType grain,
+    ExecuteFunctorPtrType functorExecuter, void* functor);
+
+private:
+  ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  void operator=(const ThreadPool&) = delete;
+
+  static int GetDefaultNumberOfThreads();
+
+  void StartWorkers(int numWorkers);
+  void Run(int id);
+
+  void Push(int id, const Task& task);
+  bool Pop(int id, Task& task);
+  bool Steal(int id, Task& task, bool single);
+
+  void Execute(int id, Task& task);
+  void ExecuteChunk(Job* job, svtkIdType chunk);
+
+  std::atomic<int> NumberOfThreads;
+  std::atomic<int> NumberOfWorkers; // started
+  std::atomic<long> NumberOfTasks;  // queued
+  std::atomic<unsigned int> NextQueue;
+  std::vector<WorkQueue> Queues;
+  std::vector<std::thread> Workers;
+  std::mutex WorkersMutex;
+  std::mutex SleepMutex;
+  std::condition_variable Wake;
+  bool Stop;
+};
+
+//--------------------------------------------------------------------------------
+int ThreadPool::GetDefaultNumberOfThreads()
+{
+  int numThreads = 0;
+
+  const char* env = std::getenv("SVTK_SMP_MAX_THREADS");
+  if (env)
+  {
+    numThreads = std::atoi(env);
+  }
+
+  return std::max(1, std::min(numThreads, MaxThreads));
+}
+
+//--------------------------------------------------------------------------------
+ThreadPool::ThreadPool()
+  : NumberOfThreads(GetDefaultNumberOfThreads())
+  , NumberOfWorkers(0)
+  , NumberOfTasks(0)
+  , NextQueue(0)
+  , Queues(MaxThreads)
+  , Stop(false)
+{
+}
+
+//--------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->SleepMutex);
+    this->Stop = true;
+  }
+  this->Wake.notify_all();
+
+  std::lock_guard<std::mutex> lock(this->WorkersMutex);
+  for (auto& worker : this->Workers)
+  {
+    worker.join();
+  }
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::SetNumberOfThreads(int numThreads)
+{
+  this->NumberOfThreads =
+    numThreads > 0 ? std::min(numThreads, MaxThreads) : GetDefaultNumberOfThreads();
+
+  // workers no longer needed go to sleep, their queued tasks are stolen by
+  // the others
+  this->Wake.notify_all();
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::StartWorkers(int numWorkers)
+{
+  if (this->NumberOfWorkers >= numWorkers)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(this->WorkersMutex);
+  for (int id = static_cast<int>(this->Workers.size()); id < numWorkers; ++id)
+  {
+    this->Workers.emplace_back(&ThreadPool::Run, this, id);
+  }
+  this->NumberOfWorkers = static_cast<int>(this->Workers.size());
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::Run(int id)
+{
+  for (;;)
+  {
+    Task task;
+    if (this->Pop(id, task) ||
+      ((id < this->NumberOfThreads - 1) && this->Steal(id, task, false)))
+    {
+      this->Execute(id, task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(this->SleepMutex);
+    this->Wake.wait(lock, [this, id]() {
+      return this->Stop || ((this->NumberOfTasks > 0) && (id < this->NumberOfThreads - 1));
+    });
+
+    if (this->Stop)
+    {
+      break;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::Push(int id, const Task& task)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Queues[id].Mutex);
+    this->Queues[id].Tasks.push_back(task);
+  }
+
+  ++this->NumberOfTasks;
+
+  // lock so that a worker deciding to sleep does not miss the wake up
+  {
+    std::lock_guard<std::mutex> lock(this->SleepMutex);
+  }
+  this->Wake.notify_one();
+}
+
+//--------------------------------------------------------------------------------
+bool ThreadPool::Pop(int id, Task& task)
+{
+  std::lock_guard<std::mutex> lock(this->Queues[id].Mutex);
+
+  std::deque<Task>& tasks = this->Queues[id].Tasks;
+  if (tasks.empty())
+  {
+    return false;
+  }
+
+  task = tasks.back();
+  tasks.pop_back();
+  --this->NumberOfTasks;
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------
+bool ThreadPool::Steal(int id, Task& task, bool single)
+{
+  int numWorkers = this->NumberOfWorkers;
+  if (numWorkers < 1)
+  {
+    return false;
+  }
+
+  // visit the other queues starting from the next
+  int start = id < 0 ? static_cast<int>(this->NextQueue++ % numWorkers) : id + 1;
+  for (int i = 0; i < numWorkers; ++i)
+  {
+    int victim = (start + i) % numWorkers;
+    if (victim == id)
+    {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(this->Queues[victim].Mutex);
+
+    std::deque<Task>& tasks = this->Queues[victim].Tasks;
+    if (tasks.empty())
+    {
+      continue;
+    }
+
+    // take one chunk for execution by a thread outside of the pool, or half
+    // of the range for a worker, leaving the rest in place
+    Task& front = tasks.front();
+    svtkIdType n = front.End - front.Begin;
+    svtkIdType take = single ? 1 : std::max<svtkIdType>(1, n / 2);
+
+    task.J = front.J;
+    task.Begin = front.Begin;
+    task.End = front.Begin + take;
+
+    if (take < n)
+    {
+      front.Begin += take;
+    }
+    else
+    {
+      tasks.pop_front();
+      --this->NumberOfTasks;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::Execute(int id, Task& task)
+{
+  // keep the first chunk, make the others available
+  while (task.End - task.Begin > 1)
+  {
+    svtkIdType mid = task.Begin + (task.End - task.Begin) / 2;
+    this->Push(id, Task{ task.J, mid, task.End });
+    task.End = mid;
+  }
+
+  this->ExecuteChunk(task.J, task.Begin);
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::ExecuteChunk(Job* job, svtkIdType chunk)
+{
+  ++ParallelScope;
+  job->Execute(job->Functor, job->First + chunk * job->Grain, job->Grain, job->Last);
+  --ParallelScope;
+
+  if (--job->Remaining == 0)
+  {
+    // the job is owned by the thread that called For and may be destroyed
+    // as soon as Finished is seen
+    std::lock_guard<std::mutex> lock(job->Mutex);
+    job->Finished = true;
+    job->Done.notify_all();
+  }
+}
+
+//--------------------------------------------------------------------------------
+void ThreadPool::For(svtkIdType first, svtkIdType last, svtkIdType grain,
+  ExecuteFunctorPtrType functorExecuter, void* functor)
+{
+  int numWorkers = this->NumberOfThreads - 1;
+  svtkIdType numChunks = (last - first + grain - 1) / grain;
+
+  // nested calls and calls without workers are executed sequentially
+  if ((ParallelScope > 0) || (numWorkers < 1) || (numChunks < 2))
+  {
+    ++ParallelScope;
+    for (svtkIdType from = first; from < last; from += grain)
+    {
+      functorExecuter(functor, from, grain, last);
+    }
+    --ParallelScope;
+    return;
+  }
+
+  this->StartWorkers(numWorkers);
+
+  Job job;
+  job.Execute = functorExecuter;
+  job.Functor = functor;
+  job.First = first;
+  job.Last = last;
+  job.Grain = grain;
+  job.Remaining = numChunks;
+  job.Finished = false;
+
+  // a contiguous range of chunks per worker, the calling thread steals
+  svtkIdType numRanges = std::min<svtkIdType>(numWorkers, numChunks);
+  unsigned int firstQueue = this->NextQueue++;
+  for (svtkIdType i = 0; i < numRanges; ++i)
+  {
+    int id = static_cast<int>((firstQueue + i) % numWorkers);
+    this->Push(id, Task{ &job, (numChunks * i) / numRanges, (numChunks * (i + 1)) / numRanges });
+  }
+
+  Task task;
+  while ((job.Remaining > 0) && this->Steal(-1, task, true))
+  {
+    this->ExecuteChunk(task.J, task.Begin);
+  }
+
+  std::unique_lock<std::mutex> lock(job.Mutex);
+  job.Done.wait(lock, [&job]() { return job.Finished; });
+}
+}
+
+//--------------------------------------------------------------------------------
+void svtkSMPTools::Initialize(int numThreads)
+{
+  ThreadPool::GetInstance().SetNumberOfThreads(numThreads);
+}
+
+//--------------------------------------------------------------------------------
+int svtkSMPTools::GetEstimatedNumberOfThreads()
+{
+  return svtk::detail::smp::GetNumberOfThreads();
+}
+
+//--------------------------------------------------------------------------------
+int svtk::detail::smp::GetNumberOfThreads()
+{
+  return ThreadPool::GetInstance().GetNumberOfThreads();
+}
+
+//--------------------------------------------------------------------------------
+bool svtk::detail::smp::GetIsParallelScope()
+{
+  return ParallelScope > 0;
+}
+
+//--------------------------------------------------------------------------------
+void svtk::detail::smp::svtkSMPTools_Impl_For_STDThread(svtkIdType first, svtkIdType last,
+  svtkIdType grain, ExecuteFunctorPtrType functorExecuter, void* functor)
+{
+  if (grain <= 0)
+  {
+    svtkIdType estimateGrain = (last - first) / (GetNumberOfThreads() * 4);
+    grain = (estimateGrain > 0) ? estimateGrain : 1;
+  }
+
+  ThreadPool::GetInstance().For(first, last, grain, functorExecuter, functor);
+}
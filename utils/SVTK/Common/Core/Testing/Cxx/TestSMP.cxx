@@ -18,7 +18,12 @@
 #include "svtkSMPThreadLocal.h"
 #include "svtkSMPThreadLocalObject.h"
 #include "svtkSMPTools.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <functional>
+#include <random>
+#include <thread>
 #include <vector>
 
 static const int Target = 10000;
@@ -84,6 +89,136 @@ bool myComp(double a, double b)
   return (a < b);
 }
 
+// A compute bound loop for the scaling benchmark, with a thread local sum
+class SumFunctor
+{
+public:
+  const std::vector<double>& Data;
+  svtkSMPThreadLocal<double> Sum;
+  double Total;
+
+  SumFunctor(const std::vector<double>& data)
+    : Data(data)
+    , Sum(0.0)
+    , Total(0.0)
+  {
+  }
+
+  void operator()(svtkIdType begin, svtkIdType end)
+  {
+    double& sum = this->Sum.Local();
+    for (svtkIdType i = begin; i < end; ++i)
+      sum += std::sqrt(std::fabs(std::sin(this->Data[i]) * std::cos(this->Data[i])));
+  }
+
+  void Initialize() {}
+
+  void Reduce()
+  {
+    this->Total = 0.0;
+    for (double sum : this->Sum)
+      this->Total += sum;
+  }
+};
+
+// A loop that calls For from within its body
+class NestedFunctor
+{
+public:
+  svtkSMPThreadLocal<int> Counter;
+
+  NestedFunctor()
+    : Counter(0)
+  {
+  }
+
+  void operator()(svtkIdType begin, svtkIdType end)
+  {
+    for (svtkIdType i = begin; i < end; ++i)
+    {
+      ARangeFunctor inner;
+      svtkSMPTools::For(0, Target, inner);
+      for (int count : inner.Counter)
+        this->Counter.Local() += count;
+    }
+  }
+};
+
+using Clock = std::chrono::high_resolution_clock;
+using Seconds = std::chrono::duration<double>;
+
+// Times For and Sort for increasing numbers of threads up to the number of
+// hardware threads, checking that the results do not depend on the number of
+// threads.
+static int ScalingBenchmark()
+{
+  const svtkIdType n = 1 << 22;
+  const int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  std::vector<double> data(n);
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<double> dist(-1000.0, 1000.0);
+  for (auto& v : data)
+    v = dist(gen);
+
+  std::vector<double> sorted(data);
+  std::sort(sorted.begin(), sorted.end());
+
+  double forTime1 = 0.0;
+  double sortTime1 = 0.0;
+  double total1 = 0.0;
+
+  for (int numThreads = 1;; numThreads = std::min(2 * numThreads, maxThreads))
+  {
+    svtkSMPTools::Initialize(numThreads);
+
+    SumFunctor sum(data);
+    auto t0 = Clock::now();
+    svtkSMPTools::For(0, n, sum);
+    auto t1 = Clock::now();
+
+    std::vector<double> toSort(data);
+    auto t2 = Clock::now();
+    svtkSMPTools::Sort(toSort.begin(), toSort.end());
+    auto t3 = Clock::now();
+
+    double forTime = Seconds(t1 - t0).count();
+    double sortTime = Seconds(t3 - t2).count();
+
+    if (numThreads == 1)
+    {
+      forTime1 = forTime;
+      sortTime1 = sortTime;
+      total1 = sum.Total;
+    }
+
+    cerr << "threads " << numThreads << " For " << forTime << " s (speedup "
+         << forTime1 / forTime << ") Sort " << sortTime << " s (speedup "
+         << sortTime1 / sortTime << ")" << endl;
+
+    if (std::fabs(sum.Total - total1) > 1e-6 * std::fabs(total1))
+    {
+      cerr << "Error: For with " << numThreads << " threads computed " << sum.Total
+           << " instead of " << total1 << endl;
+      return 1;
+    }
+
+    if (toSort != sorted)
+    {
+      cerr << "Error: Sort with " << numThreads << " threads is wrong" << endl;
+      return 1;
+    }
+
+    if (numThreads == maxThreads)
+      break;
+  }
+
+  // restore the default
+  svtkSMPTools::Initialize(0);
+
+  return 0;
+}
+
 int TestSMP(int, char*[])
 {
   // svtkSMPTools::Initialize(8);
@@ -157,5 +292,44 @@ int TestSMP(int, char*[])
     }
   }
 
-  return 0;
+  // nested parallel loops
+  NestedFunctor functor3;
+  svtkSMPTools::For(0, 100, functor3);
+
+  total = 0;
+  for (int count : functor3.Counter)
+    total += count;
+
+  if (total != 100 * Target)
+  {
+    cerr << "Error: NestedFunctor did not generate " << 100 * Target << endl;
+    return 1;
+  }
+
+  // loops issued concurrently from threads outside of the backend
+  std::vector<int> totals(4, 0);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; ++i)
+  {
+    callers.emplace_back([&totals, i]() {
+      ARangeFunctor functor;
+      svtkSMPTools::For(0, Target, functor);
+      for (int count : functor.Counter)
+        totals[i] += count;
+    });
+  }
+
+  for (auto& caller : callers)
+    caller.join();
+
+  for (int i = 0; i < 4; ++i)
+  {
+    if (totals[i] != Target)
+    {
+      cerr << "Error: concurrent ARangeFunctor did not generate " << Target << endl;
+      return 1;
+    }
+  }
+
+  return ScalingBenchmark();
 }
@@ -1,11 +1,12 @@
 set(SVTK_SMP_IMPLEMENTATION_TYPE "Sequential"
-  CACHE STRING "Which multi-threaded parallelism implementation to use. Options are Sequential, OpenMP or TBB")
+  CACHE STRING "Which multi-threaded parallelism implementation to use. Options are Sequential, STDThread, OpenMP or TBB")
 set_property(CACHE SVTK_SMP_IMPLEMENTATION_TYPE
   PROPERTY
-    STRINGS Sequential OpenMP TBB)
+    STRINGS Sequential STDThread OpenMP TBB)
 
 if (NOT (SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "OpenMP" OR
-         SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "TBB"))
+         SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "TBB" OR
+         SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "STDThread"))
   set_property(CACHE SVTK_SMP_IMPLEMENTATION_TYPE
     PROPERTY
       VALUE "Sequential")
@@ -60,6 +61,18 @@ elseif (SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "OpenMP")
       "atomics implementation.")
   endif()
 
+elseif (SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "STDThread")
+  # a work-stealing pool of std::thread, Threads::Threads is linked by the
+  # module
+  set(svtk_smp_implementation_dir "${CMAKE_CURRENT_SOURCE_DIR}/SMP/STDThread")
+  list(APPEND svtk_smp_sources
+    "${svtk_smp_implementation_dir}/svtkSMPTools.cxx"
+    "${svtk_smp_implementation_dir}/svtkSMPThreadLocalImpl.cxx")
+  list(APPEND svtk_smp_headers_to_configure
+    svtkSMPThreadLocal.h
+    svtkSMPThreadLocalImpl.h
+    svtkSMPToolsInternal.h)
+
 elseif (SVTK_SMP_IMPLEMENTATION_TYPE STREQUAL "Sequential")
   set(svtk_smp_implementation_dir "${CMAKE_CURRENT_SOURCE_DIR}/SMP/Sequential")
   list(APPEND svtk_smp_sources
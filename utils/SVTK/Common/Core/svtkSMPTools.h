@@ -224,8 +224,12 @@ public:
    * not required as it is automatically called before the first
    * execution of any parallel code. However, it can be used to
    * control the maximum number of threads used when the back-end
-   * supports it (currently Simple and TBB only). Make sure to call
+   * supports it (currently STDThread, OpenMP and TBB). Make sure to call
    * it before any other parallel operation.
+   * The STDThread back-end may be initialized again at any time, it then
+   * uses the new number of threads in subsequent parallel operations. With
+   * it 0 restores the default, the SVTK_SMP_MAX_THREADS env. variable or
+   * else 1, such that MPI ranks sharing a node do not oversubscribe it.
    * When using Kaapi, use the KAAPI_CPUCOUNT env. variable to control
    * the number of threads used in the thread pool.
    */
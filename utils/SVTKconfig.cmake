@@ -7,6 +7,11 @@ set(SVTK_BUILD_EXAMPLES OFF CACHE INTERNAL "")
 set(SVTK_BUILD_TESTING OFF CACHE INTERNAL "")
 set(SVTK_BUILD_DOCUMENTATION OFF CACHE INTERNAL "")
 set(SVTK_BUILD_SHARED_LIBS ON CACHE INTERNAL "")
+# parallelize svtkSMPTools with a std::thread pool when neither TBB nor
+# OpenMP is selected. the pool uses 1 thread unless SVTK_SMP_MAX_THREADS is
+# set in the environment or the number is set at run time
+set(SVTK_SMP_IMPLEMENTATION_TYPE "STDThread" CACHE STRING
+  "Which multi-threaded parallelism implementation to use. Options are Sequential, STDThread, OpenMP or TBB")
 set(SVTK_MODULE_ENABLE_SVTK_AcceleratorsSVTKm NO CACHE INTERNAL "")
 set(SVTK_MODULE_ENABLE_SVTK_ChartsCore NO CACHE INTERNAL "")
 set(SVTK_MODULE_ENABLE_SVTK_CommonArchive NO CACHE INTERNAL "")
@@ -17,10 +17,16 @@ Caveats:
    supported.  Char arrays are also not easy to handle and might not
    work as you expect.  Patches welcome.
 
- - You need to make sure you hold a reference to a Numpy array you want
-   to import into SVTK.  If not you'll get a segfault (in the best case).
-   The same holds in reverse when you convert a SVTK array to a numpy
-   array -- don't delete the SVTK array.
+ - Arrays are shared without copying in both directions. A SVTK array made
+   from a NumPy array holds a reference to it that is released when the SVTK
+   array is deleted, which may be after its Python object is collected when
+   the array has been passed to C++. A NumPy array made from a SVTK array
+   holds a reference to the SVTK array.
+
+ - SOA arrays are shared when their components are equally spaced in
+   memory, otherwise svtk_to_numpy copies the components into a new NumPy
+   array. Each component of an SOA array is always available without a copy
+   through svtkDataArray.buffer(comp).
 
 
 Created by Prabhu Ramachandran in Feb. 2008.
@@ -30,7 +36,8 @@ Created by Prabhu Ramachandran in Feb. 2008.
 #from svtkmodules.svtkCommonCore import svtkDataArray, svtkIdTypeArray, svtkLongArray
 
 import svtk
-from svtk import svtkConstants, svtkDataArray, svtkIdTypeArray, svtkLongArray, as_integer, as_void_ptr
+from svtk import svtkConstants, svtkDataArray, svtkIdTypeArray, svtkLongArray, as_integer, as_void_ptr, \
+    svtk_array_from_buffer
 import numpy
 
 # Useful constants for SVTK arrays.
@@ -119,9 +126,8 @@ def numpy_to_svtk(num_array, deep=0, array_type=None):
     (shallow copy) and uses more memory but detaches the two arrays
     such that the numpy array can be released.
 
-    WARNING: You must maintain a reference to the passed numpy array, if
-    the numpy data is gc'd and SVTK will point to garbage which will in
-    the best case give you a segfault.
+    When not deep-copied the SVTK array holds a reference to the numpy
+    array, released when the SVTK array is deleted.
 
     Parameters:
 
@@ -148,7 +154,6 @@ def numpy_to_svtk(num_array, deep=0, array_type=None):
         svtk_typecode = array_type
     else:
         svtk_typecode = get_svtk_array_type(z.dtype)
-    result_array = create_svtk_array(svtk_typecode)
 
     # Fixup shape in case its empty or scalar.
     try:
@@ -158,11 +163,9 @@ def numpy_to_svtk(num_array, deep=0, array_type=None):
 
     # Find the shape and set number of components.
     if len(shape) == 1:
-        result_array.SetNumberOfComponents(1)
+        n_comps = 1
     else:
-        result_array.SetNumberOfComponents(shape[1])
-
-    result_array.SetNumberOfTuples(shape[0])
+        n_comps = shape[1]
 
     # Ravel the array appropriately.
     arr_dtype = get_numpy_array_type(svtk_typecode)
@@ -170,22 +173,17 @@ def numpy_to_svtk(num_array, deep=0, array_type=None):
        z.dtype == numpy.dtype(arr_dtype):
         z_flat = numpy.ravel(z)
     else:
+        # z_flat is now a standalone object with no references from the
+        # caller, it is kept alive by the SVTK array.
         z_flat = numpy.ravel(z).astype(arr_dtype)
-        # z_flat is now a standalone object with no references from the caller.
-        # As such, it will drop out of this scope and cause memory issues if we
-        # do not deep copy its data.
-        deep = 1
-
-    # Point the SVTK array to the numpy data.  The last argument (1)
-    # tells the array not to deallocate.
-    ptr = svtk.as_void_ptr(z_flat.__array_interface__['data'][0])
-    result_array.SetVoidArray(ptr, len(z_flat), 1)
+
+    # Point the SVTK array to the numpy data. The SVTK array holds a
+    # reference to the numpy array until it is deleted.
+    result_array = svtk_array_from_buffer(z_flat, n_comps, svtk_typecode)
     if deep:
         copy = result_array.NewInstance()
         copy.DeepCopy(result_array)
         result_array = copy
-    else:
-        result_array._numpy_reference = z_flat
     return result_array
 
 def numpy_to_svtkIdTypeArray(num_array, deep=0):
@@ -221,7 +219,9 @@ def get_numpy_typestr(svtk_array_type):
     return _svtk_np[svtk_array_type]
 
 class svtk_array_handle:
-    """ A hgelper class to present data from a SVTK data array to Numpy """
+    """ A helper class to present data from a SVTK data array to Numpy
+    through the array interface. SOA arrays are copied into a temporary AOS
+    array by GetVoidPointer. Superseded by svtkDataArray.buffer """
     def __init__(self, arr):
         self.data = as_integer(arr.GetVoidPointer(0))
         self.shape = arr.GetNumberOfTuples(), arr.GetNumberOfComponents()
@@ -238,7 +238,9 @@ def svtk_to_numpy(svtk_array):
 
     Given a subclass of svtkDataArray, this function returns an
     appropriate numpy array containing the same data -- it actually
-    points to the same data.
+    points to the same data. The shape of the numpy array is (number of
+    tuples, number of components). The numpy array holds a reference to the
+    SVTK array.
 
     WARNING: This does not work for bit arrays.
 
@@ -248,5 +250,14 @@ def svtk_to_numpy(svtk_array):
       The SVTK data array to be converted.
 
     """
-    h = svtk_array_handle(svtk_array)
-    return numpy.array(h, copy=False)
+    try:
+        return numpy.asarray(svtk_array.buffer())
+    except BufferError:
+        # an SOA array with scattered components
+        n_comps = svtk_array.GetNumberOfComponents()
+        return numpy.stack([numpy.asarray(svtk_array.buffer(i))
+                            for i in range(n_comps)], axis=1)
+    except TypeError:
+        # an array type that does not expose its memory
+        h = svtk_array_handle(svtk_array)
+        return numpy.array(h, copy=False)
@@ -8,6 +8,7 @@
 #include "kwiml/int.h"
 #include "kwiml/abi.h"
 #include "svtkSetGet.h"
+#include "svtkPyBuffer.h"
 
 #include <sstream>
 
@@ -25,86 +26,105 @@
 /* SWIG does not understand attributes */
 #define __attribute__(x)
 
+%init
+%{
+if (svtkPyBuffer::Initialize())
+    return NULL;
+%}
+
 /* automatically convert to the derived type */
 %typemap(out) svtkDataArray*
 {
-  if (dynamic_cast<svtkDoubleArray*>($1))
+  if (!$1)
+  {
+    if (PyErr_Occurred())
+      SWIG_fail;
+    $result = SWIG_Py_Void();
+  }
+  else if (dynamic_cast<svtkDoubleArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkDoubleArray*>($1),
-      SWIGTYPE_p_svtkDoubleArray, 0);
+      SWIGTYPE_p_svtkDoubleArray, $owner);
   }
   else if (dynamic_cast<svtkFloatArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkFloatArray*>($1),
-      SWIGTYPE_p_svtkFloatArray, 0);
+      SWIGTYPE_p_svtkFloatArray, $owner);
   }
   else if (dynamic_cast<svtkCharArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkCharArray*>($1),
-      SWIGTYPE_p_svtkCharArray, 0);
+      SWIGTYPE_p_svtkCharArray, $owner);
   }
   else if (dynamic_cast<svtkShortArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkShortArray*>($1),
-      SWIGTYPE_p_svtkShortArray, 0);
+      SWIGTYPE_p_svtkShortArray, $owner);
   }
   else if (dynamic_cast<svtkIntArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkIntArray*>($1),
-      SWIGTYPE_p_svtkIntArray, 0);
+      SWIGTYPE_p_svtkIntArray, $owner);
   }
   else if (dynamic_cast<svtkLongArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkLongArray*>($1),
-      SWIGTYPE_p_svtkLongArray, 0);
+      SWIGTYPE_p_svtkLongArray, $owner);
   }
   else if (dynamic_cast<svtkLongLongArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkLongLongArray*>($1),
-      SWIGTYPE_p_svtkLongLongArray, 0);
+      SWIGTYPE_p_svtkLongLongArray, $owner);
   }
   else if (dynamic_cast<svtkIdTypeArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkIdTypeArray*>($1),
-      SWIGTYPE_p_svtkIdTypeArray, 0);
+      SWIGTYPE_p_svtkIdTypeArray, $owner);
   }
   else if (dynamic_cast<svtkUnsignedCharArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkUnsignedCharArray*>($1),
-      SWIGTYPE_p_svtkUnsignedCharArray, 0);
+      SWIGTYPE_p_svtkUnsignedCharArray, $owner);
   }
   else if (dynamic_cast<svtkUnsignedShortArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkUnsignedShortArray*>($1),
-      SWIGTYPE_p_svtkUnsignedShortArray, 0);
+      SWIGTYPE_p_svtkUnsignedShortArray, $owner);
   }
   else if (dynamic_cast<svtkUnsignedIntArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkUnsignedIntArray*>($1),
-      SWIGTYPE_p_svtkUnsignedIntArray, 0);
+      SWIGTYPE_p_svtkUnsignedIntArray, $owner);
   }
   else if (dynamic_cast<svtkUnsignedLongArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkUnsignedLongArray*>($1),
-      SWIGTYPE_p_svtkUnsignedLongArray, 0);
+      SWIGTYPE_p_svtkUnsignedLongArray, $owner);
   }
   else if (dynamic_cast<svtkUnsignedLongLongArray*>($1))
   {
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkUnsignedLongLongArray*>($1),
-      SWIGTYPE_p_svtkUnsignedLongLongArray, 0);
+      SWIGTYPE_p_svtkUnsignedLongLongArray, $owner);
+  }
+  else if ($1->GetArrayType() == svtkAbstractArray::SoADataArrayTemplate)
+  {
+    /* SOA arrays are not instantiated, the base class API is used */
+    $result = SWIG_NewPointerObj(
+      (void*)static_cast<svtkDataArray*>($1),
+      SWIGTYPE_p_svtkDataArray, $owner);
   }
   else
   {
@@ -113,7 +133,7 @@
       << std::endl;
     $result = SWIG_NewPointerObj(
       (void*)static_cast<svtkDataArray*>($1),
-      SWIGTYPE_p_svtkDataArray, 0);
+      SWIGTYPE_p_svtkDataArray, $owner);
   }
 }
 
@@ -297,6 +317,30 @@ SVTK_WRAP_CLASS(svtkObject)
  * Data Arrays
  ***************************************************************************/
 SVTK_WRAP_DATA_ARRAY(svtkAbstractArray)
+
+/* zero-copy access from NumPy and other DLPack consumers, see svtkPyBuffer.h
+ * for the details. the exported objects hold a reference to the array. */
+%feature("kwargs") svtkDataArray::buffer;
+%feature("kwargs") svtkDataArray::__dlpack__;
+%extend svtkDataArray
+{
+    /* a memoryview of the values, or of one component of an SOA array */
+    PyObject *buffer(int comp = -1)
+    {
+        return svtkPyBuffer::NewMemoryView(self, comp);
+    }
+
+    PyObject *__dlpack__(PyObject *stream = nullptr)
+    {
+        (void)stream;
+        return svtkPyBuffer::NewDLPackCapsule(self, -1);
+    }
+
+    PyObject *__dlpack_device__()
+    {
+        return Py_BuildValue("(ii)", int(svtkPyBuffer::kDLCPU), 0);
+    }
+};
 SVTK_WRAP_DATA_ARRAY(svtkDataArray)
 
 %ignore svtkGenericDataArray::DoComputeScalarRange;
@@ -534,6 +578,19 @@ SVTK_WRAP_CLASS(svtkMultiPieceDataSet)
 SVTK_WRAP_CLASS(svtkOctreePointLocator)
 SVTK_WRAP_CLASS(svtkHierarchicalBoxDataIterator) */
 
+/* a new array that points to the memory of a Python object supporting the
+ * buffer protocol or DLPack, or to that of each object of a list or tuple
+ * for an SOA array. The memory is released when the array is deleted. */
+%newobject svtk_array_from_buffer;
+%inline
+%{
+svtkDataArray *svtk_array_from_buffer(PyObject *obj, int n_comps = 0,
+    int array_type = -1)
+{
+    return svtkPyBuffer::NewArray(obj, n_comps, array_type);
+}
+%}
+
 /* TODO -- hack for sharing data with Numpy */
 %inline
 %{
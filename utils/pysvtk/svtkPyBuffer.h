@@ -0,0 +1,731 @@
+#ifndef svtkPyBuffer_h
+#define svtkPyBuffer_h
+
+/* Zero-copy sharing of SVTK data arrays with Python.
+ *
+ * Export: the values of an AOS array, or of an SOA array whose component
+ * buffers are equally spaced in memory, or of one component of any SOA
+ * array, are presented through the Python buffer protocol and DLPack. The
+ * exporting object holds a reference to the SVTK array, which therefore
+ * lives at least as long as any NumPy array viewing it.
+ *
+ * Import: a new SVTK array is made to point to the memory of any object that
+ * supports the buffer protocol or DLPack. One C-contiguous object makes an
+ * AOS array, a sequence of one dimensional objects an SOA array with one
+ * component per object. The Python objects are released when the SVTK
+ * array's reference count reaches zero, not when its Python proxy is
+ * collected, so the array may be handed to C++ and outlive the proxy.
+ */
+
+#include <Python.h>
+
+#include <svtkCallbackCommand.h>
+#include <svtkCommand.h>
+#include <svtkDataArray.h>
+#include <svtkSOADataArrayTemplate.h>
+#include <svtkType.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace svtkPyBuffer
+{
+
+/* DLPack ABI, see https://github.com/dmlc/dlpack */
+enum { kDLCPU = 1 };
+enum { kDLInt = 0, kDLUInt = 1, kDLFloat = 2 };
+
+struct DLDevice
+{
+  int32_t device_type;
+  int32_t device_id;
+};
+
+struct DLDataType
+{
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor
+{
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor
+{
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor* self);
+};
+
+/* the layout of the values of an array, or of one of its components */
+struct Layout
+{
+  void* Data;
+  int NDim;
+  Py_ssize_t Shape[2];
+  Py_ssize_t Strides[2]; /* in bytes */
+  Py_ssize_t ItemSize;
+};
+
+/* the buffer protocol format, and DLPack type, of a SVTK type */
+static bool GetType(int svtkType, const char*& format, DLDataType& dtype)
+{
+  dtype.lanes = 1;
+  switch (svtkType)
+  {
+    case SVTK_CHAR:
+    case SVTK_SIGNED_CHAR:
+      format = "b"; dtype.code = kDLInt; dtype.bits = 8;
+      return true;
+    case SVTK_UNSIGNED_CHAR:
+      format = "B"; dtype.code = kDLUInt; dtype.bits = 8;
+      return true;
+    case SVTK_SHORT:
+      format = "h"; dtype.code = kDLInt; dtype.bits = 16;
+      return true;
+    case SVTK_UNSIGNED_SHORT:
+      format = "H"; dtype.code = kDLUInt; dtype.bits = 16;
+      return true;
+    case SVTK_INT:
+      format = "i"; dtype.code = kDLInt; dtype.bits = 32;
+      return true;
+    case SVTK_UNSIGNED_INT:
+      format = "I"; dtype.code = kDLUInt; dtype.bits = 32;
+      return true;
+    case SVTK_LONG:
+      format = "l"; dtype.code = kDLInt; dtype.bits = 8 * sizeof(long);
+      return true;
+    case SVTK_UNSIGNED_LONG:
+      format = "L"; dtype.code = kDLUInt; dtype.bits = 8 * sizeof(long);
+      return true;
+    case SVTK_LONG_LONG:
+    case SVTK_ID_TYPE:
+      format = "q"; dtype.code = kDLInt; dtype.bits = 64;
+      return true;
+    case SVTK_UNSIGNED_LONG_LONG:
+      format = "Q"; dtype.code = kDLUInt; dtype.bits = 64;
+      return true;
+    case SVTK_FLOAT:
+      format = "f"; dtype.code = kDLFloat; dtype.bits = 32;
+      return true;
+    case SVTK_DOUBLE:
+      format = "d"; dtype.code = kDLFloat; dtype.bits = 64;
+      return true;
+  }
+  return false;
+}
+
+/* the SVTK type of a buffer protocol format, or -1 */
+static int GetSVTKType(const char* format)
+{
+  if (!format)
+  {
+    return SVTK_UNSIGNED_CHAR;
+  }
+
+  /* native byte order and size */
+  if ((format[0] == '@') || (format[0] == '='))
+  {
+    ++format;
+  }
+  if (!format[0] || format[1])
+  {
+    return -1;
+  }
+
+  switch (format[0])
+  {
+    case 'b': return SVTK_SIGNED_CHAR;
+    case 'B': return SVTK_UNSIGNED_CHAR;
+    case 'h': return SVTK_SHORT;
+    case 'H': return SVTK_UNSIGNED_SHORT;
+    case 'i': return SVTK_INT;
+    case 'I': return SVTK_UNSIGNED_INT;
+    case 'l': return SVTK_LONG;
+    case 'L': return SVTK_UNSIGNED_LONG;
+    case 'q': return SVTK_LONG_LONG;
+    case 'Q': return SVTK_UNSIGNED_LONG_LONG;
+    case 'f': return SVTK_FLOAT;
+    case 'd': return SVTK_DOUBLE;
+  }
+  return -1;
+}
+
+/* the SVTK type of a DLPack type, or -1 */
+static int GetSVTKType(const DLDataType& dtype)
+{
+  if (dtype.lanes != 1)
+  {
+    return -1;
+  }
+
+  const char* formats[] = { "b", "h", "i", "q", "B", "H", "I", "Q", "", "", "f", "d" };
+  int size = dtype.bits == 8 ? 0 : dtype.bits == 16 ? 1 : dtype.bits == 32 ? 2 :
+    dtype.bits == 64 ? 3 : -1;
+  if ((size < 0) || (dtype.code > kDLFloat))
+  {
+    return -1;
+  }
+
+  return GetSVTKType(formats[4 * dtype.code + size]);
+}
+
+/* locate the values of an array, or of one component of an SOA array when
+ * comp is not negative. sets a Python exception and returns false if the
+ * values are not laid out with a uniform stride. */
+static bool GetLayout(svtkDataArray* arr, int comp, Layout& layout)
+{
+  Py_ssize_t nTuples = arr->GetNumberOfTuples();
+  int nComps = arr->GetNumberOfComponents();
+
+  layout.ItemSize = arr->GetDataTypeSize();
+
+  if (arr->GetArrayType() == svtkAbstractArray::AoSDataArrayTemplate)
+  {
+    if (comp >= nComps)
+    {
+      PyErr_Format(PyExc_IndexError, "No component %d", comp);
+      return false;
+    }
+
+    char* data = static_cast<char*>(arr->GetVoidPointer(0));
+    if (comp < 0)
+    {
+      layout.Data = data;
+      layout.NDim = 2;
+      layout.Shape[0] = nTuples;
+      layout.Shape[1] = nComps;
+      layout.Strides[0] = nComps * layout.ItemSize;
+      layout.Strides[1] = layout.ItemSize;
+    }
+    else
+    {
+      layout.Data = data + comp * layout.ItemSize;
+      layout.NDim = 1;
+      layout.Shape[0] = nTuples;
+      layout.Strides[0] = nComps * layout.ItemSize;
+    }
+    return true;
+  }
+
+  if (arr->GetArrayType() != svtkAbstractArray::SoADataArrayTemplate)
+  {
+    PyErr_Format(PyExc_TypeError, "%s does not expose its memory", arr->GetClassName());
+    return false;
+  }
+
+  if (comp >= nComps)
+  {
+    PyErr_Format(PyExc_IndexError, "No component %d", comp);
+    return false;
+  }
+
+  /* the component buffers, without triggering an AOS copy */
+  std::vector<char*> comps(nComps, nullptr);
+  switch (arr->GetDataType())
+  {
+    svtkTemplateMacro(
+      svtkSOADataArrayTemplate<SVTK_TT>* soa = static_cast<svtkSOADataArrayTemplate<SVTK_TT>*>(arr);
+      for (int i = 0; i < nComps; ++i)
+      {
+        comps[i] = reinterpret_cast<char*>(soa->GetComponentArrayPointer(i));
+      });
+    default:
+      PyErr_Format(PyExc_TypeError, "Unsupported type %s", arr->GetDataTypeAsString());
+      return false;
+  }
+
+  layout.NDim = 1;
+  layout.Shape[0] = nTuples;
+  layout.Strides[0] = layout.ItemSize;
+
+  if (comp >= 0)
+  {
+    layout.Data = comps[comp];
+    return true;
+  }
+
+  /* all components as a two dimensional view, possible when the components
+   * are equally spaced, as when a simulation allocates them in one block */
+  layout.Data = comps[0];
+  layout.NDim = 2;
+  layout.Shape[1] = nComps;
+  layout.Strides[1] = nComps > 1 ? comps[1] - comps[0] : layout.ItemSize;
+
+  for (int i = 1; i < nComps; ++i)
+  {
+    if (((comps[i] - comps[i - 1]) != layout.Strides[1]) ||
+      (layout.Strides[1] % layout.ItemSize))
+    {
+      PyErr_Format(PyExc_BufferError,
+        "The components of this SOA array are not equally spaced, "
+        "request them one at a time");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/****************************************************************************
+ * Export through the buffer protocol
+ ***************************************************************************/
+
+/* a Python object that holds a reference to a SVTK array and exports its
+ * values. memoryviews and NumPy arrays made from it hold a reference to it. */
+struct Exporter
+{
+  PyObject_HEAD
+  svtkDataArray* Array;
+  int Component;
+  Layout Values;
+};
+
+static void ExporterDealloc(PyObject* self)
+{
+  Exporter* exp = reinterpret_cast<Exporter*>(self);
+  if (exp->Array)
+  {
+    exp->Array->UnRegister(nullptr);
+  }
+  Py_TYPE(self)->tp_free(self);
+}
+
+static int ExporterGetBuffer(PyObject* self, Py_buffer* view, int flags)
+{
+  Exporter* exp = reinterpret_cast<Exporter*>(self);
+  Layout& layout = exp->Values;
+
+  const char* format = nullptr;
+  DLDataType dtype;
+  GetType(exp->Array->GetDataType(), format, dtype);
+
+  bool contiguous = layout.Strides[layout.NDim - 1] == layout.ItemSize &&
+    ((layout.NDim == 1) || (layout.Strides[0] == layout.Shape[1] * layout.ItemSize));
+
+  if (!contiguous && !((flags & PyBUF_STRIDES) == PyBUF_STRIDES))
+  {
+    PyErr_SetString(PyExc_BufferError, "The values are not contiguous");
+    return -1;
+  }
+
+  view->obj = self;
+  Py_INCREF(self);
+  view->buf = layout.Data;
+  view->len = layout.ItemSize * layout.Shape[0] * (layout.NDim > 1 ? layout.Shape[1] : 1);
+  view->readonly = 0;
+  view->itemsize = layout.ItemSize;
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(format) : nullptr;
+  view->ndim = layout.NDim;
+  view->shape = (flags & PyBUF_ND) == PyBUF_ND ? layout.Shape : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? layout.Strides : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = nullptr;
+
+  return 0;
+}
+
+static PyBufferProcs ExporterBufferProcs = { ExporterGetBuffer, nullptr };
+
+static PyTypeObject ExporterType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+/* initialize the exporter type, called once at module import */
+static int Initialize()
+{
+  ExporterType.tp_name = "svtk.svtkArrayBuffer";
+  ExporterType.tp_basicsize = sizeof(Exporter);
+  ExporterType.tp_dealloc = ExporterDealloc;
+  ExporterType.tp_as_buffer = &ExporterBufferProcs;
+  ExporterType.tp_flags = Py_TPFLAGS_DEFAULT;
+  ExporterType.tp_doc = "Exports the values of a SVTK data array";
+  return PyType_Ready(&ExporterType);
+}
+
+/* a memoryview of the values of the array, or of one of its components */
+static PyObject* NewMemoryView(svtkDataArray* arr, int comp)
+{
+  if (!arr)
+  {
+    PyErr_SetString(PyExc_ValueError, "No array");
+    return nullptr;
+  }
+
+  const char* format = nullptr;
+  DLDataType dtype;
+  if (!GetType(arr->GetDataType(), format, dtype))
+  {
+    PyErr_Format(PyExc_TypeError, "Unsupported type %s", arr->GetDataTypeAsString());
+    return nullptr;
+  }
+
+  Layout layout;
+  if (!GetLayout(arr, comp, layout))
+  {
+    return nullptr;
+  }
+
+  Exporter* exp = PyObject_New(Exporter, &ExporterType);
+  if (!exp)
+  {
+    return nullptr;
+  }
+
+  arr->Register(nullptr);
+  exp->Array = arr;
+  exp->Component = comp;
+  exp->Values = layout;
+
+  PyObject* view = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(exp));
+  Py_DECREF(exp);
+
+  return view;
+}
+
+/****************************************************************************
+ * Export through DLPack
+ ***************************************************************************/
+
+/* holds a reference to the array while the consumer uses the tensor */
+struct ManagerContext
+{
+  svtkDataArray* Array;
+  int64_t Shape[2];
+  int64_t Strides[2];
+};
+
+static void DLManagedTensorDelete(DLManagedTensor* self)
+{
+  ManagerContext* ctx = static_cast<ManagerContext*>(self->manager_ctx);
+  ctx->Array->UnRegister(nullptr);
+  delete ctx;
+  delete self;
+}
+
+static void DLPackCapsuleDestructor(PyObject* capsule)
+{
+  /* a consumer renames the capsule and takes ownership */
+  if (PyCapsule_IsValid(capsule, "dltensor"))
+  {
+    DLManagedTensor* tensor =
+      static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule, "dltensor"));
+    tensor->deleter(tensor);
+  }
+}
+
+/* a DLPack capsule of the values of the array, or of one of its components */
+static PyObject* NewDLPackCapsule(svtkDataArray* arr, int comp)
+{
+  if (!arr)
+  {
+    PyErr_SetString(PyExc_ValueError, "No array");
+    return nullptr;
+  }
+
+  const char* format = nullptr;
+  DLDataType dtype;
+  if (!GetType(arr->GetDataType(), format, dtype))
+  {
+    PyErr_Format(PyExc_TypeError, "Unsupported type %s", arr->GetDataTypeAsString());
+    return nullptr;
+  }
+
+  Layout layout;
+  if (!GetLayout(arr, comp, layout))
+  {
+    return nullptr;
+  }
+
+  ManagerContext* ctx = new ManagerContext;
+  arr->Register(nullptr);
+  ctx->Array = arr;
+
+  /* DLPack strides are in elements */
+  for (int i = 0; i < layout.NDim; ++i)
+  {
+    ctx->Shape[i] = layout.Shape[i];
+    ctx->Strides[i] = layout.Strides[i] / layout.ItemSize;
+  }
+
+  DLManagedTensor* tensor = new DLManagedTensor;
+  tensor->dl_tensor.data = layout.Data;
+  tensor->dl_tensor.device.device_type = kDLCPU;
+  tensor->dl_tensor.device.device_id = 0;
+  tensor->dl_tensor.ndim = layout.NDim;
+  tensor->dl_tensor.dtype = dtype;
+  tensor->dl_tensor.shape = ctx->Shape;
+  tensor->dl_tensor.strides = ctx->Strides;
+  tensor->dl_tensor.byte_offset = 0;
+  tensor->manager_ctx = ctx;
+  tensor->deleter = DLManagedTensorDelete;
+
+  PyObject* capsule = PyCapsule_New(tensor, "dltensor", DLPackCapsuleDestructor);
+  if (!capsule)
+  {
+    DLManagedTensorDelete(tensor);
+  }
+
+  return capsule;
+}
+
+/****************************************************************************
+ * Import
+ ***************************************************************************/
+
+/* the Python buffers and DLPack tensors an imported array points to */
+struct ImportContext
+{
+  std::vector<Py_buffer> Buffers;
+  std::vector<DLManagedTensor*> Tensors;
+};
+
+/* releases the imported memory when the SVTK array is deleted */
+static void ImportRelease(svtkObject*, unsigned long, void* clientData, void*)
+{
+  ImportContext* ctx = static_cast<ImportContext*>(clientData);
+
+  /* after the interpreter is finalized the memory is gone with it */
+  if (Py_IsInitialized())
+  {
+    PyGILState_STATE gil = PyGILState_Ensure();
+
+    for (Py_buffer& buf : ctx->Buffers)
+    {
+      PyBuffer_Release(&buf);
+    }
+
+    for (DLManagedTensor* tensor : ctx->Tensors)
+    {
+      if (tensor->deleter)
+      {
+        tensor->deleter(tensor);
+      }
+    }
+
+    PyGILState_Release(gil);
+  }
+
+  delete ctx;
+}
+
+/* get a contiguous view of the memory of obj, through the buffer protocol
+ * if it is supported, or DLPack otherwise. returns false and sets a Python
+ * exception if neither is supported or the memory is not contiguous. */
+static bool Import(PyObject* obj, ImportContext* ctx, void*& data, Py_ssize_t& nValues,
+  Py_ssize_t& nInner, int& svtkType)
+{
+  if (PyObject_CheckBuffer(obj))
+  {
+    Py_buffer buf;
+    if (PyObject_GetBuffer(obj, &buf, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT))
+    {
+      return false;
+    }
+
+    svtkType = GetSVTKType(buf.format);
+    if (svtkType < 0)
+    {
+      PyErr_Format(PyExc_TypeError, "Unsupported format %s", buf.format);
+      PyBuffer_Release(&buf);
+      return false;
+    }
+
+    data = buf.buf;
+    nValues = buf.len / buf.itemsize;
+    nInner = buf.ndim > 1 ? buf.shape[buf.ndim - 1] : 1;
+    ctx->Buffers.push_back(buf);
+    return true;
+  }
+
+  if (PyObject_HasAttrString(obj, "__dlpack__"))
+  {
+    PyObject* capsule = PyObject_CallMethod(obj, "__dlpack__", nullptr);
+    if (!capsule)
+    {
+      return false;
+    }
+
+    DLManagedTensor* tensor =
+      static_cast<DLManagedTensor*>(PyCapsule_GetPointer(capsule, "dltensor"));
+    if (!tensor)
+    {
+      Py_DECREF(capsule);
+      return false;
+    }
+
+    DLTensor& dl = tensor->dl_tensor;
+
+    /* only contiguous memory on the host */
+    bool contiguous = true;
+    int64_t stride = 1;
+    for (int i = dl.ndim - 1; dl.strides && (i >= 0); --i)
+    {
+      contiguous &= (dl.shape[i] == 1) || (dl.strides[i] == stride);
+      stride *= dl.shape[i];
+    }
+
+    svtkType = GetSVTKType(dl.dtype);
+    if ((dl.device.device_type != kDLCPU) || !contiguous || (svtkType < 0))
+    {
+      PyErr_SetString(PyExc_BufferError,
+        "Only contiguous host memory of a numeric type can be shared");
+      Py_DECREF(capsule);
+      return false;
+    }
+
+    /* take ownership */
+    PyCapsule_SetName(capsule, "used_dltensor");
+    Py_DECREF(capsule);
+
+    nValues = 1;
+    for (int i = 0; i < dl.ndim; ++i)
+    {
+      nValues *= dl.shape[i];
+    }
+    nInner = dl.ndim > 1 ? dl.shape[dl.ndim - 1] : 1;
+    data = static_cast<char*>(dl.data) + dl.byte_offset;
+    ctx->Tensors.push_back(tensor);
+    return true;
+  }
+
+  PyErr_Format(PyExc_TypeError,
+    "%s supports neither the buffer protocol nor DLPack", Py_TYPE(obj)->tp_name);
+  return false;
+}
+
+/* a new array pointing to the memory of obj, or of each object of a
+ * sequence. when svtkType is not negative it must have the same size as the
+ * element type of the memory. when nComps is less than 1 it is taken from
+ * the last dimension of a two dimensional object. returns nullptr with a
+ * Python exception set on error, a TypeError when svtkType is not one of
+ * the numeric types. */
+static svtkDataArray* NewArray(PyObject* obj, int nComps, int svtkType)
+{
+  ImportContext* ctx = new ImportContext;
+
+  /* a sequence of objects makes an SOA array */
+  bool soa = PyTuple_Check(obj) || PyList_Check(obj);
+  Py_ssize_t nObj = soa ? PySequence_Size(obj) : 1;
+  if (nObj < 1)
+  {
+    PyErr_SetString(PyExc_ValueError, "Nothing to import");
+    delete ctx;
+    return nullptr;
+  }
+
+  std::vector<void*> data(nObj, nullptr);
+  Py_ssize_t nValues = 0;
+  Py_ssize_t nInner = 1;
+  int type = -1;
+
+  bool ok = true;
+  for (Py_ssize_t i = 0; ok && (i < nObj); ++i)
+  {
+    PyObject* item = soa ? PySequence_GetItem(obj, i) : obj;
+
+    Py_ssize_t n = 0;
+    int t = -1;
+    ok = Import(item, ctx, data[i], n, nInner, t);
+
+    if (ok && (i > 0) && ((n != nValues) || (t != type)))
+    {
+      PyErr_SetString(PyExc_ValueError, "The components differ in length or type");
+      ok = false;
+    }
+
+    nValues = n;
+    type = t;
+
+    if (soa)
+    {
+      Py_DECREF(item);
+    }
+  }
+
+  svtkDataArray* arr = nullptr;
+  if (ok)
+  {
+    if (svtkType < 0)
+    {
+      svtkType = type;
+    }
+
+    /* the types handled by the svtkTemplateMacro switch below */
+    bool supported = false;
+    switch (svtkType)
+    {
+      svtkTemplateMacro(supported = true;);
+    }
+
+    if (!supported)
+    {
+      PyErr_Format(PyExc_TypeError, "Unsupported type %d", svtkType);
+      ok = false;
+    }
+    else if (svtkDataArray::GetDataTypeSize(svtkType) != svtkDataArray::GetDataTypeSize(type))
+    {
+      PyErr_SetString(PyExc_TypeError, "The requested type has a different size");
+      ok = false;
+    }
+  }
+
+  if (ok && !soa)
+  {
+    nComps = nComps > 0 ? nComps : static_cast<int>(nInner);
+    if (nValues % nComps)
+    {
+      PyErr_SetString(PyExc_ValueError, "The size is not a multiple of the components");
+      ok = false;
+    }
+    else
+    {
+      arr = svtkDataArray::CreateDataArray(svtkType);
+      arr->SetNumberOfComponents(nComps);
+      /* save, the memory belongs to Python */
+      arr->SetVoidArray(data[0], nValues, 1);
+    }
+  }
+  else if (ok)
+  {
+    switch (svtkType)
+    {
+      svtkTemplateMacro(
+        svtkSOADataArrayTemplate<SVTK_TT>* tmp = svtkSOADataArrayTemplate<SVTK_TT>::New();
+        tmp->SetNumberOfComponents(static_cast<int>(nObj));
+        for (Py_ssize_t i = 0; i < nObj; ++i)
+        {
+          tmp->SetArray(static_cast<int>(i), static_cast<SVTK_TT*>(data[i]), nValues,
+            i == nObj - 1, true);
+        }
+        arr = tmp;);
+    }
+  }
+
+  if (!arr)
+  {
+    /* the exception was set above */
+    ImportRelease(nullptr, 0, ctx, nullptr);
+    return nullptr;
+  }
+
+  svtkCallbackCommand* release = svtkCallbackCommand::New();
+  release->SetCallback(ImportRelease);
+  release->SetClientData(ctx);
+  arr->AddObserver(svtkCommand::DeleteEvent, release);
+  release->Delete();
+
+  return arr;
+}
+
+}
+
+#endif